@@ -0,0 +1,289 @@
+/**
+ * @file       corpus.cpp
+ * @brief      Implementation of generating large source files to benchmark with
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <random>
+#include <vector>
+#include "corpus.hpp"
+
+/* Names of the kinds of source files, in the order of `CorpusKind` */
+static const char *corpusNames[CORPUS_KINDS] = { "nested", "strings", "comments", "identifiers", "numbers", "mixed", "branches" };
+
+/* Pieces that names and text are made of */
+static const char *syllables[] = { "count", "total", "index", "value", "buffer", "node", "item", "offset", "limit", "step",
+	"left", "right", "sum", "max", "min", "next", "prev", "size", "head", "tail" };
+
+/* Keeps every intermediate value well within 32 bits */
+#define CORPUS_MODULUS 1000003
+
+// --------------- function prototypes -------------------------
+
+static void addNested(std::string *out, std::mt19937 &rng);
+static void addStrings(std::string *out, std::mt19937 &rng);
+static void addComments(std::string *out, std::mt19937 &rng);
+static void addIdentifiers(std::string *out, std::mt19937 &rng);
+static void addNumbers(std::string *out, std::mt19937 &rng);
+static void addBranches(std::string *out, std::mt19937 &rng);
+static std::string makeWords(std::mt19937 &rng, size_t length);
+static std::string makeName(std::mt19937 &rng, int suffix);
+static void indent(std::string *out, int depth);
+
+
+const char *getCorpusName(CorpusKind kind) {
+	return corpusNames[kind];
+}
+
+bool findCorpusKind(const std::string &name, CorpusKind *kind) {
+	for (int idx = 0; idx < CORPUS_KINDS; idx++) {
+		if (name == corpusNames[idx]) {
+			*kind = static_cast<CorpusKind>(idx);
+			return true;
+		}
+	}
+	return false;
+}
+
+std::string generateCorpus(CorpusKind kind, size_t bytes, uint32_t seed) {
+	static void (*const generators[])(std::string *, std::mt19937 &) = { addNested, addStrings, addComments, addIdentifiers, addNumbers,
+		nullptr, addBranches };
+
+	std::mt19937 rng(seed);
+	std::string out;
+	out.reserve(bytes + bytes / 8);
+	int funcs = 0;
+
+	while (out.size() < bytes) {
+		out += "func f" + std::to_string(funcs) + "(num a) => num {\n\tnum r = a\n";
+		auto generator = generators[(kind == CORPUS_MIXED) ? funcs % CORPUS_MIXED : kind];
+
+		// Branches go in a single function, since passes over a function can grow
+		// faster than its size
+		do {
+			generator(&out, rng);
+		} while (kind == CORPUS_BRANCHES && out.size() < bytes);
+		out += "\treturn r % " + std::to_string(CORPUS_MODULUS) + "\n}\n\n";
+		funcs++;
+	}
+
+	// Call every function once, and use the result so that no call can be left out, in
+	// a branch that is never taken since the remainder always stays below the modulus
+	out += "func main() => void {\n\tnum total = 0\n";
+	for (int func = 0; func < funcs; func++) {
+		out += "\ttotal = (total + f" + std::to_string(func) + "(" + std::to_string(func % 100) + ")) % " + std::to_string(CORPUS_MODULUS) + "\n";
+	}
+	out += "\tif total >= " + std::to_string(CORPUS_MODULUS) + " {\n\t\tprintln(total)\n\t}\n}\n";
+	return out;
+}
+
+/**
+ * Adds statements nested dozens of blocks deep, mixing `if`, `while` and `for`.
+ * @param out Text to append to.
+ * @param rng Random number generator.
+ */
+static void addNested(std::string *out, std::mt19937 &rng) {
+	int depth = 16 + static_cast<int>(rng() % 32);
+	int loops = 0;
+	std::vector<std::string> closers;
+
+	for (int level = 1; level <= depth; level++) {
+		indent(out, level);
+		std::string name = std::to_string(level);
+
+		// Every loop runs at most twice, and only a few of them are nested in each other
+		switch (rng() % 3) {
+		case 0:
+			*out += "if r % " + std::to_string(2 + rng() % 5) + " >= 0 {\n";
+			closers.push_back("");
+			break;
+		case 1:
+			*out += "num w" + name + " = 0\n";
+			indent(out, level);
+			*out += "while w" + name + " < 1 {\n";
+			closers.push_back("w" + name + " = w" + name + " + 1\n");
+			break;
+		default:
+			if (loops < 3) {
+				*out += "for num i" + name + " in range(0, 2) {\n";
+				loops++;
+			} else {
+				*out += "for num i" + name + " in range(0, 1) {\n";
+			}
+			closers.push_back("");
+			break;
+		}
+	}
+
+	indent(out, depth + 1);
+	*out += "r = r + " + std::to_string(depth) + "\n";
+
+	for (int level = depth; level >= 1; level--) {
+		if (!closers[level - 1].empty()) {
+			indent(out, level + 1);
+			*out += closers[level - 1];
+		}
+		indent(out, level);
+		*out += "}\n";
+	}
+}
+
+/**
+ * Adds variables holding long string literals, some with escape codes.
+ * @param out Text to append to.
+ * @param rng Random number generator.
+ */
+static void addStrings(std::string *out, std::mt19937 &rng) {
+	int count = 4 + static_cast<int>(rng() % 6);
+
+	for (int idx = 0; idx < count; idx++) {
+		std::string text = makeWords(rng, 100 + rng() % 1900);
+
+		// Sprinkle a few escape codes in
+		if (rng() % 2 == 0) {
+			for (size_t pos = rng() % 200; pos < text.size(); pos += 100 + rng() % 300) {
+				static const char *escapes[] = { "\\n", "\\t", "\\\"", "\\\\" };
+				text.insert(pos, escapes[rng() % 4]);
+			}
+		}
+
+		*out += "\tstring s" + std::to_string(idx) + " = \"" + text + "\"";
+		if (idx > 0) {
+			*out += " + s" + std::to_string(idx - 1);
+		}
+		*out += "\n\tr = r + " + std::to_string(idx + 1) + "\n";
+	}
+}
+
+/**
+ * Adds a few statements buried in line comments and nested block comments.
+ * @param out Text to append to.
+ * @param rng Random number generator.
+ */
+static void addComments(std::string *out, std::mt19937 &rng) {
+	int count = 3 + static_cast<int>(rng() % 5);
+
+	for (int idx = 0; idx < count; idx++) {
+		int lines = 2 + static_cast<int>(rng() % 8);
+
+		*out += "\t/-\n";
+		for (int line = 0; line < lines; line++) {
+			*out += "\t - " + makeWords(rng, 40 + rng() % 60) + "\n";
+
+			if (rng() % 4 == 0) {
+				*out += "\t - /- nested: r = r * 2 -/\n";
+			}
+		}
+		*out += "\t -/\n";
+
+		*out += "\t// " + makeWords(rng, 20 + rng() % 80) + "\n";
+		*out += "\tr = r + " + std::to_string(idx + 1) + " // " + makeWords(rng, 10 + rng() % 40) + "\n";
+	}
+}
+
+/**
+ * Adds many variables with long, distinct names, and sums that use them.
+ * @param out Text to append to.
+ * @param rng Random number generator.
+ */
+static void addIdentifiers(std::string *out, std::mt19937 &rng) {
+	int count = 10 + static_cast<int>(rng() % 20);
+	std::vector<std::string> names;
+
+	for (int idx = 0; idx < count; idx++) {
+		names.push_back(makeName(rng, idx));
+		*out += "\tnum " + names.back() + " = a + " + std::to_string(idx) + "\n";
+	}
+
+	for (int idx = 0; idx < count; idx += 4) {
+		*out += "\tr = (r";
+		for (int term = idx; term < count && term < idx + 4; term++) {
+			*out += " + " + names[static_cast<size_t>(term)] + " - " + names[rng() % names.size()];
+		}
+		*out += ") % " + std::to_string(CORPUS_MODULUS) + "\n";
+	}
+}
+
+/**
+ * Adds arithmetic on many number and decimal literals.
+ * @param out Text to append to.
+ * @param rng Random number generator.
+ */
+static void addNumbers(std::string *out, std::mt19937 &rng) {
+	int count = 4 + static_cast<int>(rng() % 8);
+
+	for (int idx = 0; idx < count; idx++) {
+		// Each product is kept on its own, so that none of them can overflow
+		*out += "\tr = (r + " + std::to_string(rng() % 100000);
+		for (int term = 0; term < 6; term++) {
+			static const char *ops[] = { " * ", " / ", " % " };
+			*out += (rng() % 2 == 0) ? " + (" : " - (";
+			*out += std::to_string(1 + rng() % 999) + ops[rng() % 3] + std::to_string(1 + rng() % 999) + ")";
+		}
+		*out += ") % " + std::to_string(CORPUS_MODULUS) + "\n";
+
+		*out += "\tdec d" + std::to_string(idx) + " = " + std::to_string(rng() % 1000) + "." + std::to_string(rng() % 100000) + " * "
+			+ std::to_string(rng() % 100) + ".5 - 0." + std::to_string(rng() % 1000) + "\n";
+	}
+}
+
+/**
+ * Adds `if` statements one after the other, which the optimizer sees as a long chain
+ * of blocks joining again.
+ * @param out Text to append to.
+ * @param rng Random number generator.
+ */
+static void addBranches(std::string *out, std::mt19937 &rng) {
+	for (int idx = 0; idx < 64; idx++) {
+		*out += "\tif r % " + std::to_string(2 + rng() % 9) + " > " + std::to_string(rng() % 2) + " {\n";
+		*out += "\t\tr = r + " + std::to_string(1 + rng() % 99) + "\n\t} else {\n";
+		*out += "\t\tr = r - " + std::to_string(1 + rng() % 99) + "\n\t}\n";
+	}
+}
+
+/**
+ * Makes text out of words, without quotes or comment markers.
+ * @param rng Random number generator.
+ * @param length Number of characters, roughly.
+ * @returns Text.
+ */
+static std::string makeWords(std::mt19937 &rng, size_t length) {
+	std::string text;
+
+	while (text.size() < length) {
+		if (!text.empty()) {
+			text += ' ';
+		}
+		text += syllables[rng() % (sizeof(syllables) / sizeof(*syllables))];
+	}
+	return text;
+}
+
+/**
+ * Makes a camel case variable name that fits within `MAX_ID_LENGTH`.
+ * @param rng Random number generator.
+ * @param suffix Number that makes the name unique.
+ * @returns Name.
+ */
+static std::string makeName(std::mt19937 &rng, int suffix) {
+	std::string name = syllables[rng() % (sizeof(syllables) / sizeof(*syllables))];
+	int parts = 1 + static_cast<int>(rng() % 3);
+
+	for (int part = 0; part < parts; part++) {
+		std::string word = syllables[rng() % (sizeof(syllables) / sizeof(*syllables))];
+		word[0] = static_cast<char>(word[0] - 'a' + 'A');
+		name += word;
+	}
+	return name + "_" + std::to_string(suffix);
+}
+
+/**
+ * Adds tabs at the start of a line.
+ * @param out Text to append to.
+ * @param depth Number of tabs.
+ */
+static void indent(std::string *out, int depth) {
+	out->append(static_cast<size_t>(depth), '\t');
+}
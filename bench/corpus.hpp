@@ -0,0 +1,57 @@
+/**
+ * @file       corpus.hpp
+ * @brief      Definitions for generating large source files to benchmark with
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef CORPUS_HPP
+#define CORPUS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/** Kinds of generated source files, each stressing a different part of the compiler */
+enum CorpusKind {
+	CORPUS_NESTED,       /* blocks nested dozens of levels deep */
+	CORPUS_STRINGS,      /* long string literals, some with escape codes */
+	CORPUS_COMMENTS,     /* more comment than code, with nested block comments */
+	CORPUS_IDENTIFIERS,  /* many distinct, long variable names */
+	CORPUS_NUMBERS,      /* arithmetic on number and decimal literals */
+	CORPUS_MIXED,        /* all of the above in turn */
+	CORPUS_BRANCHES,     /* a single function of `if` statements one after the other */
+	CORPUS_KINDS
+};
+
+/**
+ * Returns the name of a kind of source file.
+ * @param kind Kind of source file.
+ * @returns Name used on the command line and in reports.
+ */
+const char *getCorpusName(CorpusKind kind);
+
+/**
+ * Finds a kind of source file by name.
+ * @param name Name of the kind.
+ * @param[out] kind Kind found.
+ * @returns `true` if there is a kind of that name.
+ */
+bool findCorpusKind(const std::string &name, CorpusKind *kind);
+
+/**
+ * Generates a valid program of functions that each return a number, and a `main`
+ * function that calls all of them once, so that the file can be checked, compiled and
+ * run as well as lexed and parsed. `CORPUS_BRANCHES` puts the whole size in one
+ * function. The same seed always gives the same text.
+ * @param kind Kind of source file.
+ * @param bytes Size to generate, the result is slightly larger.
+ * @param seed Seed of the random choices.
+ * @returns Source text.
+ */
+std::string generateCorpus(CorpusKind kind, size_t bytes, uint32_t seed);
+
+#endif // CORPUS_HPP
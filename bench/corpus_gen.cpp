@@ -0,0 +1,52 @@
+/**
+ * @file       corpus_gen.cpp
+ * @brief      Command line tool writing generated source files to disk
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ *
+ * Writes a generated source file (see corpus.hpp), for running `dium` itself or other
+ * tools on large inputs:
+ *
+ *   corpus_gen [--seed=<n>] <nested|strings|comments|identifiers|numbers|mixed|branches> <megabytes> <output.dm>
+ *
+ * g++ -std=c++17 -O2 bench/corpus_gen.cpp bench/corpus.cpp
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "corpus.hpp"
+
+int main(int argc, char *argv[]) {
+	uint32_t seed = 1;
+	int arg = 1;
+
+	if (arg < argc && strncmp(argv[arg], "--seed=", 7) == 0) {
+		seed = static_cast<uint32_t>(strtoul(argv[arg] + 7, nullptr, 10));
+		arg++;
+	}
+
+	CorpusKind kind;
+	if (argc - arg != 3 || !findCorpusKind(argv[arg], &kind) || atof(argv[arg + 1]) <= 0) {
+		fprintf(stderr, "Usage: corpus_gen [--seed=<n>] <kind> <megabytes> <output.dm>\nKinds:");
+		for (int idx = 0; idx < CORPUS_KINDS; idx++) {
+			fprintf(stderr, " %s", getCorpusName(static_cast<CorpusKind>(idx)));
+		}
+		fprintf(stderr, "\n");
+		return 2;
+	}
+
+	auto bytes = static_cast<size_t>(atof(argv[arg + 1]) * 1024 * 1024);
+	std::string text = generateCorpus(kind, bytes, seed);
+
+	FILE *file = fopen(argv[arg + 2], "wb");
+	if (file == nullptr || fwrite(text.data(), 1, text.size(), file) != text.size() || fclose(file) != 0) {
+		fprintf(stderr, "File '%s' could not be written\n", argv[arg + 2]);
+		return 2;
+	}
+
+	printf("%s: %zu bytes of %s\n", argv[arg + 2], text.size(), getCorpusName(kind));
+	return 0;
+}
@@ -0,0 +1,425 @@
+/**
+ * @file       image_bench.cpp
+ * @brief      Round trip and benchmark for images of the tokens and syntax tree of source files
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ *
+ * Lexes and parses every file given (every file in examples/ by default), writes an
+ * image of it, maps the image back and checks it against the lexer: every token must
+ * match what `getToken()` hands out, identifiers must have the same text, and the
+ * syntax tree must have the same shape, positions and values. Then times lexing and
+ * parsing each file again against mapping its image and walking every token.
+ *
+ *   image_bench [rounds] [files...]
+ *
+ * g++ -std=c++17 -O2 -pthread -I dium/src bench/image_bench.cpp $(find dium/src -name '*.cpp' ! -name main.cpp) -ldl
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "arena.hpp"
+#include "diagnostics.hpp"
+#include "image.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+
+std::string sname;
+
+/* Keeps the walk over mapped tokens from being optimized away */
+static volatile uint64_t sink;
+
+// --------------- function prototypes -------------------------
+
+static bool sameExpr(const Expr *expr, const ImageExpr *image);
+static bool sameStmt(const Stmt *stmt, const ImageStmt *image);
+
+
+/**
+ * Checks that a name of the image has the same text and symbol as one of the syntax tree.
+ * @param name Name in the syntax tree.
+ * @param image Name in the image.
+ * @returns `true` if they agree.
+ */
+static bool sameName(const Name &name, const ImageName &image) {
+	return name.symbol == image.symbol && std::string_view(name.text, name.length) == image.view();
+}
+
+/**
+ * Checks that an array of expressions in the image matches one of the syntax tree.
+ * @param exprs Expressions in the syntax tree.
+ * @param count Number of expressions.
+ * @param image Expressions in the image.
+ * @returns `true` if they agree.
+ */
+static bool sameExprs(Expr *const *exprs, uint32_t count, const RelArray<RelPtr<ImageExpr>> &image) {
+	if (count != image.size()) {
+		return false;
+	}
+	for (uint32_t idx = 0; idx < count; idx++) {
+		if (!sameExpr(exprs[idx], image[idx].get())) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Checks that an expression of the image has the kind, type and position of one of
+ * the syntax tree, leaving out what is in it.
+ * @param expr Expression in the syntax tree.
+ * @param image Expression in the image.
+ * @returns `true` if they agree.
+ */
+static bool sameNode(const Expr *expr, const ImageExpr *image) {
+	return expr->kind == image->kind && sameType(expr->type, image->type) && expr->position.line == image->position.line
+		&& expr->position.column == image->position.column;
+}
+
+/**
+ * Checks that an expression of the image matches one of the syntax tree, down to its leaves.
+ * @param expr Expression in the syntax tree, or `nullptr`.
+ * @param image Expression in the image, or `nullptr`.
+ * @returns `true` if they agree.
+ */
+static bool sameExpr(const Expr *expr, const ImageExpr *image) {
+	if (expr == nullptr || image == nullptr) {
+		return expr == nullptr && image == nullptr;
+	}
+	if (!sameNode(expr, image)) {
+		return false;
+	}
+
+	switch (expr->kind) {
+	case EXPR_NUM:
+		return static_cast<const NumExpr *>(expr)->value == static_cast<const ImageNumExpr *>(image)->value;
+	case EXPR_DEC: {
+		double a = static_cast<const DecExpr *>(expr)->value;
+		double b = static_cast<const ImageDecExpr *>(image)->value;
+		return memcmp(&a, &b, sizeof(a)) == 0;
+	}
+	case EXPR_BOOL:
+		return static_cast<const BoolExpr *>(expr)->value == static_cast<const ImageBoolExpr *>(image)->value;
+	case EXPR_CHAR:
+		return static_cast<const CharExpr *>(expr)->value == static_cast<const ImageCharExpr *>(image)->value;
+	case EXPR_STR: {
+		const auto *str = static_cast<const StrExpr *>(expr);
+		const auto *copy = static_cast<const ImageStrExpr *>(image);
+		return std::string_view(str->text, str->length) == copy->text.view() && str->escaped == copy->escaped;
+	}
+	case EXPR_NAME:
+		return sameName(static_cast<const NameExpr *>(expr)->name, static_cast<const ImageNameExpr *>(image)->name);
+	case EXPR_ARRAY: {
+		const auto *array = static_cast<const ArrayExpr *>(expr);
+		return sameExprs(array->items, array->count, static_cast<const ImageArrayExpr *>(image)->items);
+	}
+	case EXPR_UNARY: {
+		const auto *unary = static_cast<const UnaryExpr *>(expr);
+		const auto *copy = static_cast<const ImageUnaryExpr *>(image);
+		return unary->op == copy->op && sameExpr(unary->operand, copy->operand.get());
+	}
+	case EXPR_BINARY: {
+		// Chains such as long sums nest through their left operands, which are compared in a loop
+		const auto *binary = static_cast<const BinaryExpr *>(expr);
+		const auto *copy = static_cast<const ImageBinaryExpr *>(image);
+		while (binary->op == copy->op && sameExpr(binary->rhs, copy->rhs.get())) {
+			const ImageExpr *lhs = copy->lhs.get();
+			if (binary->lhs->kind != EXPR_BINARY || lhs == nullptr || lhs->kind != EXPR_BINARY) {
+				return sameExpr(binary->lhs, lhs);
+			}
+			if (!sameNode(binary->lhs, lhs)) {
+				return false;
+			}
+			binary = static_cast<const BinaryExpr *>(binary->lhs);
+			copy = static_cast<const ImageBinaryExpr *>(lhs);
+		}
+		return false;
+	}
+	case EXPR_INDEX: {
+		const auto *index = static_cast<const IndexExpr *>(expr);
+		const auto *copy = static_cast<const ImageIndexExpr *>(image);
+		return sameExpr(index->array, copy->array.get()) && sameExpr(index->index, copy->index.get());
+	}
+	case EXPR_CALL: {
+		const auto *call = static_cast<const CallExpr *>(expr);
+		const auto *copy = static_cast<const ImageCallExpr *>(image);
+		return sameName(call->name, copy->name) && sameExprs(call->args, call->count, copy->args);
+	}
+	case EXPR_CAST: {
+		const auto *cast = static_cast<const CastExpr *>(expr);
+		const auto *copy = static_cast<const ImageCastExpr *>(image);
+		return sameType(cast->target, copy->target) && cast->implicit == copy->implicit
+			&& sameExpr(cast->operand, copy->operand.get());
+	}
+	}
+	return false;
+}
+
+/**
+ * Checks that a block of the image matches one of the syntax tree.
+ * @param block Block in the syntax tree.
+ * @param image Block in the image.
+ * @returns `true` if they agree.
+ */
+static bool sameBlock(const BlockStmt *block, const ImageBlockStmt *image) {
+	return sameStmt(block, image);
+}
+
+/**
+ * Checks that a statement of the image matches one of the syntax tree, down to its leaves.
+ * @param stmt Statement in the syntax tree, or `nullptr`.
+ * @param image Statement in the image, or `nullptr`.
+ * @returns `true` if they agree.
+ */
+static bool sameStmt(const Stmt *stmt, const ImageStmt *image) {
+	if (stmt == nullptr || image == nullptr) {
+		return stmt == nullptr && image == nullptr;
+	}
+	if (stmt->kind != image->kind || stmt->position.line != image->position.line || stmt->position.column != image->position.column) {
+		return false;
+	}
+
+	switch (stmt->kind) {
+	case STMT_BLOCK: {
+		const auto *block = static_cast<const BlockStmt *>(stmt);
+		const auto &stmts = static_cast<const ImageBlockStmt *>(image)->stmts;
+		if (block->count != stmts.size()) {
+			return false;
+		}
+		for (uint32_t idx = 0; idx < block->count; idx++) {
+			if (!sameStmt(block->stmts[idx], stmts[idx].get())) {
+				return false;
+			}
+		}
+		return true;
+	}
+	case STMT_VAR: {
+		const auto *var = static_cast<const VarStmt *>(stmt);
+		const auto *copy = static_cast<const ImageVarStmt *>(image);
+		return sameType(var->type, copy->type) && sameName(var->name, copy->name) && sameExpr(var->value, copy->value.get());
+	}
+	case STMT_ASSIGN: {
+		const auto *assign = static_cast<const AssignStmt *>(stmt);
+		const auto *copy = static_cast<const ImageAssignStmt *>(image);
+		return sameExpr(assign->target, copy->target.get()) && sameExpr(assign->value, copy->value.get());
+	}
+	case STMT_EXPR:
+		return sameExpr(static_cast<const ExprStmt *>(stmt)->expr, static_cast<const ImageExprStmt *>(image)->expr.get());
+	case STMT_IF: {
+		const auto *branch = static_cast<const IfStmt *>(stmt);
+		const auto *copy = static_cast<const ImageIfStmt *>(image);
+		return sameExpr(branch->cond, copy->cond.get()) && sameBlock(branch->then, copy->then.get())
+			&& sameStmt(branch->otherwise, copy->otherwise.get());
+	}
+	case STMT_WHILE: {
+		const auto *loop = static_cast<const WhileStmt *>(stmt);
+		const auto *copy = static_cast<const ImageWhileStmt *>(image);
+		return sameExpr(loop->cond, copy->cond.get()) && sameBlock(loop->body, copy->body.get());
+	}
+	case STMT_FOR: {
+		const auto *loop = static_cast<const ForStmt *>(stmt);
+		const auto *copy = static_cast<const ImageForStmt *>(image);
+		return sameType(loop->type, copy->type) && sameName(loop->name, copy->name) && sameExpr(loop->start, copy->start.get())
+			&& sameExpr(loop->stop, copy->stop.get()) && sameExpr(loop->step, copy->step.get())
+			&& sameBlock(loop->body, copy->body.get());
+	}
+	case STMT_RETURN:
+		return sameExpr(static_cast<const ReturnStmt *>(stmt)->value, static_cast<const ImageReturnStmt *>(image)->value.get());
+	case STMT_PRINT: {
+		const auto *print = static_cast<const PrintStmt *>(stmt);
+		const auto *copy = static_cast<const ImagePrintStmt *>(image);
+		return print->newline == copy->newline && sameExpr(print->value, copy->value.get());
+	}
+	case STMT_EXIT:
+		return sameExpr(static_cast<const ExitStmt *>(stmt)->code, static_cast<const ImageExitStmt *>(image)->code.get());
+	case STMT_BREAK:
+	case STMT_CONTINUE:
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Checks that the syntax tree of the image matches the one it was written from.
+ * @param program Syntax tree.
+ * @param image Syntax tree in the image.
+ * @returns `true` if they agree.
+ */
+static bool sameProgram(const Program *program, const ImageProgram *image) {
+	if (image == nullptr || program->count != image->funcs.size()) {
+		return false;
+	}
+
+	for (uint32_t idx = 0; idx < program->count; idx++) {
+		const FuncDecl *func = program->funcs[idx];
+		const ImageFuncDecl *copy = image->funcs[idx].get();
+		if (!sameName(func->name, copy->name) || !sameType(func->returnType, copy->returnType) || func->paramCount != copy->params.size()
+			|| func->position.line != copy->position.line || func->position.column != copy->position.column
+			|| !sameBlock(func->body, copy->body.get())) {
+			return false;
+		}
+
+		for (uint32_t param = 0; param < func->paramCount; param++) {
+			if (!sameType(func->params[param].type, copy->params[param].type) || !sameName(func->params[param].name, copy->params[param].name)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * Checks that every token of the image matches what `getToken()` hands out for the
+ * file the lexer was initialized with, that identifiers have the same text, and that
+ * the part of the value a token does not use is zero.
+ * @param image Image of the file.
+ * @returns Number of tokens checked, or -1 if any differ.
+ */
+static long checkTokens(const SyntaxImage &image) {
+	Token token;
+	Token copy;
+	size_t idx = 0;
+
+	do {
+		getToken(&token);
+		if (idx == image.getTokenCount()) {
+			return -1;
+		}
+		image.getToken(idx++, &copy);
+
+		if (token.type != copy.type || token.flags != copy.flags || token.offset != copy.offset || token.length != copy.length
+			|| token.position.line != copy.position.line || token.position.column != copy.position.column
+			|| memcmp(&token.dvalue, &copy.dvalue, sizeof(token.dvalue)) != 0) {
+			return -1;
+		}
+		if (token.type == TOK_ID && getSymbols().getText(token.symbol) != image.getSymbolText(copy.symbol)) {
+			return -1;
+		}
+
+		// Only decimals fill the whole value, so that images of the same text are the same
+		uint64_t value;
+		memcpy(&value, &copy.dvalue, sizeof(value));
+		if (copy.type != TOK_DEC && (value >> 32) != 0) {
+			return -1;
+		}
+	} while (token.type != TOK_EOF);
+
+	return (idx == image.getTokenCount()) ? static_cast<long>(idx) : -1;
+}
+
+/**
+ * Returns the time since a point, in microseconds.
+ * @param start Point to measure from.
+ * @returns Time since the point.
+ */
+static double since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+	const int rounds = (argc > 1) ? atoi(argv[1]) : 100;
+
+	std::vector<std::string> paths(argv + std::min(argc, 2), argv + argc);
+	if (paths.empty()) {
+		std::error_code error;
+		for (const auto &entry : std::filesystem::directory_iterator("examples", error)) {
+			if (entry.path().extension() == ".dm") {
+				paths.push_back(entry.path().string());
+			}
+		}
+		std::sort(paths.begin(), paths.end());
+	}
+	if (paths.empty()) {
+		fprintf(stderr, "No source files given, and none in examples/\n");
+		return 2;
+	}
+
+	const std::string imagePath = (std::filesystem::temp_directory_path() / "image_bench.dmi").string();
+	int failures = 0;
+
+	printf("%-24s %8s %10s %10s %12s %12s\n", "file", "tokens", "source", "image", "lex+parse", "map+walk");
+	for (const std::string &path : paths) {
+		sname = path;
+
+		// Write the image of the file, then read it back against a second pass of the lexer
+		if (!init(path.c_str())) {
+			fprintf(stderr, "%s: could not be opened\n", path.c_str());
+			failures++;
+			continue;
+		}
+		Arena arena;
+		Parser parser(getTokens(), arena, sname, getDiagnostics());
+		Program *program = parser.parse();
+		std::string data = writeImage(getSource(), getSourceSize(), getTokens(), getSymbols(), program);
+		size_t sourceSize = getSourceSize();
+
+		std::ofstream(imagePath, std::ios::binary).write(data.data(), static_cast<std::streamsize>(data.size()));
+
+		SyntaxImage image;
+		if (!image.open(imagePath.c_str())) {
+			fprintf(stderr, "%s: image could not be opened\n", path.c_str());
+			failures++;
+			close();
+			continue;
+		}
+
+		long tokens = checkTokens(image);
+		bool same = tokens >= 0 && image.getSource() == std::string_view(getSource(), getSourceSize())
+			&& sameProgram(program, image.getProgram());
+		close();
+
+		// Errors are part of the round trip (their tokens are dropped), but are only shown once,
+		// and the count is reset so that later files are not cut short by --max-errors
+		getDiagnostics().flush();
+		getDiagnostics().clear();
+		if (!same) {
+			fprintf(stderr, "%s: image differs from the lexer and parser\n", path.c_str());
+			failures++;
+			continue;
+		}
+
+		// Lexing and parsing again is what an image saves
+		auto start = std::chrono::steady_clock::now();
+		for (int round = 0; round < rounds; round++) {
+			init(path.c_str());
+			Arena scratch;
+			Parser again(getTokens(), scratch, sname, getDiagnostics());
+			again.parse();
+			close();
+			getDiagnostics().clear();
+		}
+		double parsed = since(start) / rounds;
+
+		start = std::chrono::steady_clock::now();
+		for (int round = 0; round < rounds; round++) {
+			SyntaxImage mapped;
+			mapped.open(imagePath.c_str());
+			Token token;
+			for (size_t idx = 0; idx < mapped.getTokenCount(); idx++) {
+				mapped.getToken(idx, &token);
+				sink = sink + token.offset;
+			}
+			sink = sink + mapped.getProgram()->funcs.size();
+		}
+		double mapped = since(start) / rounds;
+
+		printf("%-24s %8ld %10zu %10zu %9.1f us %9.1f us\n", path.c_str(), tokens, sourceSize, data.size(), parsed, mapped);
+	}
+
+	std::error_code error;
+	std::filesystem::remove(imagePath, error);
+
+	if (failures > 0) {
+		fprintf(stderr, "%d of %zu files failed the round trip\n", failures, paths.size());
+		return 1;
+	}
+	printf("%zu files match getToken() and the parser after the round trip\n", paths.size());
+	return 0;
+}
@@ -0,0 +1,245 @@
+/**
+ * @file       incremental_bench.cpp
+ * @brief      Benchmark for updating the tokens and syntax tree of an edited file
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ *
+ * Replays edits an editor would send on a generated file of 100k lines by default:
+ * typing and deleting a character inside a function, breaking and joining a line, and
+ * commenting a line out with a nested comment and back in. Every edit is timed through
+ * `Document::edit()`, and compared against lexing and parsing the whole file again.
+ * Moving the syntax tree after a line was broken or joined is timed on its own, since
+ * it is left until the tree is asked for.
+ * The final document is checked against one built from scratch out of the same text.
+ *
+ *   incremental_bench [lines] [rounds]
+ *
+ * g++ -std=c++17 -O2 -pthread -I dium/src bench/incremental_bench.cpp $(find dium/src -name '*.cpp' ! -name main.cpp) -ldl
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "document.hpp"
+
+std::string sname;
+
+/* Kinds of edits that are replayed */
+enum EditKind {
+	EDIT_TYPE,     /* insert or delete a character in a name */
+	EDIT_LINE,     /* break a line in two or join it back */
+	EDIT_COMMENT,  /* open or close a nested comment around a line */
+	EDIT_TREE,     /* move the syntax tree down after a line was broken */
+	EDIT_KINDS
+};
+
+static const char *editNames[EDIT_KINDS] = { "type/delete", "break/join line", "comment line", "tree after break" };
+
+/**
+ * Generates a source file made of many small functions.
+ * @param lines Number of lines to generate, roughly.
+ * @param[out] starts Offset of the first statement of each function.
+ * @returns Source text.
+ */
+static std::string generate(int lines, std::vector<uint32_t> *starts) {
+	std::string text;
+	int func = 0;
+
+	while (lines > 0) {
+		text += "/- helper " + std::to_string(func) + " /- nested -/ -/\n";
+		text += "func f" + std::to_string(func) + "(num a, num b) => num {\n";
+		starts->push_back(static_cast<uint32_t>(text.size()));
+		text += "\tnum total = a * 2 + b\n";
+		text += "\tfor num i in range(0, b) {\n";
+		text += "\t\ttotal = total + i % 3 // running sum\n";
+		text += "\t}\n";
+		text += "\tif total > 100 {\n";
+		text += "\t\tprintln(\"big\")\n";
+		text += "\t} else {\n";
+		text += "\t\ttotal = total - 1\n";
+		text += "\t}\n";
+		text += "\treturn total\n";
+		text += "}\n\n";
+		lines -= 14;
+		func++;
+	}
+
+	text += "func main() => void {\n\tprintln(f0(1, 2))\n}\n";
+	return text;
+}
+
+/**
+ * Times a single edit.
+ * @param doc Document to edit.
+ * @param offset Offset of the first character replaced.
+ * @param removed Number of characters replaced.
+ * @param inserted Text put in their place.
+ * @returns Time taken in microseconds.
+ */
+static double timeEdit(Document *doc, uint32_t offset, uint32_t removed, const std::string &inserted) {
+	auto start = std::chrono::steady_clock::now();
+	doc->edit(offset, removed, inserted);
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Times bringing the syntax tree up to date after an edit.
+ * @param doc Document that was edited.
+ * @returns Time taken in microseconds.
+ */
+static double timeTree(Document *doc) {
+	auto start = std::chrono::steady_clock::now();
+	doc->getProgram();
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Returns a percentile of a list of times.
+ * @param times Times to look at, which get sorted.
+ * @param percent Percentile to return.
+ * @returns Time at the percentile.
+ */
+static double percentile(std::vector<double> *times, double percent) {
+	std::sort(times->begin(), times->end());
+	size_t idx = static_cast<size_t>(percent / 100.0 * static_cast<double>(times->size() - 1) + 0.5);
+	return (*times)[idx];
+}
+
+/**
+ * Checks that two documents hold the same tokens, errors and syntax trees.
+ * @param a First document.
+ * @param b Second document.
+ * @returns `true` if they agree.
+ */
+static bool sameDocument(Document &a, Document &b) {
+	const TokenStream &x = a.getTokens();
+	const TokenStream &y = b.getTokens();
+
+	if (x.types != y.types || x.flags != y.flags || x.offsets != y.offsets || x.lengths != y.lengths || x.values.size() != y.values.size()) {
+		return false;
+	}
+	for (size_t idx = 0; idx < x.size(); idx++) {
+		if (x.positions[idx].line != y.positions[idx].line || x.positions[idx].column != y.positions[idx].column) {
+			return false;
+		}
+	}
+
+	std::vector<Diagnostic> errorsA = a.getDiagnostics();
+	std::vector<Diagnostic> errorsB = b.getDiagnostics();
+	if (errorsA.size() != errorsB.size()) {
+		return false;
+	}
+	for (size_t idx = 0; idx < errorsA.size(); idx++) {
+		if (errorsA[idx].message != errorsB[idx].message || errorsA[idx].position.line != errorsB[idx].position.line
+			|| errorsA[idx].position.column != errorsB[idx].position.column) {
+			return false;
+		}
+	}
+
+	const Program *progA = a.getProgram();
+	const Program *progB = b.getProgram();
+	if (progA->count != progB->count) {
+		return false;
+	}
+	for (uint32_t idx = 0; idx < progA->count; idx++) {
+		if (progA->funcs[idx]->position.line != progB->funcs[idx]->position.line
+			|| progA->funcs[idx]->body->position.line != progB->funcs[idx]->body->position.line) {
+			return false;
+		}
+	}
+	return printProgram(progA) == printProgram(progB);
+}
+
+/**
+ * Reads a positive count from the command line.
+ * @param text Argument to read.
+ * @param[out] count Count read.
+ * @returns `true` if the whole argument is a number above 0, `false` otherwise.
+ */
+static bool parseCount(const char *text, int *count) {
+	char *end;
+	long value = strtol(text, &end, 10);
+	if (end == text || *end != '\0' || value <= 0 || value > 100000000) {
+		return false;
+	}
+	*count = static_cast<int>(value);
+	return true;
+}
+
+int main(int argc, char *argv[]) {
+	int lines = 100000;
+	int rounds = 200;
+
+	if (argc > 3 || (argc > 1 && !parseCount(argv[1], &lines)) || (argc > 2 && !parseCount(argv[2], &rounds))) {
+		fprintf(stderr, "Usage: incremental_bench [lines] [rounds]\n"
+			"  lines    size of the generated file (default 100000)\n"
+			"  rounds   edits of each kind to replay (default 200)\n");
+		return 2;
+	}
+
+	std::vector<uint32_t> starts;
+	std::string text = generate(lines, &starts);
+
+	auto start = std::chrono::steady_clock::now();
+	Document doc("bench.dm", text);
+	double full = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+	std::mt19937 rng(42);
+	std::vector<double> times[EDIT_KINDS];
+	uint64_t tokensLexed = 0;
+	uint64_t funcsParsed = 0;
+	int edits = 0;
+
+	// Every edit is undone right after, so the offsets of the generated text stay valid
+	for (int round = 0; round < rounds; round++) {
+		uint32_t stmt = starts[rng() % starts.size()];
+
+		// Type an extra character at the end of `total`, then delete it
+		uint32_t name = stmt + static_cast<uint32_t>(std::string("\tnum total").size());
+		times[EDIT_TYPE].push_back(timeEdit(&doc, name, 0, "s"));
+		tokensLexed += doc.getLastEdit().tokensLexed;
+		funcsParsed += doc.getLastEdit().funcsParsed;
+		times[EDIT_TYPE].push_back(timeEdit(&doc, name, 1, ""));
+
+		// Break the line before `+ b`, then join it again
+		uint32_t plus = stmt + static_cast<uint32_t>(std::string("\tnum total = a * 2").size());
+		times[EDIT_LINE].push_back(timeEdit(&doc, plus, 0, "\n\t\t"));
+		times[EDIT_TREE].push_back(timeTree(&doc));
+		times[EDIT_LINE].push_back(timeEdit(&doc, plus, 3, ""));
+		times[EDIT_TREE].push_back(timeTree(&doc));
+
+		// Comment the first statement out, closing the comment first so the rest of the
+		// file does not disappear into it, then take the comment out again
+		uint32_t end = stmt + static_cast<uint32_t>(std::string("\tnum total = a * 2 + b").size());
+		times[EDIT_COMMENT].push_back(timeEdit(&doc, end, 0, " -/"));
+		times[EDIT_COMMENT].push_back(timeEdit(&doc, stmt + 1, 0, "/- "));
+		times[EDIT_COMMENT].push_back(timeEdit(&doc, stmt + 1, 3, ""));
+		times[EDIT_COMMENT].push_back(timeEdit(&doc, end, 3, ""));
+		edits += 8;
+	}
+
+	Document fresh("bench.dm", doc.getText());
+	if (doc.getText() != text || !sameDocument(doc, fresh)) {
+		fprintf(stderr, "Edited document differs from one built from scratch\n");
+		return 1;
+	}
+
+	printf("lines:            %d (%zu bytes, %zu tokens, %u functions)\n", lines, text.size(), doc.getTokens().size(),
+		doc.getProgram()->count);
+	printf("full lex+parse:   %.0f us\n", full);
+	for (int kind = 0; kind < EDIT_KINDS; kind++) {
+		double p50 = percentile(&times[kind], 50.0);
+		double p99 = percentile(&times[kind], 99.0);
+		printf("%-17s p50 %.1f us, p99 %.1f us, max %.1f us\n", (std::string(editNames[kind]) + ":").c_str(), p50, p99,
+			times[kind].back());
+	}
+	printf("typing relexed:   %.1f tokens, reparsed %.1f functions per edit\n",
+		static_cast<double>(tokensLexed) / rounds, static_cast<double>(funcsParsed) / rounds);
+	printf("edits:            %d, document matches a fresh parse\n", edits);
+	return 0;
+}
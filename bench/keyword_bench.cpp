@@ -0,0 +1,134 @@
+/**
+ * @file       keyword_bench.cpp
+ * @brief      Microbenchmark for classifying words as reserved words or identifiers
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ *
+ * Compares `lookupWord()` against the previous approach of building a std::string one
+ * character at a time and binary-searching a table of std::string reserved words.
+ *
+ * g++ -std=c++17 -O2 -pthread -I dium/src bench/keyword_bench.cpp $(find dium/src -name '*.cpp' ! -name main.cpp) -ldl
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "lexer.hpp"
+
+std::string sname;
+
+/* Reserved words as they were stored before the perfect hash */
+struct LegacyWord {
+	std::string word;
+	TokenType   type;
+};
+
+static LegacyWord legacyWords[] = {
+	{ "and", TOK_AND }, { "bool", TOK_BOOL }, { "break", TOK_BREAK }, { "char", TOK_CHAR },
+	{ "continue", TOK_CONTINUE }, { "dec", TOK_DEC }, { "else", TOK_ELSE }, { "elsif", TOK_ELSIF },
+	{ "exit", TOK_EXIT }, { "false", TOK_FALSE }, { "for", TOK_FOR }, { "func", TOK_FUNC },
+	{ "if", TOK_IF }, { "in", TOK_IN }, { "num", TOK_NUM }, { "or", TOK_OR },
+	{ "print", TOK_PRINT }, { "println", TOK_PRINTLN }, { "range", TOK_RANGE }, { "return", TOK_RETURN },
+	{ "string", TOK_STR }, { "true", TOK_TRUE }, { "void", TOK_VOID }, { "while", TOK_WHILE }
+};
+
+/**
+ * Classifies a word the way the lexer used to.
+ * @param text First character of the word.
+ * @param length Number of characters in the word.
+ * @returns Token type of the word.
+ */
+static TokenType legacyLookup(const char *text, size_t length) {
+	std::string word = "";
+	for (size_t idx = 0; idx < length; idx++) {
+		word += text[idx];
+	}
+
+	int low = 0;
+	int high = sizeof(legacyWords) / sizeof(legacyWords[0]) - 1;
+
+	while (low <= high) {
+		int mid = (low + high) / 2;
+		int cmp = word.compare(legacyWords[mid].word);
+
+		if (cmp < 0) {
+			high = mid - 1;
+		} else if (cmp > 0) {
+			low = mid + 1;
+		} else {
+			return legacyWords[mid].type;
+		}
+	}
+
+	return TOK_ID;
+}
+
+/**
+ * Times a classifier over all words.
+ * @param lookup Classifier to time.
+ * @param words Words to classify.
+ * @param rounds Number of passes over the words.
+ * @param[out] checksum Sum of all token types, so the work cannot be optimised away.
+ * @returns Nanoseconds per word.
+ */
+template <typename Lookup>
+static double timeLookup(Lookup lookup, const std::vector<std::string> &words, int rounds, long *checksum) {
+	auto start = std::chrono::steady_clock::now();
+	long sum = 0;
+
+	for (int round = 0; round < rounds; round++) {
+		for (const std::string &word : words) {
+			sum += lookup(word.data(), word.size());
+		}
+	}
+
+	auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	*checksum = sum;
+	return elapsed / (static_cast<double>(words.size()) * rounds);
+}
+
+int main(int argc, char *argv[]) {
+	const int count = (argc > 1) ? atoi(argv[1]) : 1000000;
+	const int rounds = 5;
+
+	// Identifier-heavy mix: roughly one word in five is reserved
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<int> letter('a', 'z');
+	std::uniform_int_distribution<int> size(1, 12);
+	std::uniform_int_distribution<int> pick(0, 4);
+	std::vector<std::string> words;
+	words.reserve(count);
+
+	for (int idx = 0; idx < count; idx++) {
+		if (pick(rng) == 0) {
+			words.push_back(legacyWords[rng() % (sizeof(legacyWords) / sizeof(legacyWords[0]))].word);
+			continue;
+		}
+
+		std::string word;
+		for (int len = size(rng); len > 0; len--) {
+			word += static_cast<char>(letter(rng));
+		}
+		words.push_back(word);
+	}
+
+	long legacySum = 0;
+	long hashSum = 0;
+	double legacy = timeLookup(legacyLookup, words, rounds, &legacySum);
+	double hashed = timeLookup(lookupWord, words, rounds, &hashSum);
+
+	if (legacySum != hashSum) {
+		fprintf(stderr, "Classifiers disagree (%ld vs %ld)\n", legacySum, hashSum);
+		return 1;
+	}
+
+	printf("words:          %d\n", count);
+	printf("binary search:  %.2f ns/word\n", legacy);
+	printf("perfect hash:   %.2f ns/word\n", hashed);
+	printf("speedup:        %.1fx\n", legacy / hashed);
+	return 0;
+}
@@ -0,0 +1,279 @@
+/**
+ * @file       lsp_bench.cpp
+ * @brief      Benchmark for the latency of the language server
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ *
+ * Replays an editing session through `LanguageServer::handle()` and reports the time
+ * taken by each kind of request. The session is either a file recorded with
+ * `dium lsp --record=<file>`, or by default one made up on a generated file of 100k
+ * lines: typing a new statement one character at a time with a completion request after
+ * each character, jumping to the declarations of a parameter and a variable, deleting
+ * the statement again, and asking for the semantic tokens of the file every 10 rounds.
+ * The generated session can be written out with `--write=<file>` to be replayed later.
+ *
+ * g++ -std=c++17 -O2 -pthread -I dium/src bench/lsp_bench.cpp $(find dium/src -name '*.cpp' ! -name main.cpp) -ldl
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "format.hpp"
+#include "lsp.hpp"
+
+std::string sname;
+
+/* URI of the generated file */
+#define BENCH_URI "file:///bench.dm"
+
+/**
+ * Generates a source file made of many small functions, 14 lines each.
+ * @param lines Number of lines to generate, roughly.
+ * @param[out] funcs Number of functions generated.
+ * @returns Source text.
+ */
+static std::string generate(int lines, int *funcs) {
+	std::string text;
+	int func = 0;
+
+	while (lines > 0) {
+		text += "/- helper " + std::to_string(func) + " /- nested -/ -/\n";
+		text += "func f" + std::to_string(func) + "(num a, num b) => num {\n";
+		text += "\tnum total = a * 2 + b\n";
+		text += "\tfor num i in range(0, b) {\n";
+		text += "\t\ttotal = total + i % 3 // running sum\n";
+		text += "\t}\n";
+		text += "\tif total > 100 {\n";
+		text += "\t\tprintln(\"big\")\n";
+		text += "\t} else {\n";
+		text += "\t\ttotal = total - 1\n";
+		text += "\t}\n";
+		text += "\treturn total\n";
+		text += "}\n\n";
+		lines -= 14;
+		func++;
+	}
+
+	*funcs = func;
+	text += "func main() => void {\n\tprintln(f0(1, 2))\n}\n";
+	return text;
+}
+
+/**
+ * Appends a message with its header, the way the client sends it.
+ * @param session Session to append to.
+ * @param body Content of the message.
+ */
+static void addMessage(std::string *session, const std::string &body) {
+	appendFormat(session, "Content-Length: %zu\r\n\r\n", body.size());
+	*session += body;
+}
+
+/**
+ * Appends a change that replaces a range of the generated file.
+ * @param session Session to append to.
+ * @param version Version of the file after the change.
+ * @param line Line of the start of the range.
+ * @param character Column of the start of the range.
+ * @param endLine Line of the end of the range.
+ * @param endCharacter Column of the end of the range.
+ * @param text Text put in its place.
+ */
+static void addChange(std::string *session, int version, int line, int character, int endLine, int endCharacter, const std::string &text) {
+	std::string body = customFormat("{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didChange\",\"params\":{\"textDocument\":"
+		"{\"uri\":\"" BENCH_URI "\",\"version\":%d},\"contentChanges\":[{\"range\":{\"start\":{\"line\":%d,\"character\":%d},"
+		"\"end\":{\"line\":%d,\"character\":%d}},\"text\":", version, line, character, endLine, endCharacter);
+	appendJsonString(&body, text);
+	body += "}]}}";
+	addMessage(session, body);
+}
+
+/**
+ * Appends a request about a position of the generated file.
+ * @param session Session to append to.
+ * @param id Id of the request.
+ * @param method Method of the request.
+ * @param line Line of the position.
+ * @param character Column of the position.
+ */
+static void addRequest(std::string *session, int id, const char *method, int line, int character) {
+	addMessage(session, customFormat("{\"jsonrpc\":\"2.0\",\"id\":%d,\"method\":\"%s\",\"params\":{\"textDocument\":{\"uri\":\"" BENCH_URI
+		"\"},\"position\":{\"line\":%d,\"character\":%d}}}", id, method, line, character));
+}
+
+/**
+ * Makes up an editing session on a generated file.
+ * @param lines Number of lines of the file.
+ * @param rounds Number of statements typed and deleted.
+ * @returns Messages of the client, with their headers.
+ */
+static std::string makeSession(int lines, int rounds) {
+	int funcs;
+	std::string text = generate(lines, &funcs);
+	std::string session;
+	int id = 1;
+	int version = 1;
+
+	addMessage(&session, "{\"jsonrpc\":\"2.0\",\"id\":0,\"method\":\"initialize\",\"params\":{\"capabilities\":{\"general\":"
+		"{\"positionEncodings\":[\"utf-8\"]}}}}");
+	addMessage(&session, "{\"jsonrpc\":\"2.0\",\"method\":\"initialized\",\"params\":{}}");
+
+	std::string open = "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didOpen\",\"params\":{\"textDocument\":{\"uri\":\"" BENCH_URI
+		"\",\"languageId\":\"dium\",\"version\":1,\"text\":";
+	appendJsonString(&open, text);
+	open += "}}}";
+	addMessage(&session, open);
+
+	const std::string semantic = "\",\"method\":\"textDocument/semanticTokens/full\",\"params\":{\"textDocument\":{\"uri\":\"" BENCH_URI "\"}}}";
+	addMessage(&session, "{\"jsonrpc\":\"2.0\",\"id\":\"" + std::to_string(id++) + semantic);
+
+	std::mt19937 rng(42);
+	const int statement = static_cast<int>(std::string("\tnum total = a * 2 + b").size());
+
+	for (int round = 0; round < rounds; round++) {
+		// Lines of the function are counted from 0, as the protocol does
+		int line = 14 * static_cast<int>(rng() % static_cast<unsigned int>(funcs)) + 2;
+
+		// Start a new line after the first statement and type `tot` into it
+		addChange(&session, ++version, line, statement, line, statement, "\n\t");
+		const char *typed = "tot";
+		for (int idx = 0; typed[idx] != '\0'; idx++) {
+			addChange(&session, ++version, line + 1, 1 + idx, line + 1, 1 + idx, std::string(1, typed[idx]));
+			addRequest(&session, id++, "textDocument/completion", line + 1, 2 + idx);
+		}
+
+		// Jump from `b` in the loop to the parameter, and from `total` to the variable
+		addRequest(&session, id++, "textDocument/definition", line + 2, 23);
+		addRequest(&session, id++, "textDocument/definition", line + 3, 2);
+
+		// Take the new line out again
+		addChange(&session, ++version, line, statement, line + 1, 4, "");
+
+		if (round % 10 == 9) {
+			addMessage(&session, "{\"jsonrpc\":\"2.0\",\"id\":\"" + std::to_string(id++) + semantic);
+		}
+	}
+
+	addMessage(&session, "{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(id++) + ",\"method\":\"shutdown\"}");
+	addMessage(&session, "{\"jsonrpc\":\"2.0\",\"method\":\"exit\"}");
+	return session;
+}
+
+/**
+ * Splits a recorded session into its messages.
+ * @param session Messages with their headers.
+ * @returns Content of each message.
+ */
+static std::vector<std::string> splitSession(const std::string &session) {
+	std::vector<std::string> messages;
+	size_t pos = 0;
+
+	while (true) {
+		size_t header = session.find("Content-Length:", pos);
+		size_t start = session.find("\r\n\r\n", header);
+		if (header == std::string::npos || start == std::string::npos) {
+			break;
+		}
+
+		size_t length = strtoull(session.c_str() + header + 15, nullptr, 10);
+		start += 4;
+		if (start + length > session.size()) {
+			break;
+		}
+
+		messages.push_back(session.substr(start, length));
+		pos = start + length;
+	}
+	return messages;
+}
+
+/**
+ * Returns a percentile of a list of times.
+ * @param times Times to look at, sorted.
+ * @param percent Percentile to return.
+ * @returns Time at the percentile.
+ */
+static double percentile(const std::vector<double> &times, double percent) {
+	size_t idx = static_cast<size_t>(percent / 100.0 * static_cast<double>(times.size() - 1) + 0.5);
+	return times[idx];
+}
+
+int main(int argc, char *argv[]) {
+	const char *sessionPath = nullptr;
+	const char *writePath = nullptr;
+	int lines = 100000;
+	int rounds = 200;
+
+	for (int arg = 1; arg < argc; arg++) {
+		if (strncmp(argv[arg], "--write=", 8) == 0) {
+			writePath = argv[arg] + 8;
+		} else if (strncmp(argv[arg], "--lines=", 8) == 0) {
+			lines = atoi(argv[arg] + 8);
+		} else if (strncmp(argv[arg], "--rounds=", 9) == 0) {
+			rounds = atoi(argv[arg] + 9);
+		} else {
+			sessionPath = argv[arg];
+		}
+	}
+
+	std::string session;
+	if (sessionPath != nullptr) {
+		std::ifstream file(sessionPath, std::ios::binary);
+		if (!file) {
+			fprintf(stderr, "Session '%s' could not be opened\n", sessionPath);
+			return 1;
+		}
+		std::stringstream contents;
+		contents << file.rdbuf();
+		session = contents.str();
+	} else {
+		session = makeSession(lines, rounds);
+	}
+
+	if (writePath != nullptr) {
+		std::ofstream file(writePath, std::ios::binary);
+		file << session;
+	}
+
+	std::vector<std::string> messages = splitSession(session);
+	std::map<std::string, std::vector<double>> times;
+	LanguageServer server;
+	std::string out;
+	size_t sent = 0;
+
+	for (const std::string &message : messages) {
+		// Only the method is needed, and reading it is not part of the time taken
+		JsonValue request;
+		parseJson(message, &request);
+		std::string method = request["method"].string;
+
+		out.clear();
+		auto start = std::chrono::steady_clock::now();
+		bool running = server.handle(message, &out);
+		times[method].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+		sent += out.size();
+
+		if (!running) {
+			break;
+		}
+	}
+
+	printf("session:          %s (%zu messages, %zu bytes in, %zu bytes out)\n", (sessionPath != nullptr) ? sessionPath : "generated",
+		messages.size(), session.size(), sent);
+	for (auto &entry : times) {
+		std::vector<double> &list = entry.second;
+		std::sort(list.begin(), list.end());
+		printf("%-34s %5zu x  p50 %9.1f us, p99 %9.1f us, max %9.1f us\n", (entry.first + ":").c_str(), list.size(),
+			percentile(list, 50.0), percentile(list, 99.0), list.back());
+	}
+	return 0;
+}
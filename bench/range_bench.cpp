@@ -0,0 +1,195 @@
+/**
+ * @file       range_bench.cpp
+ * @brief      Microbenchmark for the ways of running a `for` loop over a range
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ *
+ * Compares the counted loop that RANGE and FORITER run, with its state in registers,
+ * against a generic iterator protocol: an iterator object allocated for every loop and
+ * asked for each value through a virtual call, as a language with user-defined
+ * iterators would do. The ranges mix lengths, starts and steps like nested loops do.
+ *
+ * g++ -std=c++17 -O2 bench/range_bench.cpp
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+#ifdef _MSC_VER
+#define NOINLINE __declspec(noinline)
+#else
+#define NOINLINE __attribute__((noinline))
+#endif
+
+/* Bounds of one loop */
+struct Bounds {
+	int64_t start;
+	int64_t stop;
+	int64_t step;
+};
+
+/* Generic iterator protocol */
+class Iterator {
+public:
+	virtual ~Iterator() = default;
+
+	/**
+	 * Produces the next value.
+	 * @param[out] value Next value.
+	 * @returns `false` when there are no values left.
+	 */
+	virtual bool next(int64_t *value) = 0;
+};
+
+/* Iterator over a range, which checks the bound and clamps every step */
+class RangeIterator : public Iterator {
+public:
+	RangeIterator(int64_t start, int64_t stop, int64_t step)
+		: current{ start }, stop{ stop }, step{ step } {}
+
+	bool next(int64_t *value) override {
+		if ((step > 0) ? (current >= stop) : (current <= stop)) {
+			return false;
+		}
+		*value = current;
+
+		uint64_t left = (step > 0) ? static_cast<uint64_t>(stop) - static_cast<uint64_t>(current) : static_cast<uint64_t>(current) - static_cast<uint64_t>(stop);
+		uint64_t size = (step > 0) ? static_cast<uint64_t>(step) : 0 - static_cast<uint64_t>(step);
+		current = (left <= size) ? stop : static_cast<int64_t>(static_cast<uint64_t>(current) + static_cast<uint64_t>(step));
+		return true;
+	}
+
+private:
+	int64_t current;
+	int64_t stop;
+	int64_t step;
+};
+
+/**
+ * Creates an iterator behind a call the compiler cannot see through, like the
+ * iterator a script asks an object for.
+ */
+NOINLINE static std::unique_ptr<Iterator> makeIterator(const Bounds &bounds) {
+	return std::make_unique<RangeIterator>(bounds.start, bounds.stop, bounds.step);
+}
+
+/**
+ * Sums the values of every range through the iterator protocol.
+ * @param ranges Ranges to loop over.
+ * @returns Sum of all values.
+ */
+static int64_t sumIterated(const std::vector<Bounds> &ranges) {
+	int64_t sum = 0;
+
+	for (const Bounds &bounds : ranges) {
+		std::unique_ptr<Iterator> iter = makeIterator(bounds);
+		int64_t value;
+
+		while (iter->next(&value)) {
+			sum += value;
+		}
+	}
+	return sum;
+}
+
+/**
+ * Sums the values of every range as counted loops, the way RANGE and FORITER do.
+ * @param ranges Ranges to loop over.
+ * @returns Sum of all values.
+ */
+static int64_t sumCounted(const std::vector<Bounds> &ranges) {
+	int64_t sum = 0;
+
+	for (const Bounds &bounds : ranges) {
+		// RANGE: the number of values, worked out once
+		uint64_t count = 0;
+		if (bounds.step > 0 && bounds.start < bounds.stop) {
+			count = (static_cast<uint64_t>(bounds.stop) - static_cast<uint64_t>(bounds.start) - 1) / static_cast<uint64_t>(bounds.step) + 1;
+		} else if (bounds.step < 0 && bounds.start > bounds.stop) {
+			count = (static_cast<uint64_t>(bounds.start) - static_cast<uint64_t>(bounds.stop) - 1) / (0 - static_cast<uint64_t>(bounds.step)) + 1;
+		}
+
+		// FORITER: one check per value
+		int64_t next = bounds.start;
+		for (; count != 0; count--) {
+			sum += next;
+			next = static_cast<int64_t>(static_cast<uint64_t>(next) + static_cast<uint64_t>(bounds.step));
+		}
+	}
+	return sum;
+}
+
+/**
+ * Times a way of looping over all ranges.
+ * @param run Function that loops over the ranges.
+ * @param ranges Ranges to loop over.
+ * @param values Number of values in all ranges.
+ * @param rounds Number of passes over the ranges.
+ * @param[out] checksum Sum of all values, so the work cannot be optimised away.
+ * @returns Nanoseconds per value.
+ */
+template <typename Run>
+static double timeLoops(Run run, const std::vector<Bounds> &ranges, int64_t values, int rounds, int64_t *checksum) {
+	auto start = std::chrono::steady_clock::now();
+	int64_t sum = 0;
+
+	for (int round = 0; round < rounds; round++) {
+		sum += run(ranges);
+	}
+
+	auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	*checksum = sum;
+	return elapsed / (static_cast<double>(values) * rounds);
+}
+
+int main(int argc, char *argv[]) {
+	const int count = (argc > 1) ? atoi(argv[1]) : 200000;
+	const int rounds = 5;
+
+	// Mostly short inner loops counting up, some counting down
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<int64_t> start(-100, 100);
+	std::uniform_int_distribution<int64_t> length(0, 64);
+	std::uniform_int_distribution<int64_t> step(1, 3);
+	std::uniform_int_distribution<int> down(0, 3);
+	std::vector<Bounds> ranges;
+	int64_t values = 0;
+	ranges.reserve(count);
+
+	for (int idx = 0; idx < count; idx++) {
+		Bounds bounds{ start(rng), 0, step(rng) };
+		int64_t size = length(rng);
+
+		if (down(rng) == 0) {
+			bounds.stop = bounds.start - size;
+			bounds.step = -bounds.step;
+		} else {
+			bounds.stop = bounds.start + size;
+		}
+
+		values += (size + ((bounds.step > 0) ? bounds.step : -bounds.step) - 1) / ((bounds.step > 0) ? bounds.step : -bounds.step);
+		ranges.push_back(bounds);
+	}
+
+	int64_t iteratedSum = 0;
+	int64_t countedSum = 0;
+	double iterated = timeLoops(sumIterated, ranges, values, rounds, &iteratedSum);
+	double counted = timeLoops(sumCounted, ranges, values, rounds, &countedSum);
+
+	if (iteratedSum != countedSum) {
+		fprintf(stderr, "Loops disagree (%lld vs %lld)\n", static_cast<long long>(iteratedSum), static_cast<long long>(countedSum));
+		return 1;
+	}
+
+	printf("loops:          %d (%lld values)\n", count, static_cast<long long>(values));
+	printf("iterator:       %.2f ns/value\n", iterated);
+	printf("counted loop:   %.2f ns/value\n", counted);
+	printf("speedup:        %.1fx\n", iterated / counted);
+	return 0;
+}
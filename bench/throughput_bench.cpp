@@ -0,0 +1,263 @@
+/**
+ * @file       throughput_bench.cpp
+ * @brief      Benchmark for the throughput of every stage on generated source files
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ *
+ * Generates a source file of each kind (see corpus.hpp) and times, on each of them:
+ *   read+lex   `init()` on the file written to disk, then `getToken()` up to the end
+ *   lex        `Lexer::tokenize()` on the text in memory
+ *   parse      `Parser::parse()` on those tokens
+ *   compile    checking, compiling and optimizing the syntax tree
+ *   vm         running the program, which calls every generated function once
+ * Each stage is run several times and the fastest run is reported, as MB of source
+ * and tokens per second (and instructions per second for the virtual machine).
+ * `--json=<file>` also writes the results as JSON, tagged with `--label=<name>`, so
+ * that runs of two versions can be compared.
+ *
+ *   throughput_bench [--size=<MB>] [--kind=<name>] [--repeat=<n>] [--seed=<n>] [--jit] [--json=<file>] [--label=<name>]
+ *
+ * g++ -std=c++17 -O2 -pthread -I dium/src -I bench bench/throughput_bench.cpp bench/corpus.cpp $(find dium/src -name '*.cpp' ! -name main.cpp)
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "arena.hpp"
+#include "checker.hpp"
+#include "compiler.hpp"
+#include "corpus.hpp"
+#include "diagnostics.hpp"
+#include "format.hpp"
+#include "json.hpp"
+#include "lexer.hpp"
+#include "optimizer.hpp"
+#include "output.hpp"
+#include "parser.hpp"
+#include "source.hpp"
+#include "vm.hpp"
+
+std::string sname;
+
+/* Stages that are timed */
+enum Stage {
+	STAGE_READ,
+	STAGE_LEX,
+	STAGE_PARSE,
+	STAGE_COMPILE,
+	STAGE_VM,
+	STAGES
+};
+
+static const char *stageNames[STAGES] = { "read+lex", "lex", "parse", "compile", "vm" };
+
+/* Best time of each stage on one source file */
+struct Result {
+	CorpusKind kind;
+	size_t bytes;
+	size_t tokens;
+	uint64_t instructions;
+	double seconds[STAGES];
+};
+
+/**
+ * Returns the time since a point in seconds.
+ * @param start Point to measure from.
+ * @returns Seconds elapsed.
+ */
+static double since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Times every stage on a single generated source file.
+ * @param kind Kind of source file.
+ * @param bytes Size of the source file.
+ * @param seed Seed of the generator.
+ * @param repeat Number of times each stage is run.
+ * @param jitMode When the virtual machine compiles functions to machine code.
+ * @returns Fastest time of each stage.
+ */
+static Result measure(CorpusKind kind, size_t bytes, uint32_t seed, int repeat, JitMode jitMode) {
+	std::string text = generateCorpus(kind, bytes, seed);
+	std::string path = std::string("throughput_") + getCorpusName(kind) + ".dm";
+	sname = path;
+
+	FILE *file = fopen(path.c_str(), "wb");
+	if (file == nullptr || fwrite(text.data(), 1, text.size(), file) != text.size() || fclose(file) != 0) {
+		fprintf(stderr, "File '%s' could not be written\n", path.c_str());
+		exit(1);
+	}
+
+	Result result{ kind, text.size(), 0, 0, {} };
+	for (double &seconds : result.seconds) {
+		seconds = 1e30;
+	}
+
+	for (int run = 0; run < repeat; run++) {
+		// What a run of `dium` does: read the file, then take the tokens one at a time
+		auto start = std::chrono::steady_clock::now();
+		init(path.c_str());
+		Token token;
+		size_t count = 0;
+		do {
+			getToken(&token);
+			count++;
+		} while (token.type != TOK_EOF);
+		close();
+		result.seconds[STAGE_READ] = std::min(result.seconds[STAGE_READ], since(start));
+		result.tokens = count;
+
+		SourceBuffer buffer;
+		if (!copySource(&buffer, text.data(), text.size())) {
+			fprintf(stderr, "File '%s' could not be copied\n", path.c_str());
+			exit(1);
+		}
+		Interner symbols;
+		Diagnostics diagnostics;
+
+		start = std::chrono::steady_clock::now();
+		Lexer lexer(buffer, path, symbols, diagnostics);
+		TokenStream tokens = lexer.tokenize();
+		result.seconds[STAGE_LEX] = std::min(result.seconds[STAGE_LEX], since(start));
+
+		Arena arena;
+		start = std::chrono::steady_clock::now();
+		Parser parser(tokens, arena, path, diagnostics);
+		Program *program = parser.parse();
+		result.seconds[STAGE_PARSE] = std::min(result.seconds[STAGE_PARSE], since(start));
+
+		if (diagnostics.flush()) {
+			fprintf(stderr, "Generated %s source does not parse\n", getCorpusName(kind));
+			exit(1);
+		}
+
+		start = std::chrono::steady_clock::now();
+		Checker checker(program, arena, path);
+		checker.check();
+		Compiler compiler(program, path);
+		Module module = compiler.compile();
+		Optimizer optimizer(module, OPT_FULL);
+		optimizer.optimize();
+		result.seconds[STAGE_COMPILE] = std::min(result.seconds[STAGE_COMPILE], since(start));
+
+		VM vm(module, jitMode);
+		start = std::chrono::steady_clock::now();
+		vm.run(true);
+		result.seconds[STAGE_VM] = std::min(result.seconds[STAGE_VM], since(start));
+		result.instructions = vm.getInstructionCount();
+
+		closeSource(&buffer);
+	}
+
+	std::remove(path.c_str());
+	return result;
+}
+
+/**
+ * Appends the results as a JSON document.
+ * @param out String to append to.
+ * @param label Name of the version measured.
+ * @param results Results of every source file.
+ * @param repeat Number of runs each time is the best of.
+ * @param seed Seed of the generator.
+ */
+static void appendResults(std::string *out, const std::string &label, const std::vector<Result> &results, int repeat, uint32_t seed) {
+	*out += "{\"label\":";
+	appendJsonString(out, label);
+	appendFormat(out, ",\"repeat\":%d,\"seed\":%u,\"corpora\":[", repeat, seed);
+
+	for (size_t idx = 0; idx < results.size(); idx++) {
+		const Result &result = results[idx];
+		double megabytes = static_cast<double>(result.bytes) / (1024.0 * 1024.0);
+
+		appendFormat(out, "%s{\"kind\":\"%s\",\"bytes\":%zu,\"tokens\":%zu,\"instructions\":%llu,\"stages\":{", (idx > 0) ? "," : "",
+			getCorpusName(result.kind), result.bytes, result.tokens, static_cast<unsigned long long>(result.instructions));
+
+		for (int stage = 0; stage < STAGES; stage++) {
+			double seconds = result.seconds[stage];
+			appendFormat(out, "%s\"%s\":{\"seconds\":%.6f,\"mb_per_s\":%.2f,\"tokens_per_s\":%.0f", (stage > 0) ? "," : "",
+				stageNames[stage], seconds, megabytes / seconds, static_cast<double>(result.tokens) / seconds);
+			if (stage == STAGE_VM) {
+				appendFormat(out, ",\"instructions_per_s\":%.0f", static_cast<double>(result.instructions) / seconds);
+			}
+			*out += '}';
+		}
+		*out += "}}";
+	}
+
+	*out += "]}\n";
+}
+
+int main(int argc, char *argv[]) {
+	double size = 8.0;
+	int repeat = 3;
+	uint32_t seed = 1;
+	JitMode jitMode = JIT_OFF;
+	const char *jsonPath = nullptr;
+	std::string label = "dev";
+	std::vector<CorpusKind> kinds;
+
+	for (int arg = 1; arg < argc; arg++) {
+		CorpusKind kind;
+		if (strncmp(argv[arg], "--size=", 7) == 0) {
+			size = atof(argv[arg] + 7);
+		} else if (strncmp(argv[arg], "--repeat=", 9) == 0) {
+			repeat = std::max(atoi(argv[arg] + 9), 1);
+		} else if (strncmp(argv[arg], "--seed=", 7) == 0) {
+			seed = static_cast<uint32_t>(strtoul(argv[arg] + 7, nullptr, 10));
+		} else if (strncmp(argv[arg], "--kind=", 7) == 0 && findCorpusKind(argv[arg] + 7, &kind)) {
+			kinds.push_back(kind);
+		} else if (strcmp(argv[arg], "--jit") == 0) {
+			jitMode = JIT_ON;
+		} else if (strncmp(argv[arg], "--json=", 7) == 0) {
+			jsonPath = argv[arg] + 7;
+		} else if (strncmp(argv[arg], "--label=", 8) == 0) {
+			label = argv[arg] + 8;
+		} else {
+			fprintf(stderr, "Unknown option '%s'\n", argv[arg]);
+			return 2;
+		}
+	}
+
+	if (kinds.empty()) {
+		for (int idx = 0; idx < CORPUS_KINDS; idx++) {
+			kinds.push_back(static_cast<CorpusKind>(idx));
+		}
+	}
+
+	std::vector<Result> results;
+	printf("%-12s %9s %10s  %-9s %10s %10s %12s\n", "corpus", "MB", "tokens", "stage", "ms", "MB/s", "Mtokens/s");
+
+	for (CorpusKind kind : kinds) {
+		Result result = measure(kind, static_cast<size_t>(size * 1024 * 1024), seed, repeat, jitMode);
+		results.push_back(result);
+
+		double megabytes = static_cast<double>(result.bytes) / (1024.0 * 1024.0);
+		for (int stage = 0; stage < STAGES; stage++) {
+			double seconds = result.seconds[stage];
+			printf("%-12s %9.2f %10zu  %-9s %10.2f %10.1f %12.2f", (stage == 0) ? getCorpusName(kind) : "", megabytes, result.tokens,
+				stageNames[stage], seconds * 1000.0, megabytes / seconds, static_cast<double>(result.tokens) / seconds / 1e6);
+			if (stage == STAGE_VM) {
+				printf("  (%.1f M instructions/s)", static_cast<double>(result.instructions) / seconds / 1e6);
+			}
+			printf("\n");
+		}
+	}
+
+	if (jsonPath != nullptr) {
+		std::string json;
+		appendResults(&json, label, results, repeat, seed);
+
+		FILE *file = fopen(jsonPath, "wb");
+		if (file == nullptr || fwrite(json.data(), 1, json.size(), file) != json.size() || fclose(file) != 0) {
+			fprintf(stderr, "File '%s' could not be written\n", jsonPath);
+			return 1;
+		}
+	}
+	return 0;
+}
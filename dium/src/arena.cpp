@@ -0,0 +1,68 @@
+/**
+ * @file       arena.cpp
+ * @brief      Implementation for the bump allocator used for syntax trees
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <cstdlib>
+#include "arena.hpp"
+
+
+Arena::~Arena() {
+	while (head != nullptr) {
+		Block *prev = head->prev;
+		free(head);
+		head = prev;
+	}
+}
+
+void Arena::reset() {
+	if (head == nullptr) {
+		return;
+	}
+
+	// Keep only the oldest block
+	while (head->prev != nullptr) {
+		Block *prev = head->prev;
+		reserved -= head->size;
+		blocks--;
+		free(head);
+		head = prev;
+	}
+
+	next = reinterpret_cast<char *>(head + 1);
+	end = reinterpret_cast<char *>(head) + head->size;
+	used = 0;
+}
+
+/**
+ * Allocates memory from a new block, used when the current block is full.
+ * @param size Number of bytes to allocate.
+ * @param align Alignment of the memory.
+ * @returns Pointer to the memory.
+ */
+void *Arena::allocateSlow(size_t size, size_t align) {
+	// Blocks double in size up to a limit, which bounds both the block count and the waste
+	size_t blockSize = ARENA_BLOCK_SIZE;
+	if (head != nullptr) {
+		blockSize = (head->size < ARENA_MAX_BLOCK_SIZE) ? head->size * 2 : ARENA_MAX_BLOCK_SIZE;
+	}
+
+	while (blockSize < sizeof(Block) + size + align) {
+		blockSize *= 2;
+	}
+
+	auto *block = static_cast<Block *>(malloc(blockSize));
+	block->prev = head;
+	block->size = blockSize;
+
+	head = block;
+	next = reinterpret_cast<char *>(block + 1);
+	end = reinterpret_cast<char *>(block) + blockSize;
+	reserved += blockSize;
+	blocks++;
+
+	return allocate(size, align);
+}
@@ -0,0 +1,149 @@
+/**
+ * @file       arena.hpp
+ * @brief      Definitions for the bump allocator used for syntax trees
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/** Size of the first block allocated by an arena */
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+/** Size that blocks stop doubling at */
+#define ARENA_MAX_BLOCK_SIZE (16 * 1024 * 1024)
+
+/**
+ * Bump allocator that hands out memory from large blocks and frees everything in one
+ * go. Destructors are never run, so only trivially destructible objects may live in it.
+ */
+class Arena {
+public:
+	Arena() = default;
+
+	/**
+	 * Frees all blocks.
+	 */
+	~Arena();
+
+	Arena(const Arena &) = delete;
+	Arena &operator=(const Arena &) = delete;
+
+	/**
+	 * Allocates uninitialised memory.
+	 * @param size Number of bytes to allocate.
+	 * @param align Alignment of the memory (a power of 2).
+	 * @returns Pointer to the memory.
+	 */
+	void *allocate(size_t size, size_t align) {
+		auto addr = reinterpret_cast<uintptr_t>(next);
+		uintptr_t aligned = (addr + align - 1) & ~static_cast<uintptr_t>(align - 1);
+
+		if (aligned + size > reinterpret_cast<uintptr_t>(end)) {
+			return allocateSlow(size, align);
+		}
+
+		next = reinterpret_cast<char *>(aligned + size);
+		used += size;
+		return reinterpret_cast<void *>(aligned);
+	}
+
+	/**
+	 * Constructs an object inside the arena.
+	 * @param args Arguments passed to the constructor.
+	 * @returns Pointer to the object.
+	 */
+	template <typename T, typename ...Args>
+	T *make(Args &&...args) {
+		static_assert(std::is_trivially_destructible<T>::value, "Arena objects are never destroyed");
+		return new (allocate(sizeof(T), alignof(T))) T{ std::forward<Args>(args)... };
+	}
+
+	/**
+	 * Copies an array into the arena.
+	 * @param items First item to copy.
+	 * @param count Number of items to copy.
+	 * @returns Pointer to the copy, or `nullptr` if there are no items.
+	 */
+	template <typename T>
+	T *copy(const T *items, size_t count) {
+		static_assert(std::is_trivially_copyable<T>::value, "Arena arrays are copied bytewise");
+		if (count == 0) {
+			return nullptr;
+		}
+
+		T *copied = static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+		for (size_t idx = 0; idx < count; idx++) {
+			copied[idx] = items[idx];
+		}
+		return copied;
+	}
+
+	/**
+	 * Frees everything allocated so far, keeping the first block for reuse.
+	 */
+	void reset();
+
+	/**
+	 * Returns the number of bytes handed out.
+	 * @returns Bytes allocated from the arena.
+	 */
+	size_t getBytesUsed() const {
+		return used;
+	}
+
+	/**
+	 * Returns the number of bytes reserved from the system.
+	 * @returns Total size of all blocks.
+	 */
+	size_t getBytesReserved() const {
+		return reserved;
+	}
+
+	/**
+	 * Returns the number of blocks reserved from the system.
+	 * @returns Number of blocks.
+	 */
+	size_t getBlockCount() const {
+		return blocks;
+	}
+
+private:
+	/* Header at the start of every block */
+	struct Block {
+		Block *prev;
+		size_t size;
+	};
+
+	/** Most recently allocated block */
+	Block *head = nullptr;
+
+	/** Next free byte in the current block */
+	char *next = nullptr;
+
+	/** One past the last byte of the current block */
+	char *end = nullptr;
+
+	/** Number of bytes handed out */
+	size_t used = 0;
+
+	/** Number of bytes reserved in blocks */
+	size_t reserved = 0;
+
+	/** Number of blocks */
+	size_t blocks = 0;
+
+	void *allocateSlow(size_t size, size_t align);
+};
+
+#endif // ARENA_HPP
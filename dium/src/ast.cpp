@@ -0,0 +1,274 @@
+/**
+ * @file       ast.cpp
+ * @brief      Implementation for printing the abstract syntax tree
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <vector>
+#include "ast.hpp"
+#include "error.hpp"
+
+// --------------- function prototypes -------------------------
+
+static void printExpr(std::string *out, const Expr *expr);
+static void printStmt(std::string *out, const Stmt *stmt, int indent);
+
+/* Names of the basic types */
+static const char *typeNames[] = { "void", "bool", "char", "num", "dec", "string" };
+
+
+std::string getTypeName(Type type) {
+	std::string name = typeNames[type.base];
+
+	for (int idx = 0; idx < type.rank; idx++) {
+		name += "[]";
+	}
+
+	return name;
+}
+
+std::string printProgram(const Program *program) {
+	std::string out;
+
+	for (uint32_t idx = 0; idx < program->count; idx++) {
+		const FuncDecl *func = program->funcs[idx];
+		out += "func " + std::string(func->name.text, func->name.length) + "(";
+
+		for (uint32_t param = 0; param < func->paramCount; param++) {
+			if (param > 0) {
+				out += ", ";
+			}
+
+			out += getTypeName(func->params[param].type) + " ";
+			out.append(func->params[param].name.text, func->params[param].name.length);
+		}
+
+		out += ") => " + getTypeName(func->returnType) + "\n";
+		printStmt(&out, func->body, 1);
+	}
+
+	return out;
+}
+
+/**
+ * Appends a name to the output.
+ * @param out Output to append to.
+ * @param name Name to append.
+ */
+static void printName(std::string *out, const Name &name) {
+	out->append(name.text, name.length);
+}
+
+/**
+ * Appends a comma-separated list of expressions to the output.
+ * @param out Output to append to.
+ * @param items Expressions to append.
+ * @param count Number of expressions.
+ */
+static void printList(std::string *out, Expr *const *items, uint32_t count) {
+	for (uint32_t idx = 0; idx < count; idx++) {
+		if (idx > 0) {
+			*out += ", ";
+		}
+		printExpr(out, items[idx]);
+	}
+}
+
+/**
+ * Appends an expression to the output, fully parenthesised.
+ * @param out Output to append to.
+ * @param expr Expression to append.
+ */
+void printExpr(std::string *out, const Expr *expr) {
+	switch (expr->kind) {
+	case EXPR_NUM:
+		*out += std::to_string(static_cast<const NumExpr *>(expr)->value);
+		break;
+	case EXPR_DEC:
+		appendFormat(out, "%g", static_cast<const DecExpr *>(expr)->value);
+		break;
+	case EXPR_BOOL:
+		*out += static_cast<const BoolExpr *>(expr)->value ? "true" : "false";
+		break;
+	case EXPR_CHAR:
+		appendFormat(out, "'%c'", static_cast<const CharExpr *>(expr)->value);
+		break;
+	case EXPR_STR: {
+		auto str = static_cast<const StrExpr *>(expr);
+		*out += "\"" + std::string(str->text, str->length) + "\"";
+		break;
+	}
+	case EXPR_NAME:
+		printName(out, static_cast<const NameExpr *>(expr)->name);
+		break;
+	case EXPR_ARRAY: {
+		auto array = static_cast<const ArrayExpr *>(expr);
+		*out += "[";
+		printList(out, array->items, array->count);
+		*out += "]";
+		break;
+	}
+	case EXPR_UNARY: {
+		auto unary = static_cast<const UnaryExpr *>(expr);
+		*out += (unary->op == TOK_MINUS) ? "(-" : "(!";
+		printExpr(out, unary->operand);
+		*out += ")";
+		break;
+	}
+	case EXPR_BINARY: {
+		// Chains such as long sums nest through their left operands, which are printed in a loop
+		std::vector<const BinaryExpr *> chain{ static_cast<const BinaryExpr *>(expr) };
+		while (chain.back()->lhs->kind == EXPR_BINARY) {
+			chain.push_back(static_cast<const BinaryExpr *>(chain.back()->lhs));
+		}
+
+		out->append(chain.size(), '(');
+		printExpr(out, chain.back()->lhs);
+		for (size_t idx = chain.size(); idx-- > 0;) {
+			std::string op = getTokenString(chain[idx]->op);
+			*out += " " + op.substr(1, op.length() - 2) + " ";
+			printExpr(out, chain[idx]->rhs);
+			*out += ")";
+		}
+		break;
+	}
+	case EXPR_INDEX: {
+		auto index = static_cast<const IndexExpr *>(expr);
+		printExpr(out, index->array);
+		*out += "@";
+		printExpr(out, index->index);
+		break;
+	}
+	case EXPR_CALL: {
+		auto call = static_cast<const CallExpr *>(expr);
+		printName(out, call->name);
+		*out += "(";
+		printList(out, call->args, call->count);
+		*out += ")";
+		break;
+	}
+	case EXPR_CAST: {
+		auto cast = static_cast<const CastExpr *>(expr);
+		*out += getTypeName(cast->target) + "(";
+		printExpr(out, cast->operand);
+		*out += ")";
+		break;
+	}
+	}
+}
+
+/**
+ * Appends a statement to the output on its own line(s).
+ * @param out Output to append to.
+ * @param stmt Statement to append.
+ * @param indent Indentation level.
+ */
+void printStmt(std::string *out, const Stmt *stmt, int indent) {
+	std::string pad(static_cast<size_t>(indent) * 2, ' ');
+
+	switch (stmt->kind) {
+	case STMT_BLOCK: {
+		auto block = static_cast<const BlockStmt *>(stmt);
+		for (uint32_t idx = 0; idx < block->count; idx++) {
+			printStmt(out, block->stmts[idx], indent);
+		}
+		break;
+	}
+	case STMT_VAR: {
+		auto var = static_cast<const VarStmt *>(stmt);
+		*out += pad + getTypeName(var->type) + " ";
+		printName(out, var->name);
+		if (var->value != nullptr) {
+			*out += " = ";
+			printExpr(out, var->value);
+		}
+		*out += "\n";
+		break;
+	}
+	case STMT_ASSIGN: {
+		auto assign = static_cast<const AssignStmt *>(stmt);
+		*out += pad;
+		printExpr(out, assign->target);
+		*out += " = ";
+		printExpr(out, assign->value);
+		*out += "\n";
+		break;
+	}
+	case STMT_EXPR:
+		*out += pad;
+		printExpr(out, static_cast<const ExprStmt *>(stmt)->expr);
+		*out += "\n";
+		break;
+	case STMT_IF: {
+		auto branch = static_cast<const IfStmt *>(stmt);
+		*out += pad + "if ";
+		printExpr(out, branch->cond);
+		*out += "\n";
+		printStmt(out, branch->then, indent + 1);
+
+		if (branch->otherwise != nullptr) {
+			*out += pad + "else\n";
+			printStmt(out, branch->otherwise, indent + 1);
+		}
+		break;
+	}
+	case STMT_WHILE: {
+		auto loop = static_cast<const WhileStmt *>(stmt);
+		*out += pad + "while ";
+		printExpr(out, loop->cond);
+		*out += "\n";
+		printStmt(out, loop->body, indent + 1);
+		break;
+	}
+	case STMT_FOR: {
+		auto loop = static_cast<const ForStmt *>(stmt);
+		*out += pad + "for " + getTypeName(loop->type) + " ";
+		printName(out, loop->name);
+		*out += " in range(";
+		if (loop->start != nullptr) {
+			printExpr(out, loop->start);
+			*out += ", ";
+		}
+		printExpr(out, loop->stop);
+		if (loop->step != nullptr) {
+			*out += ", ";
+			printExpr(out, loop->step);
+		}
+		*out += ")\n";
+		printStmt(out, loop->body, indent + 1);
+		break;
+	}
+	case STMT_RETURN: {
+		auto ret = static_cast<const ReturnStmt *>(stmt);
+		*out += pad + "return";
+		if (ret->value != nullptr) {
+			*out += " ";
+			printExpr(out, ret->value);
+		}
+		*out += "\n";
+		break;
+	}
+	case STMT_PRINT: {
+		auto print = static_cast<const PrintStmt *>(stmt);
+		*out += pad + (print->newline ? "println(" : "print(");
+		if (print->value != nullptr) {
+			printExpr(out, print->value);
+		}
+		*out += ")\n";
+		break;
+	}
+	case STMT_EXIT:
+		*out += pad + "exit(";
+		printExpr(out, static_cast<const ExitStmt *>(stmt)->code);
+		*out += ")\n";
+		break;
+	case STMT_BREAK:
+		*out += pad + "break\n";
+		break;
+	case STMT_CONTINUE:
+		*out += pad + "continue\n";
+		break;
+	}
+}
@@ -0,0 +1,332 @@
+/**
+ * @file       ast.hpp
+ * @brief      Data type definitions for the abstract syntax tree
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef AST_HPP
+#define AST_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "token.hpp"
+
+/*
+ * Every node is allocated from an `Arena` and freed along with it, so nodes only hold
+ * plain data: child pointers, arrays of child pointers (with a count) and names that
+ * point back into the source buffer.
+ */
+
+/** Basic types of values */
+enum BaseType : uint8_t {
+	TYPE_VOID = 0,  /* no value (function return type only) */
+	TYPE_BOOL,      /* `bool` */
+	TYPE_CHAR,      /* `char` */
+	TYPE_NUM,       /* `num` */
+	TYPE_DEC,       /* `dec` */
+	TYPE_STR        /* `string` */
+};
+
+/** Type of a value */
+struct Type {
+	/** Type of the elements */
+	BaseType base;
+
+	/** Number of array dimensions, 0 for a single value */
+	uint8_t rank;
+};
+
+/** Maximum number of array dimensions */
+#define MAX_ARRAY_RANK 31
+
+/**
+ * Maximum depth of the syntax tree, counting nested blocks, `elsif` branches and
+ * operators. Every stage walks the tree recursively, so this keeps them all well
+ * within the stack. Binary operators nested through their left operands, as in
+ * `a + b + c`, are walked in a loop instead, so such chains can be any length.
+ */
+#define MAX_NESTING_DEPTH 1000
+
+/**
+ * Checks if two types are the same.
+ * @param a First type.
+ * @param b Second type.
+ * @returns `true` if the types are the same, `false` otherwise.
+ */
+inline bool sameType(Type a, Type b) {
+	return a.base == b.base && a.rank == b.rank;
+}
+
+/**
+ * Checks if values of a type are references to heap objects (strings and arrays).
+ * @param type Type to check.
+ * @returns `true` for strings and arrays, `false` otherwise.
+ */
+inline bool isRefType(Type type) {
+	return type.rank > 0 || type.base == TYPE_STR;
+}
+
+/**
+ * Checks if a type is `num` or `dec`.
+ * @param type Type to check.
+ * @returns `true` for numbers and decimals, `false` otherwise.
+ */
+inline bool isNumericType(Type type) {
+	return type.rank == 0 && (type.base == TYPE_NUM || type.base == TYPE_DEC);
+}
+
+/** Identifier, referring to its interned text */
+struct Name {
+	/** First character of the identifier, held by the interner rather than the source */
+	const char *text;
+
+	/** Number of characters in the identifier */
+	uint32_t length;
+
+	/** Interned identifier, equal for names with the same characters */
+	Symbol symbol;
+};
+
+/**
+ * Checks if two names are the same. Both must have been interned by the same lexer.
+ * @param a First name.
+ * @param b Second name.
+ * @returns `true` if the names have the same characters, `false` otherwise.
+ */
+inline bool sameName(const Name &a, const Name &b) {
+	return a.symbol == b.symbol;
+}
+
+// --------------- expressions ---------------------------------
+
+/** Kinds of expressions */
+enum ExprKind : uint8_t {
+	EXPR_NUM,     /* number literal */
+	EXPR_DEC,     /* decimal literal */
+	EXPR_BOOL,    /* `true` or `false` */
+	EXPR_CHAR,    /* character literal */
+	EXPR_STR,     /* string literal */
+	EXPR_NAME,    /* variable */
+	EXPR_ARRAY,   /* array literal, `[a, b, c]` */
+	EXPR_UNARY,   /* `-x`, `!x` */
+	EXPR_BINARY,  /* `x + y`, `x and y`, ... */
+	EXPR_INDEX,   /* `arr@idx` */
+	EXPR_CALL,    /* `func(a, b)` */
+	EXPR_CAST     /* `string(x)`, `num(x)`, ... */
+};
+
+/** Fields shared by all expressions */
+struct Expr {
+	ExprKind kind;
+	SourcePosition position;
+
+	/** Type of the value, filled in by the type checker */
+	Type type;
+};
+
+struct NumExpr : Expr {
+	int64_t value;
+};
+
+struct DecExpr : Expr {
+	double value;
+};
+
+struct BoolExpr : Expr {
+	bool value;
+};
+
+struct CharExpr : Expr {
+	char value;
+};
+
+struct StrExpr : Expr {
+	/** Characters between the quotes, with escape codes as written, copied into the arena */
+	const char *text;
+
+	/** Number of characters between the quotes */
+	uint32_t length;
+
+	/** `true` if the text contains escape codes */
+	bool escaped;
+};
+
+struct NameExpr : Expr {
+	Name name;
+};
+
+struct ArrayExpr : Expr {
+	Expr **items;
+	uint32_t count;
+};
+
+struct UnaryExpr : Expr {
+	/** `TOK_MINUS` or `TOK_NOT` */
+	TokenType op;
+	Expr *operand;
+};
+
+struct BinaryExpr : Expr {
+	/** Arithmetic, relational, `TOK_AND` or `TOK_OR` */
+	TokenType op;
+	Expr *lhs;
+	Expr *rhs;
+};
+
+struct IndexExpr : Expr {
+	Expr *array;
+	Expr *index;
+};
+
+struct CallExpr : Expr {
+	Name name;
+	Expr **args;
+	uint32_t count;
+};
+
+struct CastExpr : Expr {
+	Type target;
+	Expr *operand;
+
+	/** `true` for conversions added by the type checker (e.g. `num` to `dec`) */
+	bool implicit;
+};
+
+// --------------- statements ----------------------------------
+
+/** Kinds of statements */
+enum StmtKind : uint8_t {
+	STMT_BLOCK,     /* `{ ... }` */
+	STMT_VAR,       /* `num x = 1` */
+	STMT_ASSIGN,    /* `x = 1`, `arr@0 = 1` */
+	STMT_EXPR,      /* function call on its own */
+	STMT_IF,        /* `if ... elsif ... else ...` */
+	STMT_WHILE,     /* `while cond { ... }` */
+	STMT_FOR,       /* `for num x in range(...) { ... }` */
+	STMT_RETURN,    /* `return`, `return x` */
+	STMT_PRINT,     /* `print(x)`, `println(x)` */
+	STMT_EXIT,      /* `exit(code)` */
+	STMT_BREAK,     /* `break` */
+	STMT_CONTINUE   /* `continue` */
+};
+
+/** Fields shared by all statements (`break` and `continue` have no others) */
+struct Stmt {
+	StmtKind kind;
+	SourcePosition position;
+};
+
+struct BlockStmt : Stmt {
+	Stmt **stmts;
+	uint32_t count;
+};
+
+struct VarStmt : Stmt {
+	Type type;
+	Name name;
+
+	/** Initial value, or `nullptr` for the default value */
+	Expr *value;
+};
+
+struct AssignStmt : Stmt {
+	/** `EXPR_NAME` or `EXPR_INDEX` */
+	Expr *target;
+	Expr *value;
+};
+
+struct ExprStmt : Stmt {
+	Expr *expr;
+};
+
+struct IfStmt : Stmt {
+	Expr *cond;
+	BlockStmt *then;
+
+	/** `BlockStmt` for `else`, `IfStmt` for `elsif`, or `nullptr` */
+	Stmt *otherwise;
+};
+
+struct WhileStmt : Stmt {
+	Expr *cond;
+	BlockStmt *body;
+};
+
+struct ForStmt : Stmt {
+	Type type;
+	Name name;
+
+	/** First value, or `nullptr` to start from 0 */
+	Expr *start;
+
+	/** Value to stop before */
+	Expr *stop;
+
+	/** Amount to step by, or `nullptr` to step by 1 */
+	Expr *step;
+
+	BlockStmt *body;
+};
+
+struct ReturnStmt : Stmt {
+	/** Returned value, or `nullptr` in `void` functions */
+	Expr *value;
+};
+
+struct PrintStmt : Stmt {
+	/** `true` for `println` */
+	bool newline;
+
+	/** Printed value, or `nullptr` to only print the new line */
+	Expr *value;
+};
+
+struct ExitStmt : Stmt {
+	Expr *code;
+};
+
+// --------------- declarations --------------------------------
+
+/** Function parameter */
+struct Param {
+	Type type;
+	Name name;
+	SourcePosition position;
+};
+
+/** Function declaration */
+struct FuncDecl {
+	Name name;
+	SourcePosition position;
+	Param *params;
+	uint32_t paramCount;
+	Type returnType;
+	BlockStmt *body;
+};
+
+/** Whole source file */
+struct Program {
+	FuncDecl **funcs;
+	uint32_t count;
+};
+
+/**
+ * Returns the name of a type as written in the source.
+ * @param type Type to get the name of.
+ * @returns Name of the type (e.g. "num[]").
+ */
+std::string getTypeName(Type type);
+
+/**
+ * Writes a readable, indented representation of a program.
+ * @param program Program to write.
+ * @returns Text of the syntax tree.
+ */
+std::string printProgram(const Program *program);
+
+#endif // AST_HPP
@@ -0,0 +1,128 @@
+/**
+ * @file       bytecode.cpp
+ * @brief      Implementation for listing the bytecode
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include "ast.hpp"
+#include "bytecode.hpp"
+#include "error.hpp"
+
+/** Operand formats of the instructions (see `DIUM_OPCODES`) */
+enum OperandFormat : uint8_t {
+	FMT_ABC,
+	FMT_AB,
+	FMT_A,
+	FMT_NONE,
+	FMT_AI,
+	FMT_AK,
+	FMT_AJ,
+	FMT_J,
+	FMT_ABCT,
+	FMT_ABT,
+	FMT_AT,
+	FMT_ABN,
+	FMT_CALL
+};
+
+/* Names of each opcode */
+static const char *opcodeNames[] = {
+#define DIUM_OPCODE_NAME(name, format) #name,
+	DIUM_OPCODES(DIUM_OPCODE_NAME)
+#undef DIUM_OPCODE_NAME
+};
+
+/* Operand format of each opcode */
+static const OperandFormat opcodeFormats[] = {
+#define DIUM_OPCODE_FORMAT(name, format) FMT_##format,
+	DIUM_OPCODES(DIUM_OPCODE_FORMAT)
+#undef DIUM_OPCODE_FORMAT
+};
+
+
+const char *getOpcodeName(Opcode op) {
+	return (op < OP_COUNT) ? opcodeNames[op] : "???";
+}
+
+std::string printConstant(const Constant &constant) {
+	switch (constant.kind) {
+	case CONST_NUM:
+		return std::to_string(constant.num);
+	case CONST_DEC:
+		return customFormat("%g", constant.dec);
+	default:
+		return "\"" + constant.text + "\"";
+	}
+}
+
+std::string printModule(const Module &module) {
+	std::string out;
+
+	for (const Function &func : module.funcs) {
+		appendFormat(&out, "func %s (%u params, %u registers)\n", func.name.c_str(),
+			func.paramCount, func.frameSize);
+		size_t safepoint = 0;
+
+		for (size_t idx = 0; idx < func.code.size(); idx++) {
+			const Instr &instr = func.code[idx];
+			appendFormat(&out, "  %04zu  %4d  %-9s", idx, func.positions[idx].line, getOpcodeName(instr.op));
+
+			switch (opcodeFormats[instr.op]) {
+			case FMT_ABC:
+				appendFormat(&out, "r%u, r%u, r%u", instr.a, instr.b, instr.c);
+				break;
+			case FMT_AB:
+				appendFormat(&out, "r%u, r%u", instr.a, instr.b);
+				break;
+			case FMT_A:
+				appendFormat(&out, "r%u", instr.a);
+				break;
+			case FMT_NONE:
+				break;
+			case FMT_AI:
+				appendFormat(&out, "r%u, %d", instr.a, static_cast<int32_t>(getWide(instr)));
+				break;
+			case FMT_AK:
+				appendFormat(&out, "r%u, k%u", instr.a, getWide(instr));
+				out += "  ; " + printConstant(module.constants[getWide(instr)]);
+				break;
+			case FMT_AJ:
+				appendFormat(&out, "r%u, %04u", instr.a, getWide(instr));
+				break;
+			case FMT_J:
+				appendFormat(&out, "%04u", getWide(instr));
+				break;
+			case FMT_ABCT:
+				appendFormat(&out, "r%u, r%u, r%u, %s", instr.a, instr.b, instr.c, getTypeName(unpackType(instr.type)).c_str());
+				break;
+			case FMT_ABT:
+				appendFormat(&out, "r%u, r%u, %s", instr.a, instr.b, getTypeName(unpackType(instr.type)).c_str());
+				break;
+			case FMT_AT:
+				appendFormat(&out, "r%u, %s", instr.a, getTypeName(unpackType(instr.type)).c_str());
+				break;
+			case FMT_ABN:
+				appendFormat(&out, "r%u, r%u, %u", instr.a, instr.b, instr.c);
+				break;
+			case FMT_CALL:
+				appendFormat(&out, "r%u, %s, %u", instr.a, module.funcs[instr.b].name.c_str(), instr.c);
+				break;
+			}
+
+			// List the references the collector sees while the frame is stopped here
+			if (safepoint < func.safepoints.size() && func.safepoints[safepoint] == idx) {
+				out += "  ; refs";
+				for (uint32_t ref = func.refStarts[safepoint]; ref < func.refStarts[safepoint + 1]; ref++) {
+					appendFormat(&out, " r%u", func.refRegs[ref]);
+				}
+				safepoint += 1;
+			}
+
+			out += "\n";
+		}
+	}
+
+	return out;
+}
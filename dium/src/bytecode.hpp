@@ -0,0 +1,266 @@
+/**
+ * @file       bytecode.hpp
+ * @brief      Data type definitions for the bytecode
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef BYTECODE_HPP
+#define BYTECODE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ast.hpp"
+#include "token.hpp"
+
+/*
+ * Instructions work on the registers of the current call frame. Registers hold untagged
+ * 8-byte values whose types are known statically, so each operation comes in a
+ * version for every type it applies to and never checks types at run time. `bool`
+ * and `char` values are stored as numbers, so they share the `_NUM` comparisons.
+ *
+ * Every instruction is 8 bytes: an opcode, a type operand T (a packed `Type`, see
+ * `packType`) and three 16-bit operands A, B and C. Jumps, immediates and constant
+ * indices use B and C together as a single 32-bit operand.
+ *
+ * A `for` loop keeps its state in four registers rather than in an object: RANGE
+ * works out how many times the loop runs and leaves the count, the next value and the
+ * step in R[A..A+2], and FORITER counts down, copying the next value to the loop
+ * variable in R[A + 3]. The loop runs while start < stop for a positive step and while
+ * start > stop for a negative one, never reaching stop, and a step of 0 is an error.
+ *
+ * Operand formats:
+ *   ABC   three registers
+ *   AB    two registers
+ *   A     one register
+ *   NONE  no operands
+ *   AI    register and signed 32-bit immediate
+ *   AK    register and 32-bit constant index
+ *   AJ    register and 32-bit jump target
+ *   J     32-bit jump target
+ *   ABCT  three registers and a type
+ *   ABT   two registers and a type
+ *   AT    register and a type
+ *   ABN   two registers and a small number in C
+ *   CALL  first argument register, function index in B, argument count in C
+ */
+#define DIUM_OPCODES(OP) \
+	OP(MOVE,     AB)    /* R[A] = R[B] */ \
+	OP(LOADI,    AI)    /* R[A] = immediate number (or bool, char) */ \
+	OP(LOADK,    AK)    /* R[A] = constant */ \
+	OP(NEWARRAY, ABCT)  /* R[A] = [R[B], ..., R[B + C - 1]] with items of type T */ \
+	OP(GETINDEX, ABCT)  /* R[A] = R[B]@R[C] (array with items of type T) */ \
+	OP(GETCHAR,  ABC)   /* R[A] = R[B]@R[C] (string) */ \
+	OP(SETINDEX, ABC)   /* R[A]@R[B] = R[C] */ \
+	OP(ADD_NUM,  ABC)   /* R[A] = R[B] + R[C] */ \
+	OP(SUB_NUM,  ABC)   /* R[A] = R[B] - R[C] */ \
+	OP(MUL_NUM,  ABC)   /* R[A] = R[B] * R[C] */ \
+	OP(DIV_NUM,  ABC)   /* R[A] = R[B] / R[C] */ \
+	OP(MOD_NUM,  ABC)   /* R[A] = R[B] % R[C] */ \
+	OP(NEG_NUM,  AB)    /* R[A] = -R[B] */ \
+	OP(DIVP2_NUM, ABN)  /* R[A] = R[B] / 2^C, rounded towards zero like DIV_NUM */ \
+	OP(MODP2_NUM, ABN)  /* R[A] = R[B] % 2^C, with the sign of R[B] like MOD_NUM */ \
+	OP(ADD_DEC,  ABC)   \
+	OP(SUB_DEC,  ABC)   \
+	OP(MUL_DEC,  ABC)   \
+	OP(DIV_DEC,  ABC)   \
+	OP(MOD_DEC,  ABC)   \
+	OP(NEG_DEC,  AB)    \
+	OP(CONCAT,   ABN)   /* R[A] = R[B] + ... + R[B + C - 1] (strings) */ \
+	OP(NOT,      AB)    /* R[A] = !R[B] */ \
+	OP(EQ_NUM,   ABC)   /* R[A] = R[B] == R[C] */ \
+	OP(NE_NUM,   ABC)   /* R[A] = R[B] != R[C] */ \
+	OP(LT_NUM,   ABC)   /* R[A] = R[B] < R[C] */ \
+	OP(LE_NUM,   ABC)   /* R[A] = R[B] <= R[C] */ \
+	OP(EQ_DEC,   ABC)   \
+	OP(NE_DEC,   ABC)   \
+	OP(LT_DEC,   ABC)   \
+	OP(LE_DEC,   ABC)   \
+	OP(EQ_STR,   ABC)   \
+	OP(NE_STR,   ABC)   \
+	OP(LT_STR,   ABC)   \
+	OP(LE_STR,   ABC)   \
+	OP(EQ_REF,   ABC)   /* R[A] = R[B] is R[C] (arrays) */ \
+	OP(NE_REF,   ABC)   \
+	OP(NUM2DEC,  AB)    /* R[A] = dec(R[B]) */ \
+	OP(DEC2NUM,  AB)    /* R[A] = num(R[B]) */ \
+	OP(NUM2CHAR, AB)    /* R[A] = char(R[B]) */ \
+	OP(NUM2BOOL, AB)    /* R[A] = bool(R[B]) */ \
+	OP(STR2NUM,  AB)    /* R[A] = num(R[B]) */ \
+	OP(STR2DEC,  AB)    /* R[A] = dec(R[B]) */ \
+	OP(STR2CHAR, AB)    /* R[A] = char(R[B]) */ \
+	OP(TOSTR,    ABT)   /* R[A] = string(R[B]), where R[B] has type T */ \
+	OP(JMP,      J)     /* jump */ \
+	OP(JMPF,     AJ)    /* jump if R[A] is false */ \
+	OP(JMPT,     AJ)    /* jump if R[A] is true */ \
+	OP(RANGE,    AB)    /* R[A..A+2] = loop over range(R[B], R[B + 1], R[B + 2]) (B may be A) */ \
+	OP(FORITER,  AJ)    /* R[A + 3] = next value of the loop in R[A..A+2], or jump when there is none */ \
+	OP(CALL,     CALL)  /* R[A] = func B(R[A], ..., R[A + C - 1]) */ \
+	OP(RET,      A)     /* return R[A] */ \
+	OP(RET0,     NONE)  /* return nothing */ \
+	OP(PRINT,    AT)    /* print(R[A]), where R[A] has type T */ \
+	OP(PRINTLN,  AT)    /* println(R[A]), where R[A] has type T */ \
+	OP(NEWLINE,  NONE)  /* println() */ \
+	OP(EXIT,     A)     /* exit(R[A]) */
+
+/** Operations of the virtual machine */
+enum Opcode : uint8_t {
+#define DIUM_OPCODE_ENUM(name, format) OP_##name,
+	DIUM_OPCODES(DIUM_OPCODE_ENUM)
+#undef DIUM_OPCODE_ENUM
+	OP_COUNT
+};
+
+/** Single instruction */
+struct Instr {
+	Opcode op;
+
+	/** Packed type operand */
+	uint8_t type;
+
+	uint16_t a;
+	uint16_t b;
+	uint16_t c;
+};
+
+static_assert(sizeof(Instr) == 8, "Instructions must stay 8 bytes");
+
+/**
+ * Packs a type into the type operand of an instruction.
+ * @param type Type to pack.
+ * @returns Base type in the low 3 bits, array dimensions in the high 5 bits.
+ */
+inline uint8_t packType(Type type) {
+	return static_cast<uint8_t>(type.base | (type.rank << 3));
+}
+
+/**
+ * Unpacks the type operand of an instruction.
+ * @param packed Packed type.
+ * @returns Type it represents.
+ */
+inline Type unpackType(uint8_t packed) {
+	return Type{ static_cast<BaseType>(packed & 7), static_cast<uint8_t>(packed >> 3) };
+}
+
+/** Maximum number of registers in a call frame */
+#define MAX_REGISTERS 0xFFFF
+
+/**
+ * Returns the 32-bit operand (jump target, immediate or constant) of an instruction.
+ * @param instr Instruction to read.
+ * @returns Operand stored in B and C.
+ */
+inline uint32_t getWide(const Instr &instr) {
+	return static_cast<uint32_t>(instr.b) | (static_cast<uint32_t>(instr.c) << 16);
+}
+
+/**
+ * Sets the 32-bit operand (jump target, immediate or constant) of an instruction.
+ * @param instr Instruction to change.
+ * @param value Operand to store in B and C.
+ */
+inline void setWide(Instr *instr, uint32_t value) {
+	instr->b = static_cast<uint16_t>(value);
+	instr->c = static_cast<uint16_t>(value >> 16);
+}
+
+/** Kinds of constants */
+enum ConstantKind : uint8_t {
+	CONST_NUM,
+	CONST_DEC,
+	CONST_STR
+};
+
+/** Value in the constant table of a module */
+struct Constant {
+	ConstantKind kind;
+
+	/** Value (for numbers) */
+	int64_t num;
+
+	/** Value (for decimals) */
+	double dec;
+
+	/** Value (for strings) */
+	std::string text;
+};
+
+/** Compiled function */
+struct Function {
+	/** Name of the function */
+	std::string name;
+
+	/** Number of parameters, which arrive in the first registers */
+	uint16_t paramCount;
+
+	/** Types of the parameters */
+	std::vector<Type> paramTypes;
+
+	/** Type of the returned value (`void` if there is none) */
+	Type returnType;
+
+	/** Number of registers used by the function */
+	uint16_t frameSize;
+
+	/** Instructions of the function */
+	std::vector<Instr> code;
+
+	/** Source position of each instruction */
+	std::vector<SourcePosition> positions;
+
+	/**
+	 * Instructions that may collect garbage (calls and allocations), in increasing
+	 * order. Since registers are untagged, the collector finds the references in a
+	 * frame through the registers listed for the instruction the frame is stopped at.
+	 */
+	std::vector<uint32_t> safepoints;
+
+	/** Index of the first register of each safepoint in `refRegs`, plus a final end index */
+	std::vector<uint32_t> refStarts;
+
+	/** Registers holding live references at each safepoint */
+	std::vector<uint16_t> refRegs;
+};
+
+/** Compiled program */
+struct Module {
+	/** Name of the source file */
+	std::string name;
+
+	/** Compiled functions, called by index */
+	std::vector<Function> funcs;
+
+	/** Constants shared by all functions */
+	std::vector<Constant> constants;
+
+	/** Index of `main` */
+	uint16_t entry;
+};
+
+/**
+ * Returns the name of an opcode.
+ * @param op Opcode to get the name of.
+ * @returns Name of the opcode (e.g. "ADD_NUM").
+ */
+const char *getOpcodeName(Opcode op);
+
+/**
+ * Writes a constant the way it would appear in the source.
+ * @param constant Constant to write.
+ * @returns Text of the constant.
+ */
+std::string printConstant(const Constant &constant);
+
+/**
+ * Writes a readable listing of the instructions of a module.
+ * @param module Module to list.
+ * @returns Text of the listing.
+ */
+std::string printModule(const Module &module);
+
+#endif // BYTECODE_HPP
@@ -0,0 +1,345 @@
+/**
+ * @file       cache.cpp
+ * @brief      Implementation for the on-disk cache of compiled programs
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+#include "cache.hpp"
+#include "format.hpp"
+#include "source.hpp"
+
+/* Reads the payload of a cache file, failing on anything past its end */
+struct PayloadReader {
+	/** Next byte to read */
+	const char *cursor;
+
+	/** One past the last byte */
+	const char *end;
+
+	/** `false` once a read went past the end */
+	bool valid = true;
+
+	/**
+	 * Reads a number.
+	 * @tparam T Type of the number.
+	 * @returns Number read, or 0 past the end.
+	 */
+	template <typename T>
+	T get() {
+		T value{};
+		if (static_cast<size_t>(end - cursor) < sizeof(T)) {
+			valid = false;
+			return value;
+		}
+		memcpy(&value, cursor, sizeof(T));
+		cursor += sizeof(T);
+		return value;
+	}
+
+	/**
+	 * Reads an array into a vector.
+	 * @tparam T Type of the items, which must be copyable as bytes.
+	 * @param[out] items Vector to fill.
+	 * @param count Number of items.
+	 */
+	template <typename T>
+	void getArray(std::vector<T> *items, size_t count) {
+		static_assert(std::is_trivially_copyable<T>::value, "Arrays are copied as bytes");
+		const char *data = take(count * sizeof(T));
+		if (data != nullptr) {
+			items->resize(count);
+			if (count > 0) {
+				memcpy(items->data(), data, count * sizeof(T));
+			}
+		}
+	}
+
+	/**
+	 * Skips over bytes and the padding after them.
+	 * @param size Number of bytes.
+	 * @returns First byte, or `nullptr` past the end.
+	 */
+	const char *take(size_t size) {
+		size_t padded = size + (8 - size % 8) % 8;
+		if (padded < size || static_cast<size_t>(end - cursor) < padded) {
+			valid = false;
+			return nullptr;
+		}
+		const char *data = cursor;
+		cursor += padded;
+		return data;
+	}
+};
+
+// --------------- function prototypes -------------------------
+
+static void writeModule(std::string *out, const Module &module);
+static bool readModule(PayloadReader *reader, Module *module);
+template <typename T> static void put(std::string *out, T value);
+static void putArray(std::string *out, const void *data, size_t size);
+
+
+uint64_t hashBytes(const void *data, size_t size, uint64_t hash) {
+	const auto *bytes = static_cast<const uint8_t *>(data);
+
+	for (size_t idx = 0; idx < size; idx++) {
+		hash = (hash ^ bytes[idx]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+BytecodeCache::BytecodeCache(const std::string &directory, const char *source, size_t size, OptLevel optLevel)
+	: directory{ directory }, sourceHash{ hashBytes(source, size) }, sourceSize{ size } {
+	// The instruction set is part of the version, so that adding or reordering opcodes
+	// invalidates old files even when the version was not bumped
+	std::string version = customFormat("%d/%d/%d/%zu/", DMC_COMPILER_VERSION, DMC_VERSION, static_cast<int>(optLevel), sizeof(Instr));
+	for (int op = 0; op < OP_COUNT; op++) {
+		version += getOpcodeName(static_cast<Opcode>(op));
+		version += ',';
+	}
+	compilerHash = hashBytes(version.data(), version.size());
+
+	uint64_t key = hashBytes(&compilerHash, sizeof(compilerHash), sourceHash);
+	path = (std::filesystem::path(directory) / customFormat("%016llx.dmc", static_cast<unsigned long long>(key))).string();
+}
+
+bool BytecodeCache::load(const std::string &name, Module *module) const {
+	SourceBuffer buffer;
+	if (!openSource(&buffer, path.c_str())) {
+		return false;
+	}
+
+	DmcHeader header;
+	bool valid = buffer.size >= sizeof(header);
+	if (valid) {
+		memcpy(&header, buffer.data, sizeof(header));
+		valid = memcmp(header.magic, DMC_MAGIC, sizeof(header.magic)) == 0 && header.version == DMC_VERSION
+			&& header.byteOrder == DMC_BYTE_ORDER && header.sourceHash == sourceHash && header.sourceSize == sourceSize
+			&& header.compilerHash == compilerHash && header.payloadSize == buffer.size - sizeof(header);
+	}
+
+	const char *payload = buffer.data + sizeof(header);
+	if (valid && hashBytes(payload, header.payloadSize) == header.payloadChecksum) {
+		PayloadReader reader{ payload, payload + header.payloadSize };
+		valid = readModule(&reader, module);
+	} else {
+		valid = false;
+	}
+
+	closeSource(&buffer);
+	module->name = name;
+	return valid;
+}
+
+bool BytecodeCache::save(const Module &module) const {
+	std::string data(sizeof(DmcHeader), '\0');
+	writeModule(&data, module);
+
+	DmcHeader header{};
+	memcpy(header.magic, DMC_MAGIC, sizeof(header.magic));
+	header.version = DMC_VERSION;
+	header.byteOrder = DMC_BYTE_ORDER;
+	header.sourceHash = sourceHash;
+	header.sourceSize = sourceSize;
+	header.compilerHash = compilerHash;
+	header.payloadSize = data.size() - sizeof(header);
+	header.payloadChecksum = hashBytes(data.data() + sizeof(header), header.payloadSize);
+	memcpy(&data[0], &header, sizeof(header));
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+
+	// Unique enough between processes writing the same file at the same time
+	auto stamp = static_cast<unsigned long long>(std::chrono::steady_clock::now().time_since_epoch().count());
+	std::string temporary = path + customFormat(".%llx.tmp", stamp);
+
+	std::ofstream file(temporary, std::ios::binary);
+	file.write(data.data(), static_cast<std::streamsize>(data.size()));
+	file.close();
+
+	if (!file) {
+		std::filesystem::remove(temporary, error);
+		return false;
+	}
+
+	std::filesystem::rename(temporary, path, error);
+	if (error) {
+		std::filesystem::remove(temporary, error);
+		return false;
+	}
+	return true;
+}
+
+std::string BytecodeCache::getDefaultDirectory() {
+#ifdef _WIN32
+	const char *local = getenv("LOCALAPPDATA");
+	return (local != nullptr && local[0] != '\0') ? std::string(local) + "\\dium" : "";
+#else
+	const char *xdg = getenv("XDG_CACHE_HOME");
+	if (xdg != nullptr && xdg[0] != '\0') {
+		return std::string(xdg) + "/dium";
+	}
+
+	const char *home = getenv("HOME");
+	return (home != nullptr && home[0] != '\0') ? std::string(home) + "/.cache/dium" : "";
+#endif
+}
+
+/**
+ * Appends the payload of a cache file: counts, then every constant, then every
+ * function with its arrays.
+ * @param out String to append to.
+ * @param module Module to write.
+ */
+static void writeModule(std::string *out, const Module &module) {
+	put<uint32_t>(out, module.entry);
+	put<uint32_t>(out, static_cast<uint32_t>(module.funcs.size()));
+	put<uint32_t>(out, static_cast<uint32_t>(module.constants.size()));
+	put<uint32_t>(out, 0);
+
+	for (const Constant &constant : module.constants) {
+		put<uint32_t>(out, constant.kind);
+		put<uint32_t>(out, static_cast<uint32_t>(constant.text.size()));
+		put<int64_t>(out, constant.num);
+		put<double>(out, constant.dec);
+		putArray(out, constant.text.data(), constant.text.size());
+	}
+
+	for (const Function &func : module.funcs) {
+		put<uint32_t>(out, static_cast<uint32_t>(func.name.size()));
+		put<uint16_t>(out, func.paramCount);
+		put<uint16_t>(out, func.frameSize);
+		put<uint32_t>(out, static_cast<uint32_t>(func.code.size()));
+		put<uint32_t>(out, static_cast<uint32_t>(func.safepoints.size()));
+		put<uint32_t>(out, static_cast<uint32_t>(func.refStarts.size()));
+		put<uint32_t>(out, static_cast<uint32_t>(func.refRegs.size()));
+		put<uint32_t>(out, packType(func.returnType));
+		put<uint32_t>(out, 0);
+
+		std::string paramTypes;
+		for (Type type : func.paramTypes) {
+			paramTypes += static_cast<char>(packType(type));
+		}
+
+		putArray(out, func.name.data(), func.name.size());
+		putArray(out, paramTypes.data(), paramTypes.size());
+		putArray(out, func.code.data(), func.code.size() * sizeof(Instr));
+		putArray(out, func.positions.data(), func.positions.size() * sizeof(SourcePosition));
+		putArray(out, func.safepoints.data(), func.safepoints.size() * sizeof(uint32_t));
+		putArray(out, func.refStarts.data(), func.refStarts.size() * sizeof(uint32_t));
+		putArray(out, func.refRegs.data(), func.refRegs.size() * sizeof(uint16_t));
+	}
+}
+
+/**
+ * Reads the payload of a cache file, written by `writeModule()`.
+ * @param reader Reader of the payload.
+ * @param[out] module Module to fill.
+ * @returns `true` if the payload was complete and consistent, `false` otherwise.
+ */
+static bool readModule(PayloadReader *reader, Module *module) {
+	uint32_t entry = reader->get<uint32_t>();
+	uint32_t funcCount = reader->get<uint32_t>();
+	uint32_t constantCount = reader->get<uint32_t>();
+	reader->get<uint32_t>();
+
+	// Every constant and function takes at least 24 bytes, which bounds the counts
+	// before anything is allocated for them
+	size_t remaining = static_cast<size_t>(reader->end - reader->cursor);
+	if (!reader->valid || entry >= funcCount || funcCount > remaining / 24 || constantCount > remaining / 24) {
+		return false;
+	}
+
+	module->entry = static_cast<uint16_t>(entry);
+	module->constants.resize(constantCount);
+	for (Constant &constant : module->constants) {
+		uint32_t kind = reader->get<uint32_t>();
+		uint32_t length = reader->get<uint32_t>();
+		constant.num = reader->get<int64_t>();
+		constant.dec = reader->get<double>();
+
+		const char *text = reader->take(length);
+		if (text == nullptr || kind > CONST_STR) {
+			return false;
+		}
+		constant.kind = static_cast<ConstantKind>(kind);
+		constant.text.assign(text, length);
+	}
+
+	module->funcs.resize(funcCount);
+	for (Function &func : module->funcs) {
+		uint32_t nameLength = reader->get<uint32_t>();
+		func.paramCount = reader->get<uint16_t>();
+		func.frameSize = reader->get<uint16_t>();
+		uint32_t codeCount = reader->get<uint32_t>();
+		uint32_t safepointCount = reader->get<uint32_t>();
+		uint32_t refStartCount = reader->get<uint32_t>();
+		uint32_t refRegCount = reader->get<uint32_t>();
+		func.returnType = unpackType(static_cast<uint8_t>(reader->get<uint32_t>()));
+		reader->get<uint32_t>();
+
+		const char *name = reader->take(nameLength);
+		const char *paramTypes = reader->take(func.paramCount);
+		if (name == nullptr || paramTypes == nullptr) {
+			return false;
+		}
+
+		func.name.assign(name, nameLength);
+		func.paramTypes.clear();
+		for (uint16_t param = 0; param < func.paramCount; param++) {
+			func.paramTypes.push_back(unpackType(static_cast<uint8_t>(paramTypes[param])));
+		}
+
+		reader->getArray(&func.code, codeCount);
+		reader->getArray(&func.positions, codeCount);
+		reader->getArray(&func.safepoints, safepointCount);
+		reader->getArray(&func.refStarts, refStartCount);
+		reader->getArray(&func.refRegs, refRegCount);
+
+		if (!reader->valid || func.code.empty() || refStartCount != safepointCount + 1) {
+			return false;
+		}
+
+		// The checksum catches damaged files, and what the compiler wrote is trusted
+		// beyond that, but an opcode is never allowed to index past the dispatch table
+		for (const Instr &instr : func.code) {
+			if (instr.op >= OP_COUNT) {
+				return false;
+			}
+		}
+	}
+
+	return reader->valid && reader->cursor == reader->end;
+}
+
+/**
+ * Appends a number as its bytes.
+ * @tparam T Type of the number.
+ * @param out String to append to.
+ * @param value Number to append.
+ */
+template <typename T>
+static void put(std::string *out, T value) {
+	out->append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+/**
+ * Appends bytes, then zeros up to the next multiple of 8 bytes.
+ * @param out String to append to.
+ * @param data First byte.
+ * @param size Number of bytes.
+ */
+static void putArray(std::string *out, const void *data, size_t size) {
+	if (size > 0) {
+		out->append(static_cast<const char *>(data), size);
+	}
+	out->append((8 - size % 8) % 8, '\0');
+}
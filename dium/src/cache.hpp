@@ -0,0 +1,147 @@
+/**
+ * @file       cache.hpp
+ * @brief      Definitions for the on-disk cache of compiled programs
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "bytecode.hpp"
+#include "optimizer.hpp"
+
+/** First bytes of every cache file */
+#define DMC_MAGIC "DIUMDMC"
+
+/** Version of the layout of cache files, bumped whenever it changes */
+#define DMC_VERSION 1
+
+/**
+ * Version of the compiler, bumped whenever the same source compiles to different
+ * bytecode. Cache files of other versions are ignored and replaced. The tests build
+ * an interpreter of another version by defining it for cache.cpp, the only file that
+ * uses it.
+ */
+#ifndef DMC_COMPILER_VERSION
+	#define DMC_COMPILER_VERSION 1
+#endif
+
+/** Written as a number so that files from machines of the other byte order are rejected */
+#define DMC_BYTE_ORDER 0x01020304u
+
+/**
+ * Start of a cache file (".dmc"). Everything after it is the payload: the module's
+ * counts, constants and functions, with every array padded to 8 bytes. The file is
+ * mapped when loaded, but its arrays are copied, since the module owns its vectors.
+ */
+struct DmcHeader {
+	/** `DMC_MAGIC`, zero-terminated */
+	char magic[8];
+
+	/** `DMC_VERSION` */
+	uint32_t version;
+
+	/** `DMC_BYTE_ORDER` */
+	uint32_t byteOrder;
+
+	/** Hash of the source file */
+	uint64_t sourceHash;
+
+	/** Size of the source file */
+	uint64_t sourceSize;
+
+	/** Hash of the compiler version, optimization level and instruction set */
+	uint64_t compilerHash;
+
+	/** Size of the payload */
+	uint64_t payloadSize;
+
+	/** Hash of the payload, to catch truncated and damaged files */
+	uint64_t payloadChecksum;
+};
+
+static_assert(sizeof(DmcHeader) == 56, "The header of cache files must not change size by accident");
+
+/**
+ * Cache of compiled programs, with a file for every source file and compiler version
+ * named after a hash of both. Source files are looked up by content, so renaming or
+ * touching them keeps their compiled program, while any edit or a new compiler misses
+ * the cache. Missing, stale and damaged files are simply ignored: the program is then
+ * compiled as usual, and the file replaced.
+ */
+class BytecodeCache {
+public:
+	/**
+	 * Creates a cache for one source file.
+	 * @param directory Directory the cache files are kept in.
+	 * @param source Text of the source file.
+	 * @param size Number of characters in the source file.
+	 * @param optLevel Optimization level the program is compiled at.
+	 */
+	BytecodeCache(const std::string &directory, const char *source, size_t size, OptLevel optLevel);
+
+	/**
+	 * Loads the compiled program of the source file.
+	 * @param name Name of the source file, for error messages.
+	 * @param[out] module Module to fill.
+	 * @returns `true` if the cache held a valid program for this source and compiler, `false` otherwise.
+	 */
+	bool load(const std::string &name, Module *module) const;
+
+	/**
+	 * Saves the compiled program of the source file. The file is written under a
+	 * temporary name and renamed, so that concurrent runs never see half of it.
+	 * @param module Compiled and optimized module.
+	 * @returns `true` if the file was written, `false` otherwise.
+	 */
+	bool save(const Module &module) const;
+
+	/**
+	 * Returns the path of the cache file of the source file.
+	 * @returns Path of the cache file.
+	 */
+	const std::string &getPath() const {
+		return path;
+	}
+
+	/**
+	 * Returns the directory cache files are kept in by default: `$XDG_CACHE_HOME/dium`,
+	 * `~/.cache/dium`, or `%LOCALAPPDATA%\dium` on Windows.
+	 * @returns Path of the directory, or an empty string if there is no home directory.
+	 */
+	static std::string getDefaultDirectory();
+
+private:
+	/** Directory the cache files are kept in */
+	std::string directory;
+
+	/** Path of the cache file */
+	std::string path;
+
+	/** Hash of the source file */
+	uint64_t sourceHash;
+
+	/** Size of the source file */
+	uint64_t sourceSize;
+
+	/** Hash of the compiler version */
+	uint64_t compilerHash;
+};
+
+/**
+ * Hashes bytes with 64-bit FNV-1a.
+ * @param data First byte.
+ * @param size Number of bytes.
+ * @param hash Hash to continue from, for hashing several pieces as one.
+ * @returns Hash of the bytes.
+ */
+uint64_t hashBytes(const void *data, size_t size, uint64_t hash = 14695981039346656037ull);
+
+#endif // CACHE_HPP
@@ -0,0 +1,1164 @@
+/**
+ * @file       cbackend.cpp
+ * @brief      Implementation of the ahead-of-time C backend
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <cinttypes>
+#include "cbackend.hpp"
+#include "error.hpp"
+#include "token.hpp"
+
+/*
+ * Runtime support included at the top of every generated program. It is split into
+ * pieces to stay below the string literal limits of some compilers. Packed types
+ * follow `packType`: the base type in the low 3 bits, array dimensions above.
+ */
+static const char *const runtimeParts[] = {
+R"(#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Not every program needs every helper, nor every loop its variable */
+#ifdef __GNUC__
+#pragma GCC diagnostic ignored "-Wunused-function"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#endif
+
+typedef struct dm_str {
+	uint32_t length;
+	char chars[];
+} dm_str;
+
+typedef struct dm_array dm_array;
+
+typedef union dm_value {
+	int64_t num;
+	double dec;
+	dm_str *str;
+	dm_array *arr;
+} dm_value;
+
+struct dm_array {
+	size_t length;
+	dm_value items[];
+};
+
+typedef struct dm_buf {
+	char *data;
+	size_t length;
+	size_t capacity;
+} dm_buf;
+
+#define DM_MAX_DEPTH 65536
+#define DM_NUM 3
+#define DM_DEC 4
+#define DM_STR 5
+
+static int dm_depth = 0;
+static dm_buf dm_text = { NULL, 0, 0 };
+
+static void dm_fail(const char *where, const char *fmt, ...) {
+	va_list args;
+	fflush(stdout);
+	fputs(where, stderr);
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	fputc('\n', stderr);
+	exit(2);
+}
+
+static void dm_out_of_memory(void) {
+	fflush(stdout);
+	fputs("Out of memory\n", stderr);
+	exit(2);
+}
+
+static void *dm_alloc(size_t size) {
+	void *memory = malloc(size);
+	if (memory == NULL) {
+		dm_out_of_memory();
+	}
+	return memory;
+}
+
+static dm_str *dm_str_new(const char *chars, size_t length) {
+	dm_str *str = (dm_str *)dm_alloc(sizeof(dm_str) + length + 1);
+	str->length = (uint32_t)length;
+	memcpy(str->chars, chars, length);
+	str->chars[length] = '\0';
+	return str;
+}
+
+static dm_str *dm_concat(size_t count, dm_str *const *parts) {
+	size_t length = 0;
+	for (size_t idx = 0; idx < count; idx++) {
+		length += parts[idx]->length;
+	}
+
+	dm_str *str = (dm_str *)dm_alloc(sizeof(dm_str) + length + 1);
+	char *end = str->chars;
+	str->length = (uint32_t)length;
+	for (size_t idx = 0; idx < count; idx++) {
+		memcpy(end, parts[idx]->chars, parts[idx]->length);
+		end += parts[idx]->length;
+	}
+	*end = '\0';
+	return str;
+}
+
+static int dm_str_cmp(const dm_str *a, const dm_str *b) {
+	size_t length = (a->length < b->length) ? a->length : b->length;
+	int order = memcmp(a->chars, b->chars, length);
+	if (order != 0) {
+		return order;
+	}
+	return (a->length < b->length) ? -1 : (a->length > b->length) ? 1 : 0;
+}
+
+static dm_array *dm_array_new(size_t length) {
+	dm_array *array = (dm_array *)dm_alloc(sizeof(dm_array) + length * sizeof(dm_value));
+	array->length = length;
+	return array;
+}
+
+static size_t dm_check_index(const char *where, int64_t idx, size_t length, const char *what) {
+	if ((uint64_t)idx >= length) {
+		dm_fail(where, "Index %" PRId64 " is out of bounds for %s of length %zu", idx, what, length);
+	}
+	return (size_t)idx;
+}
+)",
+R"(
+static int64_t dm_div(const char *where, int64_t a, int64_t b) {
+	if (b == 0) {
+		dm_fail(where, "Division by zero");
+	}
+	return (b == -1) ? (int64_t)(0 - (uint64_t)a) : a / b;
+}
+
+static int64_t dm_mod(const char *where, int64_t a, int64_t b) {
+	if (b == 0) {
+		dm_fail(where, "Division by zero");
+	}
+	return (b == -1) ? 0 : a % b;
+}
+
+static uint64_t dm_range_count(int64_t start, int64_t stop, int64_t step) {
+	if (step > 0) {
+		return (start < stop) ? ((uint64_t)stop - (uint64_t)start - 1) / (uint64_t)step + 1 : 0;
+	}
+	return (start > stop) ? ((uint64_t)start - (uint64_t)stop - 1) / (0 - (uint64_t)step) + 1 : 0;
+}
+
+static int64_t dm_dec2num(const char *where, double dec) {
+	if (!(dec > -9223372036854775808.0 && dec < 9223372036854775808.0)) {
+		dm_fail(where, "Cannot convert %g to num", dec);
+	}
+	return (int64_t)dec;
+}
+
+static int64_t dm_num2char(const char *where, int64_t num) {
+	if (num < 0 || num > 255) {
+		dm_fail(where, "Cannot convert %" PRId64 " to char", num);
+	}
+	return num;
+}
+
+static int64_t dm_str2char(const char *where, const dm_str *str) {
+	if (str->length != 1) {
+		dm_fail(where, "Cannot convert a string of length %u to char", str->length);
+	}
+	return (unsigned char)str->chars[0];
+}
+
+static int64_t dm_str2num(const char *where, const dm_str *str) {
+	const char *chars = str->chars;
+	const char *end = chars + str->length;
+	int negative = (chars < end && *chars == '-');
+	uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+	uint64_t value = 0;
+
+	chars += negative;
+	if (chars == end) {
+		dm_fail(where, "Cannot convert \"%s\" to num", str->chars);
+	}
+
+	for (; chars < end; chars++) {
+		unsigned digit = (unsigned)(*chars - '0');
+		if (digit > 9 || value > (limit - digit) / 10) {
+			dm_fail(where, "Cannot convert \"%s\" to num", str->chars);
+		}
+		value = value * 10 + digit;
+	}
+
+	return negative ? (int64_t)(0 - value) : (int64_t)value;
+}
+
+static double dm_str2dec(const char *where, const dm_str *str) {
+	char *end = NULL;
+	double dec = 0;
+
+	/* Accept what std::from_chars does: no leading whitespace, '+' or hexadecimal */
+	int valid = str->length > 0 && str->chars[0] != '+' && strpbrk(str->chars, " \t\n\v\f\rxX") == NULL;
+	if (valid) {
+		errno = 0;
+		dec = strtod(str->chars, &end);
+		/* Subnormal results are fine, values that overflow or vanish to 0 are not */
+		valid = end == str->chars + str->length && (errno == 0 || (dec != 0 && !isinf(dec)));
+	}
+
+	if (!valid) {
+		dm_fail(where, "Cannot convert \"%s\" to dec", str->chars);
+	}
+	return dec;
+}
+)",
+R"(
+static void dm_put(dm_buf *buf, const char *chars, size_t length) {
+	if (buf->length + length > buf->capacity) {
+		size_t capacity = (buf->capacity == 0) ? 64 : buf->capacity;
+		while (capacity < buf->length + length) {
+			capacity *= 2;
+		}
+
+		char *data = (char *)realloc(buf->data, capacity);
+		if (data == NULL) {
+			dm_out_of_memory();
+		}
+		buf->data = data;
+		buf->capacity = capacity;
+	}
+
+	memcpy(buf->data + buf->length, chars, length);
+	buf->length += length;
+}
+
+/* Shortest text that reads back as the same decimal, like std::to_chars */
+static size_t dm_format_dec(double dec, char *out) {
+	char sci[40];
+	char digits[24];
+	const char *chars = sci;
+	size_t count = 0;
+	size_t length = 0;
+	int precision;
+	int exponent;
+
+	if (isnan(dec)) {
+		return (size_t)sprintf(out, signbit(dec) ? "-nan" : "nan");
+	}
+	if (isinf(dec)) {
+		return (size_t)sprintf(out, (dec < 0) ? "-inf" : "inf");
+	}
+
+	for (precision = 0; precision < 17; precision++) {
+		snprintf(sci, sizeof(sci), "%.*e", precision, dec);
+		if (strtod(sci, NULL) == dec) {
+			break;
+		}
+	}
+
+	if (*chars == '-') {
+		out[length++] = '-';
+		chars++;
+	}
+	for (; *chars != 'e'; chars++) {
+		if (*chars != '.') {
+			digits[count++] = *chars;
+		}
+	}
+	exponent = atoi(chars + 1);
+
+	/* Plain notation, unless scientific notation is shorter */
+	if (exponent >= (int)count - 1) {
+		memcpy(out + length, digits, count);
+		length += count;
+		for (int zero = 0; zero < exponent - (int)count + 1; zero++) {
+			out[length++] = '0';
+		}
+	} else if (exponent < 0) {
+		out[length++] = '0';
+		out[length++] = '.';
+		for (int zero = 0; zero < -exponent - 1; zero++) {
+			out[length++] = '0';
+		}
+		memcpy(out + length, digits, count);
+		length += count;
+	} else {
+		memcpy(out + length, digits, (size_t)exponent + 1);
+		length += (size_t)exponent + 1;
+		out[length++] = '.';
+		memcpy(out + length, digits + exponent + 1, count - (size_t)exponent - 1);
+		length += count - (size_t)exponent - 1;
+	}
+
+	if (length > strlen(sci)) {
+		length = strlen(sci);
+		memcpy(out, sci, length);
+	}
+	return length;
+}
+
+static void dm_append(dm_buf *buf, dm_value value, int type) {
+	char text[400];
+	size_t length;
+
+	if (type >> 3) {
+		dm_put(buf, "[", 1);
+		for (size_t idx = 0; idx < value.arr->length; idx++) {
+			if (idx > 0) {
+				dm_put(buf, ", ", 2);
+			}
+			dm_append(buf, value.arr->items[idx], type - 8);
+		}
+		dm_put(buf, "]", 1);
+		return;
+	}
+
+	switch (type) {
+	case 1:
+		dm_put(buf, value.num ? "true" : "false", value.num ? 4 : 5);
+		break;
+	case 2:
+		text[0] = (char)value.num;
+		dm_put(buf, text, 1);
+		break;
+	case DM_NUM:
+		length = (size_t)sprintf(text, "%" PRId64, value.num);
+		dm_put(buf, text, length);
+		break;
+	case DM_DEC:
+		length = dm_format_dec(value.dec, text);
+		if (isfinite(value.dec) && memchr(text, '.', length) == NULL && memchr(text, 'e', length) == NULL) {
+			text[length++] = '.';
+			text[length++] = '0';
+		}
+		dm_put(buf, text, length);
+		break;
+	case DM_STR:
+		dm_put(buf, value.str->chars, value.str->length);
+		break;
+	}
+}
+
+static dm_str *dm_to_str(dm_value value, int type) {
+	dm_text.length = 0;
+	dm_append(&dm_text, value, type);
+	return dm_str_new(dm_text.data, dm_text.length);
+}
+
+static void dm_print(dm_value value, int type, int newline) {
+	dm_text.length = 0;
+	dm_append(&dm_text, value, type);
+	if (newline) {
+		dm_put(&dm_text, "\n", 1);
+	}
+	fwrite(dm_text.data, 1, dm_text.length, stdout);
+}
+)"
+};
+
+// --------------- helpers -------------------------------------
+
+/**
+ * Returns the C type that holds values of a dium type.
+ * @param type Type of the values.
+ * @returns Name of the C type.
+ */
+static const char *getCType(Type type) {
+	if (type.rank > 0) {
+		return "dm_array *";
+	}
+
+	switch (type.base) {
+	case TYPE_VOID:
+		return "void";
+	case TYPE_DEC:
+		return "double";
+	case TYPE_STR:
+		return "dm_str *";
+	default:
+		return "int64_t";
+	}
+}
+
+/**
+ * Returns the C type of a declaration, ready to be followed by the declared name.
+ * @param type Type of the values.
+ * @returns Name of the C type, followed by a space unless it is a pointer.
+ */
+static std::string getSpacedCType(Type type) {
+	std::string ctype = getCType(type);
+	return (ctype.back() == '*') ? ctype : ctype + " ";
+}
+
+/**
+ * Returns the member of `dm_value` that holds values of a type.
+ * @param type Type of the values.
+ * @returns Name of the member.
+ */
+static const char *getField(Type type) {
+	if (type.rank > 0) {
+		return "arr";
+	}
+	return (type.base == TYPE_DEC) ? "dec" : (type.base == TYPE_STR) ? "str" : "num";
+}
+
+/**
+ * Packs a type like `packType`, for the runtime's printing functions.
+ * @param type Type to pack.
+ * @returns Base type in the low 3 bits, array dimensions in the high 5 bits.
+ */
+static int getPackedType(Type type) {
+	return type.base | (type.rank << 3);
+}
+
+/**
+ * Quotes text as a C string literal. Every character outside printable ASCII is
+ * written as an octal escape, which cannot run into the following character.
+ * @param text Text to quote.
+ * @returns C string literal.
+ */
+static std::string quote(std::string_view text) {
+	std::string out = "\"";
+
+	for (char c : text) {
+		auto byte = static_cast<unsigned char>(c);
+
+		if (c == '"' || c == '\\' || c == '?') {
+			out += '\\';
+			out += c;
+		} else if (byte < 0x20 || byte >= 0x7F) {
+			appendFormat(&out, "\\%03o", byte);
+		} else {
+			out += c;
+		}
+	}
+
+	return out + "\"";
+}
+
+/**
+ * Writes a number as a C expression of type `int64_t`.
+ * @param value Number to write.
+ * @returns C expression.
+ */
+static std::string formatNum(int64_t value) {
+	if (value == INT64_MIN) {
+		return "(-INT64_MAX - 1)";
+	}
+	return customFormat("INT64_C(%" PRId64 ")", value);
+}
+
+/**
+ * Writes a decimal as a C literal that reads back as the same value.
+ * @param value Decimal to write.
+ * @returns C expression.
+ */
+static std::string formatDec(double value) {
+	std::string text = customFormat("%.17g", value);
+
+	if (text.find_first_of(".en") == std::string::npos) {
+		text += ".0";
+	}
+	return text;
+}
+
+// --------------- generator -----------------------------------
+
+CBackend::CBackend(const Program *program, std::string name)
+	: program{ program }, name{ std::move(name) } {
+}
+
+std::string CBackend::generate() {
+	std::string prototypes;
+
+	for (uint32_t idx = 0; idx < program->count; idx++) {
+		const FuncDecl *decl = program->funcs[idx];
+		std::string signature = customFormat("static %sf_%.*s(", getSpacedCType(decl->returnType).c_str(), static_cast<int>(decl->name.length), decl->name.text);
+
+		for (uint32_t param = 0; param < decl->paramCount; param++) {
+			signature += (param > 0) ? ", " : "";
+			signature += getCType(decl->params[param].type);
+		}
+
+		prototypes += signature + ((decl->paramCount == 0) ? "void);\n" : ");\n");
+		genFunc(decl);
+	}
+
+	std::string out = customFormat("/* Generated by dium from %s */\n\n", name.c_str());
+	for (const char *part : runtimeParts) {
+		out += part;
+	}
+
+	out += "\n/* String literals */\n";
+	for (size_t idx = 0; idx < strings.size(); idx++) {
+		appendFormat(&out, "static dm_str *k%zu;\n", idx);
+	}
+
+	out += "\n/* Positions of runtime errors */\n";
+	for (size_t idx = 0; idx < wheres.size(); idx++) {
+		appendFormat(&out, "static const char w%zu[] = %s;\n", idx, quote(wheres[idx]).c_str());
+	}
+
+	out += "\n" + prototypes + funcs;
+
+	out += "\nint main(void) {\n";
+	for (size_t idx = 0; idx < strings.size(); idx++) {
+		appendFormat(&out, "\tk%zu = dm_str_new(%s, %zu);\n", idx, quote(strings[idx]).c_str(), strings[idx].size());
+	}
+	out += "\tf_main();\n\tfflush(stdout);\n\treturn 0;\n}\n";
+
+	return out;
+}
+
+/**
+ * Generates the definition of a function.
+ * @param decl Function to generate.
+ */
+void CBackend::genFunc(const FuncDecl *decl) {
+	body.clear();
+	temps.clear();
+	locals.clear();
+	scopeStart = 0;
+	counter = 0;
+	depth = 1;
+
+	std::string signature = customFormat("static %sf_%.*s(", getSpacedCType(decl->returnType).c_str(), static_cast<int>(decl->name.length), decl->name.text);
+
+	for (uint32_t idx = 0; idx < decl->paramCount; idx++) {
+		const Param &param = decl->params[idx];
+		signature += (idx > 0) ? ", " : "";
+		signature += getSpacedCType(param.type) + newLocal(param.name);
+	}
+
+	// Parameters share the scope of the body
+	for (uint32_t idx = 0; idx < decl->body->count; idx++) {
+		genStatement(decl->body->stmts[idx]);
+	}
+
+	funcs += "\n" + signature + ((decl->paramCount == 0) ? "void) {\n" : ") {\n") + temps;
+	funcs += (temps.empty() ? "" : "\n") + body + "}\n";
+}
+
+// --------------- statements ----------------------------------
+
+/**
+ * Generates a block of statements in a new scope.
+ * @param block Block to generate.
+ */
+void CBackend::genBlock(const BlockStmt *block) {
+	size_t outerStart = scopeStart;
+	scopeStart = locals.size();
+
+	for (uint32_t idx = 0; idx < block->count; idx++) {
+		genStatement(block->stmts[idx]);
+	}
+
+	locals.resize(scopeStart);
+	scopeStart = outerStart;
+}
+
+/**
+ * Generates a single statement.
+ * @param stmt Statement to generate.
+ */
+void CBackend::genStatement(const Stmt *stmt) {
+	switch (stmt->kind) {
+	case STMT_BLOCK:
+		line("{");
+		depth++;
+		genBlock(static_cast<const BlockStmt *>(stmt));
+		depth--;
+		line("}");
+		break;
+	case STMT_VAR: {
+		auto var = static_cast<const VarStmt *>(stmt);
+
+		// The variable is only in scope after its initial value
+		std::string value = (var->value != nullptr) ? genExpr(var->value) : genDefault(var->type);
+		std::string cname = newLocal(var->name);
+		line(customFormat("%s%s = %s;", getSpacedCType(var->type).c_str(), cname.c_str(), value.c_str()));
+		break;
+	}
+	case STMT_ASSIGN: {
+		auto assign = static_cast<const AssignStmt *>(stmt);
+
+		if (assign->target->kind == EXPR_INDEX) {
+			auto index = static_cast<const IndexExpr *>(assign->target);
+			std::string array = genExpr(index->array);
+			std::string idx = genExpr(index->index);
+			std::string value = genExpr(assign->value);
+
+			line(customFormat("%s->items[dm_check_index(%s, %s, %s->length, \"an array\")].%s = %s;", array.c_str(),
+				where(assign->position).c_str(), idx.c_str(), array.c_str(), getField(assign->value->type), value.c_str()));
+		} else {
+			std::string value = genExpr(assign->value);
+			line(customFormat("%s = %s;", findLocal(static_cast<const NameExpr *>(assign->target)->name).c_str(), value.c_str()));
+		}
+		break;
+	}
+	case STMT_EXPR: {
+		std::string value = genExpr(static_cast<const ExprStmt *>(stmt)->expr);
+		if (!value.empty()) {
+			line(customFormat("(void)%s;", value.c_str()));
+		}
+		break;
+	}
+	case STMT_IF: {
+		auto branch = static_cast<const IfStmt *>(stmt);
+		std::string cond = genExpr(branch->cond);
+
+		line(customFormat("if (%s) {", cond.c_str()));
+		depth++;
+		genBlock(branch->then);
+		depth--;
+
+		if (branch->otherwise != nullptr) {
+			// `elsif` conditions may need statements of their own, so they nest
+			line("} else {");
+			depth++;
+			genStatement(branch->otherwise);
+			depth--;
+		}
+		line("}");
+		break;
+	}
+	case STMT_WHILE: {
+		auto loop = static_cast<const WhileStmt *>(stmt);
+
+		// The condition may need statements, so it is checked inside the loop
+		line("for (;;) {");
+		depth++;
+		std::string cond = genExpr(loop->cond);
+		line(customFormat("if (!%s) {", cond.c_str()));
+		line("\tbreak;");
+		line("}");
+		genBlock(loop->body);
+		depth--;
+		line("}");
+		break;
+	}
+	case STMT_FOR:
+		genFor(static_cast<const ForStmt *>(stmt));
+		break;
+	case STMT_RETURN: {
+		auto ret = static_cast<const ReturnStmt *>(stmt);
+
+		if (ret->value == nullptr) {
+			line("return;");
+		} else {
+			std::string value = genExpr(ret->value);
+			line(customFormat("return %s;", value.c_str()));
+		}
+		break;
+	}
+	case STMT_PRINT: {
+		auto print = static_cast<const PrintStmt *>(stmt);
+
+		if (print->value != nullptr) {
+			Type type = print->value->type;
+			std::string value = genExpr(print->value);
+
+			line(customFormat("dm_print((dm_value){ .%s = %s }, %d, %d);", getField(type), value.c_str(),
+				getPackedType(type), print->newline ? 1 : 0));
+		} else if (print->newline) {
+			line("putchar('\\n');");
+		}
+		break;
+	}
+	case STMT_EXIT: {
+		std::string code = genExpr(static_cast<const ExitStmt *>(stmt)->code);
+		line("fflush(stdout);");
+		line(customFormat("exit((int)%s);", code.c_str()));
+		break;
+	}
+	case STMT_BREAK:
+		line("break;");
+		break;
+	case STMT_CONTINUE:
+		line("continue;");
+		break;
+	}
+}
+
+/**
+ * Generates a `for` loop over a range as a counted loop, like RANGE and FORITER. The
+ * next value is worked out before the body runs, so `continue` needs no special
+ * handling.
+ * @param loop Loop to generate.
+ */
+void CBackend::genFor(const ForStmt *loop) {
+	Type num{ TYPE_NUM, 0 };
+	std::string start = (loop->start != nullptr) ? genExpr(loop->start) : "INT64_C(0)";
+	std::string next = newTemp(num);
+	line(customFormat("%s = %s;", next.c_str(), start.c_str()));
+
+	std::string stop = newTemp(num);
+	line(customFormat("%s = %s;", stop.c_str(), genExpr(loop->stop).c_str()));
+
+	std::string step = newTemp(num);
+	line(customFormat("%s = %s;", step.c_str(), (loop->step != nullptr) ? genExpr(loop->step).c_str() : "INT64_C(1)"));
+
+	line(customFormat("if (%s == 0) {", step.c_str()));
+	line(customFormat("\tdm_fail(%s, \"The step of 'range' cannot be 0\");", where(loop->position).c_str()));
+	line("}");
+
+	size_t outerStart = scopeStart;
+	scopeStart = locals.size();
+
+	std::string count = customFormat("t%d", counter++);
+	line(customFormat("for (uint64_t %s = dm_range_count(%s, %s, %s); %s != 0; %s--) {", count.c_str(), next.c_str(), stop.c_str(), step.c_str(), count.c_str(), count.c_str()));
+	depth++;
+	std::string var = newLocal(loop->name);
+	line(customFormat("int64_t %s = %s;", var.c_str(), next.c_str()));
+	line(customFormat("%s = (int64_t)((uint64_t)%s + (uint64_t)%s);", next.c_str(), next.c_str(), step.c_str()));
+	genBlock(loop->body);
+	depth--;
+	line("}");
+
+	locals.resize(scopeStart);
+	scopeStart = outerStart;
+}
+
+// --------------- expressions ---------------------------------
+
+/**
+ * Generates the statements computing an expression.
+ * @param expr Expression to generate.
+ * @returns C expression for the value, free of side effects, or an empty string for
+ * a call to a void function.
+ */
+std::string CBackend::genExpr(const Expr *expr) {
+	switch (expr->kind) {
+	case EXPR_NUM:
+		return formatNum(static_cast<const NumExpr *>(expr)->value);
+	case EXPR_DEC:
+		return formatDec(static_cast<const DecExpr *>(expr)->value);
+	case EXPR_BOOL:
+		return static_cast<const BoolExpr *>(expr)->value ? "INT64_C(1)" : "INT64_C(0)";
+	case EXPR_CHAR:
+		return customFormat("INT64_C(%d)", static_cast<unsigned char>(static_cast<const CharExpr *>(expr)->value));
+	case EXPR_STR: {
+		auto str = static_cast<const StrExpr *>(expr);
+		std::string_view raw(str->text, str->length);
+		return addString(str->escaped ? unescapeString(raw) : std::string(raw));
+	}
+	case EXPR_NAME:
+		return findLocal(static_cast<const NameExpr *>(expr)->name);
+	case EXPR_ARRAY: {
+		auto array = static_cast<const ArrayExpr *>(expr);
+		Type itemType{ expr->type.base, static_cast<uint8_t>(expr->type.rank - 1) };
+		std::vector<std::string> items;
+
+		for (uint32_t idx = 0; idx < array->count; idx++) {
+			items.push_back(genExpr(array->items[idx]));
+		}
+
+		std::string temp = newTemp(expr->type);
+		line(customFormat("%s = dm_array_new(%u);", temp.c_str(), array->count));
+		for (uint32_t idx = 0; idx < array->count; idx++) {
+			line(customFormat("%s->items[%u].%s = %s;", temp.c_str(), idx, getField(itemType), items[idx].c_str()));
+		}
+		return temp;
+	}
+	case EXPR_UNARY: {
+		auto unary = static_cast<const UnaryExpr *>(expr);
+		std::string operand = genExpr(unary->operand);
+		std::string temp = newTemp(expr->type);
+
+		if (unary->op == TOK_NOT) {
+			line(customFormat("%s = !%s;", temp.c_str(), operand.c_str()));
+		} else if (expr->type.base == TYPE_DEC) {
+			line(customFormat("%s = -%s;", temp.c_str(), operand.c_str()));
+		} else {
+			line(customFormat("%s = (int64_t)(0 - (uint64_t)%s);", temp.c_str(), operand.c_str()));
+		}
+		return temp;
+	}
+	case EXPR_BINARY:
+		return genBinary(static_cast<const BinaryExpr *>(expr));
+	case EXPR_INDEX: {
+		auto index = static_cast<const IndexExpr *>(expr);
+		std::string array = genExpr(index->array);
+		std::string idx = genExpr(index->index);
+		std::string temp = newTemp(expr->type);
+		std::string at = where(expr->position);
+
+		if (index->array->type.rank > 0) {
+			line(customFormat("%s = %s->items[dm_check_index(%s, %s, %s->length, \"an array\")].%s;", temp.c_str(),
+				array.c_str(), at.c_str(), idx.c_str(), array.c_str(), getField(expr->type)));
+		} else {
+			line(customFormat("%s = (unsigned char)%s->chars[dm_check_index(%s, %s, %s->length, \"a string\")];", temp.c_str(),
+				array.c_str(), at.c_str(), idx.c_str(), array.c_str()));
+		}
+		return temp;
+	}
+	case EXPR_CALL:
+		return genCall(static_cast<const CallExpr *>(expr));
+	case EXPR_CAST:
+		return genCast(static_cast<const CastExpr *>(expr));
+	}
+
+	return "";
+}
+
+/**
+ * Generates a binary operator, along with the chain of operators of the same kind that
+ * make up its left operand, such as the terms of a long sum. The chain is flat in the
+ * source, so it is generated in a loop from the innermost operator out.
+ * @param binary Outermost operator of the chain.
+ * @returns C expression for the value.
+ */
+std::string CBackend::genBinary(const BinaryExpr *binary) {
+	if (binary->op == TOK_PLUS && binary->type.base == TYPE_STR && binary->type.rank == 0) {
+		return genConcat(binary);
+	}
+
+	bool logical = (binary->op == TOK_AND || binary->op == TOK_OR);
+	std::vector<const BinaryExpr *> chain{ binary };
+	while (chain.back()->lhs->kind == EXPR_BINARY) {
+		auto lhs = static_cast<const BinaryExpr *>(chain.back()->lhs);
+		bool concat = lhs->op == TOK_PLUS && lhs->type.base == TYPE_STR && lhs->type.rank == 0;
+		if ((lhs->op == TOK_AND || lhs->op == TOK_OR) != logical || concat) {
+			break;
+		}
+		chain.push_back(lhs);
+	}
+
+	// Short-circuit: the right operand is only evaluated when it decides the value.
+	// Every operator of the chain has a variable, named from the outermost in.
+	if (logical) {
+		std::vector<std::string> temps;
+		for (const BinaryExpr *link : chain) {
+			temps.push_back(newTemp(link->type));
+		}
+
+		std::string value = genExpr(chain.back()->lhs);
+		for (size_t idx = chain.size(); idx-- > 0;) {
+			const char *temp = temps[idx].c_str();
+			line(customFormat("%s = %s;", temp, value.c_str()));
+			line(customFormat((chain[idx]->op == TOK_AND) ? "if (%s) {" : "if (!%s) {", temp));
+			depth++;
+			std::string rhs = genExpr(chain[idx]->rhs);
+			line(customFormat("%s = %s;", temp, rhs.c_str()));
+			depth--;
+			line("}");
+			value = temps[idx];
+		}
+		return value;
+	}
+
+	std::string value = genExpr(chain.back()->lhs);
+	for (size_t idx = chain.size(); idx-- > 0;) {
+		value = genOperator(chain[idx], value);
+	}
+	return value;
+}
+
+/**
+ * Generates a binary operator other than `and`, `or` and string `+`, whose left
+ * operand is already generated. The type checker has converted both operands to the
+ * same type, which selects the operation.
+ * @param binary Expression to generate.
+ * @param lhs C expression for the left operand.
+ * @returns C expression for the value.
+ */
+std::string CBackend::genOperator(const BinaryExpr *binary, const std::string &lhs) {
+	Type type = binary->lhs->type;
+	std::string rhs = genExpr(binary->rhs);
+	std::string temp = newTemp(binary->type);
+	const char *l = lhs.c_str();
+	const char *r = rhs.c_str();
+	const char *t = temp.c_str();
+	bool isNum = (type.rank == 0 && type.base != TYPE_DEC && type.base != TYPE_STR);
+
+	// Strings are compared by their characters, everything else by value
+	std::string a = lhs;
+	std::string b = rhs;
+	if (type.rank == 0 && type.base == TYPE_STR && binary->op != TOK_PLUS) {
+		a = customFormat("dm_str_cmp(%s, %s)", l, r);
+		b = "0";
+	}
+
+	switch (binary->op) {
+	case TOK_PLUS:
+		if (isNum) {
+			line(customFormat("%s = (int64_t)((uint64_t)%s + (uint64_t)%s);", t, l, r));
+		} else {
+			line(customFormat("%s = %s + %s;", t, l, r));
+		}
+		break;
+	case TOK_MINUS:
+		line(isNum ? customFormat("%s = (int64_t)((uint64_t)%s - (uint64_t)%s);", t, l, r) : customFormat("%s = %s - %s;", t, l, r));
+		break;
+	case TOK_MUL:
+		line(isNum ? customFormat("%s = (int64_t)((uint64_t)%s * (uint64_t)%s);", t, l, r) : customFormat("%s = %s * %s;", t, l, r));
+		break;
+	case TOK_DIV:
+		line(isNum ? customFormat("%s = dm_div(%s, %s, %s);", t, where(binary->position).c_str(), l, r)
+			: customFormat("%s = %s / %s;", t, l, r));
+		break;
+	case TOK_MOD:
+		line(isNum ? customFormat("%s = dm_mod(%s, %s, %s);", t, where(binary->position).c_str(), l, r)
+			: customFormat("%s = fmod(%s, %s);", t, l, r));
+		break;
+	case TOK_EQ:
+		line(customFormat("%s = %s == %s;", t, a.c_str(), b.c_str()));
+		break;
+	case TOK_NE:
+		line(customFormat("%s = %s != %s;", t, a.c_str(), b.c_str()));
+		break;
+	case TOK_LT:
+		line(customFormat("%s = %s < %s;", t, a.c_str(), b.c_str()));
+		break;
+	case TOK_LE:
+		line(customFormat("%s = %s <= %s;", t, a.c_str(), b.c_str()));
+		break;
+	case TOK_GT:
+		line(customFormat("%s = %s > %s;", t, a.c_str(), b.c_str()));
+		break;
+	case TOK_GE:
+		line(customFormat("%s = %s >= %s;", t, a.c_str(), b.c_str()));
+		break;
+	default:
+		break;
+	}
+
+	return temp;
+}
+
+/**
+ * Generates a chain of string concatenations such as `"n = " + n + "!"` as a single
+ * call, which allocates the result once instead of every partial string.
+ * @param binary Outermost `+` of the chain.
+ * @returns C expression for the string.
+ */
+std::string CBackend::genConcat(const BinaryExpr *binary) {
+	// Concatenation is associative, so every nested string `+` joins the chain
+	std::vector<std::string> parts;
+	std::vector<const Expr *> pending{ binary };
+
+	while (!pending.empty()) {
+		const Expr *expr = pending.back();
+		pending.pop_back();
+
+		if (expr->kind == EXPR_BINARY && static_cast<const BinaryExpr *>(expr)->op == TOK_PLUS
+			&& expr->type.base == TYPE_STR && expr->type.rank == 0) {
+			pending.push_back(static_cast<const BinaryExpr *>(expr)->rhs);
+			pending.push_back(static_cast<const BinaryExpr *>(expr)->lhs);
+		} else {
+			parts.push_back(genExpr(expr));
+		}
+	}
+
+	std::string list;
+	for (size_t idx = 0; idx < parts.size(); idx++) {
+		list += (idx > 0) ? ", " : "";
+		list += parts[idx];
+	}
+
+	std::string temp = newTemp(binary->type);
+	line(customFormat("%s = dm_concat(%zu, (dm_str *const[]){ %s });", temp.c_str(), parts.size(), list.c_str()));
+	return temp;
+}
+
+/**
+ * Generates a function call, counting the depth of calls like the interpreter does.
+ * @param call Call to generate.
+ * @returns C expression for the returned value, or an empty string for a void function.
+ */
+std::string CBackend::genCall(const CallExpr *call) {
+	std::string args;
+
+	for (uint32_t idx = 0; idx < call->count; idx++) {
+		args += (idx > 0) ? ", " : "";
+		args += genExpr(call->args[idx]);
+	}
+
+	line("if (++dm_depth >= DM_MAX_DEPTH) {");
+	line(customFormat("\tdm_fail(%s, \"Stack overflow when calling '%.*s'\");", where(call->position).c_str(),
+		static_cast<int>(call->name.length), call->name.text));
+	line("}");
+
+	std::string callee = customFormat("f_%.*s(%s)", static_cast<int>(call->name.length), call->name.text, args.c_str());
+	std::string temp;
+
+	if (call->type.base == TYPE_VOID && call->type.rank == 0) {
+		line(callee + ";");
+	} else {
+		temp = newTemp(call->type);
+		line(customFormat("%s = %s;", temp.c_str(), callee.c_str()));
+	}
+
+	line("dm_depth--;");
+	return temp;
+}
+
+/**
+ * Generates a conversion to another type.
+ * @param cast Conversion to generate.
+ * @returns C expression for the converted value.
+ */
+std::string CBackend::genCast(const CastExpr *cast) {
+	Type from = cast->operand->type;
+	Type to = cast->target;
+	std::string operand = genExpr(cast->operand);
+
+	if (sameType(from, to)) {
+		return operand;
+	}
+
+	std::string temp = newTemp(to);
+	const char *t = temp.c_str();
+	const char *o = operand.c_str();
+
+	if (to.base == TYPE_STR) {
+		line(customFormat("%s = dm_to_str((dm_value){ .%s = %s }, %d);", t, getField(from), o, getPackedType(from)));
+		return temp;
+	}
+
+	switch (from.base) {
+	case TYPE_NUM:
+		if (to.base == TYPE_DEC) {
+			line(customFormat("%s = (double)%s;", t, o));
+		} else if (to.base == TYPE_CHAR) {
+			line(customFormat("%s = dm_num2char(%s, %s);", t, where(cast->position).c_str(), o));
+		} else if (to.base == TYPE_BOOL) {
+			line(customFormat("%s = %s != 0;", t, o));
+		} else {
+			line(customFormat("%s = %s;", t, o));
+		}
+		break;
+	case TYPE_DEC:
+		line(customFormat("%s = dm_dec2num(%s, %s);", t, where(cast->position).c_str(), o));
+		break;
+	case TYPE_STR:
+		line(customFormat("%s = dm_str2%s(%s, %s);", t, (to.base == TYPE_DEC) ? "dec" : (to.base == TYPE_CHAR) ? "char" : "num",
+			where(cast->position).c_str(), o));
+		break;
+	default:
+		// `bool` and `char` are already numbers
+		line(customFormat("%s = %s;", t, o));
+		break;
+	}
+
+	return temp;
+}
+
+/**
+ * Returns the value of a variable declared without one.
+ * @param type Type of the variable.
+ * @returns C expression for the default value.
+ */
+std::string CBackend::genDefault(Type type) {
+	if (type.rank > 0) {
+		std::string temp = newTemp(type);
+		line(customFormat("%s = dm_array_new(0);", temp.c_str()));
+		return temp;
+	}
+
+	switch (type.base) {
+	case TYPE_DEC:
+		return "0.0";
+	case TYPE_STR:
+		return addString("");
+	default:
+		return "INT64_C(0)";
+	}
+}
+
+// --------------- helpers -------------------------------------
+
+/**
+ * Appends a line to the body of the current function, indented to the current depth.
+ * @param text Line to append.
+ */
+void CBackend::line(const std::string &text) {
+	body.append(static_cast<size_t>(depth), '\t');
+	body += text;
+	body += '\n';
+}
+
+/**
+ * Declares a new temporary at the top of the current function.
+ * @param type Type of the temporary.
+ * @returns Name of the temporary.
+ */
+std::string CBackend::newTemp(Type type) {
+	std::string temp = customFormat("t%d", counter++);
+	appendFormat(&temps, "\t%s%s;\n", getSpacedCType(type).c_str(), temp.c_str());
+	return temp;
+}
+
+/**
+ * Brings a local variable into scope under a name unique within the function, so
+ * that shadowing in C never differs from shadowing in dium.
+ * @param name Name of the variable.
+ * @returns Name of the variable in C.
+ */
+std::string CBackend::newLocal(const Name &name) {
+	std::string cname = customFormat("v%d_%.*s", counter++, static_cast<int>(name.length), name.text);
+	locals.push_back({ name, cname });
+	return cname;
+}
+
+/**
+ * Finds the C name of a variable in scope.
+ * @param name Name of the variable.
+ * @returns Name of the variable in C.
+ */
+const std::string &CBackend::findLocal(const Name &name) const {
+	for (size_t idx = locals.size(); idx-- > 0;) {
+		if (sameName(locals[idx].name, name)) {
+			return locals[idx].cname;
+		}
+	}
+
+	// The type checker has made sure that every variable is declared
+	return locals.back().cname;
+}
+
+/**
+ * Adds a string literal to the literal table, reusing an equal one.
+ * @param text Characters of the string.
+ * @returns C expression for the string.
+ */
+std::string CBackend::addString(std::string text) {
+	auto found = stringIndex.find(text);
+	if (found != stringIndex.end()) {
+		return customFormat("k%zu", found->second);
+	}
+
+	stringIndex.emplace(text, strings.size());
+	strings.push_back(std::move(text));
+	return customFormat("k%zu", strings.size() - 1);
+}
+
+/**
+ * Adds a source position to the table of runtime error positions. Each entry holds
+ * the start of the message as `printErrAt` writes it.
+ * @param pos Position of the operation that may fail.
+ * @returns C expression for the message prefix.
+ */
+std::string CBackend::where(const SourcePosition &pos) {
+	std::string prefix = customFormat("\n%s%s:%s %s%d:%d%s %s ", ASCII_BOLD_WHITE, name.c_str(), ASCII_RESET,
+		ASCII_BOLD_WHITE, pos.line, pos.column, ASCII_RESET, ASCII_BOLD_RED "Error:" ASCII_RESET);
+
+	auto found = whereIndex.find(prefix);
+	if (found != whereIndex.end()) {
+		return customFormat("w%zu", found->second);
+	}
+
+	whereIndex.emplace(prefix, wheres.size());
+	wheres.push_back(std::move(prefix));
+	return customFormat("w%zu", wheres.size() - 1);
+}
@@ -0,0 +1,113 @@
+/**
+ * @file       cbackend.hpp
+ * @brief      Definitions for the ahead-of-time C backend
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef CBACKEND_HPP
+#define CBACKEND_HPP
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ast.hpp"
+
+/**
+ * Lowers a type-checked syntax tree to a self-contained C99 program that any system
+ * C compiler can build. Values use the same representation as the virtual machine
+ * (unboxed `int64_t` and `double`, pointers to strings and arrays), and the generated
+ * program prints the same output and reports the same runtime errors.
+ *
+ * Expressions are flattened into temporaries so that operands are evaluated left to
+ * right, as in the interpreter, whatever order the C compiler picks. Strings and
+ * arrays are never freed: the generated program releases its memory when it exits.
+ */
+class CBackend {
+public:
+	/**
+	 * Creates a C backend for a program.
+	 * @param program Type-checked syntax tree of the program.
+	 * @param name Name of the source file, used in runtime error messages.
+	 */
+	CBackend(const Program *program, std::string name);
+
+	/**
+	 * Generates the C source of the whole program.
+	 * @returns Text of the C program.
+	 */
+	std::string generate();
+
+private:
+	/* Local variable in scope */
+	struct Local {
+		Name name;
+
+		/** Unique name of the variable in the generated function */
+		std::string cname;
+	};
+
+	/** Syntax tree being lowered */
+	const Program *program;
+
+	/** Name of the source file */
+	std::string name;
+
+	/** Definitions of the generated functions */
+	std::string funcs;
+
+	/** Statements of the function being generated */
+	std::string body;
+
+	/** Declarations of the temporaries of the function being generated */
+	std::string temps;
+
+	/** Number of temporaries and locals created in the function being generated */
+	int counter = 0;
+
+	/** Nesting depth of the statement being generated */
+	int depth = 0;
+
+	/** Local variables in scope, innermost last */
+	std::vector<Local> locals;
+
+	/** Index of the first local of the innermost scope */
+	size_t scopeStart = 0;
+
+	/** Index of each string literal in the literal table */
+	std::unordered_map<std::string, size_t> stringIndex;
+
+	/** String literals, created when the program starts */
+	std::vector<std::string> strings;
+
+	/** Index of each runtime error position in the position table */
+	std::unordered_map<std::string, size_t> whereIndex;
+
+	/** Error message prefixes for runtime error positions */
+	std::vector<std::string> wheres;
+
+	void genFunc(const FuncDecl *decl);
+	void genBlock(const BlockStmt *block);
+	void genStatement(const Stmt *stmt);
+	void genFor(const ForStmt *loop);
+	std::string genExpr(const Expr *expr);
+	std::string genBinary(const BinaryExpr *binary);
+	std::string genOperator(const BinaryExpr *binary, const std::string &lhs);
+	std::string genConcat(const BinaryExpr *binary);
+	std::string genCall(const CallExpr *call);
+	std::string genCast(const CastExpr *cast);
+	std::string genDefault(Type type);
+
+	void line(const std::string &text);
+	std::string newTemp(Type type);
+	std::string newLocal(const Name &name);
+	const std::string &findLocal(const Name &name) const;
+	std::string addString(std::string text);
+	std::string where(const SourcePosition &pos);
+};
+
+#endif // CBACKEND_HPP
@@ -0,0 +1,582 @@
+/**
+ * @file       checker.cpp
+ * @brief      Implementation of the static type checker
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include "checker.hpp"
+#include "error.hpp"
+
+/* Types of values without dimensions */
+static constexpr Type voidType{ TYPE_VOID, 0 };
+static constexpr Type boolType{ TYPE_BOOL, 0 };
+static constexpr Type charType{ TYPE_CHAR, 0 };
+static constexpr Type numType{ TYPE_NUM, 0 };
+static constexpr Type decType{ TYPE_DEC, 0 };
+static constexpr Type strType{ TYPE_STR, 0 };
+
+
+Checker::Checker(Program *program, Arena &arena, std::string name)
+	: program{ program }, arena{ arena }, name{ std::move(name) } {
+}
+
+void Checker::check() {
+	for (uint32_t idx = 0; idx < program->count; idx++) {
+		const FuncDecl *decl = program->funcs[idx];
+
+		if (!funcs.emplace(decl->name.symbol, decl).second) {
+			error(decl->position, "Function '%.*s' is already declared", decl->name.length, decl->name.text);
+		}
+	}
+
+	auto entry = funcs.find(SYM_MAIN);
+	if (entry == funcs.end()) {
+		printErrAt(name.c_str(), nullptr, "Missing the 'main' function");
+	}
+	if (entry->second->paramCount != 0) {
+		error(entry->second->position, "The 'main' function cannot take parameters");
+	}
+
+	for (uint32_t idx = 0; idx < program->count; idx++) {
+		checkFunc(program->funcs[idx]);
+	}
+}
+
+// --------------- declarations --------------------------------
+
+/**
+ * Checks a function, including that it returns a value on every path.
+ * @param decl Function to check.
+ */
+void Checker::checkFunc(const FuncDecl *decl) {
+	func = decl;
+	variables.clear();
+	scopeStart = 0;
+	loopDepth = 0;
+
+	// Parameters share the scope of the body, so the body cannot redeclare them
+	for (uint32_t idx = 0; idx < decl->paramCount; idx++) {
+		declare(decl->params[idx].name, decl->params[idx].type, decl->params[idx].position);
+	}
+
+	bool returns = false;
+	for (uint32_t idx = 0; idx < decl->body->count; idx++) {
+		returns |= checkStatement(decl->body->stmts[idx]);
+	}
+
+	if (!returns && decl->returnType.base != TYPE_VOID) {
+		error(decl->position, "Function '%.*s' does not return a value on every path",
+			decl->name.length, decl->name.text);
+	}
+}
+
+// --------------- statements ----------------------------------
+
+/**
+ * Checks a block of statements in a new scope.
+ * @param block Block to check.
+ * @returns `true` if the block always returns (or exits), `false` otherwise.
+ */
+bool Checker::checkBlock(BlockStmt *block) {
+	// The parser keeps the tree within this, but the walk must not rely on it
+	if (++depth > MAX_NESTING_DEPTH) {
+		error(block->position, "Block nested too deeply");
+	}
+
+	size_t outerStart = scopeStart;
+	scopeStart = variables.size();
+
+	bool returns = false;
+	for (uint32_t idx = 0; idx < block->count; idx++) {
+		returns |= checkStatement(block->stmts[idx]);
+	}
+
+	variables.resize(scopeStart);
+	scopeStart = outerStart;
+	depth -= 1;
+	return returns;
+}
+
+/**
+ * Checks a single statement.
+ * @param stmt Statement to check.
+ * @returns `true` if the statement always returns (or exits), `false` otherwise.
+ */
+bool Checker::checkStatement(Stmt *stmt) {
+	switch (stmt->kind) {
+	case STMT_BLOCK:
+		return checkBlock(static_cast<BlockStmt *>(stmt));
+	case STMT_VAR: {
+		auto var = static_cast<VarStmt *>(stmt);
+
+		// The variable is only in scope after its initial value
+		if (var->value != nullptr) {
+			var->value = checkAs(var->value, var->type);
+		}
+
+		declare(var->name, var->type, var->position);
+		return false;
+	}
+	case STMT_ASSIGN: {
+		auto assign = static_cast<AssignStmt *>(stmt);
+		Type target = checkExpr(assign->target);
+
+		if (assign->target->kind == EXPR_INDEX && static_cast<IndexExpr *>(assign->target)->array->type.rank == 0) {
+			error(assign->position, "Cannot assign to a character of a string");
+		}
+
+		assign->value = checkAs(assign->value, target);
+		return false;
+	}
+	case STMT_EXPR:
+		checkExpr(static_cast<ExprStmt *>(stmt)->expr);
+		return false;
+	case STMT_IF: {
+		auto branch = static_cast<IfStmt *>(stmt);
+		branch->cond = checkAs(branch->cond, boolType);
+
+		bool returns = checkBlock(branch->then);
+		bool otherwise = (branch->otherwise != nullptr) && checkStatement(branch->otherwise);
+		return returns && otherwise;
+	}
+	case STMT_WHILE: {
+		auto loop = static_cast<WhileStmt *>(stmt);
+		loop->cond = checkAs(loop->cond, boolType);
+
+		loopDepth += 1;
+		checkBlock(loop->body);
+		loopDepth -= 1;
+		return false;
+	}
+	case STMT_FOR:
+		return checkFor(static_cast<ForStmt *>(stmt));
+	case STMT_RETURN: {
+		auto ret = static_cast<ReturnStmt *>(stmt);
+		bool isVoid = (func->returnType.base == TYPE_VOID);
+
+		if (ret->value == nullptr && !isVoid) {
+			error(ret->position, "Expected a value to return from '%.*s'", func->name.length, func->name.text);
+		}
+		if (ret->value != nullptr && isVoid) {
+			error(ret->position, "Cannot return a value from the void function '%.*s'",
+				func->name.length, func->name.text);
+		}
+
+		if (ret->value != nullptr) {
+			ret->value = checkAs(ret->value, func->returnType);
+		}
+		return true;
+	}
+	case STMT_PRINT: {
+		auto print = static_cast<PrintStmt *>(stmt);
+
+		if (print->value != nullptr && checkExpr(print->value).base == TYPE_VOID) {
+			error(print->value->position, "Cannot print the result of a void function");
+		}
+		return false;
+	}
+	case STMT_EXIT: {
+		auto stop = static_cast<ExitStmt *>(stmt);
+		stop->code = checkAs(stop->code, numType);
+		return true;
+	}
+	case STMT_BREAK:
+		if (loopDepth == 0) {
+			error(stmt->position, "'break' outside of a loop");
+		}
+		return false;
+	case STMT_CONTINUE:
+		if (loopDepth == 0) {
+			error(stmt->position, "'continue' outside of a loop");
+		}
+		return false;
+	}
+
+	return false;
+}
+
+/**
+ * Checks a `for` loop. The loop variable and the arguments of `range` are numbers.
+ * @param loop Loop to check.
+ * @returns `false`, since the body may never run.
+ */
+bool Checker::checkFor(ForStmt *loop) {
+	if (!sameType(loop->type, numType)) {
+		error(loop->position, "The variable of a 'for' loop must be a num, not %s", getTypeName(loop->type).c_str());
+	}
+
+	if (loop->start != nullptr) {
+		loop->start = checkAs(loop->start, numType);
+	}
+	loop->stop = checkAs(loop->stop, numType);
+	if (loop->step != nullptr) {
+		loop->step = checkAs(loop->step, numType);
+	}
+
+	size_t outerStart = scopeStart;
+	scopeStart = variables.size();
+	declare(loop->name, loop->type, loop->position);
+
+	loopDepth += 1;
+	checkBlock(loop->body);
+	loopDepth -= 1;
+
+	variables.resize(scopeStart);
+	scopeStart = outerStart;
+	return false;
+}
+
+// --------------- expressions ---------------------------------
+
+/**
+ * Resolves the type of an expression and its operands.
+ * @param expr Expression to check.
+ * @param expected Type the value is used as, if known (needed for `[]`).
+ * @returns Type of the expression, also stored in `expr->type`.
+ */
+Type Checker::checkExpr(Expr *expr, const Type *expected) {
+	if (++depth > MAX_NESTING_DEPTH) {
+		error(expr->position, "Expression nested too deeply");
+	}
+
+	switch (expr->kind) {
+	case EXPR_NUM:
+		expr->type = numType;
+		break;
+	case EXPR_DEC:
+		expr->type = decType;
+		break;
+	case EXPR_BOOL:
+		expr->type = boolType;
+		break;
+	case EXPR_CHAR:
+		expr->type = charType;
+		break;
+	case EXPR_STR:
+		expr->type = strType;
+		break;
+	case EXPR_NAME:
+		expr->type = lookup(static_cast<NameExpr *>(expr)->name, expr->position);
+		break;
+	case EXPR_ARRAY: {
+		auto array = static_cast<ArrayExpr *>(expr);
+		bool known = (expected != nullptr && expected->rank > 0);
+
+		if (array->count == 0) {
+			if (!known) {
+				error(expr->position, "Cannot tell the type of an empty array here");
+			}
+			expr->type = *expected;
+			break;
+		}
+
+		// Without an expected type, the first item decides the type of the others
+		Type item = known ? Type{ expected->base, static_cast<uint8_t>(expected->rank - 1) } : checkExpr(array->items[0]);
+		if (item.base == TYPE_VOID) {
+			error(array->items[0]->position, "Arrays cannot hold the result of a void function");
+		}
+		if (item.rank == MAX_ARRAY_RANK) {
+			error(expr->position, "Arrays cannot have more than %d dimensions", MAX_ARRAY_RANK);
+		}
+
+		for (uint32_t idx = 0; idx < array->count; idx++) {
+			array->items[idx] = checkAs(array->items[idx], item);
+		}
+
+		expr->type = Type{ item.base, static_cast<uint8_t>(item.rank + 1) };
+		break;
+	}
+	case EXPR_UNARY: {
+		auto unary = static_cast<UnaryExpr *>(expr);
+		Type operand = checkExpr(unary->operand);
+
+		if (unary->op == TOK_NOT && !sameType(operand, boolType)) {
+			error(expr->position, "Cannot apply '!' to %s", getTypeName(operand).c_str());
+		}
+		if (unary->op == TOK_MINUS && !isNumericType(operand)) {
+			error(expr->position, "Cannot negate %s", getTypeName(operand).c_str());
+		}
+
+		expr->type = operand;
+		break;
+	}
+	case EXPR_BINARY:
+		expr->type = checkBinary(static_cast<BinaryExpr *>(expr));
+		break;
+	case EXPR_INDEX: {
+		auto index = static_cast<IndexExpr *>(expr);
+		Type array = checkExpr(index->array);
+
+		if (array.rank == 0 && array.base != TYPE_STR) {
+			error(expr->position, "Cannot index %s", getTypeName(array).c_str());
+		}
+
+		index->index = checkAs(index->index, numType);
+		expr->type = (array.rank > 0) ? Type{ array.base, static_cast<uint8_t>(array.rank - 1) } : charType;
+		break;
+	}
+	case EXPR_CALL:
+		expr->type = checkCall(static_cast<CallExpr *>(expr));
+		break;
+	case EXPR_CAST:
+		expr->type = checkCast(static_cast<CastExpr *>(expr));
+		break;
+	}
+
+	depth -= 1;
+	return expr->type;
+}
+
+/**
+ * Resolves the type of a binary operator and of the chain of operators that make up
+ * its left operand, such as the terms of a long sum. The chain is flat in the source,
+ * so it is walked in a loop from the innermost operator out.
+ * @param binary Outermost operator of the chain.
+ * @returns Type of the result.
+ */
+Type Checker::checkBinary(BinaryExpr *binary) {
+	std::vector<BinaryExpr *> chain{ binary };
+	while (chain.back()->lhs->kind == EXPR_BINARY) {
+		chain.push_back(static_cast<BinaryExpr *>(chain.back()->lhs));
+	}
+
+	Type lhs = checkExpr(chain.back()->lhs);
+	for (size_t idx = chain.size(); idx-- > 0;) {
+		lhs = checkOperator(chain[idx], lhs);
+		chain[idx]->type = lhs;
+	}
+	return lhs;
+}
+
+/**
+ * Resolves the type of a binary operator whose left operand is already checked,
+ * converting its operands where needed.
+ * @param binary Expression to check.
+ * @param lhs Type of the left operand.
+ * @returns Type of the result.
+ */
+Type Checker::checkOperator(BinaryExpr *binary, Type lhs) {
+	Type rhs = checkExpr(binary->rhs);
+	std::string op = getTokenString(binary->op);
+
+	if (lhs.base == TYPE_VOID || rhs.base == TYPE_VOID) {
+		error(binary->position, "Cannot apply %s to the result of a void function", op.c_str());
+	}
+
+	switch (binary->op) {
+	case TOK_AND:
+	case TOK_OR:
+		if (!sameType(lhs, boolType) || !sameType(rhs, boolType)) {
+			break;
+		}
+		return boolType;
+	case TOK_PLUS:
+		// Anything can be joined to a string
+		if (sameType(lhs, strType) || sameType(rhs, strType)) {
+			binary->lhs = convertImplicit(binary->lhs, strType);
+			binary->rhs = convertImplicit(binary->rhs, strType);
+			return strType;
+		}
+		// Fall through
+	case TOK_MINUS:
+	case TOK_MUL:
+	case TOK_DIV:
+	case TOK_MOD:
+		if (!isNumericType(lhs) || !isNumericType(rhs)) {
+			break;
+		}
+		if (lhs.base == TYPE_DEC || rhs.base == TYPE_DEC) {
+			binary->lhs = convertImplicit(binary->lhs, decType);
+			binary->rhs = convertImplicit(binary->rhs, decType);
+			return decType;
+		}
+		return numType;
+	case TOK_EQ:
+	case TOK_NE:
+	case TOK_LT:
+	case TOK_LE:
+	case TOK_GT:
+	case TOK_GE:
+		if (isNumericType(lhs) && isNumericType(rhs)) {
+			if (lhs.base == TYPE_DEC || rhs.base == TYPE_DEC) {
+				binary->lhs = convertImplicit(binary->lhs, decType);
+				binary->rhs = convertImplicit(binary->rhs, decType);
+			}
+			return boolType;
+		}
+		if (!sameType(lhs, rhs)) {
+			break;
+		}
+
+		// Only characters and strings have an order besides numbers
+		if (binary->op == TOK_EQ || binary->op == TOK_NE || sameType(lhs, charType) || sameType(lhs, strType)) {
+			return boolType;
+		}
+		break;
+	default:
+		break;
+	}
+
+	error(binary->position, "Cannot apply %s to %s and %s", op.c_str(),
+		getTypeName(lhs).c_str(), getTypeName(rhs).c_str());
+}
+
+/**
+ * Checks the arguments of a call against the parameters of the function.
+ * @param call Call to check.
+ * @returns Return type of the function.
+ */
+Type Checker::checkCall(CallExpr *call) {
+	auto found = funcs.find(call->name.symbol);
+	if (found == funcs.end()) {
+		error(call->position, "Undeclared function '%.*s'", call->name.length, call->name.text);
+	}
+
+	const FuncDecl *callee = found->second;
+	if (call->count != callee->paramCount) {
+		error(call->position, "Function '%.*s' expects %u arguments but found %u",
+			call->name.length, call->name.text, callee->paramCount, call->count);
+	}
+
+	for (uint32_t idx = 0; idx < call->count; idx++) {
+		call->args[idx] = checkAs(call->args[idx], callee->params[idx].type);
+	}
+
+	return callee->returnType;
+}
+
+/**
+ * Checks an explicit conversion such as `string(x)` or `num(c)`.
+ * @param cast Conversion to check.
+ * @returns Type converted to.
+ */
+Type Checker::checkCast(CastExpr *cast) {
+	Type from = checkExpr(cast->operand);
+	Type to = cast->target;
+	bool allowed = false;
+
+	if (to.rank > 0) {
+		error(cast->position, "Cannot convert a value to an array");
+	}
+
+	if (sameType(from, to)) {
+		allowed = true;
+	} else if (from.rank > 0) {
+		allowed = (to.base == TYPE_STR);
+	} else {
+		switch (to.base) {
+		case TYPE_STR:
+			allowed = (from.base != TYPE_VOID);
+			break;
+		case TYPE_NUM:
+			allowed = (from.base != TYPE_VOID);
+			break;
+		case TYPE_DEC:
+			allowed = (from.base == TYPE_NUM || from.base == TYPE_STR);
+			break;
+		case TYPE_CHAR:
+			allowed = (from.base == TYPE_NUM || from.base == TYPE_STR);
+			break;
+		case TYPE_BOOL:
+			allowed = (from.base == TYPE_NUM);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (!allowed) {
+		error(cast->position, "Cannot convert %s to %s", getTypeName(from).c_str(), getTypeName(to).c_str());
+	}
+
+	return to;
+}
+
+/**
+ * Checks an expression whose value is used as a given type. A `num` is converted
+ * when a `dec` is expected; any other difference is an error.
+ * @param expr Expression to check.
+ * @param target Type the value is used as.
+ * @returns The expression, or a conversion wrapping it.
+ */
+Expr *Checker::checkAs(Expr *expr, Type target) {
+	Type type = checkExpr(expr, &target);
+
+	if (sameType(type, target)) {
+		return expr;
+	}
+	if (sameType(type, numType) && sameType(target, decType)) {
+		return convertImplicit(expr, decType);
+	}
+
+	error(expr->position, "Expected %s but found %s", getTypeName(target).c_str(), getTypeName(type).c_str());
+}
+
+/**
+ * Wraps an expression in a conversion, unless it already has the target type.
+ * @param expr Checked expression.
+ * @param target Type to convert to.
+ * @returns The expression, or a conversion wrapping it.
+ */
+Expr *Checker::convertImplicit(Expr *expr, Type target) {
+	if (sameType(expr->type, target)) {
+		return expr;
+	}
+
+	auto *cast = arena.make<CastExpr>();
+	cast->kind = EXPR_CAST;
+	cast->position = expr->position;
+	cast->type = target;
+	cast->target = target;
+	cast->operand = expr;
+	cast->implicit = true;
+	return cast;
+}
+
+// --------------- helpers -------------------------------------
+
+/**
+ * Adds a variable to the innermost scope.
+ * @param varName Name of the variable.
+ * @param type Type of the variable.
+ * @param pos Position of the declaration.
+ */
+void Checker::declare(const Name &varName, Type type, const SourcePosition &pos) {
+	for (size_t idx = scopeStart; idx < variables.size(); idx++) {
+		if (sameName(variables[idx].name, varName)) {
+			error(pos, "Variable '%.*s' is already declared", varName.length, varName.text);
+		}
+	}
+
+	variables.push_back({ varName, type });
+}
+
+/**
+ * Finds the type of a variable, looking through the innermost scopes first.
+ * @param varName Name of the variable.
+ * @param pos Position of the use.
+ * @returns Type of the variable.
+ */
+Type Checker::lookup(const Name &varName, const SourcePosition &pos) const {
+	for (size_t idx = variables.size(); idx > 0; idx--) {
+		if (sameName(variables[idx - 1].name, varName)) {
+			return variables[idx - 1].type;
+		}
+	}
+
+	error(pos, "Undeclared variable '%.*s'", varName.length, varName.text);
+}
+
+/**
+ * Reports a type error.
+ * @param pos Position of the error.
+ * @param fmt Formatted string.
+ * @param ... Variable arguments.
+ */
+void Checker::error(const SourcePosition &pos, const char *fmt, ...) const {
+	va_list args;
+	va_start(args, fmt);
+	printErrAtV(name.c_str(), &pos, fmt, args);
+}
@@ -0,0 +1,94 @@
+/**
+ * @file       checker.hpp
+ * @brief      Definitions for the static type checker
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef CHECKER_HPP
+#define CHECKER_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "arena.hpp"
+#include "ast.hpp"
+#include "format.hpp"
+
+/**
+ * Resolves the type of every expression and checks that each operation is applied to
+ * values of the right types. Implicit conversions (`num` to `dec`, anything to
+ * `string` in a concatenation) are made explicit by inserting `CastExpr` nodes, so
+ * the compiler only ever sees operands of matching types.
+ */
+class Checker {
+public:
+	/**
+	 * Creates a type checker for a program.
+	 * @param program Syntax tree of the program, which is annotated in place.
+	 * @param arena Arena to allocate inserted conversions from.
+	 * @param name Name of the source file, used in error messages.
+	 */
+	Checker(Program *program, Arena &arena, std::string name);
+
+	/**
+	 * Checks the whole program, filling in `Expr::type`.
+	 */
+	void check();
+
+private:
+	/* Variable in scope */
+	struct Variable {
+		Name name;
+		Type type;
+	};
+
+	/** Syntax tree being checked */
+	Program *program;
+
+	/** Arena that inserted nodes are allocated from */
+	Arena &arena;
+
+	/** Name of the source file */
+	std::string name;
+
+	/** Declaration of each function by name */
+	std::unordered_map<Symbol, const FuncDecl *> funcs;
+
+	/** Function being checked */
+	const FuncDecl *func = nullptr;
+
+	/** Variables in scope, innermost last */
+	std::vector<Variable> variables;
+
+	/** Index of the first variable of the innermost scope */
+	size_t scopeStart = 0;
+
+	/** Number of loops surrounding the current statement */
+	int loopDepth = 0;
+
+	/** Number of blocks and expressions being checked inside one another */
+	uint32_t depth = 0;
+
+	void checkFunc(const FuncDecl *decl);
+	bool checkBlock(BlockStmt *block);
+	bool checkStatement(Stmt *stmt);
+	bool checkFor(ForStmt *loop);
+	Type checkExpr(Expr *expr, const Type *expected = nullptr);
+	Type checkBinary(BinaryExpr *binary);
+	Type checkOperator(BinaryExpr *binary, Type lhs);
+	Type checkCall(CallExpr *call);
+	Type checkCast(CastExpr *cast);
+	Expr *checkAs(Expr *expr, Type target);
+	Expr *convertImplicit(Expr *expr, Type target);
+
+	void declare(const Name &name, Type type, const SourcePosition &pos);
+	Type lookup(const Name &name, const SourcePosition &pos) const;
+
+	[[noreturn]] void error(const SourcePosition &pos, FORMAT_STRING const char *fmt, ...) const FORMAT_CHECK(3, 4);
+};
+
+#endif // CHECKER_HPP
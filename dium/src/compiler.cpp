@@ -0,0 +1,877 @@
+/**
+ * @file       compiler.cpp
+ * @brief      Implementation of the bytecode compiler
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include "compiler.hpp"
+#include "error.hpp"
+
+
+Compiler::Compiler(const Program *program, std::string name)
+	: program{ program } {
+	module.name = std::move(name);
+}
+
+Module Compiler::compile() {
+	if (program->count > MAX_REGISTERS) {
+		printErrAt(module.name.c_str(), nullptr, "Too many functions (more than %d)", MAX_REGISTERS);
+	}
+
+	// Declare every function first so that calls can come before declarations
+	module.funcs.resize(program->count);
+	for (uint32_t idx = 0; idx < program->count; idx++) {
+		const FuncDecl *decl = program->funcs[idx];
+
+		funcIndex.emplace(decl->name.symbol, static_cast<uint16_t>(idx));
+		module.funcs[idx].name = std::string(decl->name.text, decl->name.length);
+		module.funcs[idx].paramCount = static_cast<uint16_t>(decl->paramCount);
+		module.funcs[idx].returnType = decl->returnType;
+
+		for (uint32_t param = 0; param < decl->paramCount; param++) {
+			module.funcs[idx].paramTypes.push_back(decl->params[param].type);
+		}
+	}
+
+	// The type checker makes sure that `main` exists
+	module.entry = funcIndex.at(SYM_MAIN);
+
+	for (uint32_t idx = 0; idx < program->count; idx++) {
+		func = &module.funcs[idx];
+		compileFunc(program->funcs[idx]);
+	}
+
+	return std::move(module);
+}
+
+// --------------- declarations --------------------------------
+
+/**
+ * Compiles a function into `func`.
+ * @param funcDecl Function to compile.
+ */
+void Compiler::compileFunc(const FuncDecl *funcDecl) {
+	decl = funcDecl;
+	locals.clear();
+	loops.clear();
+	scopeStart = 0;
+	top = 0;
+	position = decl->position;
+	func->refStarts.push_back(0);
+
+	// Parameters share the scope of the body
+	for (uint32_t idx = 0; idx < decl->paramCount; idx++) {
+		uint16_t reg = allocRegister();
+		setType(reg, decl->params[idx].type);
+		locals.push_back({ decl->params[idx].name, reg });
+	}
+
+	for (uint32_t idx = 0; idx < decl->body->count; idx++) {
+		compileStatement(decl->body->stmts[idx]);
+	}
+
+	// Falling off the end returns nothing
+	emit(OP_RET0);
+
+	if (func->frameSize == 0) {
+		func->frameSize = 1;
+	}
+}
+
+// --------------- statements ----------------------------------
+
+/**
+ * Compiles a block of statements in a new scope.
+ * @param block Block to compile.
+ */
+void Compiler::compileBlock(const BlockStmt *block) {
+	// The parser keeps the tree within this, but the walk must not rely on it
+	if (++depth > MAX_NESTING_DEPTH) {
+		error(block->position, "Block nested too deeply");
+	}
+
+	size_t outerStart = scopeStart;
+	uint16_t outerTop = top;
+	scopeStart = locals.size();
+
+	for (uint32_t idx = 0; idx < block->count; idx++) {
+		compileStatement(block->stmts[idx]);
+	}
+
+	locals.resize(scopeStart);
+	scopeStart = outerStart;
+	top = outerTop;
+	depth -= 1;
+}
+
+/**
+ * Compiles a single statement. Temporaries are freed afterwards, so only declarations
+ * leave registers allocated.
+ * @param stmt Statement to compile.
+ */
+void Compiler::compileStatement(const Stmt *stmt) {
+	uint16_t mark = top;
+	position = stmt->position;
+
+	switch (stmt->kind) {
+	case STMT_BLOCK:
+		compileBlock(static_cast<const BlockStmt *>(stmt));
+		break;
+	case STMT_VAR:
+		compileVar(static_cast<const VarStmt *>(stmt));
+		return;
+	case STMT_ASSIGN:
+		compileAssign(static_cast<const AssignStmt *>(stmt));
+		break;
+	case STMT_EXPR:
+		compileOperand(static_cast<const ExprStmt *>(stmt)->expr);
+		break;
+	case STMT_IF:
+		compileIf(static_cast<const IfStmt *>(stmt));
+		break;
+	case STMT_WHILE:
+		compileWhile(static_cast<const WhileStmt *>(stmt));
+		break;
+	case STMT_FOR:
+		compileFor(static_cast<const ForStmt *>(stmt));
+		break;
+	case STMT_RETURN:
+		compileReturn(static_cast<const ReturnStmt *>(stmt));
+		break;
+	case STMT_PRINT: {
+		auto print = static_cast<const PrintStmt *>(stmt);
+
+		if (print->value != nullptr) {
+			uint16_t reg = compileOperand(print->value);
+			position = stmt->position;
+			emitTyped(print->newline ? OP_PRINTLN : OP_PRINT, print->value->type, reg);
+		} else if (print->newline) {
+			emit(OP_NEWLINE);
+		}
+		break;
+	}
+	case STMT_EXIT: {
+		uint16_t reg = compileOperand(static_cast<const ExitStmt *>(stmt)->code);
+		position = stmt->position;
+		emit(OP_EXIT, reg);
+		break;
+	}
+	case STMT_BREAK:
+		loops.back().breaks.push_back(emitWide(OP_JMP, 0, 0));
+		break;
+	case STMT_CONTINUE:
+		emitWide(OP_JMP, 0, loops.back().head);
+		break;
+	}
+
+	top = mark;
+}
+
+/**
+ * Compiles a variable declaration, which keeps its register until the end of the scope.
+ * @param var Declaration to compile.
+ */
+void Compiler::compileVar(const VarStmt *var) {
+	uint16_t reg = allocRegister();
+
+	// The variable is only in scope after its initial value
+	if (var->value != nullptr) {
+		compileExpr(var->value, reg);
+	} else {
+		compileDefault(var->type, reg);
+	}
+
+	setType(reg, var->type);
+	locals.push_back({ var->name, reg });
+	top = reg + 1;
+}
+
+/**
+ * Compiles an assignment to a variable or an array element.
+ * @param assign Assignment to compile.
+ */
+void Compiler::compileAssign(const AssignStmt *assign) {
+	if (assign->target->kind == EXPR_INDEX) {
+		auto index = static_cast<const IndexExpr *>(assign->target);
+		uint16_t array = compileOperand(index->array);
+		uint16_t idx = compileOperand(index->index);
+		uint16_t value = compileOperand(assign->value);
+
+		position = assign->position;
+		emit(OP_SETINDEX, array, idx, value);
+		return;
+	}
+
+	uint16_t reg = findLocal(static_cast<const NameExpr *>(assign->target)->name);
+	auto binary = static_cast<const BinaryExpr *>(assign->value);
+
+	// `and` and `or` write their left operand before reading the right one
+	if (assign->value->kind == EXPR_BINARY && (binary->op == TOK_AND || binary->op == TOK_OR)) {
+		uint16_t value = compileOperand(assign->value);
+		emit(OP_MOVE, reg, value);
+	} else {
+		compileExpr(assign->value, reg);
+	}
+}
+
+/**
+ * Compiles an `if` statement along with its `elsif` and `else` branches.
+ * @param branch Statement to compile.
+ */
+void Compiler::compileIf(const IfStmt *branch) {
+	uint16_t mark = top;
+	uint16_t cond = compileOperand(branch->cond);
+	size_t skipThen = emitWide(OP_JMPF, cond, 0);
+	top = mark;
+
+	compileBlock(branch->then);
+
+	if (branch->otherwise == nullptr) {
+		patchJump(skipThen);
+		return;
+	}
+
+	size_t skipElse = emitWide(OP_JMP, 0, 0);
+	patchJump(skipThen);
+	compileStatement(branch->otherwise);
+	patchJump(skipElse);
+}
+
+/**
+ * Compiles a `while` loop.
+ * @param loop Loop to compile.
+ */
+void Compiler::compileWhile(const WhileStmt *loop) {
+	uint16_t mark = top;
+	uint32_t head = here();
+	uint16_t cond = compileOperand(loop->cond);
+	size_t exit = emitWide(OP_JMPF, cond, 0);
+	top = mark;
+
+	loops.push_back({ head, {} });
+	compileBlock(loop->body);
+	emitWide(OP_JMP, 0, head);
+
+	patchJump(exit);
+	for (size_t jump : loops.back().breaks) {
+		patchJump(jump);
+	}
+	loops.pop_back();
+}
+
+/**
+ * Compiles a `for` loop over a range. The bounds are computed straight into the
+ * hidden registers that RANGE turns into the state of the loop, just below the loop
+ * variable, which `FORITER` writes to. No object is allocated.
+ * @param loop Loop to compile.
+ */
+void Compiler::compileFor(const ForStmt *loop) {
+	size_t outerStart = scopeStart;
+	uint16_t outerTop = top;
+	scopeStart = locals.size();
+
+	uint16_t range = allocRegister();
+	allocRegister();
+	allocRegister();
+	uint16_t var = allocRegister();
+
+	if (loop->start != nullptr) {
+		compileExpr(loop->start, range);
+	} else {
+		emitNum(0, range);
+	}
+
+	compileExpr(loop->stop, range + 1);
+
+	if (loop->step != nullptr) {
+		compileExpr(loop->step, range + 2);
+	} else {
+		emitNum(1, range + 2);
+	}
+
+	position = loop->position;
+	emit(OP_RANGE, range, range);
+	top = var + 1;
+	locals.push_back({ loop->name, var });
+
+	size_t head = emitWide(OP_FORITER, range, 0);
+	loops.push_back({ static_cast<uint32_t>(head), {} });
+	compileBlock(loop->body);
+	emitWide(OP_JMP, 0, static_cast<uint32_t>(head));
+
+	patchJump(head);
+	for (size_t jump : loops.back().breaks) {
+		patchJump(jump);
+	}
+	loops.pop_back();
+
+	locals.resize(scopeStart);
+	scopeStart = outerStart;
+	top = outerTop;
+}
+
+/**
+ * Compiles a `return` statement.
+ * @param ret Statement to compile.
+ */
+void Compiler::compileReturn(const ReturnStmt *ret) {
+	if (ret->value == nullptr) {
+		emit(OP_RET0);
+		return;
+	}
+
+	uint16_t reg = compileOperand(ret->value);
+	position = ret->position;
+	emit(OP_RET, reg);
+}
+
+// --------------- expressions ---------------------------------
+
+/**
+ * Compiles an expression into a register. Apart from `and` and `or`, the register is
+ * only written once all operands have been read, so it may also be an operand.
+ * @param expr Expression to compile.
+ * @param dest Register to write the value to.
+ */
+void Compiler::compileExpr(const Expr *expr, uint16_t dest) {
+	// Conversions inserted by the checker were not in the source, so they do not count
+	bool nested = expr->kind != EXPR_CAST || !static_cast<const CastExpr *>(expr)->implicit;
+	if (nested && ++depth > MAX_NESTING_DEPTH) {
+		error(expr->position, "Expression nested too deeply");
+	}
+
+	uint16_t mark = top;
+	position = expr->position;
+
+	switch (expr->kind) {
+	case EXPR_NUM:
+		emitNum(static_cast<const NumExpr *>(expr)->value, dest);
+		break;
+	case EXPR_DEC: {
+		Constant constant{ CONST_DEC, 0, static_cast<const DecExpr *>(expr)->value, "" };
+		emitWide(OP_LOADK, dest, addConstant(constant));
+		break;
+	}
+	case EXPR_BOOL:
+		emitNum(static_cast<const BoolExpr *>(expr)->value ? 1 : 0, dest);
+		break;
+	case EXPR_CHAR:
+		emitNum(static_cast<unsigned char>(static_cast<const CharExpr *>(expr)->value), dest);
+		break;
+	case EXPR_STR: {
+		auto str = static_cast<const StrExpr *>(expr);
+		std::string_view raw(str->text, str->length);
+
+		Constant constant{ CONST_STR, 0, 0, str->escaped ? unescapeString(raw) : std::string(raw) };
+		emitWide(OP_LOADK, dest, addConstant(constant));
+		break;
+	}
+	case EXPR_NAME: {
+		uint16_t reg = findLocal(static_cast<const NameExpr *>(expr)->name);
+		if (reg != dest) {
+			emit(OP_MOVE, dest, reg);
+		}
+		break;
+	}
+	case EXPR_ARRAY: {
+		auto array = static_cast<const ArrayExpr *>(expr);
+		Type itemType{ expr->type.base, static_cast<uint8_t>(expr->type.rank - 1) };
+		uint16_t items = top;
+
+		for (uint32_t idx = 0; idx < array->count; idx++) {
+			allocRegister();
+		}
+		for (uint32_t idx = 0; idx < array->count; idx++) {
+			compileExpr(array->items[idx], items + idx);
+		}
+
+		position = expr->position;
+		emitTyped(OP_NEWARRAY, itemType, dest, items, static_cast<uint16_t>(array->count));
+		addSafepoint(top);
+		break;
+	}
+	case EXPR_UNARY: {
+		auto unary = static_cast<const UnaryExpr *>(expr);
+		uint16_t operand = compileOperand(unary->operand);
+
+		position = expr->position;
+		if (unary->op == TOK_NOT) {
+			emit(OP_NOT, dest, operand);
+		} else {
+			emit((expr->type.base == TYPE_DEC) ? OP_NEG_DEC : OP_NEG_NUM, dest, operand);
+		}
+		break;
+	}
+	case EXPR_BINARY:
+		compileBinary(static_cast<const BinaryExpr *>(expr), dest);
+		break;
+	case EXPR_INDEX: {
+		auto index = static_cast<const IndexExpr *>(expr);
+		uint16_t array = compileOperand(index->array);
+		uint16_t idx = compileOperand(index->index);
+
+		position = expr->position;
+		if (index->array->type.rank > 0) {
+			emitTyped(OP_GETINDEX, expr->type, dest, array, idx);
+		} else {
+			emit(OP_GETCHAR, dest, array, idx);
+		}
+		break;
+	}
+	case EXPR_CALL:
+		compileCall(static_cast<const CallExpr *>(expr), dest);
+		break;
+	case EXPR_CAST:
+		compileCast(static_cast<const CastExpr *>(expr), dest);
+		break;
+	}
+
+	top = mark;
+	setType(dest, expr->type);
+	depth -= nested ? 1 : 0;
+}
+
+/**
+ * Compiles a binary operator into a register, along with the chain of operators of the
+ * same kind that make up its left operand, such as the terms of a long sum. The chain
+ * is flat in the source, so it is compiled in a loop from the innermost operator out.
+ * @param binary Outermost operator of the chain.
+ * @param dest Register to write the value to.
+ */
+void Compiler::compileBinary(const BinaryExpr *binary, uint16_t dest) {
+	if (binary->op == TOK_PLUS && binary->type.base == TYPE_STR && binary->type.rank == 0) {
+		compileConcat(binary, dest);
+		return;
+	}
+
+	// Short-circuit: the right operand is only evaluated when it decides the value
+	bool logical = (binary->op == TOK_AND || binary->op == TOK_OR);
+	std::vector<const BinaryExpr *> chain{ binary };
+	while (chain.back()->lhs->kind == EXPR_BINARY) {
+		auto lhs = static_cast<const BinaryExpr *>(chain.back()->lhs);
+		bool concat = lhs->op == TOK_PLUS && lhs->type.base == TYPE_STR && lhs->type.rank == 0;
+		if ((lhs->op == TOK_AND || lhs->op == TOK_OR) != logical || concat) {
+			break;
+		}
+		chain.push_back(lhs);
+	}
+
+	if (logical) {
+		compileExpr(chain.back()->lhs, dest);
+		for (size_t idx = chain.size(); idx-- > 0;) {
+			position = chain[idx]->position;
+			size_t skip = emitWide((chain[idx]->op == TOK_AND) ? OP_JMPF : OP_JMPT, dest, 0);
+			compileExpr(chain[idx]->rhs, dest);
+			patchJump(skip);
+		}
+		return;
+	}
+
+	// Partial results stay in one register, which dest cannot be: it may be a variable
+	// that a later operand still reads
+	uint16_t lhs = compileOperand(chain.back()->lhs);
+	uint16_t partial = (chain.size() > 1) ? allocRegister() : dest;
+	uint16_t mark = top;
+
+	for (size_t idx = chain.size(); idx-- > 0;) {
+		uint16_t rhs = compileOperand(chain[idx]->rhs);
+		uint16_t result = (idx == 0) ? dest : partial;
+		emitOperator(chain[idx], result, lhs, rhs);
+
+		top = mark;
+		setType(result, chain[idx]->type);
+		lhs = result;
+	}
+}
+
+/**
+ * Emits the instruction of a binary operator other than `and`, `or` and string `+`.
+ * The type checker has converted both operands to the same type, which selects the
+ * operation.
+ * @param binary Operator to emit.
+ * @param dest Register to write the value to.
+ * @param lhs Register holding the left operand.
+ * @param rhs Register holding the right operand.
+ */
+void Compiler::emitOperator(const BinaryExpr *binary, uint16_t dest, uint16_t lhs, uint16_t rhs) {
+	Type type = binary->lhs->type;
+	bool isDec = (type.base == TYPE_DEC);
+	position = binary->position;
+
+	// Comparisons come in groups of EQ, NE, LT, LE for each type
+	Opcode compare = OP_EQ_NUM;
+	if (type.rank > 0) {
+		compare = OP_EQ_REF;
+	} else if (isDec) {
+		compare = OP_EQ_DEC;
+	} else if (type.base == TYPE_STR) {
+		compare = OP_EQ_STR;
+	}
+
+	switch (binary->op) {
+	case TOK_PLUS:
+		emit(isDec ? OP_ADD_DEC : OP_ADD_NUM, dest, lhs, rhs);
+		break;
+	case TOK_MINUS:
+		emit(isDec ? OP_SUB_DEC : OP_SUB_NUM, dest, lhs, rhs);
+		break;
+	case TOK_MUL:
+		emit(isDec ? OP_MUL_DEC : OP_MUL_NUM, dest, lhs, rhs);
+		break;
+	case TOK_DIV:
+		emit(isDec ? OP_DIV_DEC : OP_DIV_NUM, dest, lhs, rhs);
+		break;
+	case TOK_MOD:
+		emit(isDec ? OP_MOD_DEC : OP_MOD_NUM, dest, lhs, rhs);
+		break;
+	case TOK_EQ:
+		emit(compare, dest, lhs, rhs);
+		break;
+	case TOK_NE:
+		emit(static_cast<Opcode>(compare + 1), dest, lhs, rhs);
+		break;
+	case TOK_LT:
+		emit(static_cast<Opcode>(compare + 2), dest, lhs, rhs);
+		break;
+	case TOK_LE:
+		emit(static_cast<Opcode>(compare + 3), dest, lhs, rhs);
+		break;
+	case TOK_GT:
+		// Operands are already evaluated, so swapping them keeps the order of effects
+		emit(static_cast<Opcode>(compare + 2), dest, rhs, lhs);
+		break;
+	case TOK_GE:
+		emit(static_cast<Opcode>(compare + 3), dest, rhs, lhs);
+		break;
+	default:
+		error(binary->position, "Unknown operator %s", getTokenString(binary->op));
+	}
+}
+
+/**
+ * Compiles a chain of string concatenations such as `"n = " + n + "!"` into a single
+ * CONCAT, which builds the result once instead of allocating every partial string.
+ * @param binary Outermost `+` of the chain.
+ * @param dest Register to write the string to.
+ */
+void Compiler::compileConcat(const BinaryExpr *binary, uint16_t dest) {
+	// Concatenation is associative, so every nested string `+` joins the chain
+	std::vector<const Expr *> operands;
+	std::vector<const Expr *> pending{ binary };
+
+	while (!pending.empty()) {
+		const Expr *expr = pending.back();
+		pending.pop_back();
+
+		if (expr->kind == EXPR_BINARY && static_cast<const BinaryExpr *>(expr)->op == TOK_PLUS
+			&& expr->type.base == TYPE_STR && expr->type.rank == 0) {
+			pending.push_back(static_cast<const BinaryExpr *>(expr)->rhs);
+			pending.push_back(static_cast<const BinaryExpr *>(expr)->lhs);
+		} else {
+			operands.push_back(expr);
+		}
+	}
+
+	uint16_t first = top;
+	for (size_t idx = 0; idx < operands.size(); idx++) {
+		allocRegister();
+	}
+	for (size_t idx = 0; idx < operands.size(); idx++) {
+		compileExpr(operands[idx], static_cast<uint16_t>(first + idx));
+	}
+
+	position = binary->position;
+	emit(OP_CONCAT, dest, first, static_cast<uint16_t>(operands.size()));
+	addSafepoint(top);
+}
+
+/**
+ * Compiles a function call. The arguments are placed in consecutive registers at the
+ * top of the frame, which become the first registers of the callee.
+ * @param call Call to compile.
+ * @param dest Register to write the returned value to.
+ */
+void Compiler::compileCall(const CallExpr *call, uint16_t dest) {
+	uint16_t callee = funcIndex.at(call->name.symbol);
+
+	// The first argument register also receives the result
+	uint16_t args = allocRegister();
+	for (uint32_t idx = 1; idx < call->count; idx++) {
+		allocRegister();
+	}
+	for (uint32_t idx = 0; idx < call->count; idx++) {
+		compileExpr(call->args[idx], args + idx);
+	}
+
+	// The arguments belong to the callee's frame while it runs
+	position = call->position;
+	emit(OP_CALL, args, callee, static_cast<uint16_t>(call->count));
+	addSafepoint(args);
+
+	if (dest != args) {
+		emit(OP_MOVE, dest, args);
+	}
+}
+
+/**
+ * Compiles a conversion to another type.
+ * @param cast Conversion to compile.
+ * @param dest Register to write the converted value to.
+ */
+void Compiler::compileCast(const CastExpr *cast, uint16_t dest) {
+	Type from = cast->operand->type;
+	Type to = cast->target;
+
+	if (sameType(from, to)) {
+		compileExpr(cast->operand, dest);
+		return;
+	}
+
+	uint16_t operand = compileOperand(cast->operand);
+	position = cast->position;
+
+	if (to.base == TYPE_STR) {
+		emitTyped(OP_TOSTR, from, dest, operand);
+		addSafepoint(top);
+		return;
+	}
+
+	Opcode op = OP_MOVE;
+	switch (from.base) {
+	case TYPE_NUM:
+		op = (to.base == TYPE_DEC) ? OP_NUM2DEC : (to.base == TYPE_CHAR) ? OP_NUM2CHAR
+			: (to.base == TYPE_BOOL) ? OP_NUM2BOOL : OP_MOVE;
+		break;
+	case TYPE_DEC:
+		op = OP_DEC2NUM;
+		break;
+	case TYPE_STR:
+		op = (to.base == TYPE_DEC) ? OP_STR2DEC : (to.base == TYPE_CHAR) ? OP_STR2CHAR : OP_STR2NUM;
+		break;
+	default:
+		// `bool` and `char` are already stored as numbers
+		break;
+	}
+
+	if (op != OP_MOVE || operand != dest) {
+		emit(op, dest, operand);
+	}
+}
+
+/**
+ * Compiles an expression into any register. Variables are used in place.
+ * @param expr Expression to compile.
+ * @returns Register holding the value.
+ */
+uint16_t Compiler::compileOperand(const Expr *expr) {
+	if (expr->kind == EXPR_NAME) {
+		position = expr->position;
+		return findLocal(static_cast<const NameExpr *>(expr)->name);
+	}
+
+	uint16_t reg = allocRegister();
+	compileExpr(expr, reg);
+	return reg;
+}
+
+/**
+ * Loads the default value of a type (0, "", `false`, an empty array, ...).
+ * @param type Type of the value.
+ * @param dest Register to write the value to.
+ */
+void Compiler::compileDefault(Type type, uint16_t dest) {
+	if (type.rank > 0) {
+		emitTyped(OP_NEWARRAY, Type{ type.base, static_cast<uint8_t>(type.rank - 1) }, dest);
+		addSafepoint(top);
+		return;
+	}
+
+	switch (type.base) {
+	case TYPE_DEC:
+		emitWide(OP_LOADK, dest, addConstant(Constant{ CONST_DEC, 0, 0, "" }));
+		break;
+	case TYPE_STR:
+		emitWide(OP_LOADK, dest, addConstant(Constant{ CONST_STR, 0, 0, "" }));
+		break;
+	default:
+		emitNum(0, dest);
+		break;
+	}
+}
+
+/**
+ * Records the type of the value just written to a register, so that later safepoints
+ * know whether it holds a reference.
+ * @param reg Register that was written.
+ * @param type Type of the value.
+ */
+void Compiler::setType(uint16_t reg, Type type) {
+	refs[reg] = isRefType(type);
+}
+
+// --------------- helpers -------------------------------------
+
+/**
+ * Appends an instruction to the current function.
+ * @param op Operation.
+ * @param a First operand.
+ * @param b Second operand.
+ * @param c Third operand.
+ * @returns Index of the instruction.
+ */
+size_t Compiler::emit(Opcode op, uint16_t a, uint16_t b, uint16_t c) {
+	func->code.push_back(Instr{ op, 0, a, b, c });
+	func->positions.push_back(position);
+	return func->code.size() - 1;
+}
+
+/**
+ * Appends an instruction with a 32-bit operand to the current function.
+ * @param op Operation.
+ * @param a First operand.
+ * @param wide Jump target, immediate or constant index.
+ * @returns Index of the instruction.
+ */
+size_t Compiler::emitWide(Opcode op, uint16_t a, uint32_t wide) {
+	size_t idx = emit(op, a);
+	setWide(&func->code[idx], wide);
+	return idx;
+}
+
+/**
+ * Appends an instruction with a type operand to the current function.
+ * @param op Operation.
+ * @param type Type operand.
+ * @param a First operand.
+ * @param b Second operand.
+ * @param c Third operand.
+ * @returns Index of the instruction.
+ */
+size_t Compiler::emitTyped(Opcode op, Type type, uint16_t a, uint16_t b, uint16_t c) {
+	size_t idx = emit(op, a, b, c);
+	func->code[idx].type = packType(type);
+	return idx;
+}
+
+/**
+ * Makes the last instruction a safepoint, recording the registers that hold live
+ * references. Registers that have been allocated but not written yet may still hold
+ * stale values, so only written ones are recorded.
+ * @param limit Registers from this one up are not part of the frame at the safepoint.
+ */
+void Compiler::addSafepoint(uint16_t limit) {
+	func->safepoints.push_back(static_cast<uint32_t>(func->code.size() - 1));
+
+	for (uint16_t reg = 0; reg < limit; reg++) {
+		if (refs[reg]) {
+			func->refRegs.push_back(reg);
+		}
+	}
+
+	func->refStarts.push_back(static_cast<uint32_t>(func->refRegs.size()));
+}
+
+/**
+ * Points a jump at the next instruction to be emitted.
+ * @param instr Index of the jump.
+ */
+void Compiler::patchJump(size_t instr) {
+	setWide(&func->code[instr], here());
+}
+
+/**
+ * Returns the index of the next instruction to be emitted.
+ * @returns Index of the instruction.
+ */
+uint32_t Compiler::here() const {
+	return static_cast<uint32_t>(func->code.size());
+}
+
+/**
+ * Loads a number, as an immediate when it fits in 32 bits.
+ * @param value Number to load.
+ * @param dest Register to write the value to.
+ */
+void Compiler::emitNum(int64_t value, uint16_t dest) {
+	if (value >= INT32_MIN && value <= INT32_MAX) {
+		emitWide(OP_LOADI, dest, static_cast<uint32_t>(static_cast<int32_t>(value)));
+	} else {
+		emitWide(OP_LOADK, dest, addConstant(Constant{ CONST_NUM, value, 0, "" }));
+	}
+}
+
+/**
+ * Adds a constant to the module, reusing an equal constant if there is one.
+ * @param constant Constant to add.
+ * @returns Index of the constant.
+ */
+uint32_t Compiler::addConstant(const Constant &constant) {
+	std::string key(1, static_cast<char>(constant.kind));
+
+	switch (constant.kind) {
+	case CONST_DEC:
+		key.append(reinterpret_cast<const char *>(&constant.dec), sizeof(constant.dec));
+		break;
+	case CONST_STR:
+		key += constant.text;
+		break;
+	default:
+		key.append(reinterpret_cast<const char *>(&constant.num), sizeof(constant.num));
+		break;
+	}
+
+	auto found = constantIndex.emplace(key, static_cast<uint32_t>(module.constants.size()));
+	if (found.second) {
+		module.constants.push_back(constant);
+	}
+
+	return found.first->second;
+}
+
+/**
+ * Allocates the next free register of the current function.
+ * @returns Index of the register.
+ */
+uint16_t Compiler::allocRegister() {
+	if (top == MAX_REGISTERS) {
+		error(position, "Function '%s' needs too many registers", func->name.c_str());
+	}
+
+	uint16_t reg = top++;
+	if (top > func->frameSize) {
+		func->frameSize = top;
+		refs.resize(top);
+	}
+
+	refs[reg] = false;
+	return reg;
+}
+
+/**
+ * Finds the register of a variable, looking through the innermost scopes first.
+ * @param name Name of the variable.
+ * @returns Register of the variable.
+ */
+uint16_t Compiler::findLocal(const Name &name) {
+	for (size_t idx = locals.size(); idx > 0; idx--) {
+		if (sameName(locals[idx - 1].name, name)) {
+			return locals[idx - 1].reg;
+		}
+	}
+
+	error(position, "Undeclared variable '%.*s'", name.length, name.text);
+}
+
+/**
+ * Reports a compile error.
+ * @param pos Position of the error.
+ * @param fmt Formatted string.
+ * @param ... Variable arguments.
+ */
+void Compiler::error(const SourcePosition &pos, const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	printErrAtV(module.name.c_str(), &pos, fmt, args);
+}
@@ -0,0 +1,132 @@
+/**
+ * @file       compiler.hpp
+ * @brief      Definitions for the bytecode compiler
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef COMPILER_HPP
+#define COMPILER_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast.hpp"
+#include "bytecode.hpp"
+#include "format.hpp"
+
+/**
+ * Compiles a type-checked syntax tree into bytecode for the register machine.
+ * Parameters and local variables live in fixed registers, and temporaries are
+ * allocated above them like a stack, so that the registers of a call frame are known
+ * when it is compiled. Operations are picked by the types of their operands, and the
+ * registers holding references are recorded at every safepoint for the collector.
+ */
+class Compiler {
+public:
+	/**
+	 * Creates a compiler for a program.
+	 * @param program Syntax tree of the program.
+	 * @param name Name of the source file, used in error messages.
+	 */
+	Compiler(const Program *program, std::string name);
+
+	/**
+	 * Compiles the whole program.
+	 * @returns Compiled module.
+	 */
+	Module compile();
+
+private:
+	/* Local variable in scope */
+	struct Local {
+		Name name;
+		uint16_t reg;
+	};
+
+	/* Loop being compiled */
+	struct Loop {
+		/** Instruction that `continue` jumps to */
+		uint32_t head;
+
+		/** Jumps to patch with the end of the loop */
+		std::vector<size_t> breaks;
+	};
+
+	/** Syntax tree being compiled */
+	const Program *program;
+
+	/** Module being built */
+	Module module;
+
+	/** Index of each function by name */
+	std::unordered_map<Symbol, uint16_t> funcIndex;
+
+	/** Index of each constant, keyed by its kind and bytes */
+	std::unordered_map<std::string, uint32_t> constantIndex;
+
+	/** Declaration of the function being compiled */
+	const FuncDecl *decl = nullptr;
+
+	/** Function being compiled */
+	Function *func = nullptr;
+
+	/** Local variables in scope, innermost last */
+	std::vector<Local> locals;
+
+	/** Index of the first local of the innermost scope */
+	size_t scopeStart = 0;
+
+	/** First free register */
+	uint16_t top = 0;
+
+	/** Whether each register below `top` holds a reference that has been written */
+	std::vector<bool> refs;
+
+	/** Loops surrounding the current statement, innermost last */
+	std::vector<Loop> loops;
+
+	/** Position of the node being compiled */
+	SourcePosition position;
+
+	/** Number of blocks and expressions being compiled inside one another */
+	uint32_t depth = 0;
+
+	void compileFunc(const FuncDecl *decl);
+	void compileBlock(const BlockStmt *block);
+	void compileStatement(const Stmt *stmt);
+	void compileVar(const VarStmt *var);
+	void compileAssign(const AssignStmt *assign);
+	void compileIf(const IfStmt *branch);
+	void compileWhile(const WhileStmt *loop);
+	void compileFor(const ForStmt *loop);
+	void compileReturn(const ReturnStmt *ret);
+	void compileExpr(const Expr *expr, uint16_t dest);
+	void compileBinary(const BinaryExpr *binary, uint16_t dest);
+	void emitOperator(const BinaryExpr *binary, uint16_t dest, uint16_t lhs, uint16_t rhs);
+	void compileConcat(const BinaryExpr *binary, uint16_t dest);
+	void compileCall(const CallExpr *call, uint16_t dest);
+	void compileCast(const CastExpr *cast, uint16_t dest);
+	uint16_t compileOperand(const Expr *expr);
+	void compileDefault(Type type, uint16_t dest);
+	void setType(uint16_t reg, Type type);
+
+	size_t emit(Opcode op, uint16_t a = 0, uint16_t b = 0, uint16_t c = 0);
+	size_t emitWide(Opcode op, uint16_t a, uint32_t wide);
+	size_t emitTyped(Opcode op, Type type, uint16_t a, uint16_t b = 0, uint16_t c = 0);
+	void addSafepoint(uint16_t limit);
+	void patchJump(size_t instr);
+	uint32_t here() const;
+	void emitNum(int64_t value, uint16_t dest);
+	uint32_t addConstant(const Constant &constant);
+
+	uint16_t allocRegister();
+	uint16_t findLocal(const Name &name);
+
+	[[noreturn]] void error(const SourcePosition &pos, FORMAT_STRING const char *fmt, ...) FORMAT_CHECK(3, 4);
+};
+
+#endif // COMPILER_HPP
@@ -0,0 +1,97 @@
+/**
+ * @file       debug.hpp
+ * @brief      Definitions for tracing the compiler
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef DEBUG_HPP
+#define DEBUG_HPP
+
+#include <cstdarg>
+#include <cstring>
+#include "format.hpp"
+#include "output.hpp"
+
+/*
+ * Traces are always compiled in and cost a test of `debugEnabled` each while they are
+ * off, so that they can be turned on in any build with `--debug`. Debug builds
+ * (DIUM_DEBUG) start with them on.
+ */
+
+/** `true` to print traces */
+#ifdef DIUM_DEBUG
+inline bool debugEnabled = true;
+#else
+inline bool debugEnabled = false;
+#endif
+
+/** Number of spaces to indent when printing */
+inline int debugIndent = 0;
+
+/**
+ * Prints a trace message at the current indentation. The line is formatted on the
+ * stack and added to the buffer of the standard error, so that traces never mix
+ * with the output of the program.
+ * @param fmt Format to apply.
+ * @param args Arguments of the format.
+ */
+inline void debugInfoV(const char *fmt, va_list args) {
+	char line[FORMAT_BUFFER_SIZE];
+	size_t indent = (debugIndent < FORMAT_BUFFER_SIZE / 2) ? static_cast<size_t>(debugIndent) : FORMAT_BUFFER_SIZE / 2;
+
+	memset(line, ' ', indent);
+	size_t length = indent + formatToV(line + indent, sizeof(line) - indent, fmt, args);
+	line[length++] = '\n';
+	getStderr().write(line, length);
+}
+
+/**
+ * Prints a trace message at the current indentation.
+ * @param fmt Format to apply.
+ * @param ... Variable arguments.
+ */
+inline void debugInfo(FORMAT_STRING const char *fmt, ...) FORMAT_CHECK(1, 2);
+inline void debugInfo(const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	debugInfoV(fmt, args);
+	va_end(args);
+}
+
+/**
+ * Prints a trace message and indents the messages that follow.
+ * @param fmt Format to apply.
+ * @param ... Variable arguments.
+ */
+inline void debugStart(FORMAT_STRING const char *fmt, ...) FORMAT_CHECK(1, 2);
+inline void debugStart(const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	debugInfoV(fmt, args);
+	va_end(args);
+	debugIndent += 2;
+}
+
+/**
+ * Removes one level of indentation and prints a trace message.
+ * @param fmt Format to apply.
+ * @param ... Variable arguments.
+ */
+inline void debugEnd(FORMAT_STRING const char *fmt, ...) FORMAT_CHECK(1, 2);
+inline void debugEnd(const char *fmt, ...) {
+	debugIndent -= 2;
+	va_list args;
+	va_start(args, fmt);
+	debugInfoV(fmt, args);
+	va_end(args);
+}
+
+#define DEBUG_START(...) (debugEnabled ? debugStart(__VA_ARGS__) : void())
+#define DEBUG_END(...)   (debugEnabled ? debugEnd(__VA_ARGS__) : void())
+#define DEBUG_INFO(...)  (debugEnabled ? debugInfo(__VA_ARGS__) : void())
+
+#endif // DEBUG_HPP
@@ -0,0 +1,126 @@
+/**
+ * @file       diagnostics.cpp
+ * @brief      Implementation of collecting and reporting errors and warnings
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <algorithm>
+#include "diagnostics.hpp"
+#include "error.hpp"
+#include "json.hpp"
+
+// --------------- function prototypes -------------------------
+
+static void printJson(const Diagnostic &diagnostic);
+
+
+void Diagnostics::error(const char *file, const SourcePosition *pos, uint32_t length, const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	add(SEVERITY_ERROR, file, pos, length, fmt, args);
+	va_end(args);
+}
+
+void Diagnostics::warning(const char *file, const SourcePosition *pos, uint32_t length, const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	add(SEVERITY_WARNING, file, pos, length, fmt, args);
+	va_end(args);
+}
+
+void Diagnostics::add(Severity severity, const char *file, const SourcePosition *pos, uint32_t length, const char *fmt, va_list args) {
+	char message[FORMAT_BUFFER_SIZE];
+	size_t size = formatToV(message, sizeof(message), fmt, args);
+
+	Diagnostic diagnostic{ severity, (file != nullptr) ? file : "", SourcePosition{ 0, 0 }, length, std::string(message, size) };
+	if (pos != nullptr) {
+		diagnostic.position = *pos;
+	}
+
+	std::lock_guard<std::mutex> guard(lock);
+
+	// Errors past the limit are dropped, the stages stop soon after
+	if (severity == SEVERITY_ERROR) {
+		if (isFull()) {
+			return;
+		}
+		errors.fetch_add(1, std::memory_order_relaxed);
+	}
+	items.push_back(std::move(diagnostic));
+}
+
+std::vector<Diagnostic> Diagnostics::take() {
+	std::vector<Diagnostic> taken;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		taken.swap(items);
+		errors.store(0, std::memory_order_relaxed);
+	}
+
+	// Files lexed in parallel report in any order, so sort for stable output
+	std::stable_sort(taken.begin(), taken.end(), [](const Diagnostic &a, const Diagnostic &b) {
+		if (a.file != b.file) {
+			return a.file < b.file;
+		}
+		if (a.position.line != b.position.line) {
+			return a.position.line < b.position.line;
+		}
+		return a.position.column < b.position.column;
+	});
+	return taken;
+}
+
+bool Diagnostics::flush() {
+	bool full = isFull();
+	std::vector<Diagnostic> taken = take();
+	bool failed = false;
+
+	for (const Diagnostic &diagnostic : taken) {
+		failed |= (diagnostic.severity == SEVERITY_ERROR);
+
+		if (format == DIAGNOSTICS_JSON) {
+			printJson(diagnostic);
+			continue;
+		}
+
+		const char *pre = (diagnostic.severity == SEVERITY_ERROR) ? ASCII_BOLD_RED "Error:" ASCII_RESET : ASCII_BOLD_YELLOW "Warning:" ASCII_RESET;
+		const SourcePosition *pos = (diagnostic.position.line > 0) ? &diagnostic.position : nullptr;
+		customPrint(pre, diagnostic.file.c_str(), pos, "%s", diagnostic.message.c_str());
+	}
+
+	if (full && format == DIAGNOSTICS_TEXT) {
+		customPrint(nullptr, nullptr, nullptr, "Stopped after %zu errors (see --max-errors)", maxErrors);
+	}
+	return failed;
+}
+
+void Diagnostics::clear() {
+	std::lock_guard<std::mutex> guard(lock);
+	items.clear();
+	errors.store(0, std::memory_order_relaxed);
+}
+
+Diagnostics &getDiagnostics() {
+	static Diagnostics diagnostics;
+	return diagnostics;
+}
+
+/**
+ * Prints a diagnostic as a single line of JSON:
+ * `{"severity":"error","file":"a.dm","line":3,"column":5,"length":2,"message":"..."}`
+ * @param diagnostic Diagnostic to print.
+ */
+static void printJson(const Diagnostic &diagnostic) {
+	std::string line = "{\"severity\":";
+	line += (diagnostic.severity == SEVERITY_ERROR) ? "\"error\"" : "\"warning\"";
+	line += ",\"file\":";
+	appendJsonString(&line, diagnostic.file);
+	appendFormat(&line, ",\"line\":%d,\"column\":%d,\"length\":%u,\"message\":", diagnostic.position.line,
+		diagnostic.position.column, diagnostic.length);
+	appendJsonString(&line, diagnostic.message);
+	line += "}\n";
+
+	fwrite(line.data(), 1, line.size(), stderr);
+}
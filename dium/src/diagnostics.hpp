@@ -0,0 +1,171 @@
+/**
+ * @file       diagnostics.hpp
+ * @brief      Definitions for collecting and reporting errors and warnings
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef DIAGNOSTICS_HPP
+#define DIAGNOSTICS_HPP
+
+#include <atomic>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "format.hpp"
+#include "token.hpp"
+
+/** Errors reported before giving up, by default */
+#define DEFAULT_MAX_ERRORS 20
+
+/** How serious a diagnostic is */
+enum Severity : uint8_t {
+	SEVERITY_ERROR,
+	SEVERITY_WARNING
+};
+
+/** How diagnostics are printed */
+enum DiagnosticFormat {
+	DIAGNOSTICS_TEXT,  /* coloured messages for people */
+	DIAGNOSTICS_JSON   /* one JSON object per line, for tools */
+};
+
+/** Error or warning about a span of a source file */
+struct Diagnostic {
+	Severity severity;
+
+	/** Name of the source file, or empty */
+	std::string file;
+
+	/** First character of the span, with a line of 0 when there is no position */
+	SourcePosition position;
+
+	/** Number of characters in the span, 0 if unknown */
+	uint32_t length;
+
+	std::string message;
+};
+
+/**
+ * Collects the errors and warnings of every stage so that they are all reported at
+ * once, instead of stopping at the first one. Stages keep going after an error and
+ * check `isFull()` to stop early once the maximum number of errors has been reached.
+ * Diagnostics can be added from several threads at once.
+ */
+class Diagnostics {
+public:
+	/**
+	 * Adds an error.
+	 * @param file Name of the source file, or `nullptr`.
+	 * @param pos Start of the span, or `nullptr`.
+	 * @param length Number of characters in the span.
+	 * @param fmt Format of the message.
+	 * @param ... Arguments of the format.
+	 */
+	void error(const char *file, const SourcePosition *pos, uint32_t length, FORMAT_STRING const char *fmt, ...)
+		FORMAT_CHECK(5, 6);
+
+	/**
+	 * Adds a warning.
+	 * @param file Name of the source file, or `nullptr`.
+	 * @param pos Start of the span, or `nullptr`.
+	 * @param length Number of characters in the span.
+	 * @param fmt Format of the message.
+	 * @param ... Arguments of the format.
+	 */
+	void warning(const char *file, const SourcePosition *pos, uint32_t length, FORMAT_STRING const char *fmt, ...)
+		FORMAT_CHECK(5, 6);
+
+	/**
+	 * Adds an error or a warning.
+	 * @param severity How serious it is.
+	 * @param file Name of the source file, or `nullptr`.
+	 * @param pos Start of the span, or `nullptr`.
+	 * @param length Number of characters in the span.
+	 * @param fmt Format of the message.
+	 * @param args Arguments of the format.
+	 */
+	void add(Severity severity, const char *file, const SourcePosition *pos, uint32_t length, const char *fmt, va_list args);
+
+	/**
+	 * Checks if so many errors were reported that stages should stop.
+	 * @returns `true` once the maximum number of errors has been reached.
+	 */
+	bool isFull() const {
+		return maxErrors != 0 && errors.load(std::memory_order_relaxed) >= maxErrors;
+	}
+
+	/**
+	 * Returns the number of errors reported since the last `clear()`.
+	 * @returns Number of errors.
+	 */
+	size_t getErrorCount() const {
+		return errors.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Sets how many errors are reported before giving up.
+	 * @param count Maximum number of errors, or 0 for no limit.
+	 */
+	void setMaxErrors(size_t count) {
+		maxErrors = count;
+	}
+
+	/**
+	 * Sets how diagnostics are printed.
+	 * @param format Format to use.
+	 */
+	void setFormat(DiagnosticFormat format) {
+		this->format = format;
+	}
+
+	/**
+	 * Takes the diagnostics collected so far, sorted by file and position.
+	 * @returns Collected diagnostics, which are no longer held.
+	 */
+	std::vector<Diagnostic> take();
+
+	/**
+	 * Prints the diagnostics collected so far, sorted by file and position, to the
+	 * standard error output and forgets them.
+	 * @returns `true` if any of them was an error.
+	 */
+	bool flush();
+
+	/**
+	 * Forgets all diagnostics and resets the error count.
+	 */
+	void clear();
+
+private:
+	/** Guards `items` */
+	std::mutex lock;
+
+	/** Diagnostics in the order they were reported */
+	std::vector<Diagnostic> items;
+
+	/** Number of errors */
+	std::atomic<size_t> errors{ 0 };
+
+	/** Errors before giving up, 0 for no limit */
+	size_t maxErrors = DEFAULT_MAX_ERRORS;
+
+	/** How diagnostics are printed */
+	DiagnosticFormat format = DIAGNOSTICS_TEXT;
+};
+
+/**
+ * Returns the diagnostics of the command-line driver, which the fatal errors of
+ * `error.hpp` are also reported through.
+ * @returns Shared diagnostics.
+ */
+Diagnostics &getDiagnostics();
+
+#endif // DIAGNOSTICS_HPP
@@ -0,0 +1,669 @@
+/**
+ * @file       document.cpp
+ * @brief      Implementation of source files that are edited in place
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <algorithm>
+#include <iterator>
+#include "document.hpp"
+#include "lexer.hpp"
+#include "source.hpp"
+
+// --------------- function prototypes -------------------------
+
+template <typename T>
+static void splice(std::vector<T> *items, size_t first, size_t last, const std::vector<T> &with);
+static void movePosition(SourcePosition *pos, const SourcePosition &from, const SourcePosition &to);
+static void moveExpr(Expr *expr, const SourcePosition &from, const SourcePosition &to);
+static void moveStmt(Stmt *stmt, const SourcePosition &from, const SourcePosition &to);
+static void moveFunc(FuncDecl *func, const SourcePosition &from, const SourcePosition &to);
+
+
+Document::Document(std::string name, std::string_view text)
+	: name{ std::move(name) } {
+	this->text.assign(text.begin(), text.end());
+	this->text.resize(text.size() + SOURCE_PADDING, '\0');
+	size = text.size();
+
+	// Every error is kept, however many there are
+	scratch.setMaxErrors(0);
+
+	relex(0, 0, static_cast<uint32_t>(size));
+	parseAll();
+	buildProgram();
+}
+
+void Document::edit(uint32_t offset, uint32_t removed, std::string_view inserted) {
+	offset = static_cast<uint32_t>(std::min<size_t>(offset, size));
+	removed = static_cast<uint32_t>(std::min<size_t>(removed, size - offset));
+
+	// Move the rest of the text (and the padding) along, then copy the new text in
+	size_t tail = offset + removed;
+	if (inserted.size() > removed) {
+		text.insert(text.begin() + static_cast<ptrdiff_t>(tail), inserted.size() - removed, '\0');
+	} else {
+		text.erase(text.begin() + static_cast<ptrdiff_t>(offset + inserted.size()), text.begin() + static_cast<ptrdiff_t>(tail));
+	}
+	std::copy(inserted.begin(), inserted.end(), text.begin() + offset);
+	size = size - removed + inserted.size();
+	tokens.source = text.data();
+
+	stats = EditStats{};
+	reparse(relex(offset, removed, static_cast<uint32_t>(inserted.size())));
+
+	// Replaced functions stay in the arena, so start over once they take up too much
+	if (arena.getBytesUsed() > 2 * parsedBytes + DOCUMENT_ARENA_SLACK) {
+		parseAll();
+	}
+	buildProgram();
+}
+
+const Program *Document::getProgram() {
+	for (FuncEntry &func : funcs) {
+		if (func.lines != 0) {
+			settle(&func);
+		}
+	}
+	return &program;
+}
+
+std::vector<Diagnostic> Document::getDiagnostics() const {
+	std::vector<Diagnostic> all;
+
+	for (const TokenError &error : lexErrors) {
+		all.push_back(error.diagnostic);
+	}
+	for (const FuncEntry &func : funcs) {
+		all.insert(all.end(), func.errors.begin(), func.errors.end());
+	}
+
+	std::stable_sort(all.begin(), all.end(), [](const Diagnostic &a, const Diagnostic &b) {
+		if (a.position.line != b.position.line) {
+			return a.position.line < b.position.line;
+		}
+		return a.position.column < b.position.column;
+	});
+	return all;
+}
+
+bool Document::findToken(const SourcePosition &pos, size_t *token) const {
+	// Find the last token starting at or before the position
+	auto after = std::upper_bound(tokens.positions.begin(), tokens.positions.end(), pos,
+		[](const SourcePosition &a, const SourcePosition &b) {
+			return a.line < b.line || (a.line == b.line && a.column < b.column);
+		});
+	if (after == tokens.positions.begin()) {
+		return false;
+	}
+
+	auto idx = static_cast<size_t>(after - tokens.positions.begin()) - 1;
+	if (tokens.positions[idx].line != pos.line || pos.column > tokens.positions[idx].column + static_cast<int>(tokens.lengths[idx])) {
+		return false;
+	}
+
+	*token = idx;
+	return true;
+}
+
+uint32_t Document::getOffset(const SourcePosition &pos) const {
+	// Tokens know where they are, so only the text after the last one before the
+	// position has to be read
+	auto after = std::upper_bound(tokens.positions.begin(), tokens.positions.end(), pos,
+		[](const SourcePosition &a, const SourcePosition &b) {
+			return a.line < b.line || (a.line == b.line && a.column < b.column);
+		});
+
+	size_t offset = 0;
+	SourcePosition at{ 1, 1 };
+	if (after != tokens.positions.begin()) {
+		auto idx = static_cast<size_t>(after - tokens.positions.begin()) - 1;
+		offset = tokens.offsets[idx];
+		at = tokens.positions[idx];
+	}
+
+	// "\r\n" only counts as a single new line, like in the lexer
+	while (at.line < pos.line && offset < size) {
+		char c = text[offset++];
+		if (c == '\n' || (c == '\r' && text[offset] != '\n')) {
+			at.line += 1;
+			at.column = 1;
+		}
+	}
+
+	while (at.column < pos.column && offset < size && text[offset] != '\n' && text[offset] != '\r') {
+		offset++;
+		at.column++;
+	}
+	return static_cast<uint32_t>(offset);
+}
+
+bool Document::findDeclaration(size_t token, DeclRef *out) const {
+	if (token >= tokens.size() || tokens.types[token] != TOK_ID) {
+		return false;
+	}
+
+	// Functions can be called before they are declared
+	if (isFuncName(tokens, token)) {
+		Symbol symbol = tokens.getSymbol(token);
+
+		for (const FuncEntry &func : funcs) {
+			for (const Declaration &decl : func.index.decls) {
+				if (decl.kind == DECL_FUNC && decl.symbol == symbol) {
+					*out = DeclRef{ DECL_FUNC, func.first + decl.token, func.first + decl.typeToken };
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	const FuncEntry *func = findFunc(token);
+	if (func == nullptr) {
+		return false;
+	}
+
+	const Declaration *decl = func->index.resolve(tokens, func->first, token);
+	if (decl == nullptr) {
+		return false;
+	}
+
+	*out = DeclRef{ decl->kind, func->first + decl->token, func->first + decl->typeToken };
+	return true;
+}
+
+void Document::collectVisible(size_t token, std::vector<DeclRef> *out) const {
+	const FuncEntry *func = findFunc(token);
+
+	if (func != nullptr) {
+		std::vector<const Declaration *> visible;
+		func->index.collectVisible(func->first, token, &visible);
+
+		for (const Declaration *decl : visible) {
+			out->push_back(DeclRef{ decl->kind, func->first + decl->token, func->first + decl->typeToken });
+		}
+	}
+
+	for (const FuncEntry &entry : funcs) {
+		for (const Declaration &decl : entry.index.decls) {
+			if (decl.kind == DECL_FUNC) {
+				out->push_back(DeclRef{ DECL_FUNC, entry.first + decl.token, entry.first + decl.typeToken });
+			}
+		}
+	}
+}
+
+/**
+ * Reads the tokens around an edit again. Lexing starts right after the last token
+ * that could not have looked at the changed text, which is never inside a comment, and
+ * stops at the first new token past the changed text that starts where an old token
+ * did: from there on the lexer reads the same characters in the same state, so the old
+ * tokens only need to move along. This holds however far a nested comment opened or
+ * closed by the edit reaches, since comments are skipped in full between two tokens.
+ * @param offset Offset of the first changed character.
+ * @param removed Number of characters that were replaced.
+ * @param inserted Number of characters put in their place.
+ * @returns Tokens that were replaced.
+ */
+Document::TokenChange Document::relex(uint32_t offset, uint32_t removed, uint32_t inserted) {
+	size_t count = tokens.size();
+	int64_t delta = static_cast<int64_t>(inserted) - static_cast<int64_t>(removed);
+
+	// Find the first token that could have looked at the changed text
+	size_t low = 0;
+	size_t high = count;
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+		if (static_cast<size_t>(tokens.offsets[mid]) + tokens.lengths[mid] + LEXER_LOOKAHEAD <= offset) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	TokenChange change{};
+	change.first = static_cast<uint32_t>(low);
+
+	// Tokens never span lines, so the end of the previous token is easy to place
+	uint32_t start = 0;
+	SourcePosition position{ 1, 1 };
+	if (change.first > 0) {
+		size_t prev = change.first - 1;
+		start = tokens.offsets[prev] + tokens.lengths[prev];
+		position = tokens.positions[prev];
+		position.column += static_cast<int>(tokens.lengths[prev]);
+	}
+
+	SourceBuffer buffer;
+	buffer.data = text.data();
+	buffer.size = size;
+
+	Lexer lexer(buffer, name, symbols, scratch);
+	lexer.seek(start, position);
+
+	TokenStream fresh;
+	std::vector<TokenError> errors;
+	size_t old = change.first;
+	size_t last = count;
+	Token token{};
+
+	while (true) {
+		lexer.next(&token);
+
+		if (scratch.getErrorCount() > 0) {
+			for (Diagnostic &diagnostic : scratch.take()) {
+				errors.push_back(TokenError{ static_cast<uint32_t>(change.first + fresh.size()), std::move(diagnostic) });
+			}
+		}
+		fresh.push(token);
+
+		// Past the changed text, look for an old token starting at the same character
+		if (token.offset >= static_cast<size_t>(offset) + inserted) {
+			int64_t oldOffset = static_cast<int64_t>(token.offset) - delta;
+			while (old < count && tokens.offsets[old] < oldOffset) {
+				old++;
+			}
+			if (old < count && tokens.offsets[old] == oldOffset) {
+				change.from = tokens.positions[old];
+				change.to = token.position;
+				last = old + 1;
+				break;
+			}
+		}
+
+		if (token.type == TOK_EOF) {
+			break;
+		}
+	}
+
+	change.last = static_cast<uint32_t>(last);
+	change.count = static_cast<uint32_t>(fresh.size());
+	stats.tokensLexed = change.count;
+	stats.tokensReplaced = change.last - change.first;
+
+	splice(&tokens.types, change.first, last, fresh.types);
+	splice(&tokens.flags, change.first, last, fresh.flags);
+	splice(&tokens.offsets, change.first, last, fresh.offsets);
+	splice(&tokens.lengths, change.first, last, fresh.lengths);
+	splice(&tokens.positions, change.first, last, fresh.positions);
+	splice(&tokens.values, change.first, last, fresh.values);
+	tokens.source = text.data();
+	tokens.symbols = &symbols;
+
+	// Move the old tokens after the new ones along
+	size_t end = tokens.size();
+	size_t moved = change.first + change.count;
+	if (delta != 0) {
+		for (size_t idx = moved; idx < end; idx++) {
+			tokens.offsets[idx] = static_cast<uint32_t>(tokens.offsets[idx] + delta);
+		}
+	}
+
+	// The rest of the line moves sideways, and every later line up or down
+	size_t idx = moved;
+	for (; idx < end && tokens.positions[idx].line == change.from.line; idx++) {
+		movePosition(&tokens.positions[idx], change.from, change.to);
+	}
+
+	int lines = change.to.line - change.from.line;
+	if (lines != 0) {
+		for (; idx < end; idx++) {
+			tokens.positions[idx].line += lines;
+		}
+	}
+
+	// Swap the errors of the replaced tokens for the new ones
+	auto firstError = std::lower_bound(lexErrors.begin(), lexErrors.end(), change.first,
+		[](const TokenError &error, uint32_t idx) { return error.token < idx; });
+	auto lastError = std::lower_bound(firstError, lexErrors.end(), change.last,
+		[](const TokenError &error, uint32_t idx) { return error.token < idx; });
+
+	for (auto error = lastError; error != lexErrors.end(); ++error) {
+		error->token = error->token - change.last + moved;
+		movePosition(&error->diagnostic.position, change.from, change.to);
+	}
+
+	firstError = lexErrors.erase(firstError, lastError);
+	lexErrors.insert(firstError, std::make_move_iterator(errors.begin()), std::make_move_iterator(errors.end()));
+	return change;
+}
+
+/**
+ * Parses the functions containing replaced tokens again. Parsing starts at the first
+ * function that could have looked at them, and stops at the first function past them
+ * that starts at the same token as an old one. The functions after it keep their
+ * syntax trees, with their positions moved along.
+ * @param change Tokens that were replaced.
+ */
+void Document::reparse(const TokenChange &change) {
+	int64_t shift = static_cast<int64_t>(change.count) - static_cast<int64_t>(change.last - change.first);
+	uint32_t changed = change.first + change.count;
+
+	// The parser may have looked at the token after a function, so it must be older
+	auto keep = std::partition_point(funcs.begin(), funcs.end(), [&](const FuncEntry &func) {
+		return func.next < change.first;
+	});
+
+	size_t from = static_cast<size_t>(keep - funcs.begin());
+	size_t old = from;
+	uint32_t current = (from > 0) ? funcs[from - 1].next : 0;
+
+	Parser parser(tokens, arena, name, scratch);
+	std::vector<FuncEntry> parsed;
+
+	while (true) {
+		if (tokens.types[current] == TOK_EOF) {
+			old = funcs.size();
+			break;
+		}
+
+		// Past the replaced tokens, look for an old function starting at the same token
+		if (current >= changed) {
+			int64_t oldFirst = static_cast<int64_t>(current) - shift;
+			while (old < funcs.size() && funcs[old].first < oldFirst) {
+				old++;
+			}
+			if (old < funcs.size() && funcs[old].first == oldFirst) {
+				break;
+			}
+		}
+
+		parseFunc(parser, current, &parsed);
+		current = parsed.back().next;
+	}
+
+	stats.funcsParsed = static_cast<uint32_t>(parsed.size());
+	stats.funcsReused = static_cast<uint32_t>(from + funcs.size() - old);
+
+	funcs.erase(funcs.begin() + static_cast<ptrdiff_t>(from), funcs.begin() + static_cast<ptrdiff_t>(old));
+	funcs.insert(funcs.begin() + static_cast<ptrdiff_t>(from), std::make_move_iterator(parsed.begin()),
+		std::make_move_iterator(parsed.end()));
+
+	// Move the functions after the new ones along
+	int lines = change.to.line - change.from.line;
+	bool columns = (change.to.column != change.from.column);
+
+	for (size_t idx = from + parsed.size(); idx < funcs.size(); idx++) {
+		FuncEntry &func = funcs[idx];
+		func.first = static_cast<uint32_t>(func.first + shift);
+		func.next = static_cast<uint32_t>(func.next + shift);
+
+		for (Diagnostic &error : func.errors) {
+			movePosition(&error.position, change.from, change.to);
+		}
+
+		// Part of a function starting on the line of the change also moves sideways
+		if (columns && tokens.positions[func.first].line == change.to.line) {
+			settle(&func);
+			if (func.decl != nullptr) {
+				moveFunc(func.decl, change.from, change.to);
+			}
+		} else {
+			func.lines += lines;
+		}
+	}
+}
+
+/**
+ * Parses all functions from scratch, freeing the syntax trees of the old ones.
+ */
+void Document::parseAll() {
+	funcs.clear();
+	arena.reset();
+
+	Parser parser(tokens, arena, name, scratch);
+	uint32_t current = 0;
+
+	while (tokens.types[current] != TOK_EOF) {
+		parseFunc(parser, current, &funcs);
+		current = funcs.back().next;
+	}
+
+	parsedBytes = arena.getBytesUsed();
+	stats.funcsParsed = static_cast<uint32_t>(funcs.size());
+	stats.funcsReused = 0;
+}
+
+/**
+ * Parses a single function.
+ * @param parser Parser of the tokens of the document.
+ * @param first Index of the first token of the function.
+ * @param out List to add the function to.
+ */
+void Document::parseFunc(Parser &parser, uint32_t first, std::vector<FuncEntry> *out) {
+	size_t next;
+	FuncDecl *decl = parser.parseFuncAt(first, &next);
+
+	out->push_back(FuncEntry{ first, static_cast<uint32_t>(next), decl, 0, {}, nextId++, {} });
+	if (scratch.getErrorCount() > 0) {
+		out->back().errors = scratch.take();
+	}
+	out->back().index.build(tokens, first, next);
+}
+
+/**
+ * Moves the syntax tree of a function by the lines it was left to move.
+ * @param func Function to move.
+ */
+void Document::settle(FuncEntry *func) {
+	// No node is on line 0, so only the lines move
+	if (func->decl != nullptr) {
+		moveFunc(func->decl, SourcePosition{ 0, 0 }, SourcePosition{ func->lines, 0 });
+	}
+	func->lines = 0;
+}
+
+/**
+ * Gathers the functions without syntax errors into the program handed out.
+ */
+void Document::buildProgram() {
+	decls.clear();
+	for (const FuncEntry &func : funcs) {
+		if (func.decl != nullptr) {
+			decls.push_back(func.decl);
+		}
+	}
+
+	program.funcs = decls.data();
+	program.count = static_cast<uint32_t>(decls.size());
+}
+
+/**
+ * Finds the function a token belongs to.
+ * @param token Index of a token.
+ * @returns Function whose tokens include it, or `nullptr` for the final `TOK_EOF`.
+ */
+const Document::FuncEntry *Document::findFunc(size_t token) const {
+	auto func = std::partition_point(funcs.begin(), funcs.end(), [&](const FuncEntry &entry) {
+		return entry.next <= token;
+	});
+	return (func != funcs.end() && func->first <= token) ? &*func : nullptr;
+}
+
+/**
+ * Replaces a range of a list by the items of another list, moving the rest of the list
+ * at most once.
+ * @param items List to change.
+ * @param first Index of the first item replaced.
+ * @param last Index of the first item kept after them.
+ * @param with Items to put in their place.
+ */
+template <typename T>
+static void splice(std::vector<T> *items, size_t first, size_t last, const std::vector<T> &with) {
+	size_t replaced = last - first;
+	auto start = items->begin() + static_cast<ptrdiff_t>(first);
+
+	if (with.size() > replaced) {
+		std::copy(with.begin(), with.begin() + static_cast<ptrdiff_t>(replaced), start);
+		items->insert(items->begin() + static_cast<ptrdiff_t>(last), with.begin() + static_cast<ptrdiff_t>(replaced), with.end());
+	} else {
+		std::copy(with.begin(), with.end(), start);
+		items->erase(start + static_cast<ptrdiff_t>(with.size()), items->begin() + static_cast<ptrdiff_t>(last));
+	}
+}
+
+/**
+ * Moves a position that comes after an edit along with the text.
+ * @param pos Position to move.
+ * @param from Old position of a point after the edit.
+ * @param to New position of the same point.
+ */
+static void movePosition(SourcePosition *pos, const SourcePosition &from, const SourcePosition &to) {
+	// The rest of the line the point is on moves sideways too
+	if (pos->line == from.line) {
+		pos->column += to.column - from.column;
+	}
+	pos->line += to.line - from.line;
+}
+
+/**
+ * Moves the positions of an expression and everything in it.
+ * @param expr Expression to move.
+ * @param from Old position of a point before the expression.
+ * @param to New position of the same point.
+ */
+static void moveExpr(Expr *expr, const SourcePosition &from, const SourcePosition &to) {
+	movePosition(&expr->position, from, to);
+
+	switch (expr->kind) {
+	case EXPR_NUM:
+	case EXPR_DEC:
+	case EXPR_BOOL:
+	case EXPR_CHAR:
+	case EXPR_STR:
+	case EXPR_NAME:
+		break;
+	case EXPR_ARRAY: {
+		auto *array = static_cast<ArrayExpr *>(expr);
+		for (uint32_t idx = 0; idx < array->count; idx++) {
+			moveExpr(array->items[idx], from, to);
+		}
+		break;
+	}
+	case EXPR_UNARY:
+		moveExpr(static_cast<UnaryExpr *>(expr)->operand, from, to);
+		break;
+	case EXPR_BINARY: {
+		// Chains such as long sums nest through their left operands, which are moved in a loop
+		auto *binary = static_cast<BinaryExpr *>(expr);
+		moveExpr(binary->rhs, from, to);
+		while (binary->lhs->kind == EXPR_BINARY) {
+			binary = static_cast<BinaryExpr *>(binary->lhs);
+			movePosition(&binary->position, from, to);
+			moveExpr(binary->rhs, from, to);
+		}
+		moveExpr(binary->lhs, from, to);
+		break;
+	}
+	case EXPR_INDEX:
+		moveExpr(static_cast<IndexExpr *>(expr)->array, from, to);
+		moveExpr(static_cast<IndexExpr *>(expr)->index, from, to);
+		break;
+	case EXPR_CALL: {
+		auto *call = static_cast<CallExpr *>(expr);
+		for (uint32_t idx = 0; idx < call->count; idx++) {
+			moveExpr(call->args[idx], from, to);
+		}
+		break;
+	}
+	case EXPR_CAST:
+		moveExpr(static_cast<CastExpr *>(expr)->operand, from, to);
+		break;
+	}
+}
+
+/**
+ * Moves the positions of a statement and everything in it.
+ * @param stmt Statement to move.
+ * @param from Old position of a point before the statement.
+ * @param to New position of the same point.
+ */
+static void moveStmt(Stmt *stmt, const SourcePosition &from, const SourcePosition &to) {
+	movePosition(&stmt->position, from, to);
+
+	switch (stmt->kind) {
+	case STMT_BLOCK: {
+		auto *block = static_cast<BlockStmt *>(stmt);
+		for (uint32_t idx = 0; idx < block->count; idx++) {
+			moveStmt(block->stmts[idx], from, to);
+		}
+		break;
+	}
+	case STMT_VAR: {
+		auto *var = static_cast<VarStmt *>(stmt);
+		if (var->value != nullptr) {
+			moveExpr(var->value, from, to);
+		}
+		break;
+	}
+	case STMT_ASSIGN:
+		moveExpr(static_cast<AssignStmt *>(stmt)->target, from, to);
+		moveExpr(static_cast<AssignStmt *>(stmt)->value, from, to);
+		break;
+	case STMT_EXPR:
+		moveExpr(static_cast<ExprStmt *>(stmt)->expr, from, to);
+		break;
+	case STMT_IF: {
+		auto *branch = static_cast<IfStmt *>(stmt);
+		moveExpr(branch->cond, from, to);
+		moveStmt(branch->then, from, to);
+		if (branch->otherwise != nullptr) {
+			moveStmt(branch->otherwise, from, to);
+		}
+		break;
+	}
+	case STMT_WHILE:
+		moveExpr(static_cast<WhileStmt *>(stmt)->cond, from, to);
+		moveStmt(static_cast<WhileStmt *>(stmt)->body, from, to);
+		break;
+	case STMT_FOR: {
+		auto *loop = static_cast<ForStmt *>(stmt);
+		if (loop->start != nullptr) {
+			moveExpr(loop->start, from, to);
+		}
+		moveExpr(loop->stop, from, to);
+		if (loop->step != nullptr) {
+			moveExpr(loop->step, from, to);
+		}
+		moveStmt(loop->body, from, to);
+		break;
+	}
+	case STMT_RETURN: {
+		auto *ret = static_cast<ReturnStmt *>(stmt);
+		if (ret->value != nullptr) {
+			moveExpr(ret->value, from, to);
+		}
+		break;
+	}
+	case STMT_PRINT: {
+		auto *print = static_cast<PrintStmt *>(stmt);
+		if (print->value != nullptr) {
+			moveExpr(print->value, from, to);
+		}
+		break;
+	}
+	case STMT_EXIT:
+		moveExpr(static_cast<ExitStmt *>(stmt)->code, from, to);
+		break;
+	case STMT_BREAK:
+	case STMT_CONTINUE:
+		break;
+	}
+}
+
+/**
+ * Moves the positions of a function and everything in it.
+ * @param func Function to move.
+ * @param from Old position of a point before the function.
+ * @param to New position of the same point.
+ */
+static void moveFunc(FuncDecl *func, const SourcePosition &from, const SourcePosition &to) {
+	movePosition(&func->position, from, to);
+
+	for (uint32_t idx = 0; idx < func->paramCount; idx++) {
+		movePosition(&func->params[idx].position, from, to);
+	}
+	moveStmt(func->body, from, to);
+}
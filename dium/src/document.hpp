@@ -0,0 +1,282 @@
+/**
+ * @file       document.hpp
+ * @brief      Definitions for source files that are edited in place
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef DOCUMENT_HPP
+#define DOCUMENT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "arena.hpp"
+#include "ast.hpp"
+#include "diagnostics.hpp"
+#include "index.hpp"
+#include "interner.hpp"
+#include "parser.hpp"
+#include "token.hpp"
+
+/** Bytes the syntax tree may waste on replaced functions before it is parsed from scratch */
+#define DOCUMENT_ARENA_SLACK (8 * 1024 * 1024)
+
+/** What the last edit of a document cost */
+struct EditStats {
+	/** Number of tokens that were read again */
+	uint32_t tokensLexed;
+
+	/** Number of old tokens that the new ones replaced */
+	uint32_t tokensReplaced;
+
+	/** Number of functions that were parsed again */
+	uint32_t funcsParsed;
+
+	/** Number of functions whose syntax tree was kept */
+	uint32_t funcsReused;
+};
+
+/** Function or variable found in a document */
+struct DeclRef {
+	DeclKind kind;
+
+	/** Index of the token naming it */
+	uint32_t token;
+
+	/** Index of the first token of its type (the `func` keyword for functions) */
+	uint32_t typeToken;
+};
+
+/** Tokens of a function that were parsed together */
+struct FuncSpan {
+	/** Index of the first token */
+	uint32_t first;
+
+	/** Index of the token after the last one */
+	uint32_t next;
+
+	/** Number that changes whenever the function is parsed again, and only then */
+	uint64_t id;
+};
+
+/**
+ * Source file held by an editor, kept lexed and parsed as it changes. An edit only
+ * reads the tokens around the changed text again, until the new tokens line up with
+ * the old ones, and only parses the functions that contain changed tokens again. The
+ * syntax trees of all other functions are kept, after moving their positions along.
+ * Errors of the lexer and parser are kept with the tokens and functions they belong to,
+ * and so is an index of the declarations of each function, which lookups by an editor
+ * are answered from.
+ */
+class Document {
+public:
+	/**
+	 * Creates a document, lexing and parsing the whole text.
+	 * @param name Name of the source file, used in diagnostics.
+	 * @param text Contents of the source file.
+	 */
+	Document(std::string name, std::string_view text);
+
+	Document(const Document &) = delete;
+	Document &operator=(const Document &) = delete;
+
+	/**
+	 * Replaces part of the text, bringing the tokens and syntax tree up to date.
+	 * @param offset Offset of the first character replaced, at most the size of the text.
+	 * @param removed Number of characters replaced, cut short at the end of the text.
+	 * @param inserted Text put in their place.
+	 */
+	void edit(uint32_t offset, uint32_t removed, std::string_view inserted);
+
+	/**
+	 * Returns the current text.
+	 * @returns Contents of the document.
+	 */
+	std::string_view getText() const {
+		return std::string_view(text.data(), size);
+	}
+
+	/**
+	 * Returns the name of the document.
+	 * @returns Name used in diagnostics.
+	 */
+	const std::string &getName() const {
+		return name;
+	}
+
+	/**
+	 * Returns the tokens of the current text.
+	 * @returns Tokens, ending with `TOK_EOF`.
+	 */
+	const TokenStream &getTokens() const {
+		return tokens;
+	}
+
+	/**
+	 * Returns the syntax tree of the current text, leaving out functions with syntax
+	 * errors. Edits that add or remove lines leave the positions of the functions after
+	 * them to be moved here, so that typing does not walk the whole tree every time.
+	 * Only valid until the next edit.
+	 * @returns Syntax tree of the program.
+	 */
+	const Program *getProgram();
+
+	/**
+	 * Returns the table the identifiers of the document are interned in, which keeps
+	 * every identifier the document ever held.
+	 * @returns Interner of the document.
+	 */
+	const Interner &getSymbols() const {
+		return symbols;
+	}
+
+	/**
+	 * Gathers the errors of the lexer and parser for the current text.
+	 * @returns Diagnostics, sorted by position.
+	 */
+	std::vector<Diagnostic> getDiagnostics() const;
+
+	/**
+	 * Returns what the last edit cost.
+	 * @returns Amount of work done by the last call to `edit()`.
+	 */
+	const EditStats &getLastEdit() const {
+		return stats;
+	}
+
+	/**
+	 * Finds the token at a position.
+	 * @param pos Line and column to look at.
+	 * @param[out] token Index of the token containing the position, or ending right
+	 *     before it.
+	 * @returns `true` if there is such a token, `false` if the position is between tokens.
+	 */
+	bool findToken(const SourcePosition &pos, size_t *token) const;
+
+	/**
+	 * Converts a line and column to an offset in the text.
+	 * @param pos Line and column, with columns counted in bytes.
+	 * @returns Offset of the character there, moved back to the end of the line or of
+	 *     the text if the position is past it.
+	 */
+	uint32_t getOffset(const SourcePosition &pos) const;
+
+	/**
+	 * Finds where the function or variable an identifier refers to is declared. Calls
+	 * refer to functions, and other names to the innermost variable of that name.
+	 * @param token Index of a token.
+	 * @param[out] out Declaration found.
+	 * @returns `true` if the token is an identifier with a declaration, `false` otherwise.
+	 */
+	bool findDeclaration(size_t token, DeclRef *out) const;
+
+	/**
+	 * Lists the names that can be used at a token: the variables in scope, innermost
+	 * first, followed by all functions.
+	 * @param token Index of a token.
+	 * @param[out] out List to add the declarations to.
+	 */
+	void collectVisible(size_t token, std::vector<DeclRef> *out) const;
+
+	/**
+	 * Returns the number of functions the tokens were parsed as.
+	 * @returns Number of functions, including stretches of tokens skipped after errors.
+	 */
+	size_t getFuncCount() const {
+		return funcs.size();
+	}
+
+	/**
+	 * Returns the tokens of a function.
+	 * @param idx Index of the function, below `getFuncCount()`.
+	 * @returns Range of tokens and the number identifying this parse of them.
+	 */
+	FuncSpan getFuncSpan(size_t idx) const {
+		return FuncSpan{ funcs[idx].first, funcs[idx].next, funcs[idx].id };
+	}
+
+private:
+	/* Error of the lexer, kept with the token it was reported for */
+	struct TokenError {
+		uint32_t token;
+		Diagnostic diagnostic;
+	};
+
+	/* Tokens replaced by an edit */
+	struct TokenChange {
+		uint32_t first;        /* Index of the first replaced token */
+		uint32_t last;         /* Index of the first old token that was kept */
+		uint32_t count;        /* Number of new tokens in their place */
+		SourcePosition from;   /* Old position of the last replaced token, where the new tokens lined up... */
+		SourcePosition to;     /* ...and its new position, which all later positions move along with */
+	};
+
+	/* Function (or the tokens skipped after a syntax error) parsed on its own */
+	struct FuncEntry {
+		uint32_t first;                   /* Index of its first token */
+		uint32_t next;                    /* Index of the token after it */
+		FuncDecl *decl;                   /* Syntax tree, `nullptr` after a syntax error */
+		int lines;                        /* Lines the syntax tree still has to move by */
+		std::vector<Diagnostic> errors;   /* Errors of the parser */
+		uint64_t id;                      /* Number given to this parse of the function */
+		TokenIndex index;                 /* Declarations of its tokens */
+	};
+
+	/** Name of the source file */
+	std::string name;
+
+	/** Text of the source file, followed by `SOURCE_PADDING` zero bytes */
+	std::vector<char> text;
+
+	/** Number of characters in the text */
+	size_t size = 0;
+
+	/** Tokens of the text */
+	TokenStream tokens;
+
+	/** Identifiers of the text */
+	Interner symbols;
+
+	/** Errors of the lexer, ordered by token */
+	std::vector<TokenError> lexErrors;
+
+	/** Functions covering all tokens but the final `TOK_EOF`, in order */
+	std::vector<FuncEntry> funcs;
+
+	/** Arena the syntax trees are allocated from */
+	Arena arena;
+
+	/** Bytes used by the arena after the last full parse */
+	size_t parsedBytes = 0;
+
+	/** Functions without syntax errors, which `program` points to */
+	std::vector<FuncDecl *> decls;
+
+	/** Syntax tree handed out by `getProgram()` */
+	Program program{};
+
+	/** Collects the errors of a single lexer or parser run */
+	Diagnostics scratch;
+
+	/** What the last edit cost */
+	EditStats stats{};
+
+	/** Number given to the next function parsed */
+	uint64_t nextId = 0;
+
+	TokenChange relex(uint32_t offset, uint32_t removed, uint32_t inserted);
+	void reparse(const TokenChange &change);
+	void parseAll();
+	void parseFunc(Parser &parser, uint32_t first, std::vector<FuncEntry> *out);
+	void settle(FuncEntry *func);
+	void buildProgram();
+	const FuncEntry *findFunc(size_t token) const;
+};
+
+#endif // DOCUMENT_HPP
@@ -0,0 +1,40 @@
+/**
+ * @file       driver.cpp
+ * @brief      Implementation for lexing many source files at once
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include "driver.hpp"
+#include "lexer.hpp"
+#include "pool.hpp"
+#include "scan.hpp"
+
+
+std::vector<LexedFile> lexFiles(const std::vector<std::string> &paths, unsigned threads) {
+	std::vector<LexedFile> files(paths.size());
+
+	// Pick the scanners before any thread needs them
+	initScanner();
+
+	ThreadPool pool(threads);
+	pool.run(paths.size(), [&paths, &files](size_t idx) {
+		LexedFile &file = files[idx];
+		file.path = paths[idx];
+		file.opened = openSource(&file.buffer, file.path.c_str());
+
+		if (file.opened) {
+			Lexer lexer(file.buffer, file.path, file.symbols, getDiagnostics());
+			file.tokens = lexer.tokenize();
+		}
+	});
+
+	return files;
+}
+
+void closeFiles(std::vector<LexedFile> &files) {
+	for (LexedFile &file : files) {
+		closeSource(&file.buffer);
+	}
+}
@@ -0,0 +1,52 @@
+/**
+ * @file       driver.hpp
+ * @brief      Definitions for lexing many source files at once
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef DRIVER_HPP
+#define DRIVER_HPP
+
+#include <string>
+#include <vector>
+#include "source.hpp"
+#include "token.hpp"
+
+/** Single source file read by `lexFiles()` */
+struct LexedFile {
+	/** Path to the source file */
+	std::string path;
+
+	/** Contents of the source file, which the tokens refer to */
+	SourceBuffer buffer;
+
+	/** Tokens of the source file */
+	TokenStream tokens;
+
+	/** Identifiers of the source file */
+	Interner symbols;
+
+	/** `true` if the file could be opened, `false` otherwise */
+	bool opened = false;
+};
+
+/**
+ * Lexes a list of source files in parallel, spreading them across a work-stealing
+ * thread pool with one lexer per file.
+ * @param paths Paths to the source files.
+ * @param threads Number of threads to use, or 0 for one per hardware thread.
+ * @returns Result for each file, in the same order as the paths.
+ */
+std::vector<LexedFile> lexFiles(const std::vector<std::string> &paths, unsigned threads = 0);
+
+/**
+ * Releases the source buffers held by lexed files.
+ * @param files Files to release.
+ */
+void closeFiles(std::vector<LexedFile> &files);
+
+#endif // DRIVER_HPP
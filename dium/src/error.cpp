@@ -0,0 +1,95 @@
+/**
+ * @file       error.cpp
+ * @brief      Implementation of error reporting
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include "diagnostics.hpp"
+#include "error.hpp"
+
+// --------------- function prototypes -------------------------
+
+[[noreturn]] static void fail(const char *name, const SourcePosition *pos, const char *fmt, va_list args);
+
+
+void customPrint(const char *pre, const char *name, const SourcePosition *pos, const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	customPrintV(pre, name, pos, fmt, args);
+	va_end(args);
+}
+
+void customPrintV(const char *pre, const char *name, const SourcePosition *pos, const char *fmt, va_list args) {
+	char message[FORMAT_BUFFER_SIZE];
+	size_t length = formatTo(message, sizeof(message), "\n");
+
+	if (name != nullptr && name[0] != '\0') {
+		length += formatTo(message + length, sizeof(message) - length, "%s%s:%s", ASCII_BOLD_WHITE, name, ASCII_RESET);
+	}
+
+	if (pos != nullptr) {
+		length += formatTo(message + length, sizeof(message) - length, " %s%d:%d%s", ASCII_BOLD_WHITE, pos->line, pos->column, ASCII_RESET);
+	}
+
+	if (pre != nullptr) {
+		length += formatTo(message + length, sizeof(message) - length, " %s ", pre);
+	} else {
+		length += formatTo(message + length, sizeof(message) - length, " ");
+	}
+
+	length += formatToV(message + length, sizeof(message) - length, fmt, args);
+
+	// A message cut short still ends its line
+	if (length == sizeof(message) - 1) {
+		length--;
+	}
+	message[length++] = '\n';
+
+	fwrite(message, 1, length, stderr);
+	fflush(stderr);
+}
+
+void printErr(const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	fail(sname.c_str(), &position, fmt, args);
+}
+
+void printErrAt(const char *name, const SourcePosition *pos, const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	fail(name, pos, fmt, args);
+}
+
+void printErrAtV(const char *name, const SourcePosition *pos, const char *fmt, va_list args) {
+	fail(name, pos, fmt, args);
+}
+
+void printWarn(const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	getDiagnostics().add(SEVERITY_WARNING, sname.c_str(), &position, 0, fmt, args);
+	va_end(args);
+}
+
+/**
+ * Adds a fatal error to the shared diagnostics, prints everything collected so far
+ * and exits.
+ * @param name Name of the source file.
+ * @param pos Position in the source file.
+ * @param fmt Formatted string.
+ * @param args Arguments of the format.
+ */
+static void fail(const char *name, const SourcePosition *pos, const char *fmt, va_list args) {
+	Diagnostics &diagnostics = getDiagnostics();
+
+	// A fatal error is always reported, even past the limit
+	diagnostics.setMaxErrors(0);
+	diagnostics.add(SEVERITY_ERROR, name, pos, 0, fmt, args);
+	diagnostics.flush();
+	exit(2);
+}
@@ -11,8 +11,10 @@
 #ifndef ERROR_HPP
 #define ERROR_HPP
 
-#include <iostream>
+#include <cstdarg>
 #include <string>
+#include "format.hpp"
+#include "token.hpp"
 
 #define ESC                      "\033["
 #define BOLD                     "1;"
@@ -72,84 +74,70 @@
 #define ASCII_BOLD_HIGH_CYAN     ESC BOLD HIGH_CYAN
 #define ASCII_BOLD_HIGH_WHITE    ESC BOLD HIGH_WHITE
 
-/* Position in the source file */
-struct SourcePosition {
-	int line = 1;
-	int column = 1;
-};
-
 extern SourcePosition position;
 extern std::string sname;
 
 /**
- * Formats a string.
+ * Prints a message to the standard error output. The message is built in a buffer on
+ * the stack and written in one go, so messages from different threads do not
+ * interleave.
+ * @param pre Prefix to apply.
+ * @param name Name of the source file.
+ * @param pos Position in the source file.
  * @param fmt Format to apply.
  * @param ... Variable arguments.
  */
-template <typename ...Args>
-static std::string customFormat(const char *fmt, Args... args) {
-	int sizeFormatted = std::snprintf(nullptr, 0, fmt, args...) + 1;
-	if (sizeFormatted <= 0) {
-		return "";
-	}
-
-	auto size = static_cast<size_t>(sizeFormatted);
-	std::unique_ptr<char[]> buffer(new char[size]);
-	std::snprintf(buffer.get(), size, fmt, args...);
-	return std::string(buffer.get(), buffer.get() + size - 1);
-}
+void customPrint(const char *pre, const char *name, const SourcePosition *pos, FORMAT_STRING const char *fmt, ...)
+	FORMAT_CHECK(4, 5);
 
 /**
- * Prints to the standard error output.
+ * Prints a message to the standard error output (see `customPrint()`).
  * @param pre Prefix to apply.
+ * @param name Name of the source file.
  * @param pos Position in the source file.
  * @param fmt Format to apply.
- * @param ... Variable arguments.
+ * @param args Arguments of the format.
  */
-template <typename ...Args>
-static void customPrint(const char *pre, const SourcePosition *pos, const char *fmt, Args... args) {
-	std::string message = "";
-
-	if (sname.length() > 0) {
-		message += customFormat("%s%s:%s", ASCII_BOLD_WHITE, sname.c_str(), ASCII_RESET);
-	}
+void customPrintV(const char *pre, const char *name, const SourcePosition *pos, const char *fmt, va_list args);
 
-	if (pos != nullptr) {
-		message += customFormat(" %s%d:%d%s", ASCII_BOLD_WHITE, pos->line, pos->column, ASCII_RESET);
-	}
-
-	if (pre != nullptr) {
-		message += customFormat(" %s ", pre);
-	} else {
-		message += " ";
-	}
-
-	message += customFormat(fmt, args...);
-	std::cerr << "\n" << message << std::endl;
-}
+/*
+ * The errors below are fatal: they are added to the shared diagnostics (see
+ * `diagnostics.hpp`), which are printed along with anything collected before, and the
+ * process exits with status 2.
+ */
 
 /**
  * Displays an error message with the current position prepended.
  * @param fmt Formatted string.
  * @param ... Variable arguments.
  */
-template <typename ...Args>
-void printErr(const char *fmt, Args... args) {
-	const char *pre = ASCII_BOLD_RED "Error:" ASCII_RESET;
-	customPrint(pre, &position, fmt, args...);
-	exit(2);
-}
+[[noreturn]] void printErr(FORMAT_STRING const char *fmt, ...) FORMAT_CHECK(1, 2);
+
+/**
+ * Displays an error message for the given source file and position.
+ * @param name Name of the source file.
+ * @param pos Position in the source file.
+ * @param fmt Formatted string.
+ * @param ... Variable arguments.
+ */
+[[noreturn]] void printErrAt(const char *name, const SourcePosition *pos, FORMAT_STRING const char *fmt, ...) FORMAT_CHECK(3, 4);
+
+/**
+ * Displays an error message for the given source file and position, for the `error()`
+ * members of the stages that forward their own arguments.
+ * @param name Name of the source file.
+ * @param pos Position in the source file.
+ * @param fmt Formatted string.
+ * @param args Arguments of the format.
+ */
+[[noreturn]] void printErrAtV(const char *name, const SourcePosition *pos, const char *fmt, va_list args);
 
 /**
- * Displays a warning message with the current position prepended.
+ * Adds a warning at the current position to the shared diagnostics, which is printed
+ * with the others (see `Diagnostics::flush()`).
  * @param fmt Formatted string.
  * @param ... Variable arguments.
  */
-template <typename ...Args>
-void printWarn(const char *fmt, Args... args) {
-	const char *pre = ASCII_BOLD_YELLOW "Warning:" ASCII_RESET;
-	customPrint(pre, &position, fmt, args...);
-	exit(2);
-}
+void printWarn(FORMAT_STRING const char *fmt, ...) FORMAT_CHECK(1, 2);
 
 #endif // ERROR_HPP
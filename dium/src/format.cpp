@@ -0,0 +1,84 @@
+/**
+ * @file       format.cpp
+ * @brief      Implementation of printf-style formatting into existing buffers
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <cstdio>
+#include "format.hpp"
+
+/* Size of the stack buffer `appendFormat()` formats into first */
+#define APPEND_BUFFER_SIZE 256
+
+// --------------- function prototypes -------------------------
+
+static void appendFormatV(std::string *out, const char *fmt, va_list args);
+
+
+size_t formatToV(char *buffer, size_t size, const char *fmt, va_list args) {
+	if (size == 0) {
+		return 0;
+	}
+
+	int written = vsnprintf(buffer, size, fmt, args);
+	if (written < 0) {
+		buffer[0] = '\0';
+		return 0;
+	}
+	return (static_cast<size_t>(written) < size) ? static_cast<size_t>(written) : size - 1;
+}
+
+size_t formatTo(char *buffer, size_t size, const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	size_t length = formatToV(buffer, size, fmt, args);
+	va_end(args);
+	return length;
+}
+
+void appendFormat(std::string *out, const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	appendFormatV(out, fmt, args);
+	va_end(args);
+}
+
+std::string customFormat(const char *fmt, ...) {
+	std::string out;
+	va_list args;
+	va_start(args, fmt);
+	appendFormatV(&out, fmt, args);
+	va_end(args);
+	return out;
+}
+
+/**
+ * Formats onto the end of a string. Text longer than the stack buffer, which is rare,
+ * is formatted a second time straight into the string.
+ * @param out String to append to.
+ * @param fmt Format to apply.
+ * @param args Arguments of the format.
+ */
+static void appendFormatV(std::string *out, const char *fmt, va_list args) {
+	char buffer[APPEND_BUFFER_SIZE];
+	va_list retry;
+	va_copy(retry, args);
+
+	int written = vsnprintf(buffer, sizeof(buffer), fmt, args);
+	if (written < 0) {
+		va_end(retry);
+		return;
+	}
+
+	auto length = static_cast<size_t>(written);
+	if (length < sizeof(buffer)) {
+		out->append(buffer, length);
+	} else {
+		size_t start = out->size();
+		out->resize(start + length);
+		vsnprintf(&(*out)[start], length + 1, fmt, retry);
+	}
+	va_end(retry);
+}
@@ -0,0 +1,76 @@
+/**
+ * @file       format.hpp
+ * @brief      Definitions for printf-style formatting into existing buffers
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef FORMAT_HPP
+#define FORMAT_HPP
+
+#include <cstdarg>
+#include <cstddef>
+#include <string>
+
+/*
+ * Format strings are checked against their arguments at compile time: by GCC and Clang
+ * through the `format` attribute (reported by -Wformat, part of -Wall), and by MSVC
+ * through the SAL annotation when building with /analyze. Arguments are passed through
+ * C varargs, so a std::string passed where "%s" expects a `const char *` is caught too.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+	#define FORMAT_STRING
+	#define FORMAT_CHECK(fmt, first) __attribute__((format(printf, fmt, first)))
+#elif defined(_MSC_VER)
+	#include <sal.h>
+	#define FORMAT_STRING _Printf_format_string_
+	#define FORMAT_CHECK(fmt, first)
+#else
+	#define FORMAT_STRING
+	#define FORMAT_CHECK(fmt, first)
+#endif
+
+/** Size of the buffer a single diagnostic or trace line is formatted into */
+#define FORMAT_BUFFER_SIZE 1024
+
+/**
+ * Formats into a fixed buffer, cutting the text short if it does not fit.
+ * @param buffer Buffer to write to.
+ * @param size Size of the buffer, including room for the final '\0'.
+ * @param fmt Format to apply.
+ * @param args Arguments of the format.
+ * @returns Number of characters written, not counting the final '\0'.
+ */
+size_t formatToV(char *buffer, size_t size, const char *fmt, va_list args);
+
+/**
+ * Formats into a fixed buffer, cutting the text short if it does not fit.
+ * @param buffer Buffer to write to.
+ * @param size Size of the buffer, including room for the final '\0'.
+ * @param fmt Format to apply.
+ * @param ... Arguments of the format.
+ * @returns Number of characters written, not counting the final '\0'.
+ */
+size_t formatTo(char *buffer, size_t size, FORMAT_STRING const char *fmt, ...) FORMAT_CHECK(3, 4);
+
+/**
+ * Formats onto the end of a string. The text is formatted once into a buffer on the
+ * stack and copied in, so a string with enough capacity is never reallocated.
+ * @param out String to append to.
+ * @param fmt Format to apply.
+ * @param ... Arguments of the format.
+ */
+void appendFormat(std::string *out, FORMAT_STRING const char *fmt, ...) FORMAT_CHECK(2, 3);
+
+/**
+ * Formats a string.
+ * @param fmt Format to apply.
+ * @param ... Arguments of the format.
+ * @returns Formatted string.
+ */
+std::string customFormat(FORMAT_STRING const char *fmt, ...) FORMAT_CHECK(1, 2);
+
+#endif // FORMAT_HPP
@@ -0,0 +1,567 @@
+/**
+ * @file       image.cpp
+ * @brief      Implementation for binary images of the tokens and syntax tree of a source file
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <vector>
+#include "cache.hpp"
+#include "image.hpp"
+
+/* Offset standing for no target */
+#define IMAGE_NONE SIZE_MAX
+
+/* Builds an image in a growing buffer, where structures are placed by offset */
+struct ImageWriter {
+	/** Bytes of the image so far */
+	std::string out;
+
+	/** Offset of the text of each symbol */
+	std::vector<size_t> symbolText;
+
+	/**
+	 * Places a structure at the end of the image.
+	 * @tparam T Type of the structure.
+	 * @param count Number of structures to place one after the other.
+	 * @returns Offset of the first structure.
+	 */
+	template <typename T>
+	size_t place(size_t count = 1) {
+		size_t offset = (out.size() + alignof(T) - 1) / alignof(T) * alignof(T);
+		out.resize(offset + sizeof(T) * count, '\0');
+		for (size_t idx = 0; idx < count; idx++) {
+			new (&out[offset + sizeof(T) * idx]) T();
+		}
+		return offset;
+	}
+
+	/**
+	 * Returns a structure placed in the image, which stays valid until the next placement.
+	 * @tparam T Type of the structure.
+	 * @param offset Offset of the structure.
+	 * @returns Structure at the offset.
+	 */
+	template <typename T>
+	T *at(size_t offset) {
+		return reinterpret_cast<T *>(&out[offset]);
+	}
+
+	/**
+	 * Points a reference in the image at an offset.
+	 * @tparam T Type of the target.
+	 * @param ref Reference, in the image.
+	 * @param target Offset of the target, or `IMAGE_NONE`.
+	 */
+	template <typename T>
+	void link(RelPtr<T> *ref, size_t target) {
+		if (target != IMAGE_NONE) {
+			auto from = static_cast<size_t>(reinterpret_cast<char *>(ref) - &out[0]);
+			ref->offset = static_cast<int32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(from));
+		}
+	}
+
+	/**
+	 * Copies bytes to the end of the image.
+	 * @param data First byte.
+	 * @param size Number of bytes.
+	 * @param align Alignment of the copy.
+	 * @returns Offset of the copy.
+	 */
+	size_t copy(const void *data, size_t size, size_t align) {
+		size_t offset = (out.size() + align - 1) / align * align;
+		out.resize(offset);
+		if (size > 0) {
+			out.append(static_cast<const char *>(data), size);
+		}
+		return offset;
+	}
+};
+
+// --------------- function prototypes -------------------------
+
+static uint64_t getLayout();
+template <typename T> static void copyArray(ImageWriter *writer, size_t arrayOffset, const std::vector<T> &items);
+static void setName(ImageWriter *writer, ImageName *name, const Name &source);
+static size_t writeFunc(ImageWriter *writer, const FuncDecl *func);
+static size_t writeStmt(ImageWriter *writer, const Stmt *stmt);
+static size_t writeBlock(ImageWriter *writer, const BlockStmt *block);
+static size_t writeExpr(ImageWriter *writer, const Expr *expr);
+static size_t writeExprs(ImageWriter *writer, Expr *const *exprs, uint32_t count);
+template <typename T> static size_t writeNode(ImageWriter *writer, const Expr *expr);
+
+
+std::string writeImage(const char *source, size_t size, const TokenStream &tokens, const Interner &symbols, const Program *program) {
+	ImageWriter writer;
+	writer.out.reserve(sizeof(ImageHeader) + size * 4 + tokens.size() * 24);
+	writer.place<ImageHeader>();
+
+	// Source, with a zero byte after it
+	size_t text = writer.copy(source, size, 1);
+	writer.out += '\0';
+	writer.link(&writer.at<ImageHeader>(0)->source.items, text);
+	writer.at<ImageHeader>(0)->source.count = static_cast<uint32_t>(size);
+
+	// Text of every symbol, then the table of symbols pointing into it
+	for (Symbol symbol = 0; symbol < symbols.size(); symbol++) {
+		std::string_view name = symbols.getText(symbol);
+		writer.symbolText.push_back(writer.copy(name.data(), name.size(), 1));
+	}
+	size_t table = writer.place<ImageString>(symbols.size());
+	for (Symbol symbol = 0; symbol < symbols.size(); symbol++) {
+		auto *entry = writer.at<ImageString>(table + sizeof(ImageString) * symbol);
+		writer.link(&entry->text, writer.symbolText[symbol]);
+		entry->length = static_cast<uint32_t>(symbols.getText(symbol).size());
+	}
+	writer.link(&writer.at<ImageHeader>(0)->symbols.items, table);
+	writer.at<ImageHeader>(0)->symbols.count = static_cast<uint32_t>(symbols.size());
+
+	// Tokens, one array at a time
+	std::vector<uint8_t> types(tokens.types.begin(), tokens.types.end());
+	const size_t start = offsetof(ImageHeader, tokens);
+	copyArray(&writer, start + offsetof(ImageTokens, types), types);
+	copyArray(&writer, start + offsetof(ImageTokens, flags), tokens.flags);
+	copyArray(&writer, start + offsetof(ImageTokens, offsets), tokens.offsets);
+	copyArray(&writer, start + offsetof(ImageTokens, lengths), tokens.lengths);
+	copyArray(&writer, start + offsetof(ImageTokens, positions), tokens.positions);
+	copyArray(&writer, start + offsetof(ImageTokens, values), tokens.values);
+
+	if (program != nullptr) {
+		std::vector<size_t> funcs;
+		for (uint32_t idx = 0; idx < program->count; idx++) {
+			funcs.push_back(writeFunc(&writer, program->funcs[idx]));
+		}
+
+		size_t node = writer.place<ImageProgram>();
+		size_t items = writer.place<RelPtr<ImageFuncDecl>>(funcs.size());
+		for (size_t idx = 0; idx < funcs.size(); idx++) {
+			writer.link(writer.at<RelPtr<ImageFuncDecl>>(items + sizeof(RelPtr<ImageFuncDecl>) * idx), funcs[idx]);
+		}
+		writer.link(&writer.at<ImageProgram>(node)->funcs.items, funcs.empty() ? IMAGE_NONE : items);
+		writer.at<ImageProgram>(node)->funcs.count = static_cast<uint32_t>(funcs.size());
+		writer.link(&writer.at<ImageHeader>(0)->program, node);
+	}
+
+	// Round up so that the size is a multiple of the alignment of every structure
+	writer.out.resize((writer.out.size() + 7) / 8 * 8, '\0');
+
+	auto *header = writer.at<ImageHeader>(0);
+	memcpy(header->magic, IMAGE_MAGIC, sizeof(header->magic));
+	header->version = IMAGE_VERSION;
+	header->byteOrder = IMAGE_BYTE_ORDER;
+	header->size = writer.out.size();
+	header->layout = getLayout();
+	return std::move(writer.out);
+}
+
+SyntaxImage::~SyntaxImage() {
+	close();
+}
+
+bool SyntaxImage::open(const char *path) {
+	close();
+	if (!openSource(&buffer, path)) {
+		return false;
+	}
+
+	// Everything past the header is trusted, as it would be in memory
+	auto *start = reinterpret_cast<const ImageHeader *>(buffer.data);
+	if (buffer.size < sizeof(ImageHeader) || memcmp(start->magic, IMAGE_MAGIC, sizeof(start->magic)) != 0 || start->version != IMAGE_VERSION
+		|| start->byteOrder != IMAGE_BYTE_ORDER || start->layout != getLayout() || start->size != buffer.size) {
+		close();
+		return false;
+	}
+
+	header = start;
+	return true;
+}
+
+void SyntaxImage::close() {
+	if (buffer.data != nullptr) {
+		closeSource(&buffer);
+	}
+	header = nullptr;
+}
+
+void SyntaxImage::getToken(size_t idx, Token *token) const {
+	const ImageTokens &tokens = header->tokens;
+	token->type = static_cast<TokenType>(tokens.types[idx]);
+	token->flags = tokens.flags[idx];
+	token->offset = tokens.offsets[idx];
+	token->length = tokens.lengths[idx];
+	token->position = tokens.positions[idx];
+	memcpy(&token->dvalue, &tokens.values[idx], sizeof(tokens.values[idx]));
+}
+
+/**
+ * Combines the sizes of the structures of an image, which change with their layout.
+ * @returns Fingerprint of the layout.
+ */
+static uint64_t getLayout() {
+	static const size_t sizes[] = { sizeof(ImageHeader), sizeof(ImageTokens), sizeof(ImageString), sizeof(ImageName), sizeof(ImageExpr),
+		sizeof(ImageNumExpr), sizeof(ImageDecExpr), sizeof(ImageBoolExpr), sizeof(ImageCharExpr), sizeof(ImageStrExpr),
+		sizeof(ImageNameExpr), sizeof(ImageArrayExpr), sizeof(ImageUnaryExpr), sizeof(ImageBinaryExpr), sizeof(ImageIndexExpr),
+		sizeof(ImageCallExpr), sizeof(ImageCastExpr), sizeof(ImageStmt), sizeof(ImageBlockStmt), sizeof(ImageVarStmt),
+		sizeof(ImageAssignStmt), sizeof(ImageExprStmt), sizeof(ImageIfStmt), sizeof(ImageWhileStmt), sizeof(ImageForStmt),
+		sizeof(ImageReturnStmt), sizeof(ImagePrintStmt), sizeof(ImageExitStmt), sizeof(ImageParam), sizeof(ImageFuncDecl),
+		sizeof(ImageProgram), sizeof(SourcePosition), sizeof(Type) };
+
+	return hashBytes(sizes, sizeof(sizes));
+}
+
+/**
+ * Copies the items of a vector into an array of the image.
+ * @tparam T Type of the items.
+ * @param writer Image being written.
+ * @param arrayOffset Offset of the array to fill, in the image.
+ * @param items Items to copy.
+ */
+template <typename T>
+static void copyArray(ImageWriter *writer, size_t arrayOffset, const std::vector<T> &items) {
+	size_t offset = writer->copy(items.data(), items.size() * sizeof(T), alignof(T));
+	auto *array = writer->at<RelArray<T>>(arrayOffset);
+	writer->link(&array->items, items.empty() ? IMAGE_NONE : offset);
+	array->count = static_cast<uint32_t>(items.size());
+}
+
+/**
+ * Fills in a name of the image.
+ * @param writer Image being written.
+ * @param name Name to fill, in the image.
+ * @param source Name in the syntax tree.
+ */
+static void setName(ImageWriter *writer, ImageName *name, const Name &source) {
+	writer->link(&name->text, writer->symbolText[source.symbol]);
+	name->length = source.length;
+	name->symbol = source.symbol;
+}
+
+/**
+ * Writes a function declaration.
+ * @param writer Image being written.
+ * @param func Function in the syntax tree.
+ * @returns Offset of the function in the image.
+ */
+static size_t writeFunc(ImageWriter *writer, const FuncDecl *func) {
+	size_t body = writeBlock(writer, func->body);
+
+	size_t params = writer->place<ImageParam>(func->paramCount);
+	for (uint32_t idx = 0; idx < func->paramCount; idx++) {
+		size_t offset = params + sizeof(ImageParam) * idx;
+		auto *param = writer->at<ImageParam>(offset);
+		param->type = func->params[idx].type;
+		param->position = func->params[idx].position;
+		setName(writer, &param->name, func->params[idx].name);
+	}
+
+	size_t offset = writer->place<ImageFuncDecl>();
+	auto *node = writer->at<ImageFuncDecl>(offset);
+	setName(writer, &node->name, func->name);
+	node->position = func->position;
+	writer->link(&node->params.items, (func->paramCount > 0) ? params : IMAGE_NONE);
+	node->params.count = func->paramCount;
+	node->returnType = func->returnType;
+	writer->link(&node->body, body);
+	return offset;
+}
+
+/**
+ * Writes a block and the statements in it.
+ * @param writer Image being written.
+ * @param block Block in the syntax tree.
+ * @returns Offset of the block in the image.
+ */
+static size_t writeBlock(ImageWriter *writer, const BlockStmt *block) {
+	std::vector<size_t> stmts;
+	for (uint32_t idx = 0; idx < block->count; idx++) {
+		stmts.push_back(writeStmt(writer, block->stmts[idx]));
+	}
+
+	size_t items = writer->place<RelPtr<ImageStmt>>(stmts.size());
+	for (size_t idx = 0; idx < stmts.size(); idx++) {
+		writer->link(writer->at<RelPtr<ImageStmt>>(items + sizeof(RelPtr<ImageStmt>) * idx), stmts[idx]);
+	}
+
+	size_t offset = writer->place<ImageBlockStmt>();
+	auto *node = writer->at<ImageBlockStmt>(offset);
+	node->kind = STMT_BLOCK;
+	node->position = block->position;
+	writer->link(&node->stmts.items, stmts.empty() ? IMAGE_NONE : items);
+	node->stmts.count = static_cast<uint32_t>(stmts.size());
+	return offset;
+}
+
+/**
+ * Writes a statement and everything in it. Children are written before their parent,
+ * so that the parent can refer to them as soon as it is placed.
+ * @param writer Image being written.
+ * @param stmt Statement in the syntax tree, or `nullptr`.
+ * @returns Offset of the statement in the image, or `IMAGE_NONE`.
+ */
+static size_t writeStmt(ImageWriter *writer, const Stmt *stmt) {
+	if (stmt == nullptr) {
+		return IMAGE_NONE;
+	}
+
+	size_t offset;
+	switch (stmt->kind) {
+	case STMT_BLOCK:
+		return writeBlock(writer, static_cast<const BlockStmt *>(stmt));
+	case STMT_VAR: {
+		const auto *var = static_cast<const VarStmt *>(stmt);
+		size_t value = writeExpr(writer, var->value);
+		offset = writer->place<ImageVarStmt>();
+		auto *node = writer->at<ImageVarStmt>(offset);
+		node->type = var->type;
+		setName(writer, &node->name, var->name);
+		writer->link(&node->value, value);
+		break;
+	}
+	case STMT_ASSIGN: {
+		const auto *assign = static_cast<const AssignStmt *>(stmt);
+		size_t target = writeExpr(writer, assign->target);
+		size_t value = writeExpr(writer, assign->value);
+		offset = writer->place<ImageAssignStmt>();
+		auto *node = writer->at<ImageAssignStmt>(offset);
+		writer->link(&node->target, target);
+		writer->link(&node->value, value);
+		break;
+	}
+	case STMT_EXPR: {
+		size_t expr = writeExpr(writer, static_cast<const ExprStmt *>(stmt)->expr);
+		offset = writer->place<ImageExprStmt>();
+		writer->link(&writer->at<ImageExprStmt>(offset)->expr, expr);
+		break;
+	}
+	case STMT_IF: {
+		const auto *branch = static_cast<const IfStmt *>(stmt);
+		size_t cond = writeExpr(writer, branch->cond);
+		size_t then = writeBlock(writer, branch->then);
+		size_t otherwise = writeStmt(writer, branch->otherwise);
+		offset = writer->place<ImageIfStmt>();
+		auto *node = writer->at<ImageIfStmt>(offset);
+		writer->link(&node->cond, cond);
+		writer->link(&node->then, then);
+		writer->link(&node->otherwise, otherwise);
+		break;
+	}
+	case STMT_WHILE: {
+		const auto *loop = static_cast<const WhileStmt *>(stmt);
+		size_t cond = writeExpr(writer, loop->cond);
+		size_t body = writeBlock(writer, loop->body);
+		offset = writer->place<ImageWhileStmt>();
+		auto *node = writer->at<ImageWhileStmt>(offset);
+		writer->link(&node->cond, cond);
+		writer->link(&node->body, body);
+		break;
+	}
+	case STMT_FOR: {
+		const auto *loop = static_cast<const ForStmt *>(stmt);
+		size_t start = writeExpr(writer, loop->start);
+		size_t stop = writeExpr(writer, loop->stop);
+		size_t step = writeExpr(writer, loop->step);
+		size_t body = writeBlock(writer, loop->body);
+		offset = writer->place<ImageForStmt>();
+		auto *node = writer->at<ImageForStmt>(offset);
+		node->type = loop->type;
+		setName(writer, &node->name, loop->name);
+		writer->link(&node->start, start);
+		writer->link(&node->stop, stop);
+		writer->link(&node->step, step);
+		writer->link(&node->body, body);
+		break;
+	}
+	case STMT_RETURN: {
+		size_t value = writeExpr(writer, static_cast<const ReturnStmt *>(stmt)->value);
+		offset = writer->place<ImageReturnStmt>();
+		writer->link(&writer->at<ImageReturnStmt>(offset)->value, value);
+		break;
+	}
+	case STMT_PRINT: {
+		const auto *print = static_cast<const PrintStmt *>(stmt);
+		size_t value = writeExpr(writer, print->value);
+		offset = writer->place<ImagePrintStmt>();
+		auto *node = writer->at<ImagePrintStmt>(offset);
+		node->newline = print->newline;
+		writer->link(&node->value, value);
+		break;
+	}
+	case STMT_EXIT: {
+		size_t code = writeExpr(writer, static_cast<const ExitStmt *>(stmt)->code);
+		offset = writer->place<ImageExitStmt>();
+		writer->link(&writer->at<ImageExitStmt>(offset)->code, code);
+		break;
+	}
+	default:
+		// `break` and `continue` have nothing but the shared fields
+		offset = writer->place<ImageStmt>();
+		break;
+	}
+
+	auto *node = writer->at<ImageStmt>(offset);
+	node->kind = stmt->kind;
+	node->position = stmt->position;
+	return offset;
+}
+
+/**
+ * Writes an expression and everything in it.
+ * @param writer Image being written.
+ * @param expr Expression in the syntax tree, or `nullptr`.
+ * @returns Offset of the expression in the image, or `IMAGE_NONE`.
+ */
+static size_t writeExpr(ImageWriter *writer, const Expr *expr) {
+	if (expr == nullptr) {
+		return IMAGE_NONE;
+	}
+
+	size_t offset;
+	switch (expr->kind) {
+	case EXPR_NUM:
+		offset = writeNode<ImageNumExpr>(writer, expr);
+		writer->at<ImageNumExpr>(offset)->value = static_cast<const NumExpr *>(expr)->value;
+		break;
+	case EXPR_DEC:
+		offset = writeNode<ImageDecExpr>(writer, expr);
+		writer->at<ImageDecExpr>(offset)->value = static_cast<const DecExpr *>(expr)->value;
+		break;
+	case EXPR_BOOL:
+		offset = writeNode<ImageBoolExpr>(writer, expr);
+		writer->at<ImageBoolExpr>(offset)->value = static_cast<const BoolExpr *>(expr)->value;
+		break;
+	case EXPR_CHAR:
+		offset = writeNode<ImageCharExpr>(writer, expr);
+		writer->at<ImageCharExpr>(offset)->value = static_cast<const CharExpr *>(expr)->value;
+		break;
+	case EXPR_STR: {
+		const auto *str = static_cast<const StrExpr *>(expr);
+		size_t text = writer->copy(str->text, str->length, 1);
+		offset = writeNode<ImageStrExpr>(writer, expr);
+		auto *node = writer->at<ImageStrExpr>(offset);
+		writer->link(&node->text.text, text);
+		node->text.length = str->length;
+		node->escaped = str->escaped;
+		break;
+	}
+	case EXPR_NAME:
+		offset = writeNode<ImageNameExpr>(writer, expr);
+		setName(writer, &writer->at<ImageNameExpr>(offset)->name, static_cast<const NameExpr *>(expr)->name);
+		break;
+	case EXPR_ARRAY: {
+		const auto *array = static_cast<const ArrayExpr *>(expr);
+		size_t items = writeExprs(writer, array->items, array->count);
+		offset = writeNode<ImageArrayExpr>(writer, expr);
+		auto *node = writer->at<ImageArrayExpr>(offset);
+		writer->link(&node->items.items, items);
+		node->items.count = array->count;
+		break;
+	}
+	case EXPR_UNARY: {
+		const auto *unary = static_cast<const UnaryExpr *>(expr);
+		size_t operand = writeExpr(writer, unary->operand);
+		offset = writeNode<ImageUnaryExpr>(writer, expr);
+		auto *node = writer->at<ImageUnaryExpr>(offset);
+		node->op = unary->op;
+		writer->link(&node->operand, operand);
+		break;
+	}
+	case EXPR_BINARY: {
+		// Chains such as long sums nest through their left operands, which are written in a loop
+		std::vector<const BinaryExpr *> chain{ static_cast<const BinaryExpr *>(expr) };
+		while (chain.back()->lhs->kind == EXPR_BINARY) {
+			chain.push_back(static_cast<const BinaryExpr *>(chain.back()->lhs));
+		}
+
+		offset = writeExpr(writer, chain.back()->lhs);
+		for (size_t idx = chain.size(); idx-- > 0;) {
+			size_t lhs = offset;
+			size_t rhs = writeExpr(writer, chain[idx]->rhs);
+			offset = writeNode<ImageBinaryExpr>(writer, chain[idx]);
+			auto *node = writer->at<ImageBinaryExpr>(offset);
+			node->op = chain[idx]->op;
+			writer->link(&node->lhs, lhs);
+			writer->link(&node->rhs, rhs);
+		}
+		break;
+	}
+	case EXPR_INDEX: {
+		const auto *index = static_cast<const IndexExpr *>(expr);
+		size_t array = writeExpr(writer, index->array);
+		size_t idx = writeExpr(writer, index->index);
+		offset = writeNode<ImageIndexExpr>(writer, expr);
+		auto *node = writer->at<ImageIndexExpr>(offset);
+		writer->link(&node->array, array);
+		writer->link(&node->index, idx);
+		break;
+	}
+	case EXPR_CALL: {
+		const auto *call = static_cast<const CallExpr *>(expr);
+		size_t args = writeExprs(writer, call->args, call->count);
+		offset = writeNode<ImageCallExpr>(writer, expr);
+		auto *node = writer->at<ImageCallExpr>(offset);
+		setName(writer, &node->name, call->name);
+		writer->link(&node->args.items, args);
+		node->args.count = call->count;
+		break;
+	}
+	case EXPR_CAST: {
+		const auto *cast = static_cast<const CastExpr *>(expr);
+		size_t operand = writeExpr(writer, cast->operand);
+		offset = writeNode<ImageCastExpr>(writer, expr);
+		auto *node = writer->at<ImageCastExpr>(offset);
+		node->target = cast->target;
+		node->implicit = cast->implicit;
+		writer->link(&node->operand, operand);
+		break;
+	}
+	default:
+		offset = writeNode<ImageExpr>(writer, expr);
+		break;
+	}
+	return offset;
+}
+
+/**
+ * Writes a list of expressions, followed by the array referring to them.
+ * @param writer Image being written.
+ * @param exprs Expressions in the syntax tree.
+ * @param count Number of expressions.
+ * @returns Offset of the array in the image, or `IMAGE_NONE` if it is empty.
+ */
+static size_t writeExprs(ImageWriter *writer, Expr *const *exprs, uint32_t count) {
+	if (count == 0) {
+		return IMAGE_NONE;
+	}
+
+	std::vector<size_t> offsets;
+	for (uint32_t idx = 0; idx < count; idx++) {
+		offsets.push_back(writeExpr(writer, exprs[idx]));
+	}
+
+	size_t items = writer->place<RelPtr<ImageExpr>>(count);
+	for (uint32_t idx = 0; idx < count; idx++) {
+		writer->link(writer->at<RelPtr<ImageExpr>>(items + sizeof(RelPtr<ImageExpr>) * idx), offsets[idx]);
+	}
+	return items;
+}
+
+/**
+ * Places an expression node and fills in the fields shared by all expressions.
+ * @tparam T Type of the node.
+ * @param writer Image being written.
+ * @param expr Expression in the syntax tree.
+ * @returns Offset of the node.
+ */
+template <typename T>
+static size_t writeNode(ImageWriter *writer, const Expr *expr) {
+	size_t offset = writer->place<T>();
+	auto *node = writer->at<T>(offset);
+	node->kind = expr->kind;
+	node->type = expr->type;
+	node->position = expr->position;
+	return offset;
+}
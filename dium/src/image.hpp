@@ -0,0 +1,411 @@
+/**
+ * @file       image.hpp
+ * @brief      Definitions for binary images of the tokens and syntax tree of a source file
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef IMAGE_HPP
+#define IMAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "ast.hpp"
+#include "interner.hpp"
+#include "source.hpp"
+#include "token.hpp"
+
+/** First bytes of every image file */
+#define IMAGE_MAGIC "DIUMIMG"
+
+/** Version of the layout of image files, bumped whenever it changes */
+#define IMAGE_VERSION 1
+
+/** Written as a number so that files from machines of the other byte order are rejected */
+#define IMAGE_BYTE_ORDER 0x01020304u
+
+/*
+ * An image holds everything needed to work on a source file without lexing or parsing
+ * it again: the source itself, its interned identifiers, its tokens (as the same struct
+ * of arrays as `TokenStream`) and its syntax tree. Nothing in it is a pointer; every
+ * reference is an offset from the reference itself, so an image is used exactly where
+ * it was mapped, and tools walk the `Image...` structures below the same way as the
+ * syntax tree in ast.hpp. References are not checked when an image is opened, so
+ * images are meant to be written by `writeImage()` and read by the same build.
+ */
+
+/**
+ * Reference to something elsewhere in the same image, as an offset from the reference
+ * itself. References cannot be copied, since a copy would point somewhere else.
+ * @tparam T Type of the target.
+ */
+template <typename T>
+struct RelPtr {
+	/** Offset of the target from this reference, 0 for none */
+	int32_t offset = 0;
+
+	RelPtr() = default;
+	RelPtr(const RelPtr &) = delete;
+	RelPtr &operator=(const RelPtr &) = delete;
+
+	/**
+	 * Returns the target.
+	 * @returns Target, or `nullptr` for none.
+	 */
+	const T *get() const {
+		return (offset == 0) ? nullptr : reinterpret_cast<const T *>(reinterpret_cast<const char *>(this) + offset);
+	}
+
+	const T *operator->() const {
+		return get();
+	}
+
+	explicit operator bool() const {
+		return offset != 0;
+	}
+};
+
+/**
+ * Array elsewhere in the same image.
+ * @tparam T Type of the items.
+ */
+template <typename T>
+struct RelArray {
+	/** First item */
+	RelPtr<T> items;
+
+	/** Number of items */
+	uint32_t count = 0;
+
+	const T &operator[](size_t idx) const {
+		return items.get()[idx];
+	}
+
+	size_t size() const {
+		return count;
+	}
+
+	const T *begin() const {
+		return items.get();
+	}
+
+	const T *end() const {
+		return items.get() + count;
+	}
+};
+
+/** Characters elsewhere in the same image */
+struct ImageString {
+	RelPtr<char> text;
+	uint32_t length;
+
+	std::string_view view() const {
+		return std::string_view(text.get(), length);
+	}
+};
+
+/** Identifier, pointing into the image's copy of the interned text */
+struct ImageName {
+	RelPtr<char> text;
+	uint32_t length;
+
+	/** Index of the identifier in the image's symbols */
+	Symbol symbol;
+
+	std::string_view view() const {
+		return std::string_view(text.get(), length);
+	}
+};
+
+// --------------- expressions ---------------------------------
+
+/** Fields shared by all expressions, as in `Expr` */
+struct ImageExpr {
+	ExprKind kind;
+	Type type;
+	SourcePosition position;
+};
+
+struct ImageNumExpr : ImageExpr {
+	int64_t value;
+};
+
+struct ImageDecExpr : ImageExpr {
+	double value;
+};
+
+struct ImageBoolExpr : ImageExpr {
+	bool value;
+};
+
+struct ImageCharExpr : ImageExpr {
+	char value;
+};
+
+struct ImageStrExpr : ImageExpr {
+	/** Characters between the quotes, with escape codes as written */
+	ImageString text;
+	bool escaped;
+};
+
+struct ImageNameExpr : ImageExpr {
+	ImageName name;
+};
+
+struct ImageArrayExpr : ImageExpr {
+	RelArray<RelPtr<ImageExpr>> items;
+};
+
+struct ImageUnaryExpr : ImageExpr {
+	TokenType op;
+	RelPtr<ImageExpr> operand;
+};
+
+struct ImageBinaryExpr : ImageExpr {
+	TokenType op;
+	RelPtr<ImageExpr> lhs;
+	RelPtr<ImageExpr> rhs;
+};
+
+struct ImageIndexExpr : ImageExpr {
+	RelPtr<ImageExpr> array;
+	RelPtr<ImageExpr> index;
+};
+
+struct ImageCallExpr : ImageExpr {
+	ImageName name;
+	RelArray<RelPtr<ImageExpr>> args;
+};
+
+struct ImageCastExpr : ImageExpr {
+	Type target;
+	bool implicit;
+	RelPtr<ImageExpr> operand;
+};
+
+// --------------- statements ----------------------------------
+
+/** Fields shared by all statements, as in `Stmt` */
+struct ImageStmt {
+	StmtKind kind;
+	SourcePosition position;
+};
+
+struct ImageBlockStmt : ImageStmt {
+	RelArray<RelPtr<ImageStmt>> stmts;
+};
+
+struct ImageVarStmt : ImageStmt {
+	Type type;
+	ImageName name;
+	RelPtr<ImageExpr> value;
+};
+
+struct ImageAssignStmt : ImageStmt {
+	RelPtr<ImageExpr> target;
+	RelPtr<ImageExpr> value;
+};
+
+struct ImageExprStmt : ImageStmt {
+	RelPtr<ImageExpr> expr;
+};
+
+struct ImageIfStmt : ImageStmt {
+	RelPtr<ImageExpr> cond;
+	RelPtr<ImageBlockStmt> then;
+	RelPtr<ImageStmt> otherwise;
+};
+
+struct ImageWhileStmt : ImageStmt {
+	RelPtr<ImageExpr> cond;
+	RelPtr<ImageBlockStmt> body;
+};
+
+struct ImageForStmt : ImageStmt {
+	Type type;
+	ImageName name;
+	RelPtr<ImageExpr> start;
+	RelPtr<ImageExpr> stop;
+	RelPtr<ImageExpr> step;
+	RelPtr<ImageBlockStmt> body;
+};
+
+struct ImageReturnStmt : ImageStmt {
+	RelPtr<ImageExpr> value;
+};
+
+struct ImagePrintStmt : ImageStmt {
+	bool newline;
+	RelPtr<ImageExpr> value;
+};
+
+struct ImageExitStmt : ImageStmt {
+	RelPtr<ImageExpr> code;
+};
+
+// --------------- declarations --------------------------------
+
+struct ImageParam {
+	Type type;
+	ImageName name;
+	SourcePosition position;
+};
+
+struct ImageFuncDecl {
+	ImageName name;
+	SourcePosition position;
+	RelArray<ImageParam> params;
+	Type returnType;
+	RelPtr<ImageBlockStmt> body;
+};
+
+struct ImageProgram {
+	RelArray<RelPtr<ImageFuncDecl>> funcs;
+};
+
+// --------------- file ----------------------------------------
+
+/** Tokens of the source file, as in `TokenStream` */
+struct ImageTokens {
+	/** Type of each token, as a byte */
+	RelArray<uint8_t> types;
+	RelArray<uint8_t> flags;
+	RelArray<uint32_t> offsets;
+	RelArray<uint32_t> lengths;
+	RelArray<SourcePosition> positions;
+
+	/** Raw bits of each value, where identifiers hold their index in the image's symbols */
+	RelArray<uint64_t> values;
+};
+
+/** Start of an image file (".dmi") */
+struct ImageHeader {
+	/** `IMAGE_MAGIC`, zero-terminated */
+	char magic[8];
+
+	/** `IMAGE_VERSION` */
+	uint32_t version;
+
+	/** `IMAGE_BYTE_ORDER` */
+	uint32_t byteOrder;
+
+	/** Size of the whole image */
+	uint64_t size;
+
+	/** Sizes of the structures above, so that a build that lays them out differently rejects the image */
+	uint64_t layout;
+
+	/** Text of the source file, followed by a zero byte that is not counted */
+	RelArray<char> source;
+
+	/** Text of each interned identifier, by symbol */
+	RelArray<ImageString> symbols;
+
+	ImageTokens tokens;
+
+	/** Syntax tree, or none if the file was not parsed */
+	RelPtr<ImageProgram> program;
+};
+
+static_assert(TOK_NONE <= UINT8_MAX, "Token types must fit in a byte");
+
+/**
+ * Writes an image of a source file.
+ * @param source Text of the source file.
+ * @param size Number of characters in the source file.
+ * @param tokens Tokens of the source file.
+ * @param symbols Table the identifiers of the tokens and the syntax tree were interned in.
+ * @param program Syntax tree of the source file, or `nullptr`.
+ * @returns Bytes of the image.
+ */
+std::string writeImage(const char *source, size_t size, const TokenStream &tokens, const Interner &symbols, const Program *program);
+
+/**
+ * Image file mapped into memory, read in place.
+ */
+class SyntaxImage {
+public:
+	SyntaxImage() = default;
+	SyntaxImage(const SyntaxImage &) = delete;
+	SyntaxImage &operator=(const SyntaxImage &) = delete;
+
+	/**
+	 * Unmaps the image.
+	 */
+	~SyntaxImage();
+
+	/**
+	 * Maps an image file, checking its header.
+	 * @param path Path to the image file.
+	 * @returns `true` if the file is an image of this version and layout, `false` otherwise.
+	 */
+	bool open(const char *path);
+
+	/**
+	 * Unmaps the image, after which nothing taken from it may be used.
+	 */
+	void close();
+
+	/**
+	 * Returns the start of the image, from which everything in it is reached.
+	 * @returns Header of the image.
+	 */
+	const ImageHeader &getHeader() const {
+		return *header;
+	}
+
+	/**
+	 * Returns the text of the source file.
+	 * @returns Characters of the source file.
+	 */
+	std::string_view getSource() const {
+		return std::string_view(header->source.begin(), header->source.size());
+	}
+
+	/**
+	 * Returns the number of tokens.
+	 * @returns Number of tokens, including the final `TOK_EOF`.
+	 */
+	size_t getTokenCount() const {
+		return header->tokens.types.size();
+	}
+
+	/**
+	 * Gathers a single token, as `TokenStream::get()` does. Identifiers hold their
+	 * index in the image's symbols (see `getSymbolText()`).
+	 * @param idx Index of the token.
+	 * @param[out] token Token to fill.
+	 */
+	void getToken(size_t idx, Token *token) const;
+
+	/**
+	 * Returns the text of an identifier.
+	 * @param symbol Index of the identifier in the image's symbols.
+	 * @returns Characters of the identifier.
+	 */
+	std::string_view getSymbolText(Symbol symbol) const {
+		return header->symbols[symbol].view();
+	}
+
+	/**
+	 * Returns the syntax tree.
+	 * @returns Root of the syntax tree, or `nullptr` if the file was not parsed.
+	 */
+	const ImageProgram *getProgram() const {
+		return header->program.get();
+	}
+
+private:
+	/** Mapped file */
+	SourceBuffer buffer;
+
+	/** Start of the mapped file */
+	const ImageHeader *header = nullptr;
+};
+
+#endif // IMAGE_HPP
@@ -0,0 +1,173 @@
+/**
+ * @file       index.cpp
+ * @brief      Implementation of indexing the declarations of a range of tokens
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <algorithm>
+#include "index.hpp"
+
+// --------------- function prototypes -------------------------
+
+static bool isTypeKeyword(const TokenStream &tokens, size_t token);
+
+
+void TokenIndex::build(const TokenStream &tokens, size_t first, size_t last) {
+	decls.clear();
+	scopes.clear();
+
+	std::vector<uint32_t> open;
+	auto end = static_cast<uint32_t>(last - first);
+
+	// Declarations between `func` or `for` and the next '{' wait for the scope it opens
+	bool header = false;
+	DeclKind headerKind = DECL_VAR;
+	size_t pending = 0;
+
+	for (size_t idx = first; idx < last; idx++) {
+		auto rel = static_cast<uint32_t>(idx - first);
+
+		switch (tokens.types[idx]) {
+		case TOK_FUNC:
+			// Functions are never nested, so close whatever the last one left open
+			while (!open.empty()) {
+				scopes[open.back()].close = rel;
+				open.pop_back();
+			}
+
+			header = true;
+			headerKind = DECL_PARAM;
+			pending = decls.size();
+			break;
+		case TOK_FOR:
+			header = true;
+			headerKind = DECL_VAR;
+			pending = decls.size();
+			break;
+		case TOK_LCURL: {
+			auto scope = static_cast<uint32_t>(scopes.size());
+			scopes.push_back(Scope{ rel, end, open.empty() ? NO_SCOPE : open.back() });
+			open.push_back(scope);
+
+			if (header) {
+				for (size_t decl = pending; decl < decls.size(); decl++) {
+					if (decls[decl].kind != DECL_FUNC) {
+						decls[decl].scope = scope;
+					}
+				}
+				header = false;
+			}
+			break;
+		}
+		case TOK_RCURL:
+			if (!open.empty()) {
+				scopes[open.back()].close = rel;
+				open.pop_back();
+			}
+			break;
+		case TOK_ID: {
+			if (idx > first && tokens.types[idx - 1] == TOK_FUNC) {
+				decls.push_back(Declaration{ tokens.getSymbol(idx), rel, rel - 1, NO_SCOPE, DECL_FUNC });
+				break;
+			}
+
+			// A name after a type (and any number of `[]`) declares a variable
+			size_t type = idx;
+			while (type > first && tokens.types[type - 1] == TOK_ARRAY) {
+				type--;
+			}
+			if (type == first || !isTypeKeyword(tokens, type - 1)) {
+				break;
+			}
+
+			uint32_t scope = (header || open.empty()) ? NO_SCOPE : open.back();
+			decls.push_back(Declaration{ tokens.getSymbol(idx), rel, static_cast<uint32_t>(type - 1 - first), scope,
+				header ? headerKind : DECL_VAR });
+			break;
+		}
+		default:
+			break;
+		}
+	}
+}
+
+const Declaration *TokenIndex::resolve(const TokenStream &tokens, size_t first, size_t token) const {
+	Symbol symbol = tokens.getSymbol(token);
+	auto rel = static_cast<uint32_t>(token - first);
+
+	// Look through the declarations before the token, nearest first
+	auto stop = std::upper_bound(decls.begin(), decls.end(), rel, [](uint32_t idx, const Declaration &decl) {
+		return idx < decl.token;
+	});
+
+	for (auto decl = stop; decl != decls.begin();) {
+		--decl;
+		if (decl->symbol != symbol || decl->kind == DECL_FUNC) {
+			continue;
+		}
+		if (decl->token == rel || contains(decl->scope, rel)) {
+			return &*decl;
+		}
+	}
+	return nullptr;
+}
+
+void TokenIndex::collectVisible(size_t first, size_t token, std::vector<const Declaration *> *out) const {
+	auto rel = static_cast<uint32_t>(token - first);
+	size_t start = out->size();
+
+	for (size_t idx = decls.size(); idx > 0; idx--) {
+		const Declaration &decl = decls[idx - 1];
+		if (decl.token >= rel || decl.kind == DECL_FUNC || !contains(decl.scope, rel)) {
+			continue;
+		}
+
+		// An inner variable hides outer ones of the same name
+		bool hidden = false;
+		for (size_t seen = start; seen < out->size(); seen++) {
+			hidden |= ((*out)[seen]->symbol == decl.symbol);
+		}
+		if (!hidden) {
+			out->push_back(&decl);
+		}
+	}
+}
+
+/**
+ * Checks if a token lies inside a scope.
+ * @param scope Scope to check, or `NO_SCOPE` for the whole range.
+ * @param token Index of the token, relative to the first indexed token.
+ * @returns `true` if the scope contains the token.
+ */
+bool TokenIndex::contains(uint32_t scope, uint32_t token) const {
+	return scope == NO_SCOPE || (scopes[scope].open < token && token <= scopes[scope].close);
+}
+
+bool isFuncName(const TokenStream &tokens, size_t token) {
+	return (token + 1 < tokens.size() && tokens.types[token + 1] == TOK_LPAR) || (token > 0 && tokens.types[token - 1] == TOK_FUNC);
+}
+
+/**
+ * Checks if a token is the name of a type that variables can have.
+ * @param tokens Tokens to look at.
+ * @param token Index of the token.
+ * @returns `true` for `num`, `dec`, `bool`, `char` and `string`.
+ */
+static bool isTypeKeyword(const TokenStream &tokens, size_t token) {
+	if (!(tokens.flags[token] & TOKF_KEYWORD)) {
+		return false;
+	}
+
+	switch (tokens.types[token]) {
+	case TOK_NUM:
+	case TOK_DEC:
+	case TOK_BOOL:
+	case TOK_CHAR:
+	case TOK_STR:
+		return true;
+	default:
+		return false;
+	}
+}
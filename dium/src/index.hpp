@@ -0,0 +1,108 @@
+/**
+ * @file       index.hpp
+ * @brief      Definitions for indexing the declarations of a range of tokens
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef INDEX_HPP
+#define INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "token.hpp"
+
+/** Marks a declaration visible in the whole file, or a scope without a parent */
+#define NO_SCOPE UINT32_MAX
+
+/** Kinds of declarations */
+enum DeclKind : uint8_t {
+	DECL_FUNC,   /* `func name(...)` */
+	DECL_PARAM,  /* parameter of a function */
+	DECL_VAR     /* variable, including the variable of a `for` loop */
+};
+
+/** Function or variable declared in the tokens */
+struct Declaration {
+	Symbol symbol;
+
+	/** Token naming it, relative to the first indexed token */
+	uint32_t token;
+
+	/** First token of its type (the `func` keyword for functions), relative too */
+	uint32_t typeToken;
+
+	/** Scope it is visible in, from its name to the end, or `NO_SCOPE` for functions */
+	uint32_t scope;
+
+	DeclKind kind;
+};
+
+/** Tokens between a '{' and its matching '}' */
+struct Scope {
+	/** Index of the '{', relative to the first indexed token */
+	uint32_t open;
+
+	/** Index of the '}', or one past the last indexed token if it is missing */
+	uint32_t close;
+
+	/** Enclosing scope, or `NO_SCOPE` */
+	uint32_t parent;
+};
+
+/**
+ * Declarations and scopes of a range of tokens, usually a single function. It is built
+ * from the tokens alone, so it is still there for code that does not parse, and uses
+ * indices relative to the start of the range, so it stays valid when the range moves.
+ * Parameters and the variable of a `for` loop belong to the block that follows them.
+ */
+struct TokenIndex {
+	/** Declarations in the order they appear */
+	std::vector<Declaration> decls;
+
+	/** Scopes in the order they open */
+	std::vector<Scope> scopes;
+
+	/**
+	 * Indexes a range of tokens, replacing what was indexed before.
+	 * @param tokens Tokens to index.
+	 * @param first Index of the first token of the range.
+	 * @param last Index one past the last token of the range.
+	 */
+	void build(const TokenStream &tokens, size_t first, size_t last);
+
+	/**
+	 * Finds the declaration an identifier refers to, ignoring functions.
+	 * @param tokens Tokens that were indexed.
+	 * @param first Index of the first token of the range.
+	 * @param token Index of a `TOK_ID` token in the range.
+	 * @returns Innermost variable or parameter of that name visible at the token, or
+	 *     `nullptr` if there is none.
+	 */
+	const Declaration *resolve(const TokenStream &tokens, size_t first, size_t token) const;
+
+	/**
+	 * Lists the variables and parameters visible at a token, innermost first.
+	 * @param first Index of the first token of the range.
+	 * @param token Index of a token in the range.
+	 * @param[out] out List to add the declarations to.
+	 */
+	void collectVisible(size_t first, size_t token, std::vector<const Declaration *> *out) const;
+
+private:
+	bool contains(uint32_t scope, uint32_t token) const;
+};
+
+/**
+ * Checks if an identifier is used as a function, either called or declared.
+ * @param tokens Tokens to look at.
+ * @param token Index of a `TOK_ID` token.
+ * @returns `true` if it names a function.
+ */
+bool isFuncName(const TokenStream &tokens, size_t token);
+
+#endif // INDEX_HPP
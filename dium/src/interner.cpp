@@ -0,0 +1,81 @@
+/**
+ * @file       interner.cpp
+ * @brief      Implementation of the identifier interning table
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <cstring>
+#include "interner.hpp"
+
+/**
+ * Hashes the text of an identifier with FNV-1a, which is quick for short keys.
+ * @param text First character of the identifier.
+ * @param length Number of characters in the identifier.
+ * @returns Hash of the text.
+ */
+static inline uint32_t hashText(const char *text, size_t length) {
+	uint32_t hash = 2166136261u;
+
+	for (size_t idx = 0; idx < length; idx++) {
+		hash = (hash ^ static_cast<uint8_t>(text[idx])) * 16777619u;
+	}
+	return hash;
+}
+
+Interner::Interner()
+	: slots(INTERNER_INITIAL_SLOTS, Slot{ 0, NO_SYMBOL }), mask{ INTERNER_INITIAL_SLOTS - 1 } {
+	// Well-known symbols, in the order of their constants
+	intern("main", 4);
+}
+
+Symbol Interner::intern(const char *text, size_t length) {
+	uint32_t hash = hashText(text, length);
+	uint32_t idx = hash & mask;
+
+	while (slots[idx].symbol != NO_SYMBOL) {
+		const Slot &slot = slots[idx];
+		const Entry &entry = entries[slot.symbol];
+
+		if (slot.hash == hash && entry.length == length && memcmp(entry.text, text, length) == 0) {
+			return slot.symbol;
+		}
+		idx = (idx + 1) & mask;
+	}
+
+	// New identifier: keep its text, NUL-terminated, in the arena
+	auto copy = static_cast<char *>(arena.allocate(length + 1, 1));
+	memcpy(copy, text, length);
+	copy[length] = '\0';
+
+	auto symbol = static_cast<Symbol>(entries.size());
+	entries.push_back(Entry{ copy, static_cast<uint32_t>(length) });
+	slots[idx] = Slot{ hash, symbol };
+
+	if (entries.size() * 2 > slots.size()) {
+		grow();
+	}
+	return symbol;
+}
+
+/**
+ * Doubles the number of slots and puts every symbol back into the table.
+ */
+void Interner::grow() {
+	std::vector<Slot> old(slots.size() * 2, Slot{ 0, NO_SYMBOL });
+	old.swap(slots);
+	mask = static_cast<uint32_t>(slots.size() - 1);
+
+	for (const Slot &slot : old) {
+		if (slot.symbol == NO_SYMBOL) {
+			continue;
+		}
+
+		uint32_t idx = slot.hash & mask;
+		while (slots[idx].symbol != NO_SYMBOL) {
+			idx = (idx + 1) & mask;
+		}
+		slots[idx] = slot;
+	}
+}
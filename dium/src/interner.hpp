@@ -0,0 +1,102 @@
+/**
+ * @file       interner.hpp
+ * @brief      Definitions for the identifier interning table
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef INTERNER_HPP
+#define INTERNER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "arena.hpp"
+
+/** Identifier interned by an `Interner`, equal for equal text */
+using Symbol = uint32_t;
+
+/** Marks a missing symbol */
+constexpr Symbol NO_SYMBOL = UINT32_MAX;
+
+/** Symbol of `main`, which every interner holds from the start */
+constexpr Symbol SYM_MAIN = 0;
+
+/** Number of slots in a new interner (must be a power of 2) */
+#define INTERNER_INITIAL_SLOTS 1024
+
+/**
+ * Table that gives every distinct identifier a small integer, so that later stages
+ * compare and hash symbols instead of text. The lexer interns each identifier as it
+ * reads it. The table uses open addressing with linear probing and stays at most half
+ * full; the text of every symbol is copied once into an arena and stays valid for as
+ * long as the interner lives.
+ */
+class Interner {
+public:
+	/**
+	 * Creates an interner holding the well-known symbols.
+	 */
+	Interner();
+
+	Interner(const Interner &) = delete;
+	Interner &operator=(const Interner &) = delete;
+
+	/**
+	 * Finds the symbol of an identifier, adding it if it is new.
+	 * @param text First character of the identifier.
+	 * @param length Number of characters in the identifier.
+	 * @returns Symbol of the identifier.
+	 */
+	Symbol intern(const char *text, size_t length);
+
+	/**
+	 * Returns the text of a symbol.
+	 * @param symbol Symbol handed out by this interner.
+	 * @returns View of the characters, followed by a '\0'.
+	 */
+	std::string_view getText(Symbol symbol) const {
+		return std::string_view(entries[symbol].text, entries[symbol].length);
+	}
+
+	/**
+	 * Returns the number of distinct symbols.
+	 * @returns Number of symbols handed out so far.
+	 */
+	size_t size() const {
+		return entries.size();
+	}
+
+private:
+	/* Slot of the hash table */
+	struct Slot {
+		uint32_t hash;    /* Hash of the text */
+		Symbol   symbol;  /* Symbol, or `NO_SYMBOL` for an empty slot */
+	};
+
+	/* Interned identifier */
+	struct Entry {
+		const char *text;    /* Characters, in the arena */
+		uint32_t    length;  /* Number of characters */
+	};
+
+	/** Hash table of symbols */
+	std::vector<Slot> slots;
+
+	/** Number of slots minus one */
+	uint32_t mask;
+
+	/** Text of each symbol */
+	std::vector<Entry> entries;
+
+	/** Storage for the text of the symbols */
+	Arena arena;
+
+	void grow();
+};
+
+#endif // INTERNER_HPP
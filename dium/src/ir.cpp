@@ -0,0 +1,1615 @@
+/**
+ * @file       ir.cpp
+ * @brief      Implementation of the SSA intermediate representation
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include "error.hpp"
+#include "ir.hpp"
+
+// --------------- graph ---------------------------------------
+
+ValueId IrFunction::newValue(bool ref) {
+	refs.push_back(ref);
+	forwards.push_back(NO_VALUE);
+	return static_cast<ValueId>(refs.size() - 1);
+}
+
+ValueId IrFunction::resolve(ValueId value) {
+	if (value == NO_VALUE) {
+		return value;
+	}
+
+	ValueId root = value;
+	while (forwards[root] != NO_VALUE) {
+		root = forwards[root];
+	}
+
+	// Shorten the chain for the next lookup
+	while (forwards[value] != NO_VALUE) {
+		ValueId next = forwards[value];
+		forwards[value] = root;
+		value = next;
+	}
+
+	return root;
+}
+
+void IrFunction::replace(ValueId value, ValueId with) {
+	value = resolve(value);
+	with = resolve(with);
+
+	if (value != with) {
+		forwards[value] = with;
+	}
+}
+
+void IrFunction::resolveArgs() {
+	for (IrBlock &block : blocks) {
+		for (IrPhi &phi : block.phis) {
+			for (ValueId &arg : phi.args) {
+				arg = resolve(arg);
+			}
+		}
+
+		block.insts.erase(std::remove_if(block.insts.begin(), block.insts.end(),
+			[](const IrInst &inst) { return inst.op == IR_DELETED; }), block.insts.end());
+
+		for (IrInst &inst : block.insts) {
+			for (ValueId &arg : inst.args) {
+				arg = resolve(arg);
+			}
+		}
+	}
+}
+
+std::vector<uint32_t> IrFunction::getOrder() const {
+	std::vector<uint32_t> order;
+	std::vector<bool> seen(blocks.size(), false);
+	std::vector<std::pair<uint32_t, size_t>> stack{ { 0, 0 } };
+	seen[0] = true;
+
+	// Successors are visited last to first, so that the first one ends up right
+	// after its block once the postorder is reversed
+	while (!stack.empty()) {
+		uint32_t block = stack.back().first;
+		size_t next = stack.back().second;
+		const std::vector<uint32_t> &succs = blocks[block].succs;
+
+		if (next == succs.size()) {
+			order.push_back(block);
+			stack.pop_back();
+			continue;
+		}
+
+		stack.back().second += 1;
+		uint32_t succ = succs[succs.size() - 1 - next];
+		if (!seen[succ]) {
+			seen[succ] = true;
+			stack.push_back({ succ, 0 });
+		}
+	}
+
+	std::reverse(order.begin(), order.end());
+	return order;
+}
+
+std::vector<uint32_t> IrFunction::getDominators(const std::vector<uint32_t> &order) const {
+	// Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm"
+	std::vector<uint32_t> idoms(blocks.size(), UINT32_MAX);
+	std::vector<uint32_t> ranks(blocks.size(), UINT32_MAX);
+
+	for (uint32_t rank = 0; rank < order.size(); rank++) {
+		ranks[order[rank]] = rank;
+	}
+	idoms[order[0]] = order[0];
+
+	for (bool changed = true; changed;) {
+		changed = false;
+
+		for (size_t idx = 1; idx < order.size(); idx++) {
+			uint32_t block = order[idx];
+			uint32_t idom = UINT32_MAX;
+
+			for (uint32_t pred : blocks[block].preds) {
+				if (idoms[pred] == UINT32_MAX) {
+					continue;
+				}
+				if (idom == UINT32_MAX) {
+					idom = pred;
+					continue;
+				}
+
+				uint32_t other = pred;
+				while (idom != other) {
+					while (ranks[idom] > ranks[other]) {
+						idom = idoms[idom];
+					}
+					while (ranks[other] > ranks[idom]) {
+						other = idoms[other];
+					}
+				}
+			}
+
+			if (idoms[block] != idom) {
+				idoms[block] = idom;
+				changed = true;
+			}
+		}
+	}
+
+	return idoms;
+}
+
+void IrFunction::removeEdge(uint32_t from, uint32_t to) {
+	std::vector<uint32_t> &succs = blocks[from].succs;
+	succs.erase(std::find(succs.begin(), succs.end(), to));
+
+	IrBlock &block = blocks[to];
+	size_t idx = static_cast<size_t>(std::find(block.preds.begin(), block.preds.end(), from) - block.preds.begin());
+
+	block.preds.erase(block.preds.begin() + idx);
+	for (IrPhi &phi : block.phis) {
+		phi.args.erase(phi.args.begin() + idx);
+	}
+}
+
+uint32_t IrFunction::splitEdge(uint32_t from, uint32_t to) {
+	uint32_t middle = static_cast<uint32_t>(blocks.size());
+	IrBlock block;
+
+	block.insts.push_back(IrInst{ OP_JMP, 0, NO_VALUE, 0, {}, blocks[from].insts.back().position });
+	block.preds.push_back(from);
+	block.succs.push_back(to);
+	blocks.push_back(std::move(block));
+
+	*std::find(blocks[from].succs.begin(), blocks[from].succs.end(), to) = middle;
+	*std::find(blocks[to].preds.begin(), blocks[to].preds.end(), from) = middle;
+	return middle;
+}
+
+void IrFunction::simplify() {
+	std::vector<uint32_t> order = getOrder();
+	std::vector<uint32_t> renumber(blocks.size(), UINT32_MAX);
+
+	for (uint32_t block : order) {
+		renumber[block] = 0;
+	}
+
+	// Unreachable blocks no longer feed the phis of reachable ones
+	for (uint32_t block = 0; block < blocks.size(); block++) {
+		if (renumber[block] == UINT32_MAX) {
+			for (uint32_t succ : std::vector<uint32_t>(blocks[block].succs)) {
+				if (renumber[succ] != UINT32_MAX) {
+					removeEdge(block, succ);
+				}
+			}
+		}
+	}
+
+	uint32_t count = 0;
+	for (uint32_t block = 0; block < blocks.size(); block++) {
+		if (renumber[block] != UINT32_MAX) {
+			renumber[block] = count;
+			if (count != block) {
+				blocks[count] = std::move(blocks[block]);
+			}
+			count++;
+		}
+	}
+	blocks.resize(count);
+
+	for (IrBlock &block : blocks) {
+		for (uint32_t &pred : block.preds) {
+			pred = renumber[pred];
+		}
+		for (uint32_t &succ : block.succs) {
+			succ = renumber[succ];
+		}
+	}
+
+	// A phi whose operands are all the same value (or the phi itself) is that value
+	for (bool changed = true; changed;) {
+		changed = false;
+
+		for (IrBlock &block : blocks) {
+			for (size_t idx = 0; idx < block.phis.size();) {
+				IrPhi &phi = block.phis[idx];
+				ValueId same = NO_VALUE;
+				bool trivial = true;
+
+				for (ValueId arg : phi.args) {
+					arg = resolve(arg);
+					if (arg == phi.dest || arg == same) {
+						continue;
+					}
+					if (same != NO_VALUE) {
+						trivial = false;
+						break;
+					}
+					same = arg;
+				}
+
+				if (trivial && same != NO_VALUE) {
+					replace(phi.dest, same);
+					block.phis.erase(block.phis.begin() + idx);
+					changed = true;
+				} else {
+					idx++;
+				}
+			}
+		}
+	}
+
+	resolveArgs();
+}
+
+// --------------- construction --------------------------------
+
+namespace {
+
+/**
+ * Checks whether an instruction ends a block.
+ * @param op Opcode of the instruction.
+ * @returns `true` for jumps, returns and exits.
+ */
+bool isTerminator(Opcode op) {
+	switch (op) {
+	case OP_JMP:
+	case OP_JMPF:
+	case OP_JMPT:
+	case OP_FORITER:
+	case OP_RET:
+	case OP_RET0:
+	case OP_EXIT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Lifts bytecode into SSA form, treating every register as a variable, following
+ * Braun et al., "Simple and Efficient Construction of Static Single Assignment Form".
+ * Blocks are filled in reverse postorder and sealed once all their predecessors are
+ * filled, at which point the phis created for them while they were still open get
+ * their operands.
+ */
+class IrBuilder {
+public:
+	IrBuilder(const Module &module, const Function &func, IrFunction *ir)
+		: module{ module }, func{ func }, ir{ ir } {}
+
+	bool build();
+
+private:
+	const Module &module;
+	const Function &func;
+	IrFunction *ir;
+
+	/** First and last instruction of each block (unused for the synthetic entry) */
+	std::vector<std::pair<uint32_t, uint32_t>> ranges;
+
+	/** Value of each register at the end of each block, as far as it is known */
+	std::vector<std::unordered_map<uint16_t, ValueId>> defs;
+
+	/** Phis created in each unsealed block, with the register they stand for */
+	std::vector<std::vector<std::pair<uint16_t, size_t>>> incomplete;
+
+	std::vector<bool> sealed;
+	std::vector<bool> filled;
+
+	/** Whether a register was read before it was written */
+	bool undefined = false;
+
+	void fill(uint32_t block);
+	void seal(uint32_t block);
+	ValueId read(uint16_t reg, uint32_t block);
+	void addPhiOperands(uint16_t reg, uint32_t block, size_t phi);
+	IrInst &add(uint32_t block, Opcode op, uint32_t idx);
+	ValueId define(uint32_t block, IrInst &inst, uint16_t reg, bool ref);
+};
+
+/**
+ * Builds the graph of a function, then fills its blocks.
+ * @returns `true` on success.
+ */
+bool IrBuilder::build() {
+	const std::vector<Instr> &code = func.code;
+	uint32_t count = static_cast<uint32_t>(code.size());
+
+	if (count == 0) {
+		return false;
+	}
+
+	// Jump targets and the instructions after jumps start blocks
+	std::vector<bool> leaders(count + 1, false);
+	leaders[0] = true;
+
+	for (uint32_t idx = 0; idx < count; idx++) {
+		switch (code[idx].op) {
+		case OP_JMP:
+		case OP_JMPF:
+		case OP_JMPT:
+		case OP_FORITER:
+			if (getWide(code[idx]) >= count) {
+				return false;
+			}
+			leaders[getWide(code[idx])] = true;
+			leaders[idx + 1] = true;
+			break;
+		case OP_RET:
+		case OP_RET0:
+		case OP_EXIT:
+			leaders[idx + 1] = true;
+			break;
+		default:
+			break;
+		}
+	}
+
+	// Only blocks that can be reached get a block in the graph. The synthetic entry
+	// block 0 defines the parameters, so the first instruction may start a loop.
+	std::vector<uint32_t> blockAt(count, UINT32_MAX);
+	std::vector<uint32_t> pending{ 0 };
+	ir->blocks.resize(2);
+	ranges.resize(2);
+	blockAt[0] = 1;
+
+	auto target = [&](uint32_t idx) {
+		if (idx >= count) {
+			return UINT32_MAX;
+		}
+		if (blockAt[idx] == UINT32_MAX) {
+			blockAt[idx] = static_cast<uint32_t>(ir->blocks.size());
+			ir->blocks.emplace_back();
+			ranges.emplace_back();
+			pending.push_back(idx);
+		}
+		return blockAt[idx];
+	};
+
+	while (!pending.empty()) {
+		uint32_t start = pending.back();
+		pending.pop_back();
+		uint32_t block = blockAt[start];
+
+		uint32_t last = start;
+		while (!leaders[last + 1]) {
+			last++;
+		}
+		ranges[block] = { start, last };
+
+		const Instr &instr = code[last];
+		std::vector<uint32_t> succs;
+
+		switch (instr.op) {
+		case OP_JMP:
+			succs.push_back(target(getWide(instr)));
+			break;
+		case OP_JMPF:
+		case OP_FORITER:
+			succs.push_back(target(last + 1));
+			succs.push_back(target(getWide(instr)));
+			break;
+		case OP_JMPT:
+			succs.push_back(target(getWide(instr)));
+			succs.push_back(target(last + 1));
+			break;
+		case OP_RET:
+		case OP_RET0:
+		case OP_EXIT:
+			break;
+		default:
+			succs.push_back(target(last + 1));
+			break;
+		}
+
+		// Falling off the end of the code
+		if (std::find(succs.begin(), succs.end(), UINT32_MAX) != succs.end()) {
+			return false;
+		}
+
+		// A branch whose targets are the same is a plain jump
+		if (succs.size() == 2 && succs[0] == succs[1] && instr.op != OP_FORITER) {
+			succs.pop_back();
+		}
+		ir->blocks[block].succs = succs;
+	}
+
+	ir->blocks[0].succs.push_back(1);
+	for (uint32_t block = 0; block < ir->blocks.size(); block++) {
+		for (uint32_t succ : ir->blocks[block].succs) {
+			ir->blocks[succ].preds.push_back(block);
+		}
+	}
+
+	// FORITER always has two different successors, even when the body is empty
+	for (const IrBlock &block : ir->blocks) {
+		if (block.succs.size() == 2 && block.succs[0] == block.succs[1]) {
+			return false;
+		}
+	}
+
+	size_t blockCount = ir->blocks.size();
+	defs.resize(blockCount);
+	incomplete.resize(blockCount);
+	sealed.resize(blockCount, false);
+	filled.resize(blockCount, false);
+
+	for (uint16_t param = 0; param < func.paramCount; param++) {
+		ValueId value = ir->newValue(isRefType(func.paramTypes[param]));
+		ir->params.push_back(value);
+		defs[0][param] = value;
+	}
+
+	for (uint32_t block : ir->getOrder()) {
+		if (!sealed[block]) {
+			bool ready = true;
+			for (uint32_t pred : ir->blocks[block].preds) {
+				ready = ready && filled[pred];
+			}
+			if (ready) {
+				seal(block);
+			}
+		}
+
+		fill(block);
+		filled[block] = true;
+
+		for (uint32_t succ : ir->blocks[block].succs) {
+			bool ready = !sealed[succ];
+			for (uint32_t pred : ir->blocks[succ].preds) {
+				ready = ready && filled[pred];
+			}
+			if (ready) {
+				seal(succ);
+			}
+		}
+	}
+
+	if (undefined) {
+		return false;
+	}
+
+	ir->simplify();
+
+	// A phi holds a reference if its operands do, which may only be known through
+	// other phis
+	for (bool changed = true; changed;) {
+		changed = false;
+
+		for (const IrBlock &block : ir->blocks) {
+			for (const IrPhi &phi : block.phis) {
+				if (ir->refs[phi.dest]) {
+					continue;
+				}
+				for (ValueId arg : phi.args) {
+					if (ir->refs[arg]) {
+						ir->refs[phi.dest] = true;
+						changed = true;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	// The collector could not tell what a register mixing references and other
+	// values holds
+	for (const IrBlock &block : ir->blocks) {
+		for (const IrPhi &phi : block.phis) {
+			for (ValueId arg : phi.args) {
+				if (ir->refs[arg] != ir->refs[phi.dest]) {
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Translates the instructions of a block. Moves only rename values, and a jump ends
+ * every block, even one that used to fall through.
+ * @param block Block to fill.
+ */
+void IrBuilder::fill(uint32_t block) {
+	if (block == 0) {
+		add(block, OP_JMP, 0);
+		return;
+	}
+
+	const std::vector<Instr> &code = func.code;
+	uint32_t last = ranges[block].second;
+
+	for (uint32_t idx = ranges[block].first; idx <= last; idx++) {
+		const Instr &instr = code[idx];
+
+		switch (instr.op) {
+		case OP_MOVE:
+			defs[block][instr.a] = read(instr.b, block);
+			break;
+		case OP_LOADI: {
+			IrInst &inst = add(block, OP_LOADI, idx);
+			inst.imm = static_cast<int32_t>(getWide(instr));
+			define(block, inst, instr.a, false);
+			break;
+		}
+		case OP_LOADK: {
+			IrInst &inst = add(block, OP_LOADK, idx);
+			inst.imm = getWide(instr);
+			define(block, inst, instr.a, module.constants[getWide(instr)].kind == CONST_STR);
+			break;
+		}
+		case OP_NEWARRAY:
+		case OP_CONCAT: {
+			std::vector<ValueId> items;
+			for (uint16_t item = 0; item < instr.c; item++) {
+				items.push_back(read(static_cast<uint16_t>(instr.b + item), block));
+			}
+
+			IrInst &inst = add(block, instr.op, idx);
+			inst.args = std::move(items);
+			define(block, inst, instr.a, true);
+			break;
+		}
+		case OP_GETINDEX:
+		case OP_GETCHAR:
+		case OP_ADD_NUM:
+		case OP_SUB_NUM:
+		case OP_MUL_NUM:
+		case OP_DIV_NUM:
+		case OP_MOD_NUM:
+		case OP_ADD_DEC:
+		case OP_SUB_DEC:
+		case OP_MUL_DEC:
+		case OP_DIV_DEC:
+		case OP_MOD_DEC:
+		case OP_EQ_NUM:
+		case OP_NE_NUM:
+		case OP_LT_NUM:
+		case OP_LE_NUM:
+		case OP_EQ_DEC:
+		case OP_NE_DEC:
+		case OP_LT_DEC:
+		case OP_LE_DEC:
+		case OP_EQ_STR:
+		case OP_NE_STR:
+		case OP_LT_STR:
+		case OP_LE_STR:
+		case OP_EQ_REF:
+		case OP_NE_REF: {
+			ValueId lhs = read(instr.b, block);
+			ValueId rhs = read(instr.c, block);
+			bool ref = (instr.op == OP_GETINDEX && isRefType(unpackType(instr.type)));
+
+			IrInst &inst = add(block, instr.op, idx);
+			inst.args = { lhs, rhs };
+			define(block, inst, instr.a, ref);
+			break;
+		}
+		case OP_DIVP2_NUM:
+		case OP_MODP2_NUM:
+		case OP_NEG_NUM:
+		case OP_NEG_DEC:
+		case OP_NOT:
+		case OP_NUM2DEC:
+		case OP_DEC2NUM:
+		case OP_NUM2CHAR:
+		case OP_NUM2BOOL:
+		case OP_STR2NUM:
+		case OP_STR2DEC:
+		case OP_STR2CHAR:
+		case OP_TOSTR: {
+			ValueId operand = read(instr.b, block);
+
+			IrInst &inst = add(block, instr.op, idx);
+			inst.args = { operand };
+			inst.imm = (instr.op == OP_DIVP2_NUM || instr.op == OP_MODP2_NUM) ? instr.c : 0;
+			define(block, inst, instr.a, instr.op == OP_TOSTR);
+			break;
+		}
+		case OP_SETINDEX: {
+			std::vector<ValueId> args = { read(instr.a, block), read(instr.b, block), read(instr.c, block) };
+			add(block, OP_SETINDEX, idx).args = std::move(args);
+			break;
+		}
+		case OP_RANGE: {
+			std::vector<ValueId> args;
+			for (uint16_t arg = 0; arg < 3; arg++) {
+				args.push_back(read(static_cast<uint16_t>(instr.b + arg), block));
+			}
+
+			IrInst &inst = add(block, OP_RANGE, idx);
+			inst.args = std::move(args);
+			define(block, inst, instr.a, false);
+			break;
+		}
+		case OP_CALL: {
+			std::vector<ValueId> args;
+			for (uint16_t arg = 0; arg < instr.c; arg++) {
+				args.push_back(read(static_cast<uint16_t>(instr.a + arg), block));
+			}
+
+			// Calls to functions without a result still define a value, which the
+			// compiler may move around but never reads
+			IrInst &inst = add(block, OP_CALL, idx);
+			inst.imm = instr.b;
+			inst.args = std::move(args);
+			define(block, inst, instr.a, isRefType(module.funcs[instr.b].returnType));
+			break;
+		}
+		case OP_PRINT:
+		case OP_PRINTLN:
+		case OP_RET:
+		case OP_EXIT: {
+			ValueId operand = read(instr.a, block);
+			add(block, instr.op, idx).args = { operand };
+			break;
+		}
+		case OP_NEWLINE:
+		case OP_RET0:
+		case OP_JMP:
+			add(block, instr.op, idx);
+			break;
+		case OP_JMPF:
+		case OP_JMPT: {
+			ValueId cond = read(instr.a, block);
+
+			// JMPT swapped its successors, and identical ones made it a jump
+			if (ir->blocks[block].succs.size() == 1) {
+				add(block, OP_JMP, idx);
+			} else {
+				add(block, OP_JMPF, idx).args = { cond };
+			}
+			break;
+		}
+		case OP_FORITER: {
+			ValueId range = read(instr.a, block);
+
+			IrInst &inst = add(block, OP_FORITER, idx);
+			inst.args = { range };
+			define(block, inst, static_cast<uint16_t>(instr.a + 3), false);
+			break;
+		}
+		default:
+			undefined = true;
+			return;
+		}
+	}
+
+	// The next instruction starts another block
+	if (ir->blocks[block].succs.size() == 1 && !isTerminator(code[last].op)) {
+		add(block, OP_JMP, last);
+	}
+}
+
+/**
+ * Gives the phis of a block their operands, now that all its predecessors are filled.
+ * @param block Block to seal.
+ */
+void IrBuilder::seal(uint32_t block) {
+	sealed[block] = true;
+
+	for (const auto &phi : incomplete[block]) {
+		addPhiOperands(phi.first, block, phi.second);
+	}
+	incomplete[block].clear();
+}
+
+/**
+ * Finds the value of a register at the end of a block, or at the current instruction
+ * of the block being filled.
+ * @param reg Register to read.
+ * @param block Block to look in.
+ * @returns Value of the register.
+ */
+ValueId IrBuilder::read(uint16_t reg, uint32_t block) {
+	auto found = defs[block].find(reg);
+	if (found != defs[block].end()) {
+		return found->second;
+	}
+
+	const IrBlock &current = ir->blocks[block];
+	ValueId value;
+
+	if (!sealed[block]) {
+		// Not all predecessors are known yet, so the phi gets its operands later
+		value = ir->newValue(false);
+		incomplete[block].push_back({ reg, ir->blocks[block].phis.size() });
+		ir->blocks[block].phis.push_back({ value, {} });
+	} else if (current.preds.empty()) {
+		undefined = true;
+		value = ir->newValue(false);
+	} else if (current.preds.size() == 1) {
+		value = read(reg, current.preds[0]);
+	} else {
+		// The phi is recorded first, so that loops reading the register find it
+		value = ir->newValue(false);
+		size_t phi = current.phis.size();
+		ir->blocks[block].phis.push_back({ value, {} });
+		defs[block][reg] = value;
+		addPhiOperands(reg, block, phi);
+	}
+
+	defs[block][reg] = value;
+	return value;
+}
+
+/**
+ * Reads a register in every predecessor of a block to fill in the operands of a phi.
+ * @param reg Register the phi stands for.
+ * @param block Block of the phi.
+ * @param phi Index of the phi in the block.
+ */
+void IrBuilder::addPhiOperands(uint16_t reg, uint32_t block, size_t phi) {
+	for (size_t idx = 0; idx < ir->blocks[block].preds.size(); idx++) {
+		ValueId value = read(reg, ir->blocks[block].preds[idx]);
+		ir->blocks[block].phis[phi].args.push_back(value);
+	}
+}
+
+/**
+ * Appends an instruction to a block.
+ * @param block Block to append to.
+ * @param op Operation.
+ * @param idx Bytecode instruction it comes from.
+ * @returns New instruction.
+ */
+IrInst &IrBuilder::add(uint32_t block, Opcode op, uint32_t idx) {
+	const Instr &instr = func.code[idx];
+	SourcePosition position = (idx < func.positions.size()) ? func.positions[idx] : SourcePosition{};
+
+	ir->blocks[block].insts.push_back(IrInst{ op, instr.type, NO_VALUE, 0, {}, position });
+	return ir->blocks[block].insts.back();
+}
+
+/**
+ * Creates the value defined by an instruction and assigns it to a register.
+ * @param block Block of the instruction.
+ * @param inst Instruction defining the value.
+ * @param reg Register it is written to.
+ * @param ref `true` if the value is a reference.
+ * @returns New value.
+ */
+ValueId IrBuilder::define(uint32_t block, IrInst &inst, uint16_t reg, bool ref) {
+	inst.dest = ir->newValue(ref);
+	defs[block][reg] = inst.dest;
+	return inst.dest;
+}
+
+// --------------- lowering ------------------------------------
+
+/* Flag of the registers reserved for `for` loops, see `IrLowering` */
+constexpr uint32_t LOOP_FLAG = 0x80000000u;
+
+/* Registers reserved for each `for` loop: its state and its variable */
+constexpr uint32_t LOOP_REGISTERS = 4;
+
+/* Register of a value that has none */
+constexpr uint32_t NO_REGISTER = UINT32_MAX;
+
+/**
+ * Set of values whose cost follows the number of values in it rather than the number
+ * of values in the function: a list of the members and the place of each value in
+ * it, so that it can be emptied and reused for every block.
+ */
+class ValueSet {
+public:
+	explicit ValueSet(size_t size = 0)
+		: slots(size, NO_SLOT) {}
+
+	bool has(ValueId value) const {
+		return slots[value] != NO_SLOT;
+	}
+
+	void add(ValueId value) {
+		if (slots[value] == NO_SLOT) {
+			slots[value] = static_cast<uint32_t>(members.size());
+			members.push_back(value);
+		}
+	}
+
+	void remove(ValueId value) {
+		uint32_t slot = slots[value];
+		if (slot != NO_SLOT) {
+			members[slot] = members.back();
+			slots[members[slot]] = slot;
+			members.pop_back();
+			slots[value] = NO_SLOT;
+		}
+	}
+
+	/**
+	 * Removes every value.
+	 */
+	void clear() {
+		for (ValueId value : members) {
+			slots[value] = NO_SLOT;
+		}
+		members.clear();
+	}
+
+	/** Values in the set, in no particular order */
+	std::vector<ValueId> members;
+
+private:
+	/* Place of a value that is not in the set */
+	static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+	/** Place of each value in `members` */
+	std::vector<uint32_t> slots;
+};
+
+/**
+ * Checks whether an instruction may collect garbage, so that it needs a stack map.
+ * @param op Opcode of the instruction.
+ * @returns `true` for calls and allocations.
+ */
+bool isSafepoint(Opcode op) {
+	switch (op) {
+	case OP_NEWARRAY:
+	case OP_CONCAT:
+	case OP_TOSTR:
+	case OP_CALL:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Lowers a function out of SSA form. Since the interference graph of a program in SSA
+ * form is chordal, walking the dominator tree and giving every value the lowest
+ * register that no live value holds uses as few registers as possible. Phis become
+ * parallel copies at the end of their predecessors, once critical edges are split.
+ *
+ * Operands that must sit in a run of registers go through scratch registers at the top
+ * of the frame: call arguments, which become the first registers of the callee, array
+ * items and range bounds. Each `for` loop also reserves four registers below the
+ * scratch registers for the state that RANGE sets up and for its loop variable, which
+ * FORITER writes to the register after the state.
+ *
+ * Frame layout:
+ *   [0, general)                   values, parameters first
+ *   [general, general + 4 * loops) loop states and variables
+ *   [general + 4 * loops, ...)     scratch registers
+ */
+class IrLowering {
+public:
+	IrLowering(IrFunction &ir, Function *func)
+		: ir{ ir }, func{ func } {}
+
+	bool lower();
+
+private:
+	/* What register allocation found out about a block */
+	struct BlockInfo {
+		/** Values live on entry, not counting the phis of the block, in increasing order */
+		std::vector<ValueId> liveIn;
+
+		/** Values live on exit, including the operands of the phis of the successor */
+		std::vector<ValueId> liveOut;
+
+		/** Operands that are not used after each instruction */
+		std::vector<std::vector<ValueId>> dying;
+
+		/** References live after each safepoint, not counting its result */
+		std::vector<std::vector<ValueId>> refsAfter;
+
+		/** Whether the result of each instruction is used */
+		std::vector<bool> used;
+	};
+
+	IrFunction &ir;
+	Function *func;
+
+	/** Blocks in the order they are emitted */
+	std::vector<uint32_t> order;
+
+	std::vector<BlockInfo> infos;
+
+	/** Register of each value, `LOOP_FLAG` plus the slot for loop registers */
+	std::vector<uint32_t> regs;
+
+	/** Registers in use while assigning a block */
+	std::vector<bool> busy;
+
+	/** Values live at the current instruction while scanning a block */
+	ValueSet live;
+
+	/** Number of registers for values */
+	uint32_t general = 0;
+
+	/** Number of `for` loops */
+	uint32_t loops = 0;
+
+	/** Number of scratch registers */
+	uint32_t scratchSize = 1;
+
+	/** First scratch register */
+	uint16_t scratch = 0;
+
+	/** Lowered function */
+	Function out;
+
+	void analyzeLiveness();
+	bool assignLoops();
+	void assignRegisters();
+	void scanBlock(uint32_t block);
+	uint32_t take();
+	void release(ValueId value);
+	void emitBlock(uint32_t block, uint32_t next, std::vector<std::pair<size_t, uint32_t>> *jumps);
+	void emitInst(const IrInst &inst, const BlockInfo &info, size_t idx);
+	void emitCopies(uint32_t from, uint32_t to);
+	void moveArgs(const IrInst &inst);
+	size_t put(Opcode op, const SourcePosition &position, uint16_t a = 0, uint16_t b = 0, uint16_t c = 0, uint8_t type = 0);
+	void addSafepoint(const std::vector<ValueId> &refs, uint16_t extraStart = 0, uint16_t extraCount = 0);
+	uint16_t reg(ValueId value) const;
+};
+
+/**
+ * Lowers the whole function into `out` and moves it into place.
+ * @returns `true` on success.
+ */
+bool IrLowering::lower() {
+	ir.simplify();
+
+	// Copies for phis need a block of their own on edges from blocks that branch
+	for (uint32_t block = 0; block < ir.blocks.size(); block++) {
+		if (ir.blocks[block].succs.size() < 2) {
+			continue;
+		}
+		for (uint32_t succ : std::vector<uint32_t>(ir.blocks[block].succs)) {
+			if (ir.blocks[succ].preds.size() > 1) {
+				ir.splitEdge(block, succ);
+			}
+		}
+	}
+
+	order = ir.getOrder();
+	regs.assign(ir.refs.size(), NO_REGISTER);
+	live = ValueSet(ir.refs.size());
+	analyzeLiveness();
+
+	if (!assignLoops()) {
+		return false;
+	}
+	assignRegisters();
+
+	uint32_t top = general + LOOP_REGISTERS * loops;
+	scratch = static_cast<uint16_t>(top);
+
+	// Scratch registers are sized while emitting, so check the worst case first
+	if (top >= MAX_REGISTERS) {
+		return false;
+	}
+
+	out.refStarts.push_back(0);
+	std::vector<std::pair<size_t, uint32_t>> jumps;
+	std::vector<uint32_t> starts(ir.blocks.size(), 0);
+
+	for (size_t idx = 0; idx < order.size(); idx++) {
+		starts[order[idx]] = static_cast<uint32_t>(out.code.size());
+		emitBlock(order[idx], (idx + 1 < order.size()) ? order[idx + 1] : UINT32_MAX, &jumps);
+	}
+
+	for (const auto &jump : jumps) {
+		setWide(&out.code[jump.first], starts[jump.second]);
+	}
+
+	if (top + scratchSize > MAX_REGISTERS) {
+		return false;
+	}
+
+	func->frameSize = static_cast<uint16_t>(top + scratchSize);
+	func->code = std::move(out.code);
+	func->positions = std::move(out.positions);
+	func->safepoints = std::move(out.safepoints);
+	func->refStarts = std::move(out.refStarts);
+	func->refRegs = std::move(out.refRegs);
+	return true;
+}
+
+/**
+ * Finds the values live on entry to and exit from every block. Since each value is
+ * defined once, it is live exactly on the paths from its uses back to its definition,
+ * so each use is followed up through the predecessors until the definition or a block
+ * where the value is already known to be live. The work is proportional to the size
+ * of the live sets rather than to the number of blocks times the number of values.
+ */
+void IrLowering::analyzeLiveness() {
+	/* Use of a value, in a block or, for a phi operand, at the end of a predecessor */
+	struct Use {
+		ValueId value;
+		uint32_t block;
+		bool atEnd;
+	};
+
+	size_t count = ir.refs.size();
+	std::vector<uint32_t> defBlocks(count, UINT32_MAX);
+	std::vector<Use> uses;
+	infos.assign(ir.blocks.size(), BlockInfo{});
+
+	for (uint32_t block = 0; block < ir.blocks.size(); block++) {
+		const IrBlock &current = ir.blocks[block];
+
+		for (const IrPhi &phi : current.phis) {
+			defBlocks[phi.dest] = block;
+		}
+		for (const IrInst &inst : current.insts) {
+			if (inst.dest != NO_VALUE) {
+				defBlocks[inst.dest] = block;
+			}
+		}
+	}
+	for (ValueId param : ir.params) {
+		defBlocks[param] = 0;
+	}
+
+	// Operands defined in their own block are defined before they are used there
+	for (uint32_t block : order) {
+		const IrBlock &current = ir.blocks[block];
+
+		for (const IrInst &inst : current.insts) {
+			for (ValueId arg : inst.args) {
+				if (defBlocks[arg] != block) {
+					uses.push_back(Use{ arg, block, false });
+				}
+			}
+		}
+		for (uint32_t succ : current.succs) {
+			const IrBlock &next = ir.blocks[succ];
+			size_t pred = static_cast<size_t>(std::find(next.preds.begin(), next.preds.end(), block) - next.preds.begin());
+
+			for (const IrPhi &phi : next.phis) {
+				uses.push_back(Use{ phi.args[pred], block, true });
+			}
+		}
+	}
+
+	// Going through the values in order keeps every live set sorted, and the last
+	// value added to each set tells whether the current one is already in it
+	std::sort(uses.begin(), uses.end(), [](const Use &lhs, const Use &rhs) { return lhs.value < rhs.value; });
+	std::vector<uint32_t> pending;
+	ValueId value = NO_VALUE;
+
+	auto addIn = [&](uint32_t block) {
+		std::vector<ValueId> &liveIn = infos[block].liveIn;
+		if (defBlocks[value] != block && (liveIn.empty() || liveIn.back() != value)) {
+			liveIn.push_back(value);
+			pending.push_back(block);
+		}
+	};
+	auto addOut = [&](uint32_t block) {
+		std::vector<ValueId> &liveOut = infos[block].liveOut;
+		if (liveOut.empty() || liveOut.back() != value) {
+			liveOut.push_back(value);
+			addIn(block);
+		}
+	};
+
+	for (const Use &use : uses) {
+		value = use.value;
+		if (use.atEnd) {
+			addOut(use.block);
+		} else {
+			addIn(use.block);
+		}
+
+		while (!pending.empty()) {
+			uint32_t block = pending.back();
+			pending.pop_back();
+
+			for (uint32_t pred : ir.blocks[block].preds) {
+				addOut(pred);
+			}
+		}
+	}
+}
+
+/**
+ * Reserves registers for the state of every `for` loop and its variable.
+ * @returns `false` if a loop does not iterate over a range of its own.
+ */
+bool IrLowering::assignLoops() {
+	std::vector<Opcode> defOps(ir.refs.size(), IR_DELETED);
+
+	for (uint32_t block : order) {
+		for (const IrInst &inst : ir.blocks[block].insts) {
+			if (inst.dest != NO_VALUE) {
+				defOps[inst.dest] = inst.op;
+			}
+		}
+	}
+
+	for (uint32_t block : order) {
+		const IrInst &last = ir.blocks[block].insts.back();
+
+		if (last.op == OP_FORITER) {
+			ValueId range = last.args[0];
+
+			if (defOps[range] != OP_RANGE || regs[range] != NO_REGISTER) {
+				return false;
+			}
+
+			regs[range] = LOOP_FLAG | (LOOP_REGISTERS * loops);
+			regs[last.dest] = LOOP_FLAG | (LOOP_REGISTERS * loops + 3);
+			loops++;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Assigns registers to the values of every block, walking the dominator tree so that
+ * values are assigned before they are used.
+ */
+void IrLowering::assignRegisters() {
+	std::vector<uint32_t> idoms = ir.getDominators(order);
+	std::vector<std::vector<uint32_t>> children(ir.blocks.size());
+
+	for (uint32_t block : order) {
+		if (block != 0) {
+			children[idoms[block]].push_back(block);
+		}
+	}
+
+	std::vector<uint32_t> stack{ 0 };
+	while (!stack.empty()) {
+		uint32_t block = stack.back();
+		stack.pop_back();
+
+		scanBlock(block);
+		const BlockInfo &info = infos[block];
+		const IrBlock &current = ir.blocks[block];
+
+		// Values live on entry were assigned in a dominating block
+		busy.assign(general, false);
+		for (ValueId value : info.liveIn) {
+			if ((regs[value] & LOOP_FLAG) == 0) {
+				busy[regs[value]] = true;
+			}
+		}
+
+		// Parameters arrive in the first registers
+		if (block == 0) {
+			for (uint32_t param = 0; param < ir.params.size(); param++) {
+				regs[ir.params[param]] = param;
+				general = std::max(general, param + 1);
+
+				if (busy.size() <= param) {
+					busy.resize(param + 1, false);
+				}
+				busy[param] = live.has(ir.params[param]);
+			}
+		}
+
+		for (const IrPhi &phi : current.phis) {
+			if (live.has(phi.dest)) {
+				regs[phi.dest] = take();
+			}
+		}
+
+		for (size_t idx = 0; idx < current.insts.size(); idx++) {
+			const IrInst &inst = current.insts[idx];
+
+			for (ValueId arg : info.dying[idx]) {
+				release(arg);
+			}
+
+			if (inst.dest != NO_VALUE && regs[inst.dest] == NO_REGISTER) {
+				regs[inst.dest] = take();
+				if (!info.used[idx]) {
+					release(inst.dest);
+				}
+			}
+		}
+
+		for (uint32_t child : children[block]) {
+			stack.push_back(child);
+		}
+	}
+}
+
+/**
+ * Walks a block backwards to find where values die and which references each
+ * safepoint must keep, leaving the values live after the phis of the block in `live`.
+ * @param block Block to scan.
+ */
+void IrLowering::scanBlock(uint32_t block) {
+	const IrBlock &current = ir.blocks[block];
+	BlockInfo &info = infos[block];
+	size_t count = current.insts.size();
+
+	live.clear();
+	for (ValueId value : info.liveOut) {
+		live.add(value);
+	}
+
+	info.dying.assign(count, {});
+	info.refsAfter.assign(count, {});
+	info.used.assign(count, false);
+
+	for (size_t idx = count; idx-- > 0;) {
+		const IrInst &inst = current.insts[idx];
+
+		if (inst.dest != NO_VALUE) {
+			info.used[idx] = live.has(inst.dest);
+			live.remove(inst.dest);
+		}
+
+		if (isSafepoint(inst.op)) {
+			for (ValueId value : live.members) {
+				if (ir.refs[value]) {
+					info.refsAfter[idx].push_back(value);
+				}
+			}
+			std::sort(info.refsAfter[idx].begin(), info.refsAfter[idx].end());
+		}
+
+		for (ValueId arg : inst.args) {
+			if (!live.has(arg)) {
+				info.dying[idx].push_back(arg);
+				live.add(arg);
+			}
+		}
+	}
+}
+
+/**
+ * Takes the lowest free register.
+ * @returns Register taken.
+ */
+uint32_t IrLowering::take() {
+	uint32_t reg = 0;
+	while (reg < busy.size() && busy[reg]) {
+		reg++;
+	}
+
+	if (reg == busy.size()) {
+		busy.push_back(false);
+	}
+	busy[reg] = true;
+	general = std::max(general, reg + 1);
+	return reg;
+}
+
+/**
+ * Frees the register of a value that is no longer used.
+ * @param value Value to free.
+ */
+void IrLowering::release(ValueId value) {
+	if ((regs[value] & LOOP_FLAG) == 0) {
+		busy[regs[value]] = false;
+	}
+}
+
+/**
+ * Emits the instructions of a block, followed by the copies for the phis of its
+ * successor and a jump unless the successor comes next.
+ * @param block Block to emit.
+ * @param next Block emitted after it.
+ * @param jumps Jumps to patch with the start of a block.
+ */
+void IrLowering::emitBlock(uint32_t block, uint32_t next, std::vector<std::pair<size_t, uint32_t>> *jumps) {
+	const IrBlock &current = ir.blocks[block];
+	const BlockInfo &info = infos[block];
+	size_t last = current.insts.size() - 1;
+
+	for (size_t idx = 0; idx < last; idx++) {
+		emitInst(current.insts[idx], info, idx);
+	}
+
+	const IrInst &inst = current.insts[last];
+	const std::vector<uint32_t> &succs = current.succs;
+
+	switch (inst.op) {
+	case OP_JMP:
+		emitCopies(block, succs[0]);
+		if (succs[0] != next) {
+			jumps->push_back({ put(OP_JMP, inst.position), succs[0] });
+		}
+		break;
+	case OP_JMPF:
+		if (succs[0] == next) {
+			jumps->push_back({ put(OP_JMPF, inst.position, reg(inst.args[0])), succs[1] });
+		} else if (succs[1] == next) {
+			jumps->push_back({ put(OP_JMPT, inst.position, reg(inst.args[0])), succs[0] });
+		} else {
+			jumps->push_back({ put(OP_JMPF, inst.position, reg(inst.args[0])), succs[1] });
+			jumps->push_back({ put(OP_JMP, inst.position), succs[0] });
+		}
+		break;
+	case OP_FORITER:
+		jumps->push_back({ put(OP_FORITER, inst.position, reg(inst.args[0])), succs[1] });
+		if (succs[0] != next) {
+			jumps->push_back({ put(OP_JMP, inst.position), succs[0] });
+		}
+		break;
+	case OP_RET:
+	case OP_EXIT:
+		put(inst.op, inst.position, reg(inst.args[0]));
+		break;
+	default:
+		put(inst.op, inst.position);
+		break;
+	}
+}
+
+/**
+ * Emits an instruction that does not end its block.
+ * @param inst Instruction to emit.
+ * @param info What register allocation found out about its block.
+ * @param idx Index of the instruction in its block.
+ */
+void IrLowering::emitInst(const IrInst &inst, const BlockInfo &info, size_t idx) {
+	const SourcePosition &position = inst.position;
+
+	switch (inst.op) {
+	case OP_LOADI:
+	case OP_LOADK:
+		setWide(&out.code[put(inst.op, position, reg(inst.dest))], static_cast<uint32_t>(inst.imm));
+		break;
+	case OP_NEWARRAY: {
+		moveArgs(inst);
+		uint16_t count = static_cast<uint16_t>(inst.args.size());
+		put(OP_NEWARRAY, position, reg(inst.dest), scratch, count, inst.type);
+
+		// The items are read after a collection, from the scratch registers
+		bool refItems = isRefType(unpackType(inst.type));
+		addSafepoint(info.refsAfter[idx], scratch, refItems ? count : 0);
+		break;
+	}
+	case OP_CONCAT:
+		// The operands are read before anything is allocated
+		moveArgs(inst);
+		put(OP_CONCAT, position, reg(inst.dest), scratch, static_cast<uint16_t>(inst.args.size()));
+		addSafepoint(info.refsAfter[idx]);
+		break;
+	case OP_RANGE:
+		moveArgs(inst);
+		put(OP_RANGE, position, reg(inst.dest), scratch);
+		break;
+	case OP_CALL:
+		moveArgs(inst);
+		put(OP_CALL, position, scratch, static_cast<uint16_t>(inst.imm), static_cast<uint16_t>(inst.args.size()));
+		addSafepoint(info.refsAfter[idx]);
+
+		if (info.used[idx]) {
+			put(OP_MOVE, position, reg(inst.dest), scratch);
+		}
+		break;
+	case OP_SETINDEX:
+		put(OP_SETINDEX, position, reg(inst.args[0]), reg(inst.args[1]), reg(inst.args[2]));
+		break;
+	case OP_PRINT:
+	case OP_PRINTLN:
+		put(inst.op, position, reg(inst.args[0]), 0, 0, inst.type);
+		break;
+	case OP_NEWLINE:
+		put(OP_NEWLINE, position);
+		break;
+	case OP_DIVP2_NUM:
+	case OP_MODP2_NUM:
+		put(inst.op, position, reg(inst.dest), reg(inst.args[0]), static_cast<uint16_t>(inst.imm));
+		break;
+	default:
+		put(inst.op, position, reg(inst.dest), reg(inst.args[0]),
+			(inst.args.size() > 1) ? reg(inst.args[1]) : 0, inst.type);
+
+		if (isSafepoint(inst.op)) {
+			addSafepoint(info.refsAfter[idx]);
+		}
+		break;
+	}
+}
+
+/**
+ * Emits the copies that give the phis of a block their values when it is entered from
+ * a predecessor. All copies happen at once, so a copy whose target another one still
+ * reads waits, and cycles are broken through a scratch register.
+ * @param from Predecessor.
+ * @param to Block with the phis.
+ */
+void IrLowering::emitCopies(uint32_t from, uint32_t to) {
+	const IrBlock &block = ir.blocks[to];
+	size_t pred = static_cast<size_t>(std::find(block.preds.begin(), block.preds.end(), from) - block.preds.begin());
+	const SourcePosition &position = ir.blocks[from].insts.back().position;
+
+	std::vector<std::pair<uint16_t, uint16_t>> copies;
+	for (const IrPhi &phi : block.phis) {
+		if (regs[phi.dest] != NO_REGISTER && reg(phi.dest) != reg(phi.args[pred])) {
+			copies.push_back({ reg(phi.dest), reg(phi.args[pred]) });
+		}
+	}
+
+	while (!copies.empty()) {
+		bool progress = false;
+
+		for (size_t idx = 0; idx < copies.size(); idx++) {
+			uint16_t target = copies[idx].first;
+			bool read = false;
+
+			for (const auto &copy : copies) {
+				read = read || copy.second == target;
+			}
+
+			if (!read) {
+				put(OP_MOVE, position, target, copies[idx].second);
+				copies.erase(copies.begin() + idx);
+				progress = true;
+				break;
+			}
+		}
+
+		if (!progress) {
+			// Every target is still read: save one and read the saved copy instead
+			uint16_t target = copies[0].first;
+			put(OP_MOVE, position, scratch, target);
+
+			for (auto &copy : copies) {
+				if (copy.second == target) {
+					copy.second = scratch;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Moves the operands of an instruction into consecutive scratch registers.
+ * @param inst Instruction whose operands to move.
+ */
+void IrLowering::moveArgs(const IrInst &inst) {
+	uint32_t count = static_cast<uint32_t>(inst.args.size());
+	scratchSize = std::max(scratchSize, count);
+
+	for (uint32_t idx = 0; idx < count; idx++) {
+		put(OP_MOVE, inst.position, static_cast<uint16_t>(scratch + idx), reg(inst.args[idx]));
+	}
+}
+
+/**
+ * Appends an instruction to the lowered code.
+ * @param op Operation.
+ * @param position Source position.
+ * @param a First operand.
+ * @param b Second operand.
+ * @param c Third operand.
+ * @param type Type operand.
+ * @returns Index of the instruction.
+ */
+size_t IrLowering::put(Opcode op, const SourcePosition &position, uint16_t a, uint16_t b, uint16_t c, uint8_t type) {
+	out.code.push_back(Instr{ op, type, a, b, c });
+	out.positions.push_back(position);
+	return out.code.size() - 1;
+}
+
+/**
+ * Makes the last instruction a safepoint.
+ * @param refs Values holding live references.
+ * @param extraStart First register of a run of other registers holding references.
+ * @param extraCount Number of registers in the run.
+ */
+void IrLowering::addSafepoint(const std::vector<ValueId> &refs, uint16_t extraStart, uint16_t extraCount) {
+	out.safepoints.push_back(static_cast<uint32_t>(out.code.size() - 1));
+
+	for (ValueId value : refs) {
+		out.refRegs.push_back(reg(value));
+	}
+	for (uint16_t idx = 0; idx < extraCount; idx++) {
+		out.refRegs.push_back(static_cast<uint16_t>(extraStart + idx));
+	}
+
+	out.refStarts.push_back(static_cast<uint32_t>(out.refRegs.size()));
+}
+
+/**
+ * Returns the register of a value.
+ * @param value Value to look up.
+ * @returns Register in the frame.
+ */
+uint16_t IrLowering::reg(ValueId value) const {
+	uint32_t assigned = regs[value];
+	return static_cast<uint16_t>(((assigned & LOOP_FLAG) != 0) ? general + (assigned & ~LOOP_FLAG) : assigned);
+}
+
+} // namespace
+
+bool buildIr(const Module &module, const Function &func, IrFunction *ir) {
+	ir->source = &func;
+	IrBuilder builder(module, func, ir);
+	return builder.build();
+}
+
+bool lowerIr(IrFunction &ir, Function *func) {
+	IrLowering lowering(ir, func);
+	return lowering.lower();
+}
+
+// --------------- listing -------------------------------------
+
+std::string printIr(const Module &module, const IrFunction &ir) {
+	std::string out = customFormat("func %s (%zu params)\n", ir.source->name.c_str(), ir.params.size());
+
+	for (uint32_t block : ir.getOrder()) {
+		const IrBlock &current = ir.blocks[block];
+		appendFormat(&out, "  b%u:", block);
+
+		if (!current.preds.empty()) {
+			out += "  ; preds";
+			for (uint32_t pred : current.preds) {
+				appendFormat(&out, " b%u", pred);
+			}
+		}
+		out += "\n";
+
+		if (block == 0) {
+			for (ValueId param : ir.params) {
+				appendFormat(&out, "    v%u = PARAM\n", param);
+			}
+		}
+
+		for (const IrPhi &phi : current.phis) {
+			appendFormat(&out, "    v%u = PHI", phi.dest);
+			for (size_t idx = 0; idx < phi.args.size(); idx++) {
+				appendFormat(&out, "%s v%u", (idx == 0) ? "" : ",", phi.args[idx]);
+			}
+			out += "\n";
+		}
+
+		for (const IrInst &inst : current.insts) {
+			out += "    ";
+			if (inst.dest != NO_VALUE) {
+				appendFormat(&out, "v%u = ", inst.dest);
+			}
+			out += getOpcodeName(inst.op);
+
+			std::vector<std::string> operands;
+			for (ValueId arg : inst.args) {
+				operands.push_back(customFormat("v%u", arg));
+			}
+
+			switch (inst.op) {
+			case OP_LOADI:
+				operands.push_back(std::to_string(inst.imm));
+				break;
+			case OP_LOADK:
+				operands.push_back(customFormat("k%u", static_cast<uint32_t>(inst.imm)) + "  ; " +
+					printConstant(module.constants[static_cast<size_t>(inst.imm)]));
+				break;
+			case OP_CALL:
+				operands.insert(operands.begin(), module.funcs[static_cast<size_t>(inst.imm)].name);
+				break;
+			case OP_DIVP2_NUM:
+			case OP_MODP2_NUM:
+				operands.push_back(std::to_string(inst.imm));
+				break;
+			default:
+				break;
+			}
+
+			for (uint32_t succ : current.succs) {
+				if (&inst == &current.insts.back()) {
+					operands.push_back(customFormat("b%u", succ));
+				}
+			}
+
+			for (size_t idx = 0; idx < operands.size(); idx++) {
+				out += ((idx == 0) ? " " : ", ") + operands[idx];
+			}
+			out += "\n";
+		}
+	}
+
+	return out;
+}
@@ -0,0 +1,191 @@
+/**
+ * @file       ir.hpp
+ * @brief      Definitions for the SSA intermediate representation
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef IR_HPP
+#define IR_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "bytecode.hpp"
+
+/*
+ * The optimizer works on a control-flow graph of basic blocks in static single
+ * assignment form, lifted from the bytecode of a function and lowered back to it
+ * afterwards. Instructions keep their bytecode opcodes, but their operands are values
+ * rather than registers, so every value is defined exactly once and operands that take
+ * a run of registers (call arguments, array items, range bounds) are listed one by one.
+ */
+
+/** Index of a value in an `IrFunction` */
+using ValueId = uint32_t;
+
+/** Marks a missing value */
+constexpr ValueId NO_VALUE = UINT32_MAX;
+
+/** Opcode of an instruction that has been deleted but not yet removed from its block */
+constexpr Opcode IR_DELETED = OP_COUNT;
+
+/** Instruction in static single assignment form */
+struct IrInst {
+	Opcode op;
+
+	/** Packed type operand, as in the bytecode */
+	uint8_t type;
+
+	/** Value defined by the instruction, or `NO_VALUE` */
+	ValueId dest;
+
+	/** Immediate of LOADI, constant of LOADK, function of CALL or shift of DIVP2/MODP2 */
+	int64_t imm;
+
+	/** Operands, in the order of the registers they come from */
+	std::vector<ValueId> args;
+
+	/** Source position, for runtime errors */
+	SourcePosition position;
+};
+
+/** Value chosen by the predecessor control came from */
+struct IrPhi {
+	ValueId dest;
+
+	/** One operand per predecessor, in the order of `IrBlock::preds` */
+	std::vector<ValueId> args;
+};
+
+/** Basic block */
+struct IrBlock {
+	std::vector<IrPhi> phis;
+
+	/** Instructions, of which the last one (JMP, JMPF, FORITER, RET, RET0 or EXIT) ends the block */
+	std::vector<IrInst> insts;
+
+	/** Blocks that jump here */
+	std::vector<uint32_t> preds;
+
+	/**
+	 * Blocks jumped to: the target of JMP, the blocks for a true and a false condition
+	 * of JMPF, and the body and the exit of FORITER.
+	 */
+	std::vector<uint32_t> succs;
+};
+
+/** Function in static single assignment form */
+struct IrFunction {
+	/** Bytecode the function was lifted from */
+	const Function *source;
+
+	/** Basic blocks, starting with the entry block */
+	std::vector<IrBlock> blocks;
+
+	/** Values of the parameters, defined on entry */
+	std::vector<ValueId> params;
+
+	/** Whether each value holds a reference, which the collector must see */
+	std::vector<bool> refs;
+
+	/** Value that replaces each value, or `NO_VALUE` */
+	std::vector<ValueId> forwards;
+
+	/**
+	 * Creates a new value.
+	 * @param ref `true` if it holds a reference.
+	 * @returns Index of the value.
+	 */
+	ValueId newValue(bool ref);
+
+	/**
+	 * Follows the replacements of a value.
+	 * @param value Value to look up.
+	 * @returns Value that currently stands for it.
+	 */
+	ValueId resolve(ValueId value);
+
+	/**
+	 * Replaces every use of a value by another value. Uses are updated lazily, by
+	 * `resolveArgs` or by looking them up with `resolve`.
+	 * @param value Value to replace.
+	 * @param with Value to use instead.
+	 */
+	void replace(ValueId value, ValueId with);
+
+	/**
+	 * Applies pending replacements to every operand and drops deleted instructions.
+	 */
+	void resolveArgs();
+
+	/**
+	 * Orders the blocks that can be reached from the entry so that every block comes
+	 * before its successors, except along loop back edges. The first successor of a
+	 * block comes right after it where possible, which keeps fall-throughs.
+	 * @returns Indices of the reachable blocks in reverse postorder.
+	 */
+	std::vector<uint32_t> getOrder() const;
+
+	/**
+	 * Finds the immediate dominator of every block.
+	 * @param order Reachable blocks in reverse postorder (see `getOrder`).
+	 * @returns Immediate dominator of each block, the entry for the entry itself and
+	 *     `UINT32_MAX` for unreachable blocks.
+	 */
+	std::vector<uint32_t> getDominators(const std::vector<uint32_t> &order) const;
+
+	/**
+	 * Removes an edge of the graph together with the matching phi operands.
+	 * @param from Predecessor.
+	 * @param to Successor.
+	 */
+	void removeEdge(uint32_t from, uint32_t to);
+
+	/**
+	 * Inserts an empty block on an edge of the graph.
+	 * @param from Predecessor.
+	 * @param to Successor.
+	 * @returns Index of the new block.
+	 */
+	uint32_t splitEdge(uint32_t from, uint32_t to);
+
+	/**
+	 * Removes the blocks that can no longer be reached and the phis that choose
+	 * between identical values.
+	 */
+	void simplify();
+};
+
+/**
+ * Lifts the bytecode of a function into static single assignment form.
+ * @param module Module the function belongs to.
+ * @param func Function to lift.
+ * @param ir Function to fill in.
+ * @returns `true` on success, `false` if the bytecode does not have the shape the
+ *     compiler produces, in which case it should be left as it is.
+ */
+bool buildIr(const Module &module, const Function &func, IrFunction *ir);
+
+/**
+ * Lowers a function back to bytecode, allocating registers and rebuilding the stack
+ * maps of its safepoints.
+ * @param ir Function to lower.
+ * @param func Function whose code is replaced.
+ * @returns `true` on success, `false` if the function needs more registers than a
+ *     frame can hold, in which case `func` is left unchanged.
+ */
+bool lowerIr(IrFunction &ir, Function *func);
+
+/**
+ * Writes a readable listing of a function.
+ * @param module Module the function belongs to.
+ * @param ir Function to list.
+ * @returns Text of the listing.
+ */
+std::string printIr(const Module &module, const IrFunction &ir);
+
+#endif // IR_HPP
@@ -0,0 +1,523 @@
+/**
+ * @file       jit.cpp
+ * @brief      Implementation of the x86-64 just-in-time compiler
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <cstring>
+#include <initializer_list>
+#include "jit.hpp"
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+// --------------- executable memory ---------------------------
+
+JitCode::JitCode(const std::vector<uint8_t> &bytes, std::vector<uint32_t> offsets)
+	: size{ bytes.size() }, offsets{ std::move(offsets) } {
+#if DIUM_JIT
+	// Pages are written first and only then made executable, never both at once
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	size_t page = info.dwPageSize;
+#else
+	size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+	mapped = (size + page - 1) / page * page;
+
+#ifdef _WIN32
+	void *pages = VirtualAlloc(nullptr, mapped, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+	if (pages == nullptr) {
+		mapped = 0;
+		return;
+	}
+
+	DWORD old;
+	memcpy(pages, bytes.data(), size);
+	VirtualProtect(pages, mapped, PAGE_EXECUTE_READ, &old);
+	FlushInstructionCache(GetCurrentProcess(), pages, size);
+#else
+	void *pages = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (pages == MAP_FAILED) {
+		mapped = 0;
+		return;
+	}
+
+	memcpy(pages, bytes.data(), size);
+	if (mprotect(pages, mapped, PROT_READ | PROT_EXEC) != 0) {
+		munmap(pages, mapped);
+		mapped = 0;
+		return;
+	}
+#endif
+
+	memory = static_cast<uint8_t *>(pages);
+#endif
+}
+
+JitCode::~JitCode() {
+#if DIUM_JIT
+	if (memory != nullptr) {
+#ifdef _WIN32
+		VirtualFree(memory, 0, MEM_RELEASE);
+#else
+		munmap(memory, mapped);
+#endif
+	}
+#endif
+}
+
+// --------------- assembler -----------------------------------
+
+namespace {
+
+/* General-purpose registers, numbered as in their encoding */
+enum Reg : uint8_t {
+	RAX = 0,
+	RCX = 1,
+	RDX = 2,
+	RDI = 7,
+	R8 = 8,
+	R9 = 9,
+	R10 = 10,
+	R11 = 11
+};
+
+/* SSE registers */
+enum Xmm : uint8_t {
+	XMM0 = 0
+};
+
+/* Condition codes, added to the base opcode of `jcc` and `setcc` */
+enum Cond : uint8_t {
+	CC_AE = 0x3,
+	CC_E = 0x4,
+	CC_NE = 0x5,
+	CC_BE = 0x6,
+	CC_A = 0x7,
+	CC_P = 0xA,
+	CC_NP = 0xB,
+	CC_L = 0xC,
+	CC_GE = 0xD,
+	CC_LE = 0xE,
+	CC_G = 0xF
+};
+
+/*
+ * The generated code only uses registers that calls may clobber, so it needs no
+ * prologue and every instruction can serve as an entry point. The first argument
+ * (the frame's registers) arrives in RCX on Windows and in RDI elsewhere.
+ */
+#ifdef _WIN32
+constexpr Reg BASE = RCX;
+#else
+constexpr Reg BASE = RDI;
+#endif
+
+/**
+ * Encoder for the handful of x86-64 instructions the compiler needs. Memory operands
+ * are always a base register plus a displacement.
+ */
+class Assembler {
+public:
+	/** Encoded machine code */
+	std::vector<uint8_t> bytes;
+
+	void byte(uint8_t value) {
+		bytes.push_back(value);
+	}
+
+	void dword(uint32_t value) {
+		for (int shift = 0; shift < 32; shift += 8) {
+			bytes.push_back(static_cast<uint8_t>(value >> shift));
+		}
+	}
+
+	void qword(uint64_t value) {
+		dword(static_cast<uint32_t>(value));
+		dword(static_cast<uint32_t>(value >> 32));
+	}
+
+	/**
+	 * Encodes an instruction with a memory operand.
+	 * @param opcode Opcode bytes.
+	 * @param reg Register operand, or opcode extension.
+	 * @param base Base register of the memory operand (not RSP or R12).
+	 * @param disp Displacement of the memory operand.
+	 * @param wide `true` for a 64-bit operation.
+	 * @param prefix Mandatory prefix, or 0 for none.
+	 */
+	void mem(std::initializer_list<uint8_t> opcode, uint8_t reg, uint8_t base, int32_t disp, bool wide = true, uint8_t prefix = 0) {
+		if (prefix != 0) {
+			byte(prefix);
+		}
+		emitRex(wide, reg, base);
+		for (uint8_t op : opcode) {
+			byte(op);
+		}
+
+		if (disp >= -128 && disp <= 127) {
+			byte(static_cast<uint8_t>(0x40 | ((reg & 7) << 3) | (base & 7)));
+			byte(static_cast<uint8_t>(disp));
+		} else {
+			byte(static_cast<uint8_t>(0x80 | ((reg & 7) << 3) | (base & 7)));
+			dword(static_cast<uint32_t>(disp));
+		}
+	}
+
+	/**
+	 * Encodes an instruction with two register operands.
+	 * @param opcode Opcode bytes.
+	 * @param reg Register in the `reg` field, or opcode extension.
+	 * @param rm Register in the `r/m` field.
+	 * @param wide `true` for a 64-bit operation.
+	 */
+	void regs(std::initializer_list<uint8_t> opcode, uint8_t reg, uint8_t rm, bool wide = true) {
+		emitRex(wide, reg, rm);
+		for (uint8_t op : opcode) {
+			byte(op);
+		}
+		byte(static_cast<uint8_t>(0xC0 | ((reg & 7) << 3) | (rm & 7)));
+	}
+
+	/** mov reg, [BASE + 8 * slot] */
+	void load(uint8_t reg, uint16_t slot) {
+		mem({ 0x8B }, reg, BASE, slot * 8);
+	}
+
+	/** mov [BASE + 8 * slot], reg */
+	void store(uint16_t slot, uint8_t reg) {
+		mem({ 0x89 }, reg, BASE, slot * 8);
+	}
+
+	/** movsd xmm, [BASE + 8 * slot] */
+	void loadDec(uint8_t xmm, uint16_t slot) {
+		mem({ 0x0F, 0x10 }, xmm, BASE, slot * 8, false, 0xF2);
+	}
+
+	/** movsd [BASE + 8 * slot], xmm */
+	void storeDec(uint16_t slot, uint8_t xmm) {
+		mem({ 0x0F, 0x11 }, xmm, BASE, slot * 8, false, 0xF2);
+	}
+
+	/** mov reg, imm64 */
+	void move(uint8_t reg, uint64_t value) {
+		emitRex(true, 0, reg);
+		byte(static_cast<uint8_t>(0xB8 + (reg & 7)));
+		qword(value);
+	}
+
+	/** Stores the flag of a condition as 0 or 1 in a slot */
+	void storeCond(uint16_t slot, Cond cond) {
+		setcc(cond, RAX);
+		byte(0x0F);  // movzx eax, al
+		byte(0xB6);
+		byte(0xC0);
+		store(slot, RAX);
+	}
+
+	/** setcc reg8 (AL or DL only) */
+	void setcc(Cond cond, uint8_t reg) {
+		byte(0x0F);
+		byte(static_cast<uint8_t>(0x90 + cond));
+		byte(static_cast<uint8_t>(0xC0 | reg));
+	}
+
+	/**
+	 * Emits a jump with a 32-bit displacement to be patched later.
+	 * @param cond Condition, or -1 for an unconditional jump.
+	 * @returns Position of the displacement.
+	 */
+	size_t jump(int cond) {
+		if (cond < 0) {
+			byte(0xE9);
+		} else {
+			byte(0x0F);
+			byte(static_cast<uint8_t>(0x80 + cond));
+		}
+
+		size_t at = bytes.size();
+		dword(0);
+		return at;
+	}
+
+	/**
+	 * Points a jump at a position in the code.
+	 * @param at Position of the jump's displacement.
+	 * @param target Position to jump to.
+	 */
+	void patch(size_t at, size_t target) {
+		uint32_t rel = static_cast<uint32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(at + 4));
+		memcpy(bytes.data() + at, &rel, sizeof(rel));
+	}
+
+	/** Returns to the interpreter, which continues at an instruction */
+	void exit(uint32_t idx) {
+		byte(0xB8);  // mov eax, idx
+		dword(idx);
+		byte(0xC3);  // ret
+	}
+
+private:
+	void emitRex(bool wide, uint8_t reg, uint8_t rm) {
+		uint8_t rex = static_cast<uint8_t>(0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((rm & 8) ? 1 : 0));
+		if (rex != 0x40) {
+			byte(rex);
+		}
+	}
+};
+
+} // namespace
+
+// --------------- compiler ------------------------------------
+
+const JitCode *Jit::compile(const Function &func, const std::vector<Value> &constants) {
+	if (!isSupported()) {
+		return nullptr;
+	}
+
+	Assembler as;
+	std::vector<uint32_t> offsets(func.code.size());
+
+	/* Jumps to other instructions, patched once every instruction has an offset */
+	std::vector<std::pair<size_t, uint32_t>> jumps;
+
+	for (uint32_t idx = 0; idx < func.code.size(); idx++) {
+		const Instr &instr = func.code[idx];
+		offsets[idx] = static_cast<uint32_t>(as.bytes.size());
+
+		switch (instr.op) {
+		case OP_MOVE:
+			as.load(RAX, instr.b);
+			as.store(instr.a, RAX);
+			break;
+		case OP_LOADI:
+			// mov qword [slot], imm32 (sign-extended)
+			as.mem({ 0xC7 }, 0, BASE, instr.a * 8);
+			as.dword(getWide(instr));
+			break;
+		case OP_LOADK:
+			// Constants never move or die, so their bits are baked into the code
+			as.move(RAX, static_cast<uint64_t>(constants[getWide(instr)].num));
+			as.store(instr.a, RAX);
+			break;
+		case OP_ADD_NUM:
+		case OP_SUB_NUM:
+		case OP_MUL_NUM: {
+			as.load(RAX, instr.b);
+			if (instr.op == OP_ADD_NUM) {
+				as.mem({ 0x03 }, RAX, BASE, instr.c * 8);
+			} else if (instr.op == OP_SUB_NUM) {
+				as.mem({ 0x2B }, RAX, BASE, instr.c * 8);
+			} else {
+				as.mem({ 0x0F, 0xAF }, RAX, BASE, instr.c * 8);
+			}
+			as.store(instr.a, RAX);
+			break;
+		}
+		case OP_DIV_NUM:
+		case OP_MOD_NUM: {
+			// Divisors that are not positive are left to the interpreter's slow path
+			as.load(R8, instr.c);
+			as.regs({ 0x85 }, R8, R8);
+			size_t fast = as.jump(CC_G);
+			as.exit(idx);
+			as.patch(fast, as.bytes.size());
+
+			as.load(RAX, instr.b);
+			as.byte(0x48);  // cqo
+			as.byte(0x99);
+			as.regs({ 0xF7 }, 7, R8);  // idiv r8
+			as.store(instr.a, (instr.op == OP_DIV_NUM) ? RAX : RDX);
+			break;
+		}
+		case OP_DIVP2_NUM:
+		case OP_MODP2_NUM:
+			// bias = (x < 0) ? 2^C - 1 : 0, so that the shift rounds towards zero
+			as.load(RAX, instr.b);
+			as.regs({ 0x89 }, RAX, RDX);  // mov rdx, rax
+			as.regs({ 0xC1 }, 7, RDX);    // sar rdx, 63
+			as.byte(63);
+			as.regs({ 0xC1 }, 5, RDX);    // shr rdx, 64 - C
+			as.byte(static_cast<uint8_t>(64 - instr.c));
+			as.regs({ 0x01 }, RAX, RDX);  // add rdx, rax
+			as.regs({ 0xC1 }, 7, RDX);    // sar rdx, C
+			as.byte(static_cast<uint8_t>(instr.c));
+			if (instr.op == OP_DIVP2_NUM) {
+				as.store(instr.a, RDX);
+			} else {
+				// x % 2^C = x - (x / 2^C) * 2^C
+				as.regs({ 0xC1 }, 4, RDX);    // shl rdx, C
+				as.byte(static_cast<uint8_t>(instr.c));
+				as.regs({ 0x29 }, RDX, RAX);  // sub rax, rdx
+				as.store(instr.a, RAX);
+			}
+			break;
+		case OP_NEG_NUM:
+			as.load(RAX, instr.b);
+			as.regs({ 0xF7 }, 3, RAX);  // neg rax
+			as.store(instr.a, RAX);
+			break;
+		case OP_ADD_DEC:
+		case OP_SUB_DEC:
+		case OP_MUL_DEC:
+		case OP_DIV_DEC: {
+			static const uint8_t sse[] = { 0x58, 0x5C, 0x59, 0x5E };
+			as.loadDec(XMM0, instr.b);
+			as.mem({ 0x0F, sse[instr.op - OP_ADD_DEC] }, XMM0, BASE, instr.c * 8, false, 0xF2);
+			as.storeDec(instr.a, XMM0);
+			break;
+		}
+		case OP_NEG_DEC:
+			// Flip the sign bit
+			as.load(RAX, instr.b);
+			as.move(RDX, 0x8000000000000000ull);
+			as.regs({ 0x31 }, RDX, RAX);  // xor rax, rdx
+			as.store(instr.a, RAX);
+			break;
+		case OP_NOT:
+		case OP_NUM2BOOL:
+			// cmp qword [slot], 0
+			as.mem({ 0x83 }, 7, BASE, instr.b * 8);
+			as.byte(0);
+			as.storeCond(instr.a, (instr.op == OP_NOT) ? CC_E : CC_NE);
+			break;
+		case OP_EQ_NUM:
+		case OP_NE_NUM:
+		case OP_LT_NUM:
+		case OP_LE_NUM:
+		case OP_EQ_REF:
+		case OP_NE_REF: {
+			static const Cond conds[] = { CC_E, CC_NE, CC_L, CC_LE };
+			Cond cond = (instr.op >= OP_EQ_REF) ? conds[instr.op - OP_EQ_REF] : conds[instr.op - OP_EQ_NUM];
+
+			as.load(RAX, instr.b);
+			as.mem({ 0x3B }, RAX, BASE, instr.c * 8);
+			as.storeCond(instr.a, cond);
+			break;
+		}
+		case OP_EQ_DEC:
+		case OP_NE_DEC:
+			// Unordered operands (NaN) set the parity flag and are never equal
+			as.loadDec(XMM0, instr.b);
+			as.mem({ 0x0F, 0x2E }, XMM0, BASE, instr.c * 8, false, 0x66);  // ucomisd
+			if (instr.op == OP_EQ_DEC) {
+				as.setcc(CC_E, RAX);
+				as.setcc(CC_NP, RDX);
+				as.byte(0x20);  // and al, dl
+			} else {
+				as.setcc(CC_NE, RAX);
+				as.setcc(CC_P, RDX);
+				as.byte(0x08);  // or al, dl
+			}
+			as.byte(0xD0);
+			as.byte(0x0F);  // movzx eax, al
+			as.byte(0xB6);
+			as.byte(0xC0);
+			as.store(instr.a, RAX);
+			break;
+		case OP_LT_DEC:
+		case OP_LE_DEC:
+			// Compared the other way around, "above" is false for unordered operands
+			as.loadDec(XMM0, instr.c);
+			as.mem({ 0x0F, 0x2E }, XMM0, BASE, instr.b * 8, false, 0x66);
+			as.storeCond(instr.a, (instr.op == OP_LT_DEC) ? CC_A : CC_AE);
+			break;
+		case OP_NUM2DEC:
+			// cvtsi2sd xmm0, qword [slot]
+			as.mem({ 0x0F, 0x2A }, XMM0, BASE, instr.b * 8, true, 0xF2);
+			as.storeDec(instr.a, XMM0);
+			break;
+		case OP_JMP:
+			jumps.emplace_back(as.jump(-1), getWide(instr));
+			break;
+		case OP_JMPF:
+		case OP_JMPT:
+			as.mem({ 0x83 }, 7, BASE, instr.a * 8);
+			as.byte(0);
+			jumps.emplace_back(as.jump((instr.op == OP_JMPF) ? CC_E : CC_NE), getWide(instr));
+			break;
+		case OP_RANGE: {
+			// Same count as the interpreter, which also reports a step of 0:
+			// (|stop - start| - 1) / |step| + 1 when the range is not empty
+			as.load(RAX, instr.b);
+			as.load(R8, instr.b + 1);
+			as.load(R9, instr.b + 2);
+			as.regs({ 0x85 }, R9, R9);
+			size_t up = as.jump(CC_G);
+			size_t down = as.jump(CC_L);
+			as.exit(idx);
+
+			as.patch(up, as.bytes.size());
+			as.regs({ 0x39 }, R8, RAX);  // cmp rax, r8
+			size_t emptyUp = as.jump(CC_GE);
+			as.regs({ 0x89 }, R8, R10);  // left = stop - start
+			as.regs({ 0x29 }, RAX, R10);
+			as.regs({ 0x89 }, R9, R11);  // |step| = step
+			size_t divide = as.jump(-1);
+
+			as.patch(down, as.bytes.size());
+			as.regs({ 0x39 }, R8, RAX);
+			size_t emptyDown = as.jump(CC_LE);
+			as.regs({ 0x89 }, RAX, R10);  // left = start - stop
+			as.regs({ 0x29 }, R8, R10);
+			as.regs({ 0x89 }, R9, R11);  // |step| = -step
+			as.regs({ 0xF7 }, 3, R11);
+
+			as.patch(divide, as.bytes.size());
+			as.regs({ 0x89 }, RAX, R8);   // r8 = start
+			as.regs({ 0x89 }, R10, RAX);  // count = (left - 1) / |step| + 1
+			as.regs({ 0xFF }, 1, RAX);    // dec rax
+			as.regs({ 0x31 }, RDX, RDX, false);
+			as.regs({ 0xF7 }, 6, R11);    // div r11
+			as.regs({ 0xFF }, 0, RAX);    // inc rax
+			size_t done = as.jump(-1);
+
+			as.patch(emptyUp, as.bytes.size());
+			as.patch(emptyDown, as.bytes.size());
+			as.regs({ 0x89 }, RAX, R8);  // r8 = start
+			as.regs({ 0x31 }, RAX, RAX, false);
+
+			as.patch(done, as.bytes.size());
+			as.store(instr.a, RAX);
+			as.store(instr.a + 1, R8);
+			as.store(instr.a + 2, R9);
+			break;
+		}
+		case OP_FORITER:
+			// cmp qword [count], 0
+			as.mem({ 0x83 }, 7, BASE, instr.a * 8);
+			as.byte(0);
+			jumps.emplace_back(as.jump(CC_E), getWide(instr));
+			as.mem({ 0xFF }, 1, BASE, instr.a * 8);  // dec qword [count]
+			as.load(RAX, instr.a + 1);
+			as.store(instr.a + 3, RAX);
+			as.mem({ 0x03 }, RAX, BASE, (instr.a + 2) * 8);  // next += step
+			as.store(instr.a + 1, RAX);
+			break;
+		default:
+			// Calls, returns, allocations, printing and checked conversions
+			as.exit(idx);
+			break;
+		}
+	}
+
+	for (const auto &jump : jumps) {
+		as.patch(jump.first, offsets[jump.second]);
+	}
+
+	auto code = std::make_unique<JitCode>(as.bytes, std::move(offsets));
+	if (!code->isMapped()) {
+		return nullptr;
+	}
+
+	compiled.push_back(std::move(code));
+	return compiled.back().get();
+}
@@ -0,0 +1,147 @@
+/**
+ * @file       jit.hpp
+ * @brief      Definitions for the x86-64 just-in-time compiler
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef JIT_HPP
+#define JIT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "bytecode.hpp"
+#include "value.hpp"
+
+/*
+ * Machine code is only generated for x86-64. Elsewhere, or when DIUM_NO_JIT is
+ * defined, every function stays in the interpreter.
+ */
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(DIUM_NO_JIT)
+	#define DIUM_JIT 1
+#else
+	#define DIUM_JIT 0
+#endif
+
+/** Number of calls after which a function is compiled to machine code */
+#define JIT_CALL_THRESHOLD 1000
+
+/** Number of loop iterations after which a function is compiled to machine code */
+#define JIT_LOOP_THRESHOLD 1000
+
+/** When functions are compiled to machine code */
+enum JitMode {
+	JIT_OFF,    /* always interpret */
+	JIT_ON,     /* compile functions once they are called or loop often enough */
+	JIT_EAGER   /* compile every function before running */
+};
+
+/**
+ * Machine code of one function. The code works directly on the registers of the
+ * frame and keeps nothing in machine registers between instructions, so it can be
+ * entered at any instruction. Instructions it does not handle (calls, returns,
+ * allocations, printing and rare slow paths) return to the interpreter instead.
+ */
+class JitCode {
+public:
+	/**
+	 * Maps machine code for a function.
+	 * @param bytes Machine code.
+	 * @param offsets Offset of the machine code of each instruction.
+	 */
+	JitCode(const std::vector<uint8_t> &bytes, std::vector<uint32_t> offsets);
+
+	/**
+	 * Unmaps the machine code.
+	 */
+	~JitCode();
+
+	JitCode(const JitCode &) = delete;
+	JitCode &operator=(const JitCode &) = delete;
+
+	/**
+	 * Runs the machine code until it reaches an instruction it leaves to the
+	 * interpreter.
+	 * @param registers First register of the frame.
+	 * @param idx Instruction to start at.
+	 * @returns Instruction for the interpreter to continue at.
+	 */
+	uint32_t enter(Value *registers, uint32_t idx) const {
+		return reinterpret_cast<Entry>(memory + offsets[idx])(registers);
+	}
+
+	/**
+	 * Checks whether the code could be mapped into executable memory.
+	 * @returns `true` if the code can be entered.
+	 */
+	bool isMapped() const {
+		return memory != nullptr;
+	}
+
+	/**
+	 * Returns the size of the machine code.
+	 * @returns Number of bytes.
+	 */
+	size_t getSize() const {
+		return size;
+	}
+
+private:
+	/* Signature of every instruction's machine code */
+	using Entry = uint32_t (*)(Value *registers);
+
+	/** Executable memory holding the code */
+	uint8_t *memory = nullptr;
+
+	/** Number of bytes of code */
+	size_t size = 0;
+
+	/** Number of bytes mapped */
+	size_t mapped = 0;
+
+	/** Offset of the machine code of each instruction */
+	std::vector<uint32_t> offsets;
+};
+
+/**
+ * Compiles functions to x86-64 machine code and owns the result. Since every
+ * register has a static type, numbers and decimals are handled unboxed with plain
+ * integer and SSE2 instructions.
+ */
+class Jit {
+public:
+	/**
+	 * Checks whether machine code can be generated on this platform.
+	 * @returns `true` if `compile` can succeed.
+	 */
+	static bool isSupported() {
+		return DIUM_JIT;
+	}
+
+	/**
+	 * Compiles a function.
+	 * @param func Function to compile.
+	 * @param constants Values of the constants of the module, which must not move.
+	 * @returns Machine code, owned by the compiler, or `nullptr` if it could not be made.
+	 */
+	const JitCode *compile(const Function &func, const std::vector<Value> &constants);
+
+	/**
+	 * Returns the number of functions compiled so far.
+	 * @returns Number of compiled functions.
+	 */
+	size_t getCompiledCount() const {
+		return compiled.size();
+	}
+
+private:
+	/** Machine code of every compiled function */
+	std::vector<std::unique_ptr<JitCode>> compiled;
+};
+
+#endif // JIT_HPP
@@ -0,0 +1,375 @@
+/**
+ * @file       json.cpp
+ * @brief      Implementation of reading and writing JSON
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <charconv>
+#include <cmath>
+#include "format.hpp"
+#include "json.hpp"
+
+/* Reads a JSON document from a string */
+struct JsonReader {
+	const char *cursor;
+	const char *end;
+};
+
+// --------------- function prototypes -------------------------
+
+static void skipWhitespace(JsonReader *reader);
+static bool readValue(JsonReader *reader, JsonValue *value, int depth);
+static bool readString(JsonReader *reader, std::string *out);
+static bool readNumber(JsonReader *reader, double *out);
+static bool readWord(JsonReader *reader, const char *word);
+static void appendUtf8(std::string *out, uint32_t code);
+
+
+const JsonValue &JsonValue::operator[](std::string_view key) const {
+	static const JsonValue none;
+
+	for (const auto &member : members) {
+		if (member.first == key) {
+			return member.second;
+		}
+	}
+	return none;
+}
+
+const JsonValue &JsonValue::operator[](size_t idx) const {
+	static const JsonValue none;
+	return (idx < items.size()) ? items[idx] : none;
+}
+
+bool parseJson(std::string_view text, JsonValue *value) {
+	JsonReader reader{ text.data(), text.data() + text.size() };
+
+	*value = JsonValue{};
+	if (!readValue(&reader, value, 0)) {
+		return false;
+	}
+
+	skipWhitespace(&reader);
+	return reader.cursor == reader.end;
+}
+
+void appendJson(std::string *out, const JsonValue &value) {
+	switch (value.type) {
+	case JSON_NULL:
+		*out += "null";
+		break;
+	case JSON_BOOL:
+		*out += value.boolean ? "true" : "false";
+		break;
+	case JSON_NUMBER:
+		// Request ids and positions are integers, which print without a fraction
+		if (std::floor(value.number) == value.number && std::fabs(value.number) < 1e15) {
+			appendFormat(out, "%lld", static_cast<long long>(value.number));
+		} else {
+			appendFormat(out, "%.17g", value.number);
+		}
+		break;
+	case JSON_STRING:
+		appendJsonString(out, value.string);
+		break;
+	case JSON_ARRAY:
+		*out += '[';
+		for (size_t idx = 0; idx < value.items.size(); idx++) {
+			if (idx > 0) {
+				*out += ',';
+			}
+			appendJson(out, value.items[idx]);
+		}
+		*out += ']';
+		break;
+	case JSON_OBJECT:
+		*out += '{';
+		for (size_t idx = 0; idx < value.members.size(); idx++) {
+			if (idx > 0) {
+				*out += ',';
+			}
+			appendJsonString(out, value.members[idx].first);
+			*out += ':';
+			appendJson(out, value.members[idx].second);
+		}
+		*out += '}';
+		break;
+	}
+}
+
+void appendJsonString(std::string *out, std::string_view text) {
+	*out += '"';
+
+	for (char c : text) {
+		switch (c) {
+		case '"':
+			*out += "\\\"";
+			break;
+		case '\\':
+			*out += "\\\\";
+			break;
+		case '\n':
+			*out += "\\n";
+			break;
+		case '\r':
+			*out += "\\r";
+			break;
+		case '\t':
+			*out += "\\t";
+			break;
+		default:
+			if (static_cast<unsigned char>(c) < 32) {
+				appendFormat(out, "\\u%04x", static_cast<unsigned int>(c));
+			} else {
+				*out += c;
+			}
+			break;
+		}
+	}
+
+	*out += '"';
+}
+
+/**
+ * Skips whitespace between tokens.
+ * @param reader Reader to move.
+ */
+static void skipWhitespace(JsonReader *reader) {
+	while (reader->cursor < reader->end && (*reader->cursor == ' ' || *reader->cursor == '\t' || *reader->cursor == '\n' || *reader->cursor == '\r')) {
+		reader->cursor++;
+	}
+}
+
+/**
+ * Reads any value.
+ * @param reader Reader to read from.
+ * @param[out] value Value read.
+ * @param depth Number of arrays and objects the value is nested in.
+ * @returns `true` if a valid value was read.
+ */
+static bool readValue(JsonReader *reader, JsonValue *value, int depth) {
+	skipWhitespace(reader);
+	if (reader->cursor == reader->end || depth > JSON_MAX_DEPTH) {
+		return false;
+	}
+
+	switch (*reader->cursor) {
+	case 'n':
+		value->type = JSON_NULL;
+		return readWord(reader, "null");
+	case 't':
+		value->type = JSON_BOOL;
+		value->boolean = true;
+		return readWord(reader, "true");
+	case 'f':
+		value->type = JSON_BOOL;
+		value->boolean = false;
+		return readWord(reader, "false");
+	case '"':
+		value->type = JSON_STRING;
+		return readString(reader, &value->string);
+	case '[':
+		value->type = JSON_ARRAY;
+		reader->cursor++;
+		skipWhitespace(reader);
+
+		if (reader->cursor < reader->end && *reader->cursor == ']') {
+			reader->cursor++;
+			return true;
+		}
+
+		while (true) {
+			value->items.emplace_back();
+			if (!readValue(reader, &value->items.back(), depth + 1)) {
+				return false;
+			}
+
+			skipWhitespace(reader);
+			if (reader->cursor == reader->end) {
+				return false;
+			}
+			if (*reader->cursor == ']') {
+				reader->cursor++;
+				return true;
+			}
+			if (*reader->cursor++ != ',') {
+				return false;
+			}
+		}
+	case '{':
+		value->type = JSON_OBJECT;
+		reader->cursor++;
+		skipWhitespace(reader);
+
+		if (reader->cursor < reader->end && *reader->cursor == '}') {
+			reader->cursor++;
+			return true;
+		}
+
+		while (true) {
+			value->members.emplace_back();
+			auto &member = value->members.back();
+
+			skipWhitespace(reader);
+			if (reader->cursor == reader->end || *reader->cursor != '"' || !readString(reader, &member.first)) {
+				return false;
+			}
+
+			skipWhitespace(reader);
+			if (reader->cursor == reader->end || *reader->cursor++ != ':') {
+				return false;
+			}
+			if (!readValue(reader, &member.second, depth + 1)) {
+				return false;
+			}
+
+			skipWhitespace(reader);
+			if (reader->cursor == reader->end) {
+				return false;
+			}
+			if (*reader->cursor == '}') {
+				reader->cursor++;
+				return true;
+			}
+			if (*reader->cursor++ != ',') {
+				return false;
+			}
+		}
+	default:
+		value->type = JSON_NUMBER;
+		return readNumber(reader, &value->number);
+	}
+}
+
+/**
+ * Reads a string, replacing escape codes by the characters they represent.
+ * @param reader Reader positioned at the opening quote.
+ * @param[out] out Contents of the string, encoded as UTF-8.
+ * @returns `true` if a valid string was read.
+ */
+static bool readString(JsonReader *reader, std::string *out) {
+	reader->cursor++;
+
+	while (reader->cursor < reader->end) {
+		// Copy everything up to the next quote or escape code in one go
+		const char *start = reader->cursor;
+		while (reader->cursor < reader->end && *reader->cursor != '"' && *reader->cursor != '\\') {
+			reader->cursor++;
+		}
+		out->append(start, static_cast<size_t>(reader->cursor - start));
+
+		if (reader->cursor == reader->end) {
+			return false;
+		}
+		if (*reader->cursor++ == '"') {
+			return true;
+		}
+		if (reader->cursor == reader->end) {
+			return false;
+		}
+
+		char escape = *reader->cursor++;
+		switch (escape) {
+		case '"':
+		case '\\':
+		case '/':
+			*out += escape;
+			break;
+		case 'b':
+			*out += '\b';
+			break;
+		case 'f':
+			*out += '\f';
+			break;
+		case 'n':
+			*out += '\n';
+			break;
+		case 'r':
+			*out += '\r';
+			break;
+		case 't':
+			*out += '\t';
+			break;
+		case 'u': {
+			uint32_t code = 0;
+			if (reader->end - reader->cursor < 4 || std::from_chars(reader->cursor, reader->cursor + 4, code, 16).ptr != reader->cursor + 4) {
+				return false;
+			}
+			reader->cursor += 4;
+
+			// A high surrogate is followed by the low one of the same character
+			uint32_t low = 0;
+			if (code >= 0xD800 && code < 0xDC00 && reader->end - reader->cursor >= 6 && reader->cursor[0] == '\\'
+				&& reader->cursor[1] == 'u' && std::from_chars(reader->cursor + 2, reader->cursor + 6, low, 16).ptr == reader->cursor + 6
+				&& low >= 0xDC00 && low < 0xE000) {
+				code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+				reader->cursor += 6;
+			}
+			appendUtf8(out, code);
+			break;
+		}
+		default:
+			return false;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Reads a number.
+ * @param reader Reader positioned at the first character of the number.
+ * @param[out] out Value of the number.
+ * @returns `true` if a valid number was read.
+ */
+static bool readNumber(JsonReader *reader, double *out) {
+	auto result = std::from_chars(reader->cursor, reader->end, *out);
+	if (result.ec != std::errc() || result.ptr == reader->cursor) {
+		return false;
+	}
+
+	reader->cursor = result.ptr;
+	return true;
+}
+
+/**
+ * Reads one of the words `null`, `true` and `false`.
+ * @param reader Reader positioned at the first character of the word.
+ * @param word Word to read.
+ * @returns `true` if the word is there.
+ */
+static bool readWord(JsonReader *reader, const char *word) {
+	std::string_view expected(word);
+
+	if (static_cast<size_t>(reader->end - reader->cursor) < expected.size() || std::string_view(reader->cursor, expected.size()) != expected) {
+		return false;
+	}
+
+	reader->cursor += expected.size();
+	return true;
+}
+
+/**
+ * Appends a character encoded as UTF-8.
+ * @param out String to append to.
+ * @param code Code point of the character.
+ */
+static void appendUtf8(std::string *out, uint32_t code) {
+	if (code < 0x80) {
+		*out += static_cast<char>(code);
+	} else if (code < 0x800) {
+		*out += static_cast<char>(0xC0 | (code >> 6));
+		*out += static_cast<char>(0x80 | (code & 0x3F));
+	} else if (code < 0x10000) {
+		*out += static_cast<char>(0xE0 | (code >> 12));
+		*out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+		*out += static_cast<char>(0x80 | (code & 0x3F));
+	} else {
+		*out += static_cast<char>(0xF0 | (code >> 18));
+		*out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+		*out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+		*out += static_cast<char>(0x80 | (code & 0x3F));
+	}
+}
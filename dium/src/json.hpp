@@ -0,0 +1,110 @@
+/**
+ * @file       json.hpp
+ * @brief      Definitions for reading and writing JSON
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/** Arrays and objects nested deeper than this are rejected, to bound the recursion */
+#define JSON_MAX_DEPTH 256
+
+/** Types of JSON values */
+enum JsonType : uint8_t {
+	JSON_NULL,
+	JSON_BOOL,
+	JSON_NUMBER,
+	JSON_STRING,
+	JSON_ARRAY,
+	JSON_OBJECT
+};
+
+/**
+ * Parsed JSON value. Looking up a missing member or item gives a `null` value instead
+ * of failing, so that optional fields of a message can be read without checks.
+ */
+struct JsonValue {
+	JsonType type = JSON_NULL;
+
+	/** Value (for booleans) */
+	bool boolean = false;
+
+	/** Value (for numbers) */
+	double number = 0.0;
+
+	/** Value (for strings) */
+	std::string string;
+
+	/** Items (for arrays) */
+	std::vector<JsonValue> items;
+
+	/** Members in the order they were written (for objects) */
+	std::vector<std::pair<std::string, JsonValue>> members;
+
+	/**
+	 * Finds a member of an object.
+	 * @param key Name of the member.
+	 * @returns Value of the member, or `null` if there is none.
+	 */
+	const JsonValue &operator[](std::string_view key) const;
+
+	/**
+	 * Returns an item of an array.
+	 * @param idx Index of the item.
+	 * @returns Item, or `null` past the end.
+	 */
+	const JsonValue &operator[](size_t idx) const;
+
+	/**
+	 * Checks if the value is not `null`.
+	 * @returns `true` if the value is present.
+	 */
+	bool exists() const {
+		return type != JSON_NULL;
+	}
+
+	/**
+	 * Returns the value as an integer.
+	 * @param fallback Value to return if it is not a number.
+	 * @returns Integer value.
+	 */
+	int64_t asInt(int64_t fallback = 0) const {
+		return (type == JSON_NUMBER) ? static_cast<int64_t>(number) : fallback;
+	}
+};
+
+/**
+ * Parses a JSON document.
+ * @param text Text of the document.
+ * @param[out] value Parsed value.
+ * @returns `true` if the whole text is a valid JSON value, `false` otherwise.
+ */
+bool parseJson(std::string_view text, JsonValue *value);
+
+/**
+ * Appends a value as JSON text, without spaces.
+ * @param out String to append to.
+ * @param value Value to write.
+ */
+void appendJson(std::string *out, const JsonValue &value);
+
+/**
+ * Appends a string as a quoted JSON string.
+ * @param out String to append to.
+ * @param text Text to quote.
+ */
+void appendJsonString(std::string *out, std::string_view text);
+
+#endif // JSON_HPP
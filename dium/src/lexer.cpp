@@ -7,81 +7,197 @@
  */
 
 #include <cctype>
+#include <charconv>
+#include <climits>
+#include <cstring>
 #include "error.hpp"
 #include "lexer.hpp"
+#include "scan.hpp"
+#include "stats.hpp"
 
 /* Single reserved word */
 struct ReservedWord {
-	std::string word;  /* Actual word */
-	TokenType   type;  /* Token type */
+	const char *word;    /* Actual word */
+	size_t      length;  /* Number of characters in the word */
+	TokenType   type;    /* Token type */
 };
 
 /* List of reserved words */
-static ReservedWord reservedWords[] = {
-	{ "and",      TOK_AND },
-	{ "bool",     TOK_BOOL },
-	{ "break",    TOK_BREAK },
-	{ "char",     TOK_CHAR },
-	{ "continue", TOK_CONTINUE },
-	{ "dec",      TOK_DEC },
-	{ "else",     TOK_ELSE },
-	{ "elsif",    TOK_ELSIF },
-	{ "exit",     TOK_EXIT },
-	{ "false",    TOK_FALSE },
-	{ "for",      TOK_FOR },
-	{ "func",     TOK_FUNC },
-	{ "if",       TOK_IF },
-	{ "in",       TOK_IN },
-	{ "num",      TOK_NUM },
-	{ "or",       TOK_OR },
-	{ "print",    TOK_PRINT },
-	{ "println",  TOK_PRINTLN },
-	{ "range",    TOK_RANGE },
-	{ "return",   TOK_RETURN },
-	{ "string",   TOK_STR },
-	{ "true",     TOK_TRUE },
-	{ "void",     TOK_VOID },
-	{ "while",    TOK_WHILE }
+static constexpr ReservedWord reservedWords[] = {
+	{ "and",      3, TOK_AND },
+	{ "bool",     4, TOK_BOOL },
+	{ "break",    5, TOK_BREAK },
+	{ "char",     4, TOK_CHAR },
+	{ "continue", 8, TOK_CONTINUE },
+	{ "dec",      3, TOK_DEC },
+	{ "else",     4, TOK_ELSE },
+	{ "elsif",    5, TOK_ELSIF },
+	{ "exit",     4, TOK_EXIT },
+	{ "false",    5, TOK_FALSE },
+	{ "for",      3, TOK_FOR },
+	{ "func",     4, TOK_FUNC },
+	{ "if",       2, TOK_IF },
+	{ "in",       2, TOK_IN },
+	{ "num",      3, TOK_NUM },
+	{ "or",       2, TOK_OR },
+	{ "print",    5, TOK_PRINT },
+	{ "println",  7, TOK_PRINTLN },
+	{ "range",    5, TOK_RANGE },
+	{ "return",   6, TOK_RETURN },
+	{ "string",   6, TOK_STR },
+	{ "true",     4, TOK_TRUE },
+	{ "void",     4, TOK_VOID },
+	{ "while",    5, TOK_WHILE }
 };
 
 #define NUM_RESERVED_WORDS (sizeof(reservedWords) / sizeof(ReservedWord))
 
-// --------------- function prototypes -------------------------
+/* Shortest and longest reserved words */
+#define MIN_RESERVED_LENGTH 2
+#define MAX_RESERVED_LENGTH 8
 
-static void resetToken(Token *token);
-static void processWord(Token *token);
-static void processNumber(Token *token);
-static void processString(Token *token);
-static void processCharacter(Token *token);
-static void skipComment(bool single);
+/* Number of slots in the reserved word hash table (must be a power of 2) */
+#define RESERVED_TABLE_BITS 6
+#define RESERVED_TABLE_SIZE (1 << RESERVED_TABLE_BITS)
 
-/* Source file */
-static std::ifstream srcFile;
+/* Multiplier that makes `hashWord()` collision-free over the reserved words */
+#define RESERVED_SEED 51177u
 
-/* Current character in the source file */
-static char currChar;
+/**
+ * Hashes a word from its first two characters, last character and length. Only
+ * defined for words of at least `MIN_RESERVED_LENGTH` characters.
+ * @param word Word to hash.
+ * @param length Number of characters in the word.
+ * @returns Slot in the reserved word hash table.
+ */
+static constexpr uint32_t hashWord(const char *word, size_t length) {
+	uint32_t key = static_cast<uint32_t>(static_cast<uint8_t>(word[0]))
+		| static_cast<uint32_t>(static_cast<uint8_t>(word[1])) << 8
+		| static_cast<uint32_t>(static_cast<uint8_t>(word[length - 1])) << 16
+		| static_cast<uint32_t>(length) << 24;
+
+	return (key * RESERVED_SEED) >> (32 - RESERVED_TABLE_BITS);
+}
+
+/* Hash table of reserved words, built at compile time */
+struct ReservedTable {
+	/** Index into `reservedWords` for each slot, or -1 when empty */
+	int8_t slots[RESERVED_TABLE_SIZE];
+
+	/** `true` if no two reserved words share a slot */
+	bool perfect;
+};
+
+/**
+ * Builds the reserved word hash table.
+ * @returns Table mapping each hash slot to a reserved word.
+ */
+static constexpr ReservedTable buildReservedTable() {
+	ReservedTable table{};
+	table.perfect = true;
+
+	for (int idx = 0; idx < RESERVED_TABLE_SIZE; idx++) {
+		table.slots[idx] = -1;
+	}
+
+	for (size_t idx = 0; idx < NUM_RESERVED_WORDS; idx++) {
+		uint32_t slot = hashWord(reservedWords[idx].word, reservedWords[idx].length);
+
+		if (table.slots[slot] != -1) {
+			table.perfect = false;
+		}
+		table.slots[slot] = static_cast<int8_t>(idx);
+	}
+
+	return table;
+}
+
+static constexpr ReservedTable reservedTable = buildReservedTable();
+static_assert(reservedTable.perfect, "RESERVED_SEED no longer gives a perfect hash, pick a new one");
+
+// --------------- global lexer --------------------------------
 
-/* Position inside the source file */
+/* Source file held in memory */
+static SourceBuffer srcFile;
+
+/* Tokens of the source file */
+static TokenStream tokens;
+
+/* Identifiers of the source file */
+static Interner symbols;
+
+/* Index of the next token handed out by `getToken()` */
+static size_t nextToken;
+
+/* Position of the last token handed out by `getToken()` */
 SourcePosition position;
 
 
+TokenStream tokenize(const SourceBuffer &buffer) {
+	Lexer lexer(buffer, sname, symbols, getDiagnostics());
+	return lexer.tokenize();
+}
+
 bool init(const char *path) {
-	srcFile.open(path);
+	if (!openFile(path)) {
+		return false;
+	}
+
+	lexFile();
+	return true;
+}
+
+bool openFile(const char *path) {
+	PhaseTimer timer(PHASE_READ);
 
 	// File could not be opened
-	if (!srcFile || !srcFile.is_open()) {
+	if (!openSource(&srcFile, path)) {
 		printErr("File could not be opened");
 		return false;
 	}
 
-	position.line = 1;
-	position.column = 0;
-	nextChar();
+	countSource(srcFile);
 	return true;
 }
 
+void lexFile() {
+	{
+		PhaseTimer timer(PHASE_LEX);
+		tokens = tokenize(srcFile);
+	}
+
+	countTokens(tokens);
+	nextToken = 0;
+}
+
 void close() {
-	srcFile.close();
+	closeSource(&srcFile);
+	tokens = TokenStream{};
+}
+
+const char *getSource() {
+	return srcFile.data;
+}
+
+size_t getSourceSize() {
+	return srcFile.size;
+}
+
+const TokenStream &getTokens() {
+	return tokens;
+}
+
+Interner &getSymbols() {
+	return symbols;
+}
+
+/**
+ * Checks if the given character may appear in a word (after the first character).
+ * @param c Character to check.
+ * @returns `true` if the character is alphanumeric or '_', `false` otherwise.
+ */
+static inline bool isIdentChar(char c) {
+	return isalnum(static_cast<unsigned char>(c)) || c == '_';
 }
 
 bool isNewLine(const char c) {
@@ -92,16 +208,65 @@ bool isNewLine(const char c) {
 	return false;
 }
 
-void nextChar() {
+// --------------- lexer --------------------------------------
+
+Lexer::Lexer(const SourceBuffer &buffer, std::string name, Interner &symbols, Diagnostics &diagnostics)
+	: srcStart{ buffer.data }, srcEnd{ buffer.data + buffer.size }, cursor{ buffer.data },
+	  currChar{ *buffer.data }, name{ std::move(name) }, symbols{ symbols }, diagnostics{ diagnostics } {
+	position.line = 1;
+	position.column = 1;
+}
+
+void Lexer::seek(uint32_t offset, const SourcePosition &pos) {
+	cursor = srcStart + offset;
+	currChar = *cursor;
+	position = pos;
+}
+
+TokenStream Lexer::tokenize() {
+	TokenStream stream;
+	Token token{};
+
+	// Rough guess of one token for every 4 characters
+	stream.source = srcStart;
+	stream.symbols = &symbols;
+	stream.reserve(static_cast<size_t>(srcEnd - cursor) / 4 + 1);
+
+	do {
+		next(&token);
+		stream.push(token);
+	} while (token.type != TOK_EOF);
+
+	return stream;
+}
+
+/**
+ * Reports an error, after which the lexer carries on.
+ * @param pos Start of the span the error is about.
+ * @param length Number of characters in the span.
+ * @param fmt Formatted string.
+ * @param ... Variable arguments.
+ */
+void Lexer::error(const SourcePosition &pos, uint32_t length, const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	diagnostics.add(SEVERITY_ERROR, name.c_str(), &pos, length, fmt, args);
+	va_end(args);
+}
+
+void Lexer::nextChar() {
 	// Do nothing if we have no more characters to read
-	if (srcFile.eof()) {
+	if (atEnd()) {
 		return;
 	}
 
 	char last = currChar;
-	srcFile.get(currChar);
 
-	if (isNewLine(last)) {
+	// The padding after the source acts as a sentinel, so this never reads out of bounds
+	currChar = *++cursor;
+
+	// "\r\n" only counts as a single new line
+	if (last == '\n' || (last == '\r' && currChar != '\n')) {
 		position.line += 1;
 		position.column = 1;
 	} else {
@@ -110,52 +275,106 @@ void nextChar() {
 }
 
 /**
- * Resets the given token.
- * @param token Token to reset.
+ * Moves the cursor forward to the given character in one step, updating the position
+ * as if `nextChar()` had been called for every character skipped.
+ * @param stop Character to move to, no further than the end of the source file.
  */
-void resetToken(Token *token) {
-	if (token->identifier) {
-		token->identifier.reset();
-	}
+void Lexer::advanceTo(const char *stop) {
+	const char *lineStart = nullptr;
+	int lines = countLines(cursor, stop, &lineStart);
 
-	if (token->string) {
-		token->string.reset();
+	if (lines > 0) {
+		position.line += lines;
+		position.column = static_cast<int>(stop - lineStart) + 1;
+	} else {
+		position.column += static_cast<int>(stop - cursor);
 	}
 
-	if (token->character) {
-		token->character.reset();
+	cursor = stop;
+	currChar = *cursor;
+}
+
+TokenType lookupWord(const char *word, size_t length) {
+	if (length < MIN_RESERVED_LENGTH || length > MAX_RESERVED_LENGTH) {
+		return TOK_ID;
 	}
 
-	if (token->ivalue) {
-		token->ivalue.reset();
+	int idx = reservedTable.slots[hashWord(word, length)];
+	if (idx < 0) {
+		return TOK_ID;
 	}
 
-	if (token->dvalue) {
-		token->dvalue.reset();
+	// A single comparison against the only candidate
+	const ReservedWord &reserved = reservedWords[idx];
+	if (reserved.length == length && memcmp(reserved.word, word, length) == 0) {
+		return reserved.type;
 	}
+
+	return TOK_ID;
+}
+
+const char *getReservedWord(size_t idx) {
+	return (idx < NUM_RESERVED_WORDS) ? reservedWords[idx].word : nullptr;
 }
 
 void getToken(Token *token) {
-	// Reached the end of the file before even starting
-	if (srcFile.eof()) {
-		token->type = TOK_EOF;
-		return;
+	tokens.get(nextToken, token);
+
+	// Stay on the final end-of-file token
+	if (nextToken + 1 < tokens.size()) {
+		nextToken += 1;
 	}
 
-	// Reset token fields
-	resetToken(token);
+	// Errors refer to the global position
+	position = token->position;
+}
 
-	// Skip whitespace
-	while (isspace(currChar)) {
-		nextChar();
+void Lexer::next(Token *token) {
+	// Illegal characters are reported and dropped
+	while (!scan(token)) {
+	}
+}
 
-		// Reached the end of file without reading any actual tokens
-		if (srcFile.eof()) {
-			token->type = TOK_EOF;
-			return;
+/**
+ * Reads the next token, or drops an illegal character.
+ * @param[out] token Next token.
+ * @returns `true` if a token was read, `false` if a character was dropped instead.
+ */
+bool Lexer::scan(Token *token) {
+	// Skip whitespace and comments
+	while (true) {
+		if (isspace(currChar)) {
+			advanceTo(skipSpace(cursor));
+		}
+
+		// The padding makes it safe to peek past the current character
+		if (currChar == '/' && cursor[1] == '-') {
+			nextChar();
+			nextChar();
+			skipComment(false);
+		} else if (currChar == '/' && cursor[1] == '/') {
+			nextChar();
+			skipComment(true);
+		} else {
+			break;
 		}
 	}
 
+	const char *start = cursor;
+	token->flags = TOKF_NONE;
+	token->position = position;
+
+	// The whole value is kept by token streams and images, not only the part a token uses
+	token->dvalue = 0;
+
+	// Reached the end of file without reading any actual tokens, or gave up
+	if (atEnd() || diagnostics.isFull()) {
+		token->type = TOK_EOF;
+		token->offset = static_cast<uint32_t>(start - srcStart);
+		token->length = 0;
+		return true;
+	}
+
 	if (isalpha(currChar) || currChar == '_') {
 		// Process word
 		processWord(token);
@@ -222,19 +441,8 @@ void getToken(Token *token) {
 			nextChar();
 			break;
 		case '/':
+			token->type = TOK_DIV;
 			nextChar();
-			if (currChar == '-') {
-				nextChar();
-				skipComment(false);
-				token->type = TOK_NONE;
-				getToken(token);
-			} else if (currChar == '/') {
-				skipComment(true);
-				token->type = TOK_NONE;
-				getToken(token);
-			} else {
-				token->type = TOK_DIV;
-			}
 			break;
 		case '*':
 			token->type = TOK_MUL;
@@ -286,86 +494,97 @@ void getToken(Token *token) {
 			nextChar();
 			break;
 		default:
-			printErr("Illegal character '%c' (ASCII #%d) found", currChar, currChar);
-			break;
+			error(position, 1, "Illegal character '%c' (ASCII #%d) found", currChar, currChar);
+			nextChar();
+			return false;
 		}
 	}
+
+	token->offset = static_cast<uint32_t>(start - srcStart);
+	token->length = static_cast<uint32_t>(cursor - start);
+	return true;
 }
 
 /**
  * Processes a word and updates the given token.
  * @param token Token to update after processing.
  */
-void processWord(Token *token) {
-	std::string word = "";
-	int startColumn = position.column;
-
-	int idx = 0;
-	while (currChar != ' ' && !srcFile.eof() && (isalnum(currChar) || currChar == '_')) {
-		if (idx <= MAX_ID_LENGTH) {
-			word += currChar;
-			idx += 1;
-			nextChar();
-		} else {
-			position.column = startColumn;
-			printErr("Identifier too long (more than 32 characters)");
-		}
+void Lexer::processWord(Token *token) {
+	const char *start = cursor;
+	const char *stop = cursor;
+
+	// Words never span lines, so the whole word is found before moving the cursor
+	while (isIdentChar(*stop)) {
+		stop++;
 	}
 
-	// Perform binary search through list of reserved words
-	int low = 0;
-	int mid = 0;
-	int high = sizeof(reservedWords) / sizeof(reservedWords[0]) - 1;
-	int cmp = 0;
+	auto length = static_cast<size_t>(stop - start);
+	if (length > MAX_ID_LENGTH) {
+		error(position, static_cast<uint32_t>(length), "Identifier too long (more than %d characters)", MAX_ID_LENGTH);
+	}
 
-	while (low <= high) {
-		mid = (low + high) / 2;
-		cmp = word.compare(reservedWords[mid].word);
+	position.column += static_cast<int>(length);
+	cursor = stop;
+	currChar = *cursor;
 
-		if (cmp < 0) {
-			high = mid - 1;
-		} else if (cmp > 0) {
-			low = mid + 1;
-		} else {
-			// Found a match, so it is a reserved word
-			token->type = reservedWords[mid].type;
-			token->identifier = word;
-			return;
-		}
+	token->type = lookupWord(start, length);
+	if (token->type != TOK_ID) {
+		token->flags |= TOKF_KEYWORD;
+	} else {
+		token->symbol = symbols.intern(start, length);
 	}
-
-	// Not a reserved word, so it is an identifier
-	token->type = TOK_ID;
-	token->identifier = word;
 }
 
 /**
  * Processes a number and updates the given token.
  * @param token Token to update after processing.
  */
-void processNumber(Token *token) {
+void Lexer::processNumber(Token *token) {
 	SourcePosition start{ position };
+	const char *begin = cursor;
+	const char *stop = cursor;
 
-	int number;
-	int value;
-	int diff;
+	// Numbers never span lines, so the whole number is found before moving the cursor
+	while (isdigit(static_cast<unsigned char>(*stop))) {
+		stop++;
+	}
 
-	value = currChar - '0';
-	number = value;
-	nextChar();
+	// A '.' followed by more digits makes it a decimal
+	bool decimal = (*stop == '.' && isdigit(static_cast<unsigned char>(stop[1])));
+	if (decimal) {
+		stop++;
+		while (isdigit(static_cast<unsigned char>(*stop))) {
+			stop++;
+		}
+	}
 
-	// Build up the number until we do not have another number to read
-	while (isdigit(currChar)) {
-		diff = currChar - '0';
+	position.column += static_cast<int>(stop - begin);
+	cursor = stop;
+	currChar = *cursor;
 
-		if (number <= ((INT_MAX - diff) / 10)) {
-			number = (10 * value) + diff;
-			value = number;
-			nextChar();
-		} else {
-			position = start;
-			printErr("Number too large");
+	if (decimal) {
+		double value = 0.0;
+		std::from_chars(begin, stop, value);
+
+		token->type = TOK_DEC;
+		token->dvalue = value;
+		return;
+	}
+
+	// Build up the number, checking that it fits
+	int number = 0;
+	int diff;
+
+	for (const char *digit = begin; digit < stop; digit++) {
+		diff = *digit - '0';
+
+		if (number > ((INT_MAX - diff) / 10)) {
+			error(start, static_cast<uint32_t>(stop - begin), "Number too large");
+			number = 0;
+			break;
 		}
+
+		number = (10 * number) + diff;
 	}
 
 	// Update token information
@@ -377,40 +596,51 @@ void processNumber(Token *token) {
  * Processes a string and updates the given token.
  * @param token Token to update after processing.
  */
-void processString(Token *token) {
+void Lexer::processString(Token *token) {
 	SourcePosition start{ position.line, position.column - 1 };
-	std::string str = "";
 	char temp;
 
-	// Build the string
+	// Find the end of the string, the value is only built when it is needed
 	while (currChar != '"') {
-		if (srcFile.eof()) {
-			position = start;
-			printErr("String not closed");
+		// Skip the run of ordinary characters in one go
+		const char *stop = findStringMark(cursor);
+		if (stop != cursor) {
+			advanceTo(stop);
+			continue;
 		}
 
-		if (!isascii(currChar) || currChar < 32) {
-			position = start;
-			printErr("Non-printable character (ASCII #%d) found in string", currChar);
+		// Close the string at the end of its line, so the next line is read as usual
+		if (atEnd() || isNewLine(currChar)) {
+			error(start, static_cast<uint32_t>(position.column - start.column), "String not closed");
+			token->type = TOK_STR;
+			token->flags |= TOKF_UNCLOSED;
+			return;
 		}
 
-		str += currChar;
+		if (!isascii(currChar) || currChar < 32) {
+			error(start, static_cast<uint32_t>(position.column - start.column + 1), "Non-printable character (ASCII #%d) found in string", currChar);
+			nextChar();
+			continue;
+		}
 
 		// Check escape codes
 		if (currChar == '\\') {
 			temp = currChar;
+			token->flags |= TOKF_ESCAPED;
 			nextChar();
 
+			if (atEnd() || isNewLine(currChar)) {
+				continue;
+			}
+
 			switch (currChar) {
 			case 'n':
 			case 't':
 			case '"':
 			case '\\':
-				str += currChar;
 				break;
 			default:
-				position = { position.line, position.column - 1 };
-				printErr("Unknown escape code '%c%c' found in string", temp, currChar);
+				error({ position.line, position.column - 1 }, 2, "Unknown escape code '%c%c' found in string", temp, currChar);
 				break;
 			}
 		}
@@ -419,7 +649,6 @@ void processString(Token *token) {
 	}
 
 	token->type = TOK_STR;
-	token->string = str;
 	nextChar();
 }
 
@@ -427,27 +656,34 @@ void processString(Token *token) {
  * Processes a single character and updates the given token.
  * @param token Token to update after processing.
  */
-void processCharacter(Token *token) {
+void Lexer::processCharacter(Token *token) {
 	SourcePosition start{ position.line, position.column - 1 };
-	char ch;
+	char ch = '\0';
 	char temp;
 	char escape = '-';
 	bool finished = false;
+	bool closed = true;
 
 	while (currChar != '\'') {
-		if (srcFile.eof()) {
-			position = start;
-			printErr("Character not closed");
+		if (atEnd() || isNewLine(currChar)) {
+			error(start, static_cast<uint32_t>(position.column - start.column), "Character not closed");
+			closed = false;
+			break;
 		}
 
 		if (finished) {
-			position = start;
-			printErr("Too many characters found");
+			// Report the literal once and carry on after it
+			while (currChar != '\'' && !atEnd() && !isNewLine(currChar)) {
+				nextChar();
+			}
+
+			error(start, static_cast<uint32_t>(position.column - start.column + 1), "Too many characters found");
+			closed = (currChar == '\'');
+			break;
 		}
 
 		if (!isascii(currChar) || currChar < 32) {
-			position = start;
-			printErr("Non-printable character (ASCII #%d) found in character", currChar);
+			error(start, static_cast<uint32_t>(position.column - start.column + 1), "Non-printable character (ASCII #%d) found in character", currChar);
 		}
 
 		ch = currChar;
@@ -457,6 +693,10 @@ void processCharacter(Token *token) {
 			temp = currChar;
 			nextChar();
 
+			if (atEnd() || isNewLine(currChar)) {
+				continue;
+			}
+
 			switch (currChar) {
 			case 'n':
 				escape = '\n';
@@ -471,8 +711,7 @@ void processCharacter(Token *token) {
 				escape = '\\';
 				break;
 			default:
-				position = { position.line, position.column - 1 };
-				printErr("Unknown escape code '%c%c' found in character", temp, currChar);
+				error({ position.line, position.column - 1 }, 2, "Unknown escape code '%c%c' found in character", temp, currChar);
 				break;
 			}
 		}
@@ -483,18 +722,26 @@ void processCharacter(Token *token) {
 
 	token->type = TOK_CHAR;
 	token->character = (escape != '-') ? escape : ch;
-	nextChar();
+
+	if (closed) {
+		nextChar();
+	}
 }
 
 /**
  * Skips comments.
  * @param single `true` if the comment is a single-line comment, `false` if multi-line.
  */
-void skipComment(bool single) {
+void Lexer::skipComment(bool single) {
 	// Only need to read to end of current line (single-line comment)
 	if (single && currChar == '/') {
-		while (!isNewLine(currChar) && !srcFile.eof()) {
-			nextChar();
+		while (!isNewLine(currChar) && !atEnd()) {
+			advanceTo(findLineEnd(cursor));
+
+			// Stray zero byte inside the comment
+			if (currChar == '\0' && !atEnd()) {
+				nextChar();
+			}
 		}
 		return;
 	}
@@ -505,9 +752,11 @@ void skipComment(bool single) {
 
 	// Keep checking characters while the comment is not closed
 	while (!closed) {
-		if (srcFile.eof()) {
-			position = start;
-			printErr("Comment not closed");
+		// Jump straight to the next character that could open or close a comment
+		advanceTo(findCommentMark(cursor));
+
+		if (atEnd()) {
+			error(start, 2, "Comment not closed");
 			return;
 		}
 
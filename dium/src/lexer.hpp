@@ -11,21 +11,177 @@
 #ifndef LEXER_HPP
 #define LEXER_HPP
 
-#include <fstream>
+#include <string>
+#include "diagnostics.hpp"
+#include "format.hpp"
+#include "source.hpp"
 #include "token.hpp"
 
 /**
- * Initialises the lexer.
+ * Characters past the end of a token that the lexer may look at before deciding where
+ * the token ends (`12` looks at ".5" to tell it apart from `12.5`)
+ */
+#define LEXER_LOOKAHEAD 2
+
+/**
+ * Reads tokens from a single source buffer. Every lexer keeps its own cursor,
+ * position and file name, so any number of them can run at the same time.
+ */
+class Lexer {
+public:
+	/**
+	 * Creates a lexer positioned at the start of the source.
+	 * @param buffer Source to read from, which must outlive the lexer.
+	 * @param name Name of the source file, used in error messages.
+	 * @param symbols Table the identifiers are interned in, which must outlive the lexer.
+	 * @param diagnostics Where errors are reported, which must outlive the lexer.
+	 */
+	Lexer(const SourceBuffer &buffer, std::string name, Interner &symbols, Diagnostics &diagnostics);
+
+	/**
+	 * Reads the next token. Keeps returning `TOK_EOF` at the end of the source, and
+	 * also once the diagnostics are full. Errors are reported and skipped over: an
+	 * illegal character is dropped and a string or character that is not closed ends
+	 * with its line.
+	 * @param[out] token Next token.
+	 */
+	void next(Token *token);
+
+	/**
+	 * Moves the lexer to another point of the source, to read part of it again. The
+	 * point must lie between two tokens (e.g. right after one), never inside a token
+	 * or comment.
+	 * @param offset Offset of the character to read next.
+	 * @param pos Line and column of that character.
+	 */
+	void seek(uint32_t offset, const SourcePosition &pos);
+
+	/**
+	 * Reads all remaining tokens in one pass.
+	 * @returns Remaining tokens of the source, ending with `TOK_EOF`.
+	 */
+	TokenStream tokenize();
+
+	/**
+	 * Returns the current position in the source.
+	 * @returns Line and column of the current character.
+	 */
+	const SourcePosition &getPosition() const {
+		return position;
+	}
+
+	/**
+	 * Returns the name of the source file.
+	 * @returns Name used in error messages.
+	 */
+	const std::string &getName() const {
+		return name;
+	}
+
+private:
+	/** First character of the source */
+	const char *srcStart;
+
+	/** One past the last character of the source */
+	const char *srcEnd;
+
+	/** Cursor pointing at the current character */
+	const char *cursor;
+
+	/** Current character in the source */
+	char currChar;
+
+	/** Position of the current character */
+	SourcePosition position;
+
+	/** Name of the source file */
+	std::string name;
+
+	/** Table the identifiers are interned in */
+	Interner &symbols;
+
+	/** Where errors are reported */
+	Diagnostics &diagnostics;
+
+	/**
+	 * Checks if the whole source has been read.
+	 * @returns `true` if there are no more characters to read, `false` otherwise.
+	 */
+	bool atEnd() const {
+		return cursor >= srcEnd;
+	}
+
+	bool scan(Token *token);
+	void nextChar();
+	void advanceTo(const char *stop);
+	void processWord(Token *token);
+	void processNumber(Token *token);
+	void processString(Token *token);
+	void processCharacter(Token *token);
+	void skipComment(bool single);
+
+	void error(const SourcePosition &pos, uint32_t length, FORMAT_STRING const char *fmt, ...) FORMAT_CHECK(4, 5);
+};
+
+/**
+ * Reads all tokens from a source buffer in one pass, naming it after the file opened
+ * through `init()` in error messages, interning identifiers in `getSymbols()` and
+ * reporting errors to `getDiagnostics()`.
+ * @param buffer Source to read from.
+ * @returns Tokens of the source, ending with `TOK_EOF`.
+ */
+TokenStream tokenize(const SourceBuffer &buffer);
+
+/**
+ * Initialises the lexer and reads all tokens from the source file, which are then
+ * handed out one at a time by `getToken()`. Same as `openFile()` then `lexFile()`.
  * @param path Path to the source file to read from.
  * @returns `true` if the lexer was initialized successfully, `false` otherwise.
  */
 bool init(const char *path);
 
+/**
+ * Reads the source file without reading its tokens yet, for when a compiled copy of
+ * the program may make them unnecessary.
+ * @param path Path to the source file to read from.
+ * @returns `true` if the file was read, `false` otherwise.
+ */
+bool openFile(const char *path);
+
+/**
+ * Reads all tokens from the source file opened by `openFile()`.
+ */
+void lexFile();
+
 /**
  * Closes the lexer and frees all allocated memory.
  */
 void close();
 
+/**
+ * Returns the text of the source file, which tokens refer back to.
+ * @returns First character of the source file.
+ */
+const char *getSource();
+
+/**
+ * Returns the size of the source file.
+ * @returns Number of characters in the source file.
+ */
+size_t getSourceSize();
+
+/**
+ * Returns all tokens of the source file opened by `init()`.
+ * @returns Tokens of the source file.
+ */
+const TokenStream &getTokens();
+
+/**
+ * Returns the table the identifiers of the source file are interned in.
+ * @returns Interner shared by the lexer, parser and later stages.
+ */
+Interner &getSymbols();
+
 /**
  * Checks if the given character is a new line character.
  * @param c Character to check
@@ -34,12 +190,23 @@ void close();
 bool isNewLine(const char c);
 
 /**
- * Gets the next character from the source file.
+ * Classifies a word as either a reserved word or an identifier.
+ * @param word First character of the word.
+ * @param length Number of characters in the word.
+ * @returns Token type of the reserved word, or `TOK_ID` if it is not reserved.
+ */
+TokenType lookupWord(const char *word, size_t length);
+
+/**
+ * Returns a reserved word, to list them all.
+ * @param idx Index of the reserved word, in alphabetical order.
+ * @returns The word, or `nullptr` past the last one.
  */
-void nextChar();
+const char *getReservedWord(size_t idx);
 
 /**
- * Gets the next token from the source file.
+ * Gets the next token from the source file. Keeps returning `TOK_EOF` once all
+ * tokens have been handed out.
  * @param[out] token Next token.
  */
 void getToken(Token *token);
@@ -0,0 +1,680 @@
+/**
+ * @file       lsp.cpp
+ * @brief      Implementation of the language server spoken to by editors
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include "error.hpp"
+#include "format.hpp"
+#include "index.hpp"
+#include "lexer.hpp"
+#include "lsp.hpp"
+#include "output.hpp"
+
+#ifdef _WIN32
+	#include <fcntl.h>
+	#include <io.h>
+#endif
+
+/* Names of the semantic token types, in the order of `SemanticType` */
+static const char *semanticTypeNames[] = { "keyword", "type", "function", "variable", "parameter", "string", "number", "operator" };
+
+/* Semantic token modifier for the name in a declaration */
+#define SEM_DECLARATION 1
+
+/* Kinds of completion items, as numbered by the protocol */
+#define COMPLETION_FUNCTION 3
+#define COMPLETION_VARIABLE 6
+#define COMPLETION_KEYWORD  14
+
+// --------------- function prototypes -------------------------
+
+static bool readMessage(FILE *in, std::string *message);
+static void appendMessage(std::string *out, std::string_view body);
+static void appendResult(std::string *out, const JsonValue &id, std::string_view result);
+static void appendError(std::string *out, const JsonValue &id, int code, const char *message);
+static void appendInt(std::string *out, int64_t value);
+static void appendRange(std::string *out, const SourcePosition &pos, uint32_t length);
+static SourcePosition getPosition(const JsonValue &pos);
+static SemanticType classifyToken(const Document &doc, size_t token, uint32_t *modifiers);
+static std::string describe(const Document &doc, const DeclRef &decl);
+
+
+bool LanguageServer::handle(std::string_view message, std::string *out) {
+	JsonValue request;
+	if (!parseJson(message, &request) || request.type != JSON_OBJECT) {
+		appendError(out, JsonValue{}, -32700, "Message is not valid JSON");
+		return true;
+	}
+
+	const JsonValue &id = request["id"];
+	const JsonValue &method = request["method"];
+	const JsonValue &params = request["params"];
+
+	// Responses to requests of the server are not expected, since it sends none
+	if (method.type != JSON_STRING) {
+		return true;
+	}
+
+	const std::string &name = method.string;
+	if (name == "initialize") {
+		initialize(id, params, out);
+	} else if (name == "textDocument/didOpen") {
+		open(params, out);
+	} else if (name == "textDocument/didChange") {
+		change(params, out);
+	} else if (name == "textDocument/didClose") {
+		close(params, out);
+	} else if (name == "textDocument/semanticTokens/full") {
+		semanticTokens(id, params, out);
+	} else if (name == "textDocument/definition") {
+		definition(id, params, out);
+	} else if (name == "textDocument/completion") {
+		completion(id, params, out);
+	} else if (name == "shutdown") {
+		shutdown = true;
+		appendResult(out, id, "null");
+	} else if (name == "exit") {
+		return false;
+	} else if (id.exists()) {
+		appendError(out, id, -32601, "Method not supported");
+	}
+
+	// Notifications the server does not handle, like `initialized`, are dropped
+	return true;
+}
+
+/**
+ * Answers the `initialize` request with what the server can do.
+ * @param id Id of the request.
+ * @param params Parameters of the request.
+ * @param[out] out String to append the response to.
+ */
+void LanguageServer::initialize(const JsonValue &id, const JsonValue &params, std::string *out) {
+	bool utf8 = false;
+	for (const JsonValue &encoding : params["capabilities"]["general"]["positionEncodings"].items) {
+		utf8 |= (encoding.string == "utf-8");
+	}
+
+	std::string result = "{\"capabilities\":{";
+	if (utf8) {
+		result += "\"positionEncoding\":\"utf-8\",";
+	}
+	result += "\"textDocumentSync\":{\"openClose\":true,\"change\":2},";
+	result += "\"semanticTokensProvider\":{\"legend\":{\"tokenTypes\":[";
+	for (size_t idx = 0; idx < SEM_NONE; idx++) {
+		appendFormat(&result, "%s\"%s\"", (idx > 0) ? "," : "", semanticTypeNames[idx]);
+	}
+	result += "],\"tokenModifiers\":[\"declaration\"]},\"full\":true},";
+	result += "\"definitionProvider\":true,\"completionProvider\":{}},";
+	result += "\"serverInfo\":{\"name\":\"dium\"}}";
+
+	appendResult(out, id, result);
+}
+
+/**
+ * Opens a file with the text the client sent.
+ * @param params Parameters of the `textDocument/didOpen` notification.
+ * @param[out] out String to append the diagnostics of the file to.
+ */
+void LanguageServer::open(const JsonValue &params, std::string *out) {
+	const JsonValue &item = params["textDocument"];
+	const std::string &uri = item["uri"].string;
+
+	OpenFile &file = files[uri];
+	file.doc = std::make_unique<Document>(uri, item["text"].string);
+	file.version = item["version"].asInt();
+	file.diagnostics.clear();
+	file.segments.clear();
+
+	publishDiagnostics(uri, &file, out);
+}
+
+/**
+ * Applies changes the client made to an open file. Ranges are edited in place, while
+ * a change without a range replaces the whole text.
+ * @param params Parameters of the `textDocument/didChange` notification.
+ * @param[out] out String to append the new diagnostics of the file to.
+ */
+void LanguageServer::change(const JsonValue &params, std::string *out) {
+	OpenFile *file = findFile(params);
+	if (file == nullptr) {
+		return;
+	}
+
+	const std::string &uri = params["textDocument"]["uri"].string;
+	for (const JsonValue &edit : params["contentChanges"].items) {
+		const JsonValue &range = edit["range"];
+
+		if (!range.exists()) {
+			file->doc = std::make_unique<Document>(uri, edit["text"].string);
+			file->segments.clear();
+			continue;
+		}
+
+		uint32_t start = file->doc->getOffset(getPosition(range["start"]));
+		uint32_t end = file->doc->getOffset(getPosition(range["end"]));
+		if (end < start) {
+			std::swap(start, end);
+		}
+		file->doc->edit(start, end - start, edit["text"].string);
+	}
+
+	file->version = params["textDocument"]["version"].asInt(file->version);
+	publishDiagnostics(uri, file, out);
+}
+
+/**
+ * Forgets a file the client closed, clearing its diagnostics.
+ * @param params Parameters of the `textDocument/didClose` notification.
+ * @param[out] out String to append the empty diagnostics to.
+ */
+void LanguageServer::close(const JsonValue &params, std::string *out) {
+	const std::string &uri = params["textDocument"]["uri"].string;
+	if (files.erase(uri) == 0) {
+		return;
+	}
+
+	std::string body = "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":";
+	appendJsonString(&body, uri);
+	body += ",\"diagnostics\":[]}}";
+	appendMessage(out, body);
+}
+
+/**
+ * Answers a request for the semantic tokens of a whole file. The tokens are numbered
+ * relative to the one before, so those of a function stay the same when it moves and
+ * are only worked out again, and written as text again, when it was parsed again.
+ * @param id Id of the request.
+ * @param params Parameters of the request.
+ * @param[out] out String to append the response to.
+ */
+void LanguageServer::semanticTokens(const JsonValue &id, const JsonValue &params, std::string *out) {
+	OpenFile *file = findFile(params);
+	if (file == nullptr) {
+		appendResult(out, id, "null");
+		return;
+	}
+
+	const Document &doc = *file->doc;
+	const TokenStream &tokens = doc.getTokens();
+	size_t count = doc.getFuncCount();
+
+	std::string result = "{\"data\":[";
+	SourcePosition prev{ 1, 1 };
+	bool any = false;
+
+	for (size_t idx = 0; idx < count; idx++) {
+		FuncSpan span = doc.getFuncSpan(idx);
+
+		auto found = file->segments.find(span.id);
+		if (found == file->segments.end()) {
+			Segment segment{ UINT32_MAX, 0, {}, {} };
+			SourcePosition last{};
+
+			for (size_t token = span.first; token < span.next; token++) {
+				uint32_t modifiers;
+				SemanticType type = classifyToken(doc, token, &modifiers);
+				if (type == SEM_NONE) {
+					continue;
+				}
+
+				const SourcePosition &pos = tokens.positions[token];
+				if (segment.first == UINT32_MAX) {
+					segment.first = static_cast<uint32_t>(token - span.first);
+					segment.head[0] = tokens.lengths[token];
+					segment.head[1] = type;
+					segment.head[2] = modifiers;
+				} else {
+					int lines = pos.line - last.line;
+					segment.rest += ',';
+					appendInt(&segment.rest, lines);
+					segment.rest += ',';
+					appendInt(&segment.rest, (lines == 0) ? pos.column - last.column : pos.column - 1);
+					segment.rest += ',';
+					appendInt(&segment.rest, tokens.lengths[token]);
+					segment.rest += ',';
+					appendInt(&segment.rest, type);
+					segment.rest += ',';
+					appendInt(&segment.rest, modifiers);
+				}
+
+				segment.last = static_cast<uint32_t>(token - span.first);
+				last = pos;
+			}
+
+			found = file->segments.emplace(span.id, std::move(segment)).first;
+		}
+
+		const Segment &segment = found->second;
+		if (segment.first == UINT32_MAX) {
+			continue;
+		}
+
+		// Only the first token depends on where the function is now
+		const SourcePosition &pos = tokens.positions[span.first + segment.first];
+		int lines = pos.line - prev.line;
+		appendFormat(&result, "%s%d,%d,%u,%u,%u", any ? "," : "", lines, (lines == 0) ? pos.column - prev.column : pos.column - 1,
+			segment.head[0], segment.head[1], segment.head[2]);
+		result += segment.rest;
+
+		prev = tokens.positions[span.first + segment.last];
+		any = true;
+	}
+
+	result += "]}";
+	appendResult(out, id, result);
+
+	// Drop the tokens of functions that were parsed again once they pile up
+	if (file->segments.size() > 2 * count + 64) {
+		std::unordered_map<uint64_t, Segment> kept;
+		for (size_t idx = 0; idx < count; idx++) {
+			uint64_t func = doc.getFuncSpan(idx).id;
+			auto found = file->segments.find(func);
+			if (found != file->segments.end()) {
+				kept.emplace(func, std::move(found->second));
+			}
+		}
+		file->segments = std::move(kept);
+	}
+}
+
+/**
+ * Answers a request for the declaration of the name at a position.
+ * @param id Id of the request.
+ * @param params Parameters of the request.
+ * @param[out] out String to append the response to.
+ */
+void LanguageServer::definition(const JsonValue &id, const JsonValue &params, std::string *out) {
+	OpenFile *file = findFile(params);
+	size_t token;
+	DeclRef decl;
+
+	if (file == nullptr || !file->doc->findToken(getPosition(params["position"]), &token) || !file->doc->findDeclaration(token, &decl)) {
+		appendResult(out, id, "null");
+		return;
+	}
+
+	const TokenStream &tokens = file->doc->getTokens();
+	std::string result = "{\"uri\":";
+	appendJsonString(&result, params["textDocument"]["uri"].string);
+	result += ",\"range\":";
+	appendRange(&result, tokens.positions[decl.token], tokens.lengths[decl.token]);
+	result += '}';
+
+	appendResult(out, id, result);
+}
+
+/**
+ * Answers a request for completions at a position: the variables in scope, the
+ * functions and the reserved words starting with the name being typed.
+ * @param id Id of the request.
+ * @param params Parameters of the request.
+ * @param[out] out String to append the response to.
+ */
+void LanguageServer::completion(const JsonValue &id, const JsonValue &params, std::string *out) {
+	OpenFile *file = findFile(params);
+	if (file == nullptr) {
+		appendResult(out, id, "null");
+		return;
+	}
+
+	const Document &doc = *file->doc;
+	const TokenStream &tokens = doc.getTokens();
+	std::string_view text = doc.getText();
+	uint32_t offset = doc.getOffset(getPosition(params["position"]));
+
+	// The first token at or after the cursor, and the word right before it if any
+	auto after = std::lower_bound(tokens.offsets.begin(), tokens.offsets.end() - 1, offset);
+	auto scope = static_cast<size_t>(after - tokens.offsets.begin());
+	std::string_view prefix;
+
+	if (scope > 0) {
+		size_t before = scope - 1;
+		char c = text[tokens.offsets[before]];
+		bool word = (c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'));
+
+		if (word && tokens.offsets[before] + tokens.lengths[before] >= offset) {
+			prefix = text.substr(tokens.offsets[before], offset - tokens.offsets[before]);
+			scope = before;
+		} else if (tokens.types[scope] == TOK_EOF) {
+			scope = before;
+		}
+	}
+
+	std::vector<DeclRef> visible;
+	doc.collectVisible(scope, &visible);
+
+	std::string items;
+	size_t count = 0;
+	bool complete = true;
+
+	auto addItem = [&](std::string_view label, int kind, const std::string &detail) {
+		if (count == LSP_MAX_COMPLETIONS) {
+			complete = false;
+			return;
+		}
+
+		items += (count++ > 0) ? ",{\"label\":" : "{\"label\":";
+		appendJsonString(&items, label);
+		appendFormat(&items, ",\"kind\":%d", kind);
+		if (!detail.empty()) {
+			items += ",\"detail\":";
+			appendJsonString(&items, detail);
+		}
+		items += '}';
+	};
+
+	for (const DeclRef &decl : visible) {
+		std::string_view label = doc.getSymbols().getText(tokens.getSymbol(decl.token));
+		if (label.substr(0, prefix.size()) == prefix && count < LSP_MAX_COMPLETIONS) {
+			addItem(label, (decl.kind == DECL_FUNC) ? COMPLETION_FUNCTION : COMPLETION_VARIABLE, describe(doc, decl));
+		}
+	}
+	for (size_t idx = 0; getReservedWord(idx) != nullptr; idx++) {
+		std::string_view label = getReservedWord(idx);
+		if (label.substr(0, prefix.size()) == prefix) {
+			addItem(label, COMPLETION_KEYWORD, std::string());
+		}
+	}
+
+	std::string result = complete ? "{\"isIncomplete\":false,\"items\":[" : "{\"isIncomplete\":true,\"items\":[";
+	result += items;
+	result += "]}";
+	appendResult(out, id, result);
+}
+
+/**
+ * Sends the errors of the lexer and parser for a file, unless they did not change
+ * since they were last sent.
+ * @param uri URI of the file.
+ * @param file File to report on.
+ * @param[out] out String to append the notification to.
+ */
+void LanguageServer::publishDiagnostics(const std::string &uri, OpenFile *file, std::string *out) {
+	std::string list = "[";
+
+	for (const Diagnostic &diagnostic : file->doc->getDiagnostics()) {
+		if (list.size() > 1) {
+			list += ',';
+		}
+		list += "{\"range\":";
+		appendRange(&list, diagnostic.position, std::max<uint32_t>(diagnostic.length, 1));
+		appendFormat(&list, ",\"severity\":%d,\"source\":\"dium\",\"message\":", (diagnostic.severity == SEVERITY_ERROR) ? 1 : 2);
+		appendJsonString(&list, diagnostic.message);
+		list += '}';
+	}
+	list += ']';
+
+	// Typing inside a function rarely changes the errors of the file
+	if (list == file->diagnostics) {
+		return;
+	}
+	file->diagnostics = list;
+
+	std::string body = "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":";
+	appendJsonString(&body, uri);
+	appendFormat(&body, ",\"version\":%lld,\"diagnostics\":", static_cast<long long>(file->version));
+	body += list;
+	body += "}}";
+	appendMessage(out, body);
+}
+
+/**
+ * Finds the open file a request is about.
+ * @param params Parameters of the request.
+ * @returns File named by `params.textDocument.uri`, or `nullptr` if it is not open.
+ */
+LanguageServer::OpenFile *LanguageServer::findFile(const JsonValue &params) {
+	auto found = files.find(params["textDocument"]["uri"].string);
+	return (found != files.end()) ? &found->second : nullptr;
+}
+
+int runLanguageServer(const char *recordPath) {
+#ifdef _WIN32
+	// Content lengths count bytes, which text mode would change
+	_setmode(_fileno(stdin), _O_BINARY);
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+	FILE *record = nullptr;
+	if (recordPath != nullptr) {
+		record = fopen(recordPath, "wb");
+		if (record == nullptr) {
+			customPrint(ASCII_BOLD_RED "Error:" ASCII_RESET, recordPath, nullptr, "File could not be written");
+			return 2;
+		}
+	}
+
+	LanguageServer server;
+	std::string message;
+	std::string out;
+	bool running = true;
+
+	while (running && readMessage(stdin, &message)) {
+		if (record != nullptr) {
+			fprintf(record, "Content-Length: %zu\r\n\r\n", message.size());
+			fwrite(message.data(), 1, message.size(), record);
+			fflush(record);
+		}
+
+		out.clear();
+		running = server.handle(message, &out);
+		getStdout().write(out);
+		getStdout().flush();
+	}
+
+	if (record != nullptr) {
+		fclose(record);
+	}
+	return server.getExitCode();
+}
+
+/**
+ * Reads a single message, skipping any header but its length.
+ * @param in Stream to read from.
+ * @param[out] message Content of the message.
+ * @returns `true` if a whole message was read, `false` at the end of the stream.
+ */
+static bool readMessage(FILE *in, std::string *message) {
+	std::string line;
+	size_t length = 0;
+	bool sized = false;
+
+	while (true) {
+		line.clear();
+		int c;
+		while ((c = getc(in)) != EOF && c != '\n') {
+			line += static_cast<char>(c);
+		}
+		if (c == EOF) {
+			return false;
+		}
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+
+		// An empty line ends the header
+		if (line.empty()) {
+			if (sized) {
+				break;
+			}
+			continue;
+		}
+		if (line.compare(0, 15, "Content-Length:") == 0) {
+			length = strtoull(line.c_str() + 15, nullptr, 10);
+			sized = true;
+		}
+	}
+
+	message->resize(length);
+	return fread(&(*message)[0], 1, length, in) == length;
+}
+
+/**
+ * Appends a message with its header.
+ * @param out String to append to.
+ * @param body Content of the message.
+ */
+static void appendMessage(std::string *out, std::string_view body) {
+	appendFormat(out, "Content-Length: %zu\r\n\r\n", body.size());
+	out->append(body.data(), body.size());
+}
+
+/**
+ * Appends the response to a request.
+ * @param out String to append to.
+ * @param id Id of the request.
+ * @param result JSON text of the result.
+ */
+static void appendResult(std::string *out, const JsonValue &id, std::string_view result) {
+	std::string body = "{\"jsonrpc\":\"2.0\",\"id\":";
+	appendJson(&body, id);
+	body += ",\"result\":";
+	body.append(result.data(), result.size());
+	body += '}';
+	appendMessage(out, body);
+}
+
+/**
+ * Appends an error response to a request.
+ * @param out String to append to.
+ * @param id Id of the request, `null` if it could not be read.
+ * @param code Error code defined by JSON-RPC.
+ * @param message Description of the error.
+ */
+static void appendError(std::string *out, const JsonValue &id, int code, const char *message) {
+	std::string body = "{\"jsonrpc\":\"2.0\",\"id\":";
+	appendJson(&body, id);
+	appendFormat(&body, ",\"error\":{\"code\":%d,\"message\":", code);
+	appendJsonString(&body, message);
+	body += "}}";
+	appendMessage(out, body);
+}
+
+/**
+ * Appends an integer, without going through a format string.
+ * @param out String to append to.
+ * @param value Integer to append.
+ */
+static void appendInt(std::string *out, int64_t value) {
+	char text[NUMBER_TEXT_MAX];
+	out->append(text, static_cast<size_t>(formatNum(text, value) - text));
+}
+
+/**
+ * Appends a range of characters on a single line.
+ * @param out String to append to.
+ * @param pos Position of the first character.
+ * @param length Number of characters.
+ */
+static void appendRange(std::string *out, const SourcePosition &pos, uint32_t length) {
+	// The protocol counts from 0, and positions without a line are put at the start
+	int line = std::max(pos.line - 1, 0);
+	int column = std::max(pos.column - 1, 0);
+	appendFormat(out, "{\"start\":{\"line\":%d,\"character\":%d},\"end\":{\"line\":%d,\"character\":%u}}", line, column, line,
+		static_cast<uint32_t>(column) + length);
+}
+
+/**
+ * Converts a position sent by the client.
+ * @param pos Position object, counting lines and characters from 0.
+ * @returns Line and column, counting from 1.
+ */
+static SourcePosition getPosition(const JsonValue &pos) {
+	int64_t line = std::max<int64_t>(pos["line"].asInt(), 0);
+	int64_t character = std::max<int64_t>(pos["character"].asInt(), 0);
+	return SourcePosition{ static_cast<int>(std::min<int64_t>(line, INT32_MAX - 1)) + 1,
+		static_cast<int>(std::min<int64_t>(character, INT32_MAX - 1)) + 1 };
+}
+
+/**
+ * Works out how a token is highlighted.
+ * @param doc Document the token belongs to.
+ * @param token Index of the token.
+ * @param[out] modifiers `SEM_DECLARATION` for the name in a declaration, 0 otherwise.
+ * @returns Semantic token type, or `SEM_NONE` if it is not highlighted.
+ */
+static SemanticType classifyToken(const Document &doc, size_t token, uint32_t *modifiers) {
+	const TokenStream &tokens = doc.getTokens();
+	TokenType type = tokens.types[token];
+	bool keyword = (tokens.flags[token] & TOKF_KEYWORD) != 0;
+	*modifiers = 0;
+
+	switch (type) {
+	case TOK_ID: {
+		if (isFuncName(tokens, token)) {
+			*modifiers = (token > 0 && tokens.types[token - 1] == TOK_FUNC) ? SEM_DECLARATION : 0;
+			return SEM_FUNCTION;
+		}
+
+		DeclRef decl;
+		if (!doc.findDeclaration(token, &decl)) {
+			return SEM_VARIABLE;
+		}
+		*modifiers = (decl.token == token) ? SEM_DECLARATION : 0;
+		return (decl.kind == DECL_PARAM) ? SEM_PARAMETER : SEM_VARIABLE;
+	}
+	case TOK_NUM:
+	case TOK_DEC:
+		return keyword ? SEM_TYPE : SEM_NUMBER;
+	case TOK_CHAR:
+	case TOK_STR:
+		return keyword ? SEM_TYPE : SEM_STRING;
+	case TOK_BOOL:
+	case TOK_VOID:
+	case TOK_ARRAY:
+		return SEM_TYPE;
+	case TOK_ARROW:
+		return SEM_OPERATOR;
+	default:
+		break;
+	}
+
+	if (type >= TOK_AND && type <= TOK_WHILE) {
+		return SEM_KEYWORD;
+	}
+	if (type >= TOK_ASSIGN && type <= TOK_AT) {
+		return SEM_OPERATOR;
+	}
+	return SEM_NONE;
+}
+
+/**
+ * Writes the declaration of a function or the type of a variable, from its tokens, so
+ * that it is there even when the function does not parse.
+ * @param doc Document the declaration belongs to.
+ * @param decl Declaration to describe.
+ * @returns Text such as "func f(num a) => num" or "num[]".
+ */
+static std::string describe(const Document &doc, const DeclRef &decl) {
+	const TokenStream &tokens = doc.getTokens();
+	std::string_view text = doc.getText();
+	std::string out;
+
+	// A function goes up to its body, a variable up to its name
+	size_t stop = decl.token;
+	if (decl.kind == DECL_FUNC) {
+		stop = decl.token + 1;
+		while (stop - decl.typeToken < 32 && tokens.types[stop] != TOK_LCURL && tokens.types[stop] != TOK_FUNC && tokens.types[stop] != TOK_EOF) {
+			stop++;
+		}
+	}
+
+	for (size_t token = decl.typeToken; token < stop; token++) {
+		TokenType type = tokens.types[token];
+		bool joined = (type == TOK_LPAR || type == TOK_RPAR || type == TOK_COMMA || type == TOK_ARRAY
+			|| (token > decl.typeToken && tokens.types[token - 1] == TOK_LPAR));
+
+		if (token > decl.typeToken && !joined) {
+			out += ' ';
+		}
+		out += text.substr(tokens.offsets[token], tokens.lengths[token]);
+	}
+	return out;
+}
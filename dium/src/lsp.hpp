@@ -0,0 +1,114 @@
+/**
+ * @file       lsp.hpp
+ * @brief      Definitions for the language server spoken to by editors
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef LSP_HPP
+#define LSP_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "document.hpp"
+#include "json.hpp"
+
+/** Most completion items sent for one request, the client asks again as the prefix grows */
+#define LSP_MAX_COMPLETIONS 100
+
+/** Kinds of semantic tokens, in the order of the legend sent to the client */
+enum SemanticType : uint8_t {
+	SEM_KEYWORD,
+	SEM_TYPE,
+	SEM_FUNCTION,
+	SEM_VARIABLE,
+	SEM_PARAMETER,
+	SEM_STRING,
+	SEM_NUMBER,
+	SEM_OPERATOR,
+	SEM_NONE       /* not highlighted, like punctuation */
+};
+
+/**
+ * Language server for dium source files, speaking the Language Server Protocol. It
+ * offers semantic tokens, diagnostics, go-to-definition and completion of functions and
+ * variables. Open files are kept as `Document`s, edited in place by every change the
+ * editor sends, so requests are answered from their tokens and declaration indexes
+ * without reading anything from disk. The semantic tokens of every function are kept
+ * too, and only worked out again for functions that were parsed again.
+ * Positions are in bytes, which the client is asked to agree to. Clients that insist on
+ * UTF-16 get the same numbers, which only match for ASCII text.
+ */
+class LanguageServer {
+public:
+	LanguageServer() = default;
+
+	LanguageServer(const LanguageServer &) = delete;
+	LanguageServer &operator=(const LanguageServer &) = delete;
+
+	/**
+	 * Handles a single message from the client.
+	 * @param message Content of the message, without its header.
+	 * @param[out] out String to append the messages sent back to, with their headers.
+	 * @returns `false` once the client told the server to exit, `true` otherwise.
+	 */
+	bool handle(std::string_view message, std::string *out);
+
+	/**
+	 * Returns the exit code the protocol asks for.
+	 * @returns 0 if the client shut the server down before telling it to exit, 1 otherwise.
+	 */
+	int getExitCode() const {
+		return shutdown ? 0 : 1;
+	}
+
+private:
+	/* Semantic tokens of one function, kept until it is parsed again */
+	struct Segment {
+		uint32_t first;     /* Index of its first highlighted token, relative to the function */
+		uint32_t last;      /* Index of its last highlighted token, relative too */
+		uint32_t head[3];   /* Length, type and modifiers of the first one */
+		std::string rest;   /* ",line,start,length,type,modifiers" of every other one */
+	};
+
+	/* File opened by the client */
+	struct OpenFile {
+		std::unique_ptr<Document> doc;
+		int64_t version;
+		std::string diagnostics;                         /* Diagnostics last published */
+		std::unordered_map<uint64_t, Segment> segments;  /* Semantic tokens by function id */
+	};
+
+	/** Files opened by the client, by URI */
+	std::unordered_map<std::string, OpenFile> files;
+
+	/** `true` once the client asked the server to shut down */
+	bool shutdown = false;
+
+	void initialize(const JsonValue &id, const JsonValue &params, std::string *out);
+	void open(const JsonValue &params, std::string *out);
+	void change(const JsonValue &params, std::string *out);
+	void close(const JsonValue &params, std::string *out);
+	void semanticTokens(const JsonValue &id, const JsonValue &params, std::string *out);
+	void definition(const JsonValue &id, const JsonValue &params, std::string *out);
+	void completion(const JsonValue &id, const JsonValue &params, std::string *out);
+	void publishDiagnostics(const std::string &uri, OpenFile *file, std::string *out);
+	OpenFile *findFile(const JsonValue &params);
+};
+
+/**
+ * Runs a language server over the standard input and output until the client tells
+ * it to exit.
+ * @param recordPath File to copy every message from the client to, so that the session
+ *     can be replayed later, or `nullptr`.
+ * @returns Exit code of the server.
+ */
+int runLanguageServer(const char *recordPath);
+
+#endif // LSP_HPP
@@ -6,124 +6,631 @@
  * @date       2022-07-28
  */
 
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "arena.hpp"
+#include "cache.hpp"
+#include "cbackend.hpp"
+#include "checker.hpp"
+#include "compiler.hpp"
+#include "debug.hpp"
+#include "diagnostics.hpp"
+#include "driver.hpp"
 #include "error.hpp"
+#include "image.hpp"
 #include "lexer.hpp"
+#include "lsp.hpp"
+#include "optimizer.hpp"
+#include "output.hpp"
+#include "parser.hpp"
+#include "profiler.hpp"
+#include "stats.hpp"
+#include "vm.hpp"
+
+#ifdef _WIN32
+	#include <process.h>
+#else
+	#include <spawn.h>
+	#include <sys/wait.h>
 
-#ifdef DIUM_DEBUG
-	template<typename ...Args>
-	void debugInfo(const char *fmt, Args... args);
+extern char **environ;
+#endif
 
-	template<typename ...Args>
-	void debugStart(const char *fmt, Args... args);
+/* Name of the source file */
+std::string sname;
 
-	template<typename ...Args>
-	void debugEnd(const char *fmt, Args... args);
+/** What to do with the source file */
+enum RunMode {
+	MODE_RUN,       /* compile and run the program */
+	MODE_BENCH,     /* run the program and report the speed of the virtual machine */
+	MODE_AST,       /* print the syntax tree */
+	MODE_IMAGE,     /* write the tokens and syntax tree to an image file */
+	MODE_BYTECODE,  /* print the compiled bytecode */
+	MODE_IR,        /* print the optimized intermediate representation */
+	MODE_LEX,       /* count the tokens of any number of files */
+	MODE_BUILD      /* compile the program to a native executable through C */
+};
 
-	#define DEBUG_START(...) debugStart(__VA_ARGS__)
-	#define DEBUG_END(...)   debugEnd(__VA_ARGS__)
-	#define DEBUG_INFO(...)  debugInfo(__VA_ARGS__)
-#else
-	#define DEBUG_START(...)
-	#define DEBUG_END(...)
-	#define DEBUG_INFO(...)
-#endif
+/* When functions are compiled to machine code */
+JitMode jitMode = JIT_ON;
 
-/* Current token */
-Token token;
+/* Optimization passes to run on the bytecode (and level for the C compiler) */
+OptLevel optLevel = OPT_FULL;
 
-/* Name of the source file */
-std::string sname;
+/* Executable or C file written by `dium build`, or image written by `--image` */
+std::string outputPath;
 
-void parseSource();
+/* `true` to print statistics of the run when it ends */
+bool printStats = false;
+
+/* Chrome trace written when the run ends, if not empty */
+std::string tracePath;
+
+/* Folded stacks written when the program ends, if not empty */
+std::string profilePath;
+
+/* Samples the program when it is profiled */
+Profiler profiler;
+
+/* `true` once the program started running under the profiler */
+bool profiling = false;
+
+/* Directory of the cache of compiled programs, empty to always compile */
+std::string cacheDirectory;
+
+int runSource(RunMode mode, const BytecodeCache *cache);
+int runCached(RunMode mode, const BytecodeCache &cache);
+int runModule(RunMode mode, const Module &module);
+int lexSources(int count, char *paths[]);
+int buildProgram(const Program *program);
+int runCompiler(const std::vector<std::string> &args);
+void reportStats();
+void reportProfile();
+
+/**
+ * Prints how to use the command line.
+ * @param out Stream to print to.
+ */
+static void printUsage(std::ostream &out) {
+	out << "Usage:\n"
+		<< "  dium [options] <file>              run a program\n"
+		<< "  dium [options] -                   run a program read from standard input\n"
+		<< "  dium build <file> [-o <output>]    compile a program to a native executable,\n"
+		<< "                                     or to C when <output> ends in .c\n"
+		<< "  dium --lex <files...>              count the tokens of source files\n"
+		<< "  dium lsp [--record=<file>]         serve editors over the Language Server Protocol\n"
+		<< "                                     on stdio, copying what they send to <file>\n"
+		<< "\n"
+		<< "Options:\n"
+		<< "  -O0, -O1, -O2        optimization level (default -O2, see optimizer.hpp)\n"
+		<< "  --jit=off|on|eager   when to compile functions to machine code (default on)\n"
+		<< "  --bench              report the speed of the virtual machine\n"
+		<< "  --ast                print the syntax tree\n"
+		<< "  --image=<file>       write the tokens and syntax tree to <file>, for tools to map\n"
+		<< "                       and read in place (see image.hpp)\n"
+		<< "  --bytecode           print the compiled bytecode\n"
+		<< "  --ir                 print the optimized intermediate representation\n"
+		<< "  --max-errors=<n>     stop after n errors, 0 for no limit (default 20)\n"
+		<< "  --diagnostics=json   print errors and warnings as JSON, one object per line\n"
+		<< "  --stats              report the time of each phase, tokens, allocations and\n"
+		<< "                       instructions when the run ends\n"
+		<< "  --trace=<file>       write the same as a Chrome trace (chrome://tracing, Perfetto)\n"
+		<< "  --debug              trace the parser on standard error\n"
+		<< "  --profile=<file>     sample the program, write folded stacks for flame graphs to\n"
+		<< "                       <file> and print the source annotated with the samples\n"
+		<< "  --profile-interval=<n>\n"
+		<< "                       instructions between samples (default 1000)\n"
+		<< "  --cache[=<dir>]      keep compiled programs in <dir> (default ~/.cache/dium), or in\n"
+		<< "                       $DIUM_CACHE when it is set, and run them without compiling\n"
+		<< "  --no-cache           always compile, even when $DIUM_CACHE is set\n"
+		<< "  -h, --help           print this message\n";
+}
 
 /**
  * Main method.
  */
 int main(int argc, char *argv[]) {
+	RunMode mode = MODE_RUN;
+	const char *filePath = nullptr;
+	int arg = 1;
+
+	const char *cacheVariable = getenv("DIUM_CACHE");
+	if (cacheVariable != nullptr) {
+		cacheDirectory = cacheVariable;
+	}
+
+	// The language server talks to an editor until it is told to exit
+	if (arg < argc && strcmp(argv[arg], "lsp") == 0) {
+		const char *recordPath = nullptr;
+		for (arg++; arg < argc; arg++) {
+			if (strncmp(argv[arg], "--record=", 9) == 0 && argv[arg][9] != '\0') {
+				recordPath = argv[arg] + 9;
+			} else {
+				customPrint(ASCII_BOLD_RED "Error:" ASCII_RESET, nullptr, nullptr, "Unknown option '%s'", argv[arg]);
+				return 2;
+			}
+		}
+		return runLanguageServer(recordPath);
+	}
+
+	if (arg < argc && strcmp(argv[arg], "build") == 0) {
+		mode = MODE_BUILD;
+		arg++;
+	}
+
+	for (; arg < argc; arg++) {
+		// Everything after `--lex` is a file to lex
+		if (mode == MODE_LEX) {
+			break;
+		}
+
+		// A lone `-` reads the program from standard input
+		if (argv[arg][0] != '-' || strcmp(argv[arg], "-") == 0) {
+			if (filePath != nullptr) {
+				customPrint(ASCII_BOLD_RED "Error:" ASCII_RESET, nullptr, nullptr, "Unexpected argument '%s'", argv[arg]);
+				return 2;
+			}
+			filePath = argv[arg];
+		} else if (strcmp(argv[arg], "-h") == 0 || strcmp(argv[arg], "--help") == 0) {
+			printUsage(std::cout);
+			return 0;
+		} else if (strcmp(argv[arg], "-o") == 0 && mode == MODE_BUILD) {
+			if (++arg == argc) {
+				customPrint(ASCII_BOLD_RED "Error:" ASCII_RESET, nullptr, nullptr, "Expected a file name after '-o'");
+				return 2;
+			}
+			outputPath = argv[arg];
+		} else if (strcmp(argv[arg], "--bench") == 0) {
+			mode = MODE_BENCH;
+		} else if (strcmp(argv[arg], "--ast") == 0) {
+			mode = MODE_AST;
+		} else if (strncmp(argv[arg], "--image=", 8) == 0 && argv[arg][8] != '\0') {
+			mode = MODE_IMAGE;
+			outputPath = argv[arg] + 8;
+		} else if (strcmp(argv[arg], "--bytecode") == 0) {
+			mode = MODE_BYTECODE;
+		} else if (strcmp(argv[arg], "--ir") == 0) {
+			mode = MODE_IR;
+		} else if (strcmp(argv[arg], "-O0") == 0) {
+			optLevel = OPT_NONE;
+		} else if (strcmp(argv[arg], "-O1") == 0) {
+			optLevel = OPT_BASIC;
+		} else if (strcmp(argv[arg], "-O2") == 0) {
+			optLevel = OPT_FULL;
+		} else if (strcmp(argv[arg], "--lex") == 0) {
+			mode = MODE_LEX;
+		} else if (strcmp(argv[arg], "--jit=off") == 0) {
+			jitMode = JIT_OFF;
+		} else if (strcmp(argv[arg], "--jit=on") == 0) {
+			jitMode = JIT_ON;
+		} else if (strcmp(argv[arg], "--jit=eager") == 0) {
+			jitMode = JIT_EAGER;
+		} else if (strncmp(argv[arg], "--max-errors=", 13) == 0 && isdigit(static_cast<unsigned char>(argv[arg][13]))) {
+			getDiagnostics().setMaxErrors(strtoul(argv[arg] + 13, nullptr, 10));
+		} else if (strcmp(argv[arg], "--diagnostics=json") == 0) {
+			getDiagnostics().setFormat(DIAGNOSTICS_JSON);
+		} else if (strcmp(argv[arg], "--diagnostics=text") == 0) {
+			getDiagnostics().setFormat(DIAGNOSTICS_TEXT);
+		} else if (strcmp(argv[arg], "--stats") == 0) {
+			printStats = true;
+		} else if (strcmp(argv[arg], "--debug") == 0) {
+			debugEnabled = true;
+		} else if (strncmp(argv[arg], "--trace=", 8) == 0 && argv[arg][8] != '\0') {
+			tracePath = argv[arg] + 8;
+		} else if (strncmp(argv[arg], "--profile=", 10) == 0 && argv[arg][10] != '\0') {
+			profilePath = argv[arg] + 10;
+		} else if (strncmp(argv[arg], "--profile-interval=", 19) == 0 && isdigit(static_cast<unsigned char>(argv[arg][19]))) {
+			profiler = Profiler(static_cast<uint32_t>(strtoul(argv[arg] + 19, nullptr, 10)));
+		} else if (strcmp(argv[arg], "--cache") == 0) {
+			cacheDirectory = BytecodeCache::getDefaultDirectory();
+		} else if (strncmp(argv[arg], "--cache=", 8) == 0 && argv[arg][8] != '\0') {
+			cacheDirectory = argv[arg] + 8;
+		} else if (strcmp(argv[arg], "--no-cache") == 0) {
+			cacheDirectory.clear();
+		} else {
+			customPrint(ASCII_BOLD_RED "Error:" ASCII_RESET, nullptr, nullptr, "Unknown option '%s'", argv[arg]);
+			return 2;
+		}
+	}
+
+	// Lex every file given on the command line in parallel
+	if (mode == MODE_LEX) {
+		return lexSources(argc - arg, argv + arg);
+	}
 
-	const std::string fileName{ "fizzbuzz.dm" };
-	const std::string filePath{ "../examples/" + fileName };
+	if (filePath == nullptr) {
+		customPrint(ASCII_BOLD_RED "Error:" ASCII_RESET, nullptr, nullptr, "No source file given");
+		printUsage(std::cerr);
+		return 2;
+	}
 
 	// Initialize source file name
-	sname = fileName;
+	sname = filePath;
+
+	// Build next to the source file by default
+	if (mode == MODE_BUILD && outputPath.empty()) {
+		size_t length = sname.size();
+		bool hasExtension = length > 3 && sname.compare(length - 3, 3, ".dm") == 0;
+		outputPath = hasExtension ? sname.substr(0, length - 3) : sname + ".out";
+	}
+
+	// Report even when an error exits the process. Standard output is created first so
+	// that it is destroyed after the report, which flushes it
+	if (printStats || !tracePath.empty()) {
+		getStdout();
+		enableStats();
+		std::atexit(reportStats);
+	}
 
-	// Initialize the lexer
-	init(filePath.c_str());
+	// Machine code is not sampled, so profiled programs are only interpreted
+	if (!profilePath.empty()) {
+		getStdout();
+		jitMode = JIT_OFF;
+		std::atexit(reportProfile);
+	}
 
-	// Start reading
-	getToken(&token);
-	parseSource();
+	int status;
+	if (!cacheDirectory.empty() && (mode == MODE_RUN || mode == MODE_BENCH)) {
+		// Programs that are run may come from the cache, which is looked up by content
+		openFile(filePath);
+		BytecodeCache cache(cacheDirectory, getSource(), getSourceSize(), optLevel);
+		status = runCached(mode, cache);
+	} else {
+		// Initialize the lexer
+		init(filePath);
+
+		// Start reading
+		status = runSource(mode, nullptr);
+	}
+	close();
 
+	return status;
 }
 
 /**
- * Parses the source file.
+ * Lexes the given source files in parallel and reports the number of tokens in each.
+ * @param count Number of source files.
+ * @param paths Paths to the source files.
+ * @returns Exit code, non-zero if any file could not be opened.
  */
-void parseSource() {
-	std::string toPrint;
+int lexSources(int count, char *paths[]) {
+	std::vector<LexedFile> files = lexFiles(std::vector<std::string>(paths, paths + count));
+	int status = 0;
+
+	for (const LexedFile &file : files) {
+		if (!file.opened) {
+			customPrint(ASCII_BOLD_RED "Error:" ASCII_RESET, file.path.c_str(), nullptr, "File could not be opened");
+			status = 2;
+			continue;
+		}
 
-	while (token.type != TOK_EOF) {
-		toPrint = "";
+		std::cout << file.path << ": " << file.tokens.size() - 1 << " tokens\n";
+	}
 
-		if (token.identifier) {
-			toPrint += (token.type == TOK_ID) ? token.identifier.value() + " " : customFormat("[%s] ", token.identifier.value().c_str());
-		}
+	std::cout.flush();
+	if (getDiagnostics().flush()) {
+		status = 2;
+	}
 
-		if (token.string) {
-			toPrint += customFormat("\"%s\" ", token.string.value().c_str());
-		}
+	closeFiles(files);
+	return status;
+}
+
+/**
+ * Parses, checks and compiles the source file, then runs it or prints one of the stages.
+ * @param mode What to do with the source file.
+ * @param cache Cache to save the compiled program to, or `nullptr`.
+ * @returns Exit code of the program, or 0 if it is not run.
+ */
+int runSource(RunMode mode, const BytecodeCache *cache) {
+	Arena arena;
+	Parser parser(getTokens(), arena, sname, getDiagnostics());
+	Program *program;
+	{
+		PhaseTimer timer(PHASE_PARSE);
+		program = parser.parse();
+	}
+	countArena(arena);
+
+	// Report every lexical and syntax error of the file at once
+	if (getDiagnostics().flush()) {
+		return 2;
+	}
+
+	if (mode == MODE_AST) {
+		getStdout().write(printProgram(program));
+		return 0;
+	}
+
+	if (mode == MODE_IMAGE) {
+		std::string image = writeImage(getSource(), getSourceSize(), getTokens(), getSymbols(), program);
+		std::ofstream file(outputPath, std::ios::binary);
+		file.write(image.data(), static_cast<std::streamsize>(image.size()));
+		file.close();
 
-		if (token.character) {
-			toPrint += customFormat("'%c' ", token.character.value());
+		if (!file) {
+			customPrint(ASCII_BOLD_RED "Error:" ASCII_RESET, outputPath.c_str(), nullptr, "File could not be written");
+			return 2;
 		}
+		return 0;
+	}
+
+	Checker checker(program, arena, sname);
+	{
+		PhaseTimer timer(PHASE_CHECK);
+		checker.check();
+	}
+	countArena(arena);
+
+	if (mode == MODE_BUILD) {
+		return buildProgram(program);
+	}
+
+	Compiler compiler(program, sname);
+	Module module;
+	{
+		PhaseTimer timer(PHASE_COMPILE);
+		module = compiler.compile();
+	}
+
+	Optimizer optimizer(module, optLevel);
+	std::string listing;
+	{
+		PhaseTimer timer(PHASE_OPTIMIZE);
+		optimizer.optimize((mode == MODE_IR) ? &listing : nullptr);
+	}
 
-		if (token.ivalue) {
-			toPrint += customFormat("%d ", token.ivalue.value());
+	if (mode == MODE_IR) {
+		getStdout().write(listing);
+		return 0;
+	}
+
+	if (mode == MODE_BYTECODE) {
+		getStdout().write(printModule(module));
+		return 0;
+	}
+
+	// Saved before running, since the program may end in a runtime error. Failing to
+	// save only means compiling again next time
+	if (cache != nullptr) {
+		cache->save(module);
+	}
+
+	return runModule(mode, module);
+}
+
+/**
+ * Runs the compiled program of the source file from the cache, or compiles it (and
+ * saves it for next time) when the cache has none.
+ * @param mode Whether to report the speed of the virtual machine.
+ * @param cache Cache of the source file, which has been opened but not lexed.
+ * @returns Exit code of the program.
+ */
+int runCached(RunMode mode, const BytecodeCache &cache) {
+	Module module;
+	bool loaded;
+	{
+		PhaseTimer timer(PHASE_LOAD);
+		loaded = cache.load(sname, &module);
+	}
+
+	if (!loaded) {
+		lexFile();
+		return runSource(mode, &cache);
+	}
+	return runModule(mode, module);
+}
+
+/**
+ * Runs a compiled program.
+ * @param mode Whether to report the speed of the virtual machine.
+ * @param module Compiled and optimized program.
+ * @returns Exit code of the program.
+ */
+int runModule(RunMode mode, const Module &module) {
+	VM vm(module, jitMode);
+
+	if (!profilePath.empty()) {
+		profiler.start(module);
+		vm.setProfiler(&profiler);
+		profiling = true;
+	}
+
+	// Counting instructions is what slows the virtual machine down, so only do it when asked
+	auto start = std::chrono::steady_clock::now();
+	int status;
+	{
+		PhaseTimer timer(PHASE_EXECUTE);
+		status = vm.run(mode == MODE_BENCH || statsEnabled());
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	countRun(vm);
+
+	// The listing needs the source file, which is closed once this returns
+	reportProfile();
+
+	if (mode != MODE_BENCH) {
+		return status;
+	}
+
+	double seconds = elapsed.count();
+	double count = static_cast<double>(vm.getInstructionCount());
+
+	getStdout().flush();
+	std::cerr << customFormat("\nDispatch:      %s\n", VM::getDispatchName())
+		<< customFormat("JIT:           %zu functions compiled\n", vm.getCompiledCount())
+		<< customFormat("Instructions:  %.0f interpreted\n", count)
+		<< customFormat("Time:          %.3f ms\n", seconds * 1000.0)
+		<< customFormat("Speed:         %.1f M instructions/s\n", (seconds > 0) ? count / seconds / 1e6 : 0.0);
+
+	return status;
+}
+
+/**
+ * Compiles a checked program to C and builds it with the system C compiler, which is
+ * taken from the CC environment variable (one program, `cc` by default) and run at the same
+ * optimization level. When the output file ends in ".c", only the C source is written.
+ * @param program Checked syntax tree of the program.
+ * @returns 0 on success, 2 on failure.
+ */
+int buildProgram(const Program *program) {
+	CBackend backend(program, sname);
+	std::string source = backend.generate();
+
+	bool sourceOnly = outputPath.size() > 2 && outputPath.compare(outputPath.size() - 2, 2, ".c") == 0;
+	std::string sourcePath = sourceOnly ? outputPath : outputPath + ".c";
+
+	std::ofstream file(sourcePath, std::ios::binary);
+	file << source;
+	file.close();
+
+	if (!file) {
+		customPrint(ASCII_BOLD_RED "Error:" ASCII_RESET, sourcePath.c_str(), nullptr, "File could not be written");
+		return 2;
+	}
+
+	if (sourceOnly) {
+		return 0;
+	}
+
+	// A path starting with '-' would be taken for an option of the compiler
+	std::string sourceArg = (sourcePath[0] == '-') ? "./" + sourcePath : sourcePath;
+	const char *cc = getenv("CC");
+	std::vector<std::string> args = { (cc != nullptr && cc[0] != '\0') ? cc : "cc", "-std=c99", customFormat("-O%d", static_cast<int>(optLevel)), "-o",
+		outputPath, sourceArg, "-lm" };
+
+	int status = runCompiler(args);
+	if (status != 0) {
+		std::string command;
+		for (const std::string &arg : args) {
+			command += (command.empty() ? "" : " ") + arg;
 		}
 
-		if (token.dvalue) {
-			toPrint += customFormat("%d ", token.dvalue.value());
+		// Keep the C source around to see what went wrong
+		customPrint(ASCII_BOLD_RED "Error:" ASCII_RESET, sourcePath.c_str(), nullptr,
+			(status < 0) ? "C compiler could not be run: %s" : "C compiler failed: %s", command.c_str());
+		return 2;
+	}
+
+	std::remove(sourcePath.c_str());
+	return 0;
+}
+
+/**
+ * Runs the C compiler and waits for it. No shell is involved, so paths are passed as
+ * they are, whatever characters they contain.
+ * @param args Compiler, looked up in PATH, followed by its arguments.
+ * @returns Exit code of the compiler, -1 if it could not be run or was killed.
+ */
+int runCompiler(const std::vector<std::string> &args) {
+	getStdout().flush();
+	std::cout.flush();
+
+#ifdef _WIN32
+	// The arguments are joined into one command line, which the compiler splits again
+	std::vector<std::string> quoted;
+	for (const std::string &arg : args) {
+		if (!arg.empty() && arg.find_first_of(" \t\"") == std::string::npos) {
+			quoted.push_back(arg);
+			continue;
 		}
 
-		if (toPrint.length() < 1) {
-			toPrint += customFormat("%s ", getTokenString(token.type));
+		// Backslashes are only special before a quote, where they are doubled
+		std::string text = "\"";
+		size_t slashes = 0;
+		for (char c : arg) {
+			if (c == '\\') {
+				slashes++;
+			} else {
+				if (c == '"') {
+					text.append(slashes + 1, '\\');
+				}
+				slashes = 0;
+			}
+			text += c;
 		}
+		text.append(slashes, '\\');
+		quoted.push_back(text + "\"");
+	}
 
-		std::cout << toPrint;
-		getToken(&token);
+	std::vector<const char *> argv;
+	for (const std::string &arg : quoted) {
+		argv.push_back(arg.c_str());
 	}
+	argv.push_back(nullptr);
 
-	std::cout << std::endl;
+	intptr_t status = _spawnvp(_P_WAIT, args[0].c_str(), argv.data());
+	return (status < 0) ? -1 : static_cast<int>(status);
+#else
+	std::vector<char *> argv;
+	for (const std::string &arg : args) {
+		argv.push_back(const_cast<char *>(arg.c_str()));
+	}
+	argv.push_back(nullptr);
+
+	pid_t pid;
+	if (posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ) != 0) {
+		return -1;
+	}
+
+	int status;
+	while (waitpid(pid, &status, 0) < 0) {
+		if (errno != EINTR) {
+			return -1;
+		}
+	}
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
 }
 
+/**
+ * Prints the statistics of the run and writes its trace, as asked on the command line.
+ * Registered with `atexit`, so that runs ended by an error are reported as well.
+ */
+void reportStats() {
+	getStdout().flush();
 
-#ifdef DIUM_DEBUG
+	if (printStats) {
+		std::cerr << formatStats();
+	}
 
-/** Number of spaces to indent when printing */
-static int indent = 0;
+	if (!tracePath.empty()) {
+		std::ofstream file(tracePath, std::ios::binary);
+		file << formatTrace();
+		file.close();
 
-template<typename ...Args>
-void debugStart(const char *fmt, Args... args) {
-	debugInfo(fmt, args...);
-	indent += 2;
+		if (!file) {
+			customPrint(ASCII_BOLD_RED "Error:" ASCII_RESET, tracePath.c_str(), nullptr, "File could not be written");
+		}
+	}
 }
 
-template<typename ...Args>
-void debugEnd(const char *fmt, Args... args) {
-	indent -= 2;
-	debugInfo(fmt, args...);
-}
+/**
+ * Writes the folded stacks of the profile and prints the annotated source, once the
+ * program has run. Also registered with `atexit`, for programs ended by an error.
+ */
+void reportProfile() {
+	if (!profiling) {
+		return;
+	}
+	profiling = false;
+	getStdout().flush();
 
-template<typename ...Args>
-void debugInfo(const char *fmt, Args... args) {
-	std::string temp = "";
+	std::ofstream file(profilePath, std::ios::binary);
+	file << profiler.formatFolded();
+	file.close();
 
-	for (int idx = 0; idx < indent; idx++) {
-		temp += " ";
+	if (!file) {
+		customPrint(ASCII_BOLD_RED "Error:" ASCII_RESET, profilePath.c_str(), nullptr, "File could not be written");
 	}
 
-	temp += fmt;
-	std::cout << customFormat(temp.c_str(), args...) << std::endl;
+	std::cerr << profiler.formatListing(getSource());
 }
-
-#endif
@@ -0,0 +1,886 @@
+/**
+ * @file       optimizer.cpp
+ * @brief      Implementation of the bytecode optimizer
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "optimizer.hpp"
+
+namespace {
+
+/* What the passes may do with an operation */
+enum OpFlags : uint8_t {
+	OPF_PURE = 1,         /* has no effect besides its result, so it can go when unused */
+	OPF_SAFE = 2,         /* never fails, so it can run where it would not have */
+	OPF_REUSABLE = 4,     /* always gives the same result for the same operands */
+	OPF_COMMUTATIVE = 8   /* gives the same result with its operands swapped */
+};
+
+/**
+ * Returns what the passes may do with an operation.
+ * @param op Operation.
+ * @returns Combination of `OpFlags`.
+ */
+uint8_t getFlags(Opcode op) {
+	constexpr uint8_t plain = OPF_PURE | OPF_SAFE | OPF_REUSABLE;
+
+	switch (op) {
+	case OP_ADD_NUM:
+	case OP_MUL_NUM:
+	case OP_ADD_DEC:
+	case OP_MUL_DEC:
+	case OP_EQ_NUM:
+	case OP_NE_NUM:
+	case OP_EQ_DEC:
+	case OP_NE_DEC:
+	case OP_EQ_STR:
+	case OP_NE_STR:
+	case OP_EQ_REF:
+	case OP_NE_REF:
+		return plain | OPF_COMMUTATIVE;
+	case OP_LOADI:
+	case OP_LOADK:
+	case OP_SUB_NUM:
+	case OP_NEG_NUM:
+	case OP_DIVP2_NUM:
+	case OP_MODP2_NUM:
+	case OP_SUB_DEC:
+	case OP_DIV_DEC:
+	case OP_MOD_DEC:
+	case OP_NEG_DEC:
+	case OP_NOT:
+	case OP_LT_NUM:
+	case OP_LE_NUM:
+	case OP_LT_DEC:
+	case OP_LE_DEC:
+	case OP_LT_STR:
+	case OP_LE_STR:
+	case OP_NUM2DEC:
+	case OP_NUM2BOOL:
+		return plain;
+	case OP_DIV_NUM:
+	case OP_MOD_NUM:
+	case OP_DEC2NUM:
+	case OP_NUM2CHAR:
+	case OP_STR2NUM:
+	case OP_STR2DEC:
+	case OP_STR2CHAR:
+	case OP_GETCHAR:
+		// These fail on some operands, but strings are immutable
+		return OPF_REUSABLE;
+	case OP_NEWARRAY:
+	case OP_CONCAT:
+	case OP_TOSTR:
+		return OPF_PURE;
+	default:
+		// Array reads see stores, and the rest have effects
+		return 0;
+	}
+}
+
+/**
+ * Finds the exponent of a power of two.
+ * @param num Number to check.
+ * @returns k if `num` is 2^k with 0 < k < 63, or 0 otherwise.
+ */
+int getPowerOfTwo(int64_t num) {
+	if (num < 2 || (num & (num - 1)) != 0) {
+		return 0;
+	}
+
+	int shift = 0;
+	while ((int64_t{ 1 } << shift) != num) {
+		shift++;
+	}
+	return shift;
+}
+
+/** Wraps a result around like the `num` operators of the virtual machine */
+int64_t wrap(uint64_t num) {
+	return static_cast<int64_t>(num);
+}
+
+/**
+ * Identifies a constant by its kind and bytes, as the compiler does.
+ * @param constant Constant to identify.
+ * @returns Key of the constant.
+ */
+std::string getConstantKey(const Constant &constant) {
+	std::string key(1, static_cast<char>(constant.kind));
+
+	switch (constant.kind) {
+	case CONST_DEC:
+		key.append(reinterpret_cast<const char *>(&constant.dec), sizeof(constant.dec));
+		break;
+	case CONST_STR:
+		key += constant.text;
+		break;
+	default:
+		key.append(reinterpret_cast<const char *>(&constant.num), sizeof(constant.num));
+		break;
+	}
+
+	return key;
+}
+
+/* Operation that common subexpression elimination can reuse, with resolved operands */
+struct Expression {
+	Opcode op;
+	uint8_t type;
+	int64_t imm;
+
+	/** Operands, `NO_VALUE` where the operation has fewer */
+	ValueId args[2];
+
+	bool operator==(const Expression &other) const {
+		return op == other.op && type == other.type && imm == other.imm
+			&& args[0] == other.args[0] && args[1] == other.args[1];
+	}
+};
+
+/* Hash of an `Expression`, for `std::unordered_map` */
+struct ExpressionHash {
+	size_t operator()(const Expression &expr) const {
+		uint64_t hash = (static_cast<uint64_t>(expr.op) << 8) | expr.type;
+		hash = (hash ^ static_cast<uint64_t>(expr.imm)) * 0x9E3779B97F4A7C15u;
+		hash = (hash ^ expr.args[0]) * 0x9E3779B97F4A7C15u;
+		hash = (hash ^ expr.args[1]) * 0x9E3779B97F4A7C15u;
+		return static_cast<size_t>(hash ^ (hash >> 32));
+	}
+};
+
+} // namespace
+
+Optimizer::Optimizer(Module &module, OptLevel level)
+	: module{ module }, level{ level } {
+	for (size_t idx = 0; idx < module.constants.size(); idx++) {
+		constantIndex.emplace(getConstantKey(module.constants[idx]), static_cast<uint32_t>(idx));
+	}
+}
+
+void Optimizer::optimize(std::string *listing) {
+	if (level == OPT_NONE) {
+		return;
+	}
+
+	for (Function &func : module.funcs) {
+		IrFunction function;
+		ir = &function;
+
+		if (!buildIr(module, func, ir)) {
+			continue;
+		}
+
+		foldConstants();
+		fuseConcats();
+		eliminateDeadCode();
+
+		if (level >= OPT_FULL) {
+			eliminateCommonSubexpressions();
+			hoistInvariants();
+
+			// Hoisting and reuse expose more constants and dead values
+			foldConstants();
+			eliminateDeadCode();
+		}
+
+		if (listing != nullptr) {
+			*listing += printIr(module, *ir);
+		}
+		lowerIr(*ir, &func);
+	}
+
+	ir = nullptr;
+}
+
+// --------------- constant folding ----------------------------
+
+/**
+ * Folds operations on constants into constants, propagating them through phis, and
+ * turns branches on constant conditions into jumps, which makes the other side dead.
+ * Also applies identities (`x + 0`, `x * 1`, ...) and reduces division and remainder
+ * by powers of two to shifts and masks.
+ * @returns `true` if anything changed.
+ */
+bool Optimizer::foldConstants() {
+	std::vector<Known> known(ir->refs.size(), Known{ false, false, 0, 0 });
+	bool changedAny = false;
+
+	for (bool changed = true; changed;) {
+		changed = false;
+
+		// Blocks found reachable so far in this round. A predecessor that comes earlier
+		// and was not reached no longer runs, so its phi operands can be ignored without
+		// waiting for `simplify`, which lets a chain of folded branches go in one round.
+		std::vector<uint32_t> order = ir->getOrder();
+		std::vector<uint32_t> ranks(ir->blocks.size(), UINT32_MAX);
+		std::vector<bool> reached(ir->blocks.size(), false);
+		reached[0] = true;
+
+		for (uint32_t rank = 0; rank < order.size(); rank++) {
+			ranks[order[rank]] = rank;
+		}
+
+		for (uint32_t rank = 0; rank < order.size(); rank++) {
+			uint32_t block = order[rank];
+			IrBlock &current = ir->blocks[block];
+
+			// A phi choosing between equal constants is that constant
+			for (size_t idx = 0; idx < current.phis.size();) {
+				const IrPhi &phi = current.phis[idx];
+				Known first{ false, false, 0, 0 };
+				bool same = false;
+				bool seen = false;
+
+				for (size_t arg = 0; arg < phi.args.size(); arg++) {
+					uint32_t pred = current.preds[arg];
+					if (!reached[pred] && (ranks[pred] < rank || ranks[pred] == UINT32_MAX)) {
+						continue;
+					}
+
+					const Known &other = known[ir->resolve(phi.args[arg])];
+					if (!seen) {
+						first = other;
+						same = other.known;
+						seen = true;
+					}
+					same = same && other.known && other.isDec == first.isDec &&
+						memcmp(&other.num, &first.num, sizeof(first.num)) == 0 &&
+						memcmp(&other.dec, &first.dec, sizeof(first.dec)) == 0;
+				}
+
+				if (!same) {
+					idx++;
+					continue;
+				}
+
+				IrInst load{ OP_LOADI, 0, phi.dest, 0, {}, current.insts.front().position };
+				setConstant(&load, first);
+				known[phi.dest] = first;
+				current.phis.erase(current.phis.begin() + idx);
+				current.insts.insert(current.insts.begin(), std::move(load));
+				changed = true;
+			}
+
+			for (IrInst &inst : current.insts) {
+				if (inst.op == IR_DELETED) {
+					continue;
+				}
+
+				for (ValueId &arg : inst.args) {
+					arg = ir->resolve(arg);
+				}
+				changed = foldInst(block, &inst, known) || changed;
+			}
+
+			if (reached[block]) {
+				for (uint32_t succ : current.succs) {
+					reached[succ] = true;
+				}
+			}
+		}
+
+		if (changed) {
+			changedAny = true;
+			ir->simplify();
+		}
+	}
+
+	return changedAny;
+}
+
+/**
+ * Folds a single instruction.
+ * @param block Block of the instruction.
+ * @param inst Instruction to fold.
+ * @param known Constant value of each value, as far as it is known.
+ * @returns `true` if the instruction changed.
+ */
+bool Optimizer::foldInst(uint32_t block, IrInst *inst, std::vector<Known> &known) {
+	switch (inst->op) {
+	case OP_LOADI:
+		known[inst->dest] = Known{ true, false, inst->imm, 0 };
+		return false;
+	case OP_LOADK: {
+		const Constant &constant = module.constants[static_cast<size_t>(inst->imm)];
+		if (constant.kind != CONST_STR) {
+			known[inst->dest] = Known{ true, constant.kind == CONST_DEC, constant.num, constant.dec };
+		}
+		return false;
+	}
+	case OP_JMPF: {
+		const Known &cond = known[inst->args[0]];
+		if (!cond.known) {
+			return false;
+		}
+
+		// Only the side the condition picks stays reachable
+		IrBlock &current = ir->blocks[block];
+		ir->removeEdge(block, current.succs[(cond.num != 0) ? 1 : 0]);
+		inst->op = OP_JMP;
+		inst->args.clear();
+		return true;
+	}
+	default:
+		break;
+	}
+
+	if (inst->dest == NO_VALUE) {
+		return false;
+	}
+
+	bool constant = !inst->args.empty();
+	for (ValueId arg : inst->args) {
+		constant = constant && known[arg].known;
+	}
+
+	if (constant) {
+		Known result = evaluate(*inst, known);
+		if (result.known) {
+			setConstant(inst, result);
+			known[inst->dest] = result;
+			return true;
+		}
+	}
+
+	if (inst->args.size() != 2) {
+		return false;
+	}
+
+	// Identities of numbers (decimals have -0.0 and NaN to think of)
+	const Known &lhs = known[inst->args[0]];
+	const Known &rhs = known[inst->args[1]];
+	ValueId same = NO_VALUE;
+
+	switch (inst->op) {
+	case OP_ADD_NUM:
+		same = (rhs.known && rhs.num == 0) ? inst->args[0] : (lhs.known && lhs.num == 0) ? inst->args[1] : NO_VALUE;
+		break;
+	case OP_SUB_NUM:
+		same = (rhs.known && rhs.num == 0) ? inst->args[0] : NO_VALUE;
+		break;
+	case OP_MUL_NUM:
+		same = (rhs.known && rhs.num == 1) ? inst->args[0] : (lhs.known && lhs.num == 1) ? inst->args[1] : NO_VALUE;
+		break;
+	case OP_DIV_NUM:
+	case OP_MOD_NUM: {
+		if (!rhs.known) {
+			break;
+		}
+
+		if (rhs.num == 1) {
+			if (inst->op == OP_DIV_NUM) {
+				same = inst->args[0];
+			} else {
+				setConstant(inst, Known{ true, false, 0, 0 });
+				known[inst->dest] = Known{ true, false, 0, 0 };
+				return true;
+			}
+			break;
+		}
+
+		// Shifting and masking with a bias for negative dividends is cheaper than
+		// dividing, and cannot divide by zero
+		int shift = getPowerOfTwo(rhs.num);
+		if (shift != 0) {
+			inst->op = (inst->op == OP_DIV_NUM) ? OP_DIVP2_NUM : OP_MODP2_NUM;
+			inst->imm = shift;
+			inst->args.pop_back();
+			return true;
+		}
+		break;
+	}
+	default:
+		break;
+	}
+
+	if (same == NO_VALUE) {
+		return false;
+	}
+
+	ir->replace(inst->dest, same);
+	inst->op = IR_DELETED;
+	return true;
+}
+
+/**
+ * Computes the result of an operation on constants, exactly as the virtual machine
+ * would at run time.
+ * @param inst Instruction whose operands are all known.
+ * @param known Constant value of each value.
+ * @returns Result, unknown if it cannot be computed or would be a runtime error.
+ */
+Optimizer::Known Optimizer::evaluate(const IrInst &inst, const std::vector<Known> &known) const {
+	int64_t a = known[inst.args[0]].num;
+	double x = known[inst.args[0]].dec;
+	int64_t b = (inst.args.size() > 1) ? known[inst.args[1]].num : 0;
+	double y = (inst.args.size() > 1) ? known[inst.args[1]].dec : 0;
+
+	auto num = [](int64_t value) { return Known{ true, false, value, 0 }; };
+	auto dec = [](double value) { return Known{ true, true, 0, value }; };
+
+	switch (inst.op) {
+	case OP_ADD_NUM:
+		return num(wrap(static_cast<uint64_t>(a) + static_cast<uint64_t>(b)));
+	case OP_SUB_NUM:
+		return num(wrap(static_cast<uint64_t>(a) - static_cast<uint64_t>(b)));
+	case OP_MUL_NUM:
+		return num(wrap(static_cast<uint64_t>(a) * static_cast<uint64_t>(b)));
+	case OP_DIV_NUM:
+	case OP_MOD_NUM:
+		if (b == 0) {
+			break;
+		}
+		if (b == -1) {
+			return num((inst.op == OP_DIV_NUM) ? wrap(0 - static_cast<uint64_t>(a)) : 0);
+		}
+		return num((inst.op == OP_DIV_NUM) ? a / b : a % b);
+	case OP_DIVP2_NUM:
+	case OP_MODP2_NUM: {
+		int64_t divisor = int64_t{ 1 } << inst.imm;
+		return num((inst.op == OP_DIVP2_NUM) ? a / divisor : a % divisor);
+	}
+	case OP_NEG_NUM:
+		return num(wrap(0 - static_cast<uint64_t>(a)));
+	case OP_ADD_DEC:
+		return dec(x + y);
+	case OP_SUB_DEC:
+		return dec(x - y);
+	case OP_MUL_DEC:
+		return dec(x * y);
+	case OP_DIV_DEC:
+		return dec(x / y);
+	case OP_MOD_DEC:
+		return dec(std::fmod(x, y));
+	case OP_NEG_DEC:
+		return dec(-x);
+	case OP_NOT:
+		return num(!a);
+	case OP_EQ_NUM:
+		return num(a == b);
+	case OP_NE_NUM:
+		return num(a != b);
+	case OP_LT_NUM:
+		return num(a < b);
+	case OP_LE_NUM:
+		return num(a <= b);
+	case OP_EQ_DEC:
+		return num(x == y);
+	case OP_NE_DEC:
+		return num(x != y);
+	case OP_LT_DEC:
+		return num(x < y);
+	case OP_LE_DEC:
+		return num(x <= y);
+	case OP_NUM2DEC:
+		return dec(static_cast<double>(a));
+	case OP_NUM2BOOL:
+		return num(a != 0);
+	case OP_DEC2NUM:
+		if (x > -9223372036854775808.0 && x < 9223372036854775808.0) {
+			return num(static_cast<int64_t>(x));
+		}
+		break;
+	case OP_NUM2CHAR:
+		if (a >= 0 && a <= 255) {
+			return num(a);
+		}
+		break;
+	default:
+		break;
+	}
+
+	return Known{ false, false, 0, 0 };
+}
+
+/**
+ * Turns an instruction into a load of a constant.
+ * @param inst Instruction to change, which keeps its result.
+ * @param value Constant to load.
+ */
+void Optimizer::setConstant(IrInst *inst, const Known &value) {
+	inst->type = 0;
+	inst->args.clear();
+
+	if (!value.isDec && value.num >= INT32_MIN && value.num <= INT32_MAX) {
+		inst->op = OP_LOADI;
+		inst->imm = value.num;
+	} else {
+		inst->op = OP_LOADK;
+		inst->imm = addConstant(value.isDec ? Constant{ CONST_DEC, 0, value.dec, "" } : Constant{ CONST_NUM, value.num, 0, "" });
+	}
+}
+
+// --------------- string building -----------------------------
+
+/**
+ * Merges a concatenation into the one that uses its result, when that is its only use
+ * and both are in the same block, so that `s = a + b` followed by `s = s + c` builds
+ * the string once. The inner concatenation is left for dead code elimination.
+ */
+void Optimizer::fuseConcats() {
+	/* Most operands of a merged concatenation, which go through scratch registers */
+	constexpr size_t maxOperands = 64;
+
+	std::vector<uint32_t> uses(ir->refs.size(), 0);
+	for (const IrBlock &block : ir->blocks) {
+		for (const IrPhi &phi : block.phis) {
+			for (ValueId arg : phi.args) {
+				uses[arg]++;
+			}
+		}
+		for (const IrInst &inst : block.insts) {
+			for (ValueId arg : inst.args) {
+				uses[arg]++;
+			}
+		}
+	}
+
+	for (IrBlock &block : ir->blocks) {
+		/* Concatenations of the block so far, by the value they define */
+		std::unordered_map<ValueId, size_t> concats;
+
+		for (size_t idx = 0; idx < block.insts.size(); idx++) {
+			if (block.insts[idx].op != OP_CONCAT) {
+				continue;
+			}
+
+			std::vector<ValueId> args;
+			for (ValueId arg : block.insts[idx].args) {
+				auto inner = concats.find(arg);
+
+				if (inner != concats.end() && uses[arg] == 1
+					&& args.size() + block.insts[inner->second].args.size() <= maxOperands) {
+					const std::vector<ValueId> &parts = block.insts[inner->second].args;
+					args.insert(args.end(), parts.begin(), parts.end());
+				} else {
+					args.push_back(arg);
+				}
+			}
+
+			block.insts[idx].args = std::move(args);
+			concats.emplace(block.insts[idx].dest, idx);
+		}
+	}
+}
+
+// --------------- dead code -----------------------------------
+
+/**
+ * Removes the instructions and phis whose results are never used and which have no
+ * other effect. Values are marked from the instructions that must run, so unused
+ * cycles of phis go as well.
+ */
+void Optimizer::eliminateDeadCode() {
+	/* Where a value is defined: an instruction, or a phi if `phi` is set */
+	struct Def {
+		uint32_t block;
+		uint32_t idx;
+		bool phi;
+	};
+
+	std::vector<Def> defs(ir->refs.size(), Def{ UINT32_MAX, 0, false });
+	std::vector<bool> live(ir->refs.size(), false);
+	std::vector<ValueId> pending;
+
+	for (uint32_t block = 0; block < ir->blocks.size(); block++) {
+		const IrBlock &current = ir->blocks[block];
+
+		for (uint32_t idx = 0; idx < current.phis.size(); idx++) {
+			defs[current.phis[idx].dest] = Def{ block, idx, true };
+		}
+
+		for (uint32_t idx = 0; idx < current.insts.size(); idx++) {
+			const IrInst &inst = current.insts[idx];
+
+			if (inst.dest != NO_VALUE) {
+				defs[inst.dest] = Def{ block, idx, false };
+			}
+			if (inst.dest == NO_VALUE || (getFlags(inst.op) & OPF_PURE) == 0) {
+				pending.insert(pending.end(), inst.args.begin(), inst.args.end());
+			}
+		}
+	}
+
+	while (!pending.empty()) {
+		ValueId value = pending.back();
+		pending.pop_back();
+
+		if (live[value]) {
+			continue;
+		}
+		live[value] = true;
+
+		const Def &def = defs[value];
+		if (def.block == UINT32_MAX) {
+			continue;
+		}
+
+		const IrBlock &current = ir->blocks[def.block];
+		const std::vector<ValueId> &args = def.phi ? current.phis[def.idx].args : current.insts[def.idx].args;
+		pending.insert(pending.end(), args.begin(), args.end());
+	}
+
+	for (IrBlock &block : ir->blocks) {
+		block.phis.erase(std::remove_if(block.phis.begin(), block.phis.end(),
+			[&](const IrPhi &phi) { return !live[phi.dest]; }), block.phis.end());
+
+		for (IrInst &inst : block.insts) {
+			if (inst.dest != NO_VALUE && !live[inst.dest] && (getFlags(inst.op) & OPF_PURE) != 0) {
+				inst.op = IR_DELETED;
+			}
+		}
+	}
+
+	ir->resolveArgs();
+}
+
+// --------------- common subexpressions -----------------------
+
+/**
+ * Reuses the result of an operation computed earlier on the same operands, walking
+ * the dominator tree so that the earlier result is available on every path.
+ */
+void Optimizer::eliminateCommonSubexpressions() {
+	std::vector<uint32_t> order = ir->getOrder();
+	std::vector<uint32_t> idoms = ir->getDominators(order);
+	std::vector<std::vector<uint32_t>> children(ir->blocks.size());
+
+	for (uint32_t block : order) {
+		if (block != 0) {
+			children[idoms[block]].push_back(block);
+		}
+	}
+
+	// Expressions available in the current block, and the order they were added in,
+	// so that those of a subtree can be forgotten when leaving it
+	std::unordered_map<Expression, ValueId, ExpressionHash> available;
+	std::vector<Expression> added;
+
+	/* Block to enter, or to leave after its subtree, forgetting what it added */
+	struct Visit {
+		uint32_t block;
+		size_t mark;
+		bool leaving;
+	};
+	std::vector<Visit> stack{ { 0, 0, false } };
+
+	while (!stack.empty()) {
+		Visit visit = stack.back();
+		stack.pop_back();
+
+		if (visit.leaving) {
+			while (added.size() > visit.mark) {
+				available.erase(added.back());
+				added.pop_back();
+			}
+			continue;
+		}
+
+		stack.push_back({ visit.block, added.size(), true });
+
+		for (IrInst &inst : ir->blocks[visit.block].insts) {
+			uint8_t flags = getFlags(inst.op);
+			if (inst.dest == NO_VALUE || (flags & OPF_REUSABLE) == 0 || inst.args.size() > 2) {
+				continue;
+			}
+
+			Expression key{ inst.op, inst.type, inst.imm, { NO_VALUE, NO_VALUE } };
+			for (size_t arg = 0; arg < inst.args.size(); arg++) {
+				key.args[arg] = ir->resolve(inst.args[arg]);
+			}
+			if ((flags & OPF_COMMUTATIVE) != 0 && key.args[0] > key.args[1]) {
+				std::swap(key.args[0], key.args[1]);
+			}
+
+			auto found = available.emplace(key, inst.dest);
+			if (found.second) {
+				added.push_back(key);
+			} else {
+				ir->replace(inst.dest, found.first->second);
+				inst.op = IR_DELETED;
+			}
+		}
+
+		for (uint32_t child : children[visit.block]) {
+			stack.push_back({ child, 0, false });
+		}
+	}
+
+	ir->resolveArgs();
+}
+
+// --------------- loop-invariant code motion ------------------
+
+/**
+ * Moves operations whose operands do not change inside a loop out of it, into the
+ * block that enters the loop. Only operations that cannot fail are moved, since the
+ * loop body might not have run them at all.
+ */
+void Optimizer::hoistInvariants() {
+	std::vector<uint32_t> order = ir->getOrder();
+	std::vector<uint32_t> idoms = ir->getDominators(order);
+	std::vector<uint32_t> defBlocks(ir->refs.size(), 0);
+
+	for (uint32_t block = 0; block < ir->blocks.size(); block++) {
+		for (const IrPhi &phi : ir->blocks[block].phis) {
+			defBlocks[phi.dest] = block;
+		}
+		for (const IrInst &inst : ir->blocks[block].insts) {
+			if (inst.dest != NO_VALUE) {
+				defBlocks[inst.dest] = block;
+			}
+		}
+	}
+
+	// Number the blocks on entering and leaving them in a walk of the dominator tree,
+	// so that a block dominates exactly the blocks numbered within its own range
+	std::vector<std::vector<uint32_t>> children(ir->blocks.size());
+	std::vector<uint32_t> enter(ir->blocks.size(), 0);
+	std::vector<uint32_t> leave(ir->blocks.size(), 0);
+	std::vector<std::pair<uint32_t, bool>> stack{ { 0, false } };
+	uint32_t clock = 0;
+
+	for (uint32_t block : order) {
+		if (block != 0) {
+			children[idoms[block]].push_back(block);
+		}
+	}
+
+	while (!stack.empty()) {
+		auto visit = stack.back();
+		stack.pop_back();
+
+		if (visit.second) {
+			leave[visit.first] = clock++;
+			continue;
+		}
+
+		enter[visit.first] = clock++;
+		stack.push_back({ visit.first, true });
+		for (uint32_t child : children[visit.first]) {
+			stack.push_back({ child, false });
+		}
+	}
+
+	auto dominates = [&](uint32_t dominator, uint32_t block) {
+		return enter[dominator] <= enter[block] && leave[block] <= leave[dominator];
+	};
+
+	// A back edge goes to a block that dominates its source. Inner loops come later
+	// in reverse postorder, so they are done first and what they hoist can move
+	// further out.
+	std::vector<std::pair<uint32_t, std::vector<uint32_t>>> loops;
+	for (size_t rank = order.size(); rank-- > 0;) {
+		uint32_t header = order[rank];
+		std::vector<uint32_t> latches;
+
+		for (uint32_t pred : ir->blocks[header].preds) {
+			if (idoms[pred] != UINT32_MAX && dominates(header, pred)) {
+				latches.push_back(pred);
+			}
+		}
+		if (!latches.empty()) {
+			loops.push_back({ header, std::move(latches) });
+		}
+	}
+
+	// Rank of each block in reverse postorder, leaving room for a preheader before
+	// every header, so that the body of a loop can be visited in order on its own
+	std::vector<uint32_t> ranks(ir->blocks.size(), UINT32_MAX);
+	for (size_t rank = 0; rank < order.size(); rank++) {
+		ranks[order[rank]] = static_cast<uint32_t>(2 * rank + 1);
+	}
+
+	// Loop each block was last found in, so that the marks need no clearing
+	std::vector<uint32_t> loopOf(ir->blocks.size(), UINT32_MAX);
+
+	for (uint32_t current = 0; current < loops.size(); current++) {
+		uint32_t header = loops[current].first;
+		auto inLoop = [&](uint32_t block) { return loopOf[block] == current; };
+
+		// The body is every block that reaches a latch without passing the header
+		std::vector<uint32_t> body{ header };
+		std::vector<uint32_t> pending = loops[current].second;
+		loopOf[header] = current;
+
+		while (!pending.empty()) {
+			uint32_t block = pending.back();
+			pending.pop_back();
+
+			if (!inLoop(block)) {
+				loopOf[block] = current;
+				body.push_back(block);
+				pending.insert(pending.end(), ir->blocks[block].preds.begin(), ir->blocks[block].preds.end());
+			}
+		}
+
+		std::vector<uint32_t> outside;
+		for (uint32_t pred : ir->blocks[header].preds) {
+			if (!inLoop(pred)) {
+				outside.push_back(pred);
+			}
+		}
+		if (outside.size() != 1) {
+			continue;
+		}
+
+		// Hoisted code needs a block that runs exactly when the loop is entered
+		uint32_t preheader = outside[0];
+		if (ir->blocks[preheader].succs.size() != 1) {
+			preheader = ir->splitEdge(preheader, header);
+			ranks.push_back(ranks[header] - 1);
+			loopOf.push_back(UINT32_MAX);
+		}
+
+		std::sort(body.begin(), body.end(), [&](uint32_t lhs, uint32_t rhs) { return ranks[lhs] < ranks[rhs]; });
+
+		for (uint32_t block : body) {
+			if (ranks[block] == UINT32_MAX) {
+				continue;
+			}
+
+			for (IrInst &inst : ir->blocks[block].insts) {
+				if (inst.dest == NO_VALUE || (getFlags(inst.op) & (OPF_PURE | OPF_SAFE)) != (OPF_PURE | OPF_SAFE)) {
+					continue;
+				}
+
+				bool invariant = true;
+				for (ValueId arg : inst.args) {
+					invariant = invariant && !inLoop(defBlocks[ir->resolve(arg)]);
+				}
+				if (!invariant) {
+					continue;
+				}
+
+				std::vector<IrInst> &target = ir->blocks[preheader].insts;
+				defBlocks[inst.dest] = preheader;
+				target.insert(target.end() - 1, inst);
+				inst.op = IR_DELETED;
+			}
+		}
+	}
+
+	ir->resolveArgs();
+}
+
+// --------------- helpers -------------------------------------
+
+/**
+ * Adds a constant to the module, unless an equal one exists.
+ * @param constant Constant to add.
+ * @returns Index of the constant.
+ */
+uint32_t Optimizer::addConstant(const Constant &constant) {
+	auto found = constantIndex.emplace(getConstantKey(constant), static_cast<uint32_t>(module.constants.size()));
+	if (found.second) {
+		module.constants.push_back(constant);
+	}
+
+	return found.first->second;
+}
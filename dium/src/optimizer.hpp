@@ -0,0 +1,88 @@
+/**
+ * @file       optimizer.hpp
+ * @brief      Definitions for the bytecode optimizer
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef OPTIMIZER_HPP
+#define OPTIMIZER_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "bytecode.hpp"
+#include "ir.hpp"
+
+/** How hard to optimize, picked with -O0, -O1 and -O2 */
+enum OptLevel {
+	OPT_NONE,   /* run the bytecode as compiled */
+	OPT_BASIC,  /* fold constants, remove dead branches and code, reduce strength, merge concatenations */
+	OPT_FULL    /* also reuse common subexpressions and hoist loop invariants */
+};
+
+/**
+ * Optimizes the functions of a compiled module. Each function is lifted into SSA form
+ * (see `ir.hpp`), run through the passes of the optimization level and lowered back to
+ * bytecode with fresh register allocation. Functions whose bytecode the optimizer does
+ * not understand are left as they are.
+ *
+ * Passes:
+ *   -O1  constant folding and propagation, including dead branches such as
+ *        `if false`, strength reduction of `x / 2^k` and `x % 2^k` to shifts and
+ *        masks, merging of string concatenations and dead code elimination
+ *   -O2  common subexpression elimination along the dominator tree and loop-invariant
+ *        code motion, followed by another round of the -O1 passes
+ */
+class Optimizer {
+public:
+	/**
+	 * Creates an optimizer for a module.
+	 * @param module Module to optimize in place.
+	 * @param level Passes to run.
+	 */
+	Optimizer(Module &module, OptLevel level);
+
+	/**
+	 * Optimizes every function of the module.
+	 * @param listing If given, receives a listing of the optimized SSA form.
+	 */
+	void optimize(std::string *listing = nullptr);
+
+private:
+	/* Value of a constant known at compile time */
+	struct Known {
+		bool known;
+		bool isDec;
+		int64_t num;
+		double dec;
+	};
+
+	/** Module being optimized */
+	Module &module;
+
+	/** Passes to run */
+	OptLevel level;
+
+	/** Index of each constant, keyed by its kind and bytes */
+	std::unordered_map<std::string, uint32_t> constantIndex;
+
+	/** Function being optimized */
+	IrFunction *ir = nullptr;
+
+	bool foldConstants();
+	bool foldInst(uint32_t block, IrInst *inst, std::vector<Known> &known);
+	Known evaluate(const IrInst &inst, const std::vector<Known> &known) const;
+	void setConstant(IrInst *inst, const Known &value);
+	void fuseConcats();
+	void eliminateDeadCode();
+	void eliminateCommonSubexpressions();
+	void hoistInvariants();
+
+	uint32_t addConstant(const Constant &constant);
+};
+
+#endif // OPTIMIZER_HPP
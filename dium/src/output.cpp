@@ -0,0 +1,112 @@
+/**
+ * @file       output.cpp
+ * @brief      Implementation of the buffered output used by running programs
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include "output.hpp"
+
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
+
+char *formatNum(char *out, int64_t value) {
+	return std::to_chars(out, out + NUMBER_TEXT_MAX, value).ptr;
+}
+
+char *formatDec(char *out, double value) {
+	char *stop = std::to_chars(out, out + NUMBER_TEXT_MAX - 2, value).ptr;
+
+	if (std::isfinite(value) && memchr(out, '.', stop - out) == nullptr && memchr(out, 'e', stop - out) == nullptr) {
+		*stop++ = '.';
+		*stop++ = '0';
+	}
+	return stop;
+}
+
+// --------------- output stream -------------------------------
+
+Output::Output(int fd, bool lineBuffered, size_t capacity)
+	: fd{ fd }, lineBuffered{ lineBuffered }, buffer{ new char[capacity] } {
+	next = buffer.get();
+	end = buffer.get() + capacity;
+}
+
+Output::~Output() {
+	flush();
+}
+
+void Output::flush() {
+	writeAll(buffer.get(), static_cast<size_t>(next - buffer.get()));
+	next = buffer.get();
+}
+
+/**
+ * Appends characters that do not fit in the rest of the buffer. Text at least as large
+ * as the whole buffer is written out directly instead of being copied.
+ * @param text First character to append.
+ * @param length Number of characters to append.
+ */
+void Output::writeSlow(const char *text, size_t length) {
+	flush();
+
+	if (length >= static_cast<size_t>(end - buffer.get())) {
+		writeAll(text, length);
+		return;
+	}
+
+	write(text, length);
+}
+
+/**
+ * Hands characters to the operating system, retrying partial and interrupted writes.
+ * Output that cannot be written, as to a closed pipe, is dropped.
+ * @param text First character to write.
+ * @param length Number of characters to write.
+ */
+void Output::writeAll(const char *text, size_t length) {
+	while (length > 0) {
+#ifdef _WIN32
+		unsigned int chunk = (length > INT32_MAX) ? INT32_MAX : static_cast<unsigned int>(length);
+		int written = _write(fd, text, chunk);
+#else
+		ssize_t written = ::write(fd, text, length);
+#endif
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return;
+		}
+
+		text += written;
+		length -= static_cast<size_t>(written);
+	}
+}
+
+Output &getStdout() {
+#ifdef _WIN32
+	static Output stream(_fileno(stdout), _isatty(_fileno(stdout)) != 0);
+#else
+	static Output stream(STDOUT_FILENO, isatty(STDOUT_FILENO) != 0);
+#endif
+	return stream;
+}
+
+Output &getStderr() {
+#ifdef _WIN32
+	static Output stream(_fileno(stderr), _isatty(_fileno(stderr)) != 0);
+#else
+	static Output stream(STDERR_FILENO, isatty(STDERR_FILENO) != 0);
+#endif
+	return stream;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file       output.hpp
+ * @brief      Definitions for the buffered output used by running programs
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef OUTPUT_HPP
+#define OUTPUT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+/** Size of the buffer of standard output */
+#define OUTPUT_BUFFER_SIZE (64 * 1024)
+
+/** Most characters written by `formatNum()` or `formatDec()` */
+#define NUMBER_TEXT_MAX 32
+
+/**
+ * Writes a number in decimal, without going through the C locale.
+ * @param out Space for at least `NUMBER_TEXT_MAX` characters.
+ * @param value Number to write.
+ * @returns One past the last character written.
+ */
+char *formatNum(char *out, int64_t value);
+
+/**
+ * Writes a decimal in the shortest form that reads back the same, with ".0" added to
+ * whole decimals so that they stay recognisable as decimals.
+ * @param out Space for at least `NUMBER_TEXT_MAX` characters.
+ * @param value Decimal to write.
+ * @returns One past the last character written.
+ */
+char *formatDec(char *out, double value);
+
+/**
+ * Output stream with a large buffer of its own, written to the file descriptor in as
+ * few system calls as possible: when the buffer is full, when `flush()` is called and
+ * when the stream is destroyed. A line-buffered stream also writes out every line as
+ * soon as it ends, which is what a terminal expects.
+ */
+class Output {
+public:
+	/**
+	 * Creates an output stream.
+	 * @param fd File descriptor to write to.
+	 * @param lineBuffered `true` to write out every completed line.
+	 * @param capacity Size of the buffer.
+	 */
+	Output(int fd, bool lineBuffered, size_t capacity = OUTPUT_BUFFER_SIZE);
+
+	/**
+	 * Writes out whatever is left in the buffer.
+	 */
+	~Output();
+
+	Output(const Output &) = delete;
+	Output &operator=(const Output &) = delete;
+
+	/**
+	 * Appends characters to the stream.
+	 * @param text First character to append.
+	 * @param length Number of characters to append.
+	 */
+	void write(const char *text, size_t length) {
+		if (length > static_cast<size_t>(end - next)) {
+			writeSlow(text, length);
+			return;
+		}
+
+		memcpy(next, text, length);
+		next += length;
+
+		if (lineBuffered && memchr(text, '\n', length) != nullptr) {
+			flush();
+		}
+	}
+
+	/**
+	 * Appends text to the stream.
+	 * @param text Text to append.
+	 */
+	void write(std::string_view text) {
+		write(text.data(), text.size());
+	}
+
+	/**
+	 * Appends a single character to the stream.
+	 * @param c Character to append.
+	 */
+	void put(char c) {
+		if (next == end) {
+			flush();
+		}
+
+		*next++ = c;
+		if (lineBuffered && c == '\n') {
+			flush();
+		}
+	}
+
+	/**
+	 * Appends a number in decimal.
+	 * @param value Number to append.
+	 */
+	void writeNum(int64_t value) {
+		if (end - next < NUMBER_TEXT_MAX) {
+			flush();
+		}
+		next = formatNum(next, value);
+	}
+
+	/**
+	 * Appends a decimal (see `formatDec()`).
+	 * @param value Decimal to append.
+	 */
+	void writeDec(double value) {
+		if (end - next < NUMBER_TEXT_MAX) {
+			flush();
+		}
+		next = formatDec(next, value);
+	}
+
+	/**
+	 * Writes out everything in the buffer.
+	 */
+	void flush();
+
+private:
+	/** File descriptor written to */
+	int fd;
+
+	/** `true` if every completed line is written out */
+	bool lineBuffered;
+
+	/** Buffered characters */
+	std::unique_ptr<char[]> buffer;
+
+	/** Where the next character goes */
+	char *next;
+
+	/** One past the end of the buffer */
+	char *end;
+
+	void writeSlow(const char *text, size_t length);
+	void writeAll(const char *text, size_t length);
+};
+
+/**
+ * Returns the stream for the standard output, created on first use. It is line
+ * buffered when the standard output is a terminal and is flushed when the process
+ * exits through `exit()` or by returning from `main()`.
+ * @returns Standard output stream.
+ */
+Output &getStdout();
+
+/**
+ * Returns the stream for the standard error, created on first use, for traces that
+ * must not mix with the output of the program. It is line buffered when the standard
+ * error is a terminal and is flushed when the process exits.
+ * @returns Standard error stream.
+ */
+Output &getStderr();
+
+#endif // OUTPUT_HPP
@@ -0,0 +1,877 @@
+/**
+ * @file       parser.cpp
+ * @brief      Implementation of the recursive-descent parser
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include "debug.hpp"
+#include "error.hpp"
+#include "parser.hpp"
+
+
+/* Thrown by `Parser::error()` to unwind to the statement or function being parsed */
+struct SyntaxError {};
+
+// --------------- function prototypes -------------------------
+
+static bool isDeeper(const Expr *expr, uint32_t limit);
+
+
+Parser::Parser(const TokenStream &tokens, Arena &arena, std::string name, Diagnostics &diagnostics)
+	: tokens{ tokens }, arena{ arena }, name{ std::move(name) }, diagnostics{ diagnostics } {
+}
+
+Program *Parser::parse() {
+	DEBUG_START("<program>");
+	auto *program = arena.make<Program>();
+	size_t mark = scratch.size();
+
+	while (!check(TOK_EOF) && !diagnostics.isFull()) {
+		size_t next;
+		FuncDecl *func = parseFuncAt(current, &next);
+
+		if (func != nullptr) {
+			scratch.push_back(func);
+		}
+		current = next;
+	}
+
+	program->funcs = finishList<FuncDecl>(mark, &program->count);
+	DEBUG_END("</program>");
+	return program;
+}
+
+FuncDecl *Parser::parseFuncAt(size_t first, size_t *next) {
+	size_t items = scratch.size();
+	FuncDecl *func = nullptr;
+	current = first;
+
+	try {
+		func = parseFunc();
+	} catch (const SyntaxError &) {
+		scratch.resize(items);
+		depth = 0;
+		expressions = 0;
+		skipToFunc(first);
+	}
+
+	*next = current;
+	return func;
+}
+
+// --------------- helpers -------------------------------------
+
+/**
+ * Returns the type of an upcoming token.
+ * @param ahead Number of tokens to look past the current one.
+ * @returns Type of the token, `TOK_EOF` past the end.
+ */
+TokenType Parser::peek(size_t ahead) const {
+	size_t idx = current + ahead;
+	return (idx < tokens.size()) ? tokens.types[idx] : TOK_EOF;
+}
+
+/**
+ * Returns the position of the current token.
+ * @returns Line and column of the current token.
+ */
+const SourcePosition &Parser::here() const {
+	return tokens.positions[current];
+}
+
+/**
+ * Checks the type of the current token.
+ * @param type Expected type.
+ * @returns `true` if the current token has the given type, `false` otherwise.
+ */
+bool Parser::check(TokenType type) const {
+	return tokens.types[current] == type;
+}
+
+/**
+ * Moves past the current token if it has the given type.
+ * @param type Expected type.
+ * @returns `true` if the token was accepted, `false` otherwise.
+ */
+bool Parser::accept(TokenType type) {
+	if (!check(type)) {
+		return false;
+	}
+
+	current += 1;
+	return true;
+}
+
+/**
+ * Moves past the current token, which must have the given type.
+ * @param type Expected type.
+ */
+void Parser::expect(TokenType type) {
+	if (!accept(type)) {
+		error(here(), "Expected %s but found %s", getTokenString(type), getTokenString(peek()));
+	}
+}
+
+/**
+ * Checks if an upcoming token is a type (`num`, `dec`, `bool`, `char` or `string`).
+ * @param ahead Number of tokens to look past the current one.
+ * @returns `true` if the token names a type, `false` otherwise.
+ */
+bool Parser::isTypeKeyword(size_t ahead) const {
+	size_t idx = current + ahead;
+	if (idx >= tokens.size() || !(tokens.flags[idx] & TOKF_KEYWORD)) {
+		return false;
+	}
+
+	switch (tokens.types[idx]) {
+	case TOK_NUM:
+	case TOK_DEC:
+	case TOK_BOOL:
+	case TOK_CHAR:
+	case TOK_STR:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Skips the rest of the line that a syntax error was found on, so that parsing can
+ * carry on with the next statement. Stops early at a '}' that may close the enclosing
+ * block, skips whole blocks opened on the line, and keeps going through the `else` and
+ * `elsif` branches that follow them.
+ */
+void Parser::synchronize() {
+	int line = here().line;
+	int depth = 0;
+
+	while (!check(TOK_EOF)) {
+		if (depth == 0) {
+			if (check(TOK_RCURL)) {
+				break;
+			}
+
+			if (here().line > line) {
+				if (!check(TOK_ELSE) && !check(TOK_ELSIF)) {
+					break;
+				}
+				line = here().line;
+			}
+		}
+
+		if (check(TOK_LCURL)) {
+			depth += 1;
+		} else if (check(TOK_RCURL)) {
+			depth -= 1;
+		}
+		current += 1;
+	}
+}
+
+/**
+ * Skips to the next function after a syntax error outside of a function body.
+ * @param start Token the failed function started at, which is always skipped.
+ */
+void Parser::skipToFunc(size_t start) {
+	if (current == start) {
+		current += 1;
+	}
+
+	while (!check(TOK_EOF) && !check(TOK_FUNC)) {
+		current += 1;
+	}
+}
+
+/**
+ * Goes one level deeper into the syntax tree, which callers undo when done.
+ * @param pos Position of what is nested, for the error.
+ * @param what What is nested, for the error.
+ */
+void Parser::nest(const SourcePosition &pos, const char *what) {
+	depth += 1;
+	if (depth > MAX_NESTING_DEPTH) {
+		error(pos, "%s nested too deeply", what);
+	}
+}
+
+/**
+ * Copies the nodes pushed onto the scratch list since `mark` into the arena.
+ * @param mark Size of the scratch list when the list started.
+ * @param[out] count Number of nodes in the list.
+ * @returns Array of nodes.
+ */
+template <typename T>
+T **Parser::finishList(size_t mark, uint32_t *count) {
+	*count = static_cast<uint32_t>(scratch.size() - mark);
+	T **items = reinterpret_cast<T **>(arena.copy(scratch.data() + mark, *count));
+	scratch.resize(mark);
+	return items;
+}
+
+/**
+ * Allocates a zeroed node from the arena.
+ * @param kind Kind of the node.
+ * @param position Position of the node.
+ * @returns New node.
+ */
+template <typename T, typename Kind>
+T *Parser::make(Kind kind, const SourcePosition &position) {
+	T *node = arena.make<T>();
+	node->kind = kind;
+	node->position = position;
+	return node;
+}
+
+/**
+ * Reports a syntax error and unwinds to the statement or function being parsed.
+ * @param pos Position of the error.
+ * @param fmt Formatted string.
+ * @param ... Variable arguments.
+ */
+void Parser::error(const SourcePosition &pos, const char *fmt, ...) {
+	// Underline the token the error points at
+	uint32_t length = 0;
+	for (size_t idx = current + 1; idx-- > 0;) {
+		if (tokens.positions[idx].line < pos.line) {
+			break;
+		}
+		if (tokens.positions[idx].line == pos.line && tokens.positions[idx].column == pos.column) {
+			length = tokens.lengths[idx];
+			break;
+		}
+	}
+
+	va_list args;
+	va_start(args, fmt);
+	diagnostics.add(SEVERITY_ERROR, name.c_str(), &pos, length, fmt, args);
+	va_end(args);
+
+	throw SyntaxError{};
+}
+
+// --------------- declarations --------------------------------
+
+/**
+ * Parses an identifier.
+ * @returns Name referring to the identifier in the source.
+ */
+Name Parser::parseName() {
+	if (!check(TOK_ID)) {
+		error(here(), "Expected %s but found %s", getTokenString(TOK_ID), getTokenString(peek()));
+	}
+
+	// The text is taken from the interner, so that names stay valid when the source changes
+	Symbol symbol = tokens.getSymbol(current);
+	Name name{ tokens.symbols->getText(symbol).data(), tokens.lengths[current], symbol };
+	current += 1;
+	return name;
+}
+
+/**
+ * Parses a type, followed by any number of `[]`.
+ * @param allowVoid `true` if `void` is allowed (for return types).
+ * @returns Parsed type.
+ */
+Type Parser::parseType(bool allowVoid) {
+	Type type{ TYPE_VOID, 0 };
+
+	if (allowVoid && accept(TOK_VOID)) {
+		return type;
+	}
+
+	if (!isTypeKeyword()) {
+		error(here(), "Expected a type but found %s", getTokenString(peek()));
+	}
+
+	switch (peek()) {
+	case TOK_NUM:
+		type.base = TYPE_NUM;
+		break;
+	case TOK_DEC:
+		type.base = TYPE_DEC;
+		break;
+	case TOK_BOOL:
+		type.base = TYPE_BOOL;
+		break;
+	case TOK_CHAR:
+		type.base = TYPE_CHAR;
+		break;
+	default:
+		type.base = TYPE_STR;
+		break;
+	}
+
+	current += 1;
+	while (check(TOK_ARRAY)) {
+		if (type.rank == MAX_ARRAY_RANK) {
+			error(here(), "Arrays cannot have more than %d dimensions", MAX_ARRAY_RANK);
+		}
+
+		type.rank += 1;
+		current += 1;
+	}
+
+	return type;
+}
+
+/**
+ * Parses a function declaration:
+ * `func name(type param, ...) => type { ... }`
+ * @returns Parsed function.
+ */
+FuncDecl *Parser::parseFunc() {
+	DEBUG_START("<func>");
+	auto *func = arena.make<FuncDecl>();
+	func->position = here();
+
+	expect(TOK_FUNC);
+	func->name = parseName();
+	expect(TOK_LPAR);
+
+	std::vector<Param> params;
+	if (!check(TOK_RPAR)) {
+		do {
+			Param param;
+			param.position = here();
+			param.type = parseType(false);
+			param.name = parseName();
+			params.push_back(param);
+		} while (accept(TOK_COMMA));
+	}
+
+	expect(TOK_RPAR);
+	func->params = arena.copy(params.data(), params.size());
+	func->paramCount = static_cast<uint32_t>(params.size());
+
+	// Functions without a return type return nothing
+	func->returnType = accept(TOK_ARROW) ? parseType(true) : Type{ TYPE_VOID, 0 };
+	func->body = parseBlock();
+
+	DEBUG_END("</func>");
+	return func;
+}
+
+// --------------- statements ----------------------------------
+
+/**
+ * Parses a block of statements between curly braces.
+ * @returns Parsed block.
+ */
+BlockStmt *Parser::parseBlock() {
+	DEBUG_START("<block>");
+	auto *block = make<BlockStmt>(STMT_BLOCK, here());
+	size_t mark = scratch.size();
+
+	nest(here(), "Block");
+	uint32_t blockDepth = depth;
+
+	expect(TOK_LCURL);
+	while (!check(TOK_RCURL) && !check(TOK_EOF)) {
+		size_t items = scratch.size();
+
+		try {
+			scratch.push_back(parseStatement());
+		} catch (const SyntaxError &) {
+			scratch.resize(items);
+			depth = blockDepth;
+			expressions = 0;
+
+			// Give up on the whole program once there are too many errors
+			if (diagnostics.isFull()) {
+				throw;
+			}
+			synchronize();
+		}
+	}
+	expect(TOK_RCURL);
+	depth -= 1;
+
+	block->stmts = finishList<Stmt>(mark, &block->count);
+	DEBUG_END("</block>");
+	return block;
+}
+
+/**
+ * Parses a single statement.
+ * @returns Parsed statement.
+ */
+Stmt *Parser::parseStatement() {
+	DEBUG_INFO("<statement> %s", getTokenString(peek()));
+	SourcePosition start = here();
+
+	// Declaration, unless the type is used as a conversion (e.g. `string(x)`)
+	if (isTypeKeyword() && peek(1) != TOK_LPAR) {
+		auto *var = make<VarStmt>(STMT_VAR, start);
+		var->type = parseType(false);
+		var->name = parseName();
+		var->value = accept(TOK_ASSIGN) ? parseExpression() : nullptr;
+		return var;
+	}
+
+	switch (peek()) {
+	case TOK_LCURL:
+		return parseBlock();
+	case TOK_IF:
+		return parseIf();
+	case TOK_FOR:
+		return parseFor();
+	case TOK_WHILE: {
+		auto *loop = make<WhileStmt>(STMT_WHILE, start);
+		current += 1;
+		loop->cond = parseExpression();
+		loop->body = parseBlock();
+		return loop;
+	}
+	case TOK_RETURN: {
+		auto *ret = make<ReturnStmt>(STMT_RETURN, start);
+		current += 1;
+
+		// Statements have no terminator, so a value has to start on the same line
+		if (!check(TOK_RCURL) && !check(TOK_EOF) && here().line == start.line) {
+			ret->value = parseExpression();
+		}
+		return ret;
+	}
+	case TOK_PRINT:
+	case TOK_PRINTLN: {
+		auto *print = make<PrintStmt>(STMT_PRINT, start);
+		print->newline = (peek() == TOK_PRINTLN);
+		current += 1;
+
+		expect(TOK_LPAR);
+		if (!check(TOK_RPAR)) {
+			print->value = parseExpression();
+		}
+		expect(TOK_RPAR);
+		return print;
+	}
+	case TOK_EXIT: {
+		auto *stop = make<ExitStmt>(STMT_EXIT, start);
+		current += 1;
+
+		expect(TOK_LPAR);
+		stop->code = parseExpression();
+		expect(TOK_RPAR);
+		return stop;
+	}
+	case TOK_BREAK:
+		current += 1;
+		return make<Stmt>(STMT_BREAK, start);
+	case TOK_CONTINUE:
+		current += 1;
+		return make<Stmt>(STMT_CONTINUE, start);
+	default:
+		break;
+	}
+
+	Expr *expr = parseExpression();
+
+	if (accept(TOK_ASSIGN)) {
+		if (expr->kind != EXPR_NAME && expr->kind != EXPR_INDEX) {
+			error(start, "Can only assign to a variable or an array element");
+		}
+
+		auto *assign = make<AssignStmt>(STMT_ASSIGN, start);
+		assign->target = expr;
+		assign->value = parseExpression();
+		return assign;
+	}
+
+	if (expr->kind != EXPR_CALL) {
+		error(start, "Expected a statement but found an expression");
+	}
+
+	auto *call = make<ExprStmt>(STMT_EXPR, start);
+	call->expr = expr;
+	return call;
+}
+
+/**
+ * Parses an `if` statement along with its `elsif` and `else` branches.
+ * @returns Parsed statement.
+ */
+Stmt *Parser::parseIf() {
+	DEBUG_START("<if>");
+	auto *branch = make<IfStmt>(STMT_IF, here());
+
+	// Either `if` or `elsif`
+	current += 1;
+	branch->cond = parseExpression();
+	branch->then = parseBlock();
+
+	// Every `elsif` is another `if` inside the last one
+	if (check(TOK_ELSIF)) {
+		nest(here(), "'elsif' branch");
+		branch->otherwise = parseIf();
+		depth -= 1;
+	} else if (accept(TOK_ELSE)) {
+		branch->otherwise = parseBlock();
+	}
+
+	DEBUG_END("</if>");
+	return branch;
+}
+
+/**
+ * Parses a `for` loop:
+ * `for type name in range([start,] stop[, step]) { ... }`
+ * @returns Parsed statement.
+ */
+Stmt *Parser::parseFor() {
+	DEBUG_START("<for>");
+	auto *loop = make<ForStmt>(STMT_FOR, here());
+
+	expect(TOK_FOR);
+	loop->type = parseType(false);
+	loop->name = parseName();
+	expect(TOK_IN);
+
+	SourcePosition rangePos = here();
+	expect(TOK_RANGE);
+	expect(TOK_LPAR);
+
+	Expr **args;
+	uint32_t count = parseArguments(TOK_RPAR, &args);
+
+	switch (count) {
+	case 1:
+		loop->stop = args[0];
+		break;
+	case 2:
+		loop->start = args[0];
+		loop->stop = args[1];
+		break;
+	case 3:
+		loop->start = args[0];
+		loop->stop = args[1];
+		loop->step = args[2];
+		break;
+	default:
+		error(rangePos, "Expected 1 to 3 arguments to 'range' but found %u", count);
+	}
+
+	loop->body = parseBlock();
+	DEBUG_END("</for>");
+	return loop;
+}
+
+// --------------- expressions ---------------------------------
+
+/**
+ * Parses an expression (lowest precedence: `or`).
+ * @returns Parsed expression.
+ */
+Expr *Parser::parseExpression() {
+	SourcePosition start = here();
+	nest(start, "Expression");
+	expressions += 1;
+
+	Expr *lhs = parseAnd();
+
+	while (check(TOK_OR)) {
+		auto *binary = make<BinaryExpr>(EXPR_BINARY, here());
+		current += 1;
+		binary->op = TOK_OR;
+		binary->lhs = lhs;
+		binary->rhs = parseAnd();
+		lhs = binary;
+	}
+
+	depth -= 1;
+	expressions -= 1;
+
+	// Operators nested through their right operands grow the tree without going any
+	// deeper here, so the height of the whole expression is checked once, when it is
+	// done. Chains of left operands, such as long sums, do not count.
+	if (expressions == 0 && isDeeper(lhs, MAX_NESTING_DEPTH - depth)) {
+		error(start, "Expression nested too deeply");
+	}
+	return lhs;
+}
+
+/**
+ * Parses a chain of `and` operators.
+ * @returns Parsed expression.
+ */
+Expr *Parser::parseAnd() {
+	Expr *lhs = parseComparison();
+
+	while (check(TOK_AND)) {
+		auto *binary = make<BinaryExpr>(EXPR_BINARY, here());
+		current += 1;
+		binary->op = TOK_AND;
+		binary->lhs = lhs;
+		binary->rhs = parseComparison();
+		lhs = binary;
+	}
+
+	return lhs;
+}
+
+/**
+ * Parses relational operators (`==`, `!=`, `<`, `<=`, `>`, `>=`).
+ * @returns Parsed expression.
+ */
+Expr *Parser::parseComparison() {
+	Expr *lhs = parseAdditive();
+
+	while (true) {
+		TokenType op = peek();
+		if (op != TOK_EQ && op != TOK_NE && op != TOK_LT && op != TOK_LE && op != TOK_GT && op != TOK_GE) {
+			return lhs;
+		}
+
+		auto *binary = make<BinaryExpr>(EXPR_BINARY, here());
+		current += 1;
+		binary->op = op;
+		binary->lhs = lhs;
+		binary->rhs = parseAdditive();
+		lhs = binary;
+	}
+}
+
+/**
+ * Parses `+` and `-`.
+ * @returns Parsed expression.
+ */
+Expr *Parser::parseAdditive() {
+	Expr *lhs = parseMultiplicative();
+
+	while (check(TOK_PLUS) || check(TOK_MINUS)) {
+		auto *binary = make<BinaryExpr>(EXPR_BINARY, here());
+		binary->op = peek();
+		current += 1;
+		binary->lhs = lhs;
+		binary->rhs = parseMultiplicative();
+		lhs = binary;
+	}
+
+	return lhs;
+}
+
+/**
+ * Parses `*`, `/` and `%`.
+ * @returns Parsed expression.
+ */
+Expr *Parser::parseMultiplicative() {
+	Expr *lhs = parseUnary();
+
+	while (check(TOK_MUL) || check(TOK_DIV) || check(TOK_MOD)) {
+		auto *binary = make<BinaryExpr>(EXPR_BINARY, here());
+		binary->op = peek();
+		current += 1;
+		binary->lhs = lhs;
+		binary->rhs = parseUnary();
+		lhs = binary;
+	}
+
+	return lhs;
+}
+
+/**
+ * Parses the prefix operators `-` and `!`.
+ * @returns Parsed expression.
+ */
+Expr *Parser::parseUnary() {
+	if (check(TOK_MINUS) || check(TOK_NOT)) {
+		auto *unary = make<UnaryExpr>(EXPR_UNARY, here());
+		unary->op = peek();
+		current += 1;
+
+		nest(unary->position, "Expression");
+		unary->operand = parseUnary();
+		depth -= 1;
+		return unary;
+	}
+
+	return parsePostfix();
+}
+
+/**
+ * Parses array indexing with `@`, which binds tighter than any other operator.
+ * @returns Parsed expression.
+ */
+Expr *Parser::parsePostfix() {
+	Expr *expr = parsePrimary();
+
+	while (check(TOK_AT)) {
+		auto *index = make<IndexExpr>(EXPR_INDEX, here());
+		current += 1;
+		index->array = expr;
+		index->index = parsePrimary();
+		expr = index;
+	}
+
+	return expr;
+}
+
+/**
+ * Parses literals, variables, calls, conversions, array literals and parentheses.
+ * @returns Parsed expression.
+ */
+Expr *Parser::parsePrimary() {
+	SourcePosition start = here();
+	Token token;
+
+	// Conversion to another type, e.g. `string(x)`
+	if (isTypeKeyword()) {
+		auto *cast = make<CastExpr>(EXPR_CAST, start);
+		cast->target = parseType(false);
+		expect(TOK_LPAR);
+		cast->operand = parseExpression();
+		expect(TOK_RPAR);
+		return cast;
+	}
+
+	tokens.get(current, &token);
+
+	switch (token.type) {
+	case TOK_NUM: {
+		auto *num = make<NumExpr>(EXPR_NUM, start);
+		num->value = token.ivalue;
+		current += 1;
+		return num;
+	}
+	case TOK_DEC: {
+		auto *dec = make<DecExpr>(EXPR_DEC, start);
+		dec->value = token.dvalue;
+		current += 1;
+		return dec;
+	}
+	case TOK_CHAR: {
+		auto *ch = make<CharExpr>(EXPR_CHAR, start);
+		ch->value = token.character;
+		current += 1;
+		return ch;
+	}
+	case TOK_STR: {
+		auto *str = make<StrExpr>(EXPR_STR, start);
+		str->length = token.length - ((token.flags & TOKF_UNCLOSED) ? 1 : 2);
+		str->text = (str->length > 0) ? arena.copy(tokens.source + token.offset + 1, str->length) : "";
+		str->escaped = (token.flags & TOKF_ESCAPED) != 0;
+		current += 1;
+		return str;
+	}
+	case TOK_TRUE:
+	case TOK_FALSE: {
+		auto *boolean = make<BoolExpr>(EXPR_BOOL, start);
+		boolean->value = (token.type == TOK_TRUE);
+		current += 1;
+		return boolean;
+	}
+	case TOK_ID: {
+		Name name = parseName();
+
+		if (check(TOK_LPAR)) {
+			auto *call = make<CallExpr>(EXPR_CALL, start);
+			current += 1;
+			call->name = name;
+			call->count = parseArguments(TOK_RPAR, &call->args);
+			return call;
+		}
+
+		auto *var = make<NameExpr>(EXPR_NAME, start);
+		var->name = name;
+		return var;
+	}
+	case TOK_LPAR: {
+		current += 1;
+		Expr *inner = parseExpression();
+		expect(TOK_RPAR);
+		return inner;
+	}
+	case TOK_LBRACK: {
+		auto *array = make<ArrayExpr>(EXPR_ARRAY, start);
+		current += 1;
+		array->count = parseArguments(TOK_RBRACK, &array->items);
+		return array;
+	}
+	case TOK_ARRAY:
+		// Empty array, `[]`
+		current += 1;
+		return make<ArrayExpr>(EXPR_ARRAY, start);
+	default:
+		error(start, "Expected an expression but found %s", getTokenString(peek()));
+	}
+}
+
+/**
+ * Parses a comma-separated list of expressions up to and including the closing token.
+ * @param close Token that ends the list.
+ * @param[out] args Array of parsed expressions.
+ * @returns Number of expressions in the list.
+ */
+uint32_t Parser::parseArguments(TokenType close, Expr ***args) {
+	size_t mark = scratch.size();
+	uint32_t count;
+
+	if (!check(close)) {
+		do {
+			scratch.push_back(parseExpression());
+		} while (accept(TOK_COMMA));
+	}
+
+	expect(close);
+	*args = finishList<Expr>(mark, &count);
+	return count;
+}
+
+/**
+ * Checks if an expression is deeper than a limit, going no deeper than the limit to
+ * find out.
+ * @param expr Expression to check, or `nullptr`.
+ * @param limit Number of levels the expression may take, counting itself.
+ * @returns `true` if the expression takes more levels, `false` otherwise.
+ */
+static bool isDeeper(const Expr *expr, uint32_t limit) {
+	if (expr == nullptr) {
+		return false;
+	}
+	if (limit == 0) {
+		return true;
+	}
+
+	switch (expr->kind) {
+	case EXPR_ARRAY: {
+		const auto *array = static_cast<const ArrayExpr *>(expr);
+		for (uint32_t idx = 0; idx < array->count; idx++) {
+			if (isDeeper(array->items[idx], limit - 1)) {
+				return true;
+			}
+		}
+		return false;
+	}
+	case EXPR_UNARY:
+		return isDeeper(static_cast<const UnaryExpr *>(expr)->operand, limit - 1);
+	case EXPR_BINARY: {
+		// Every stage walks a chain of left operands in a loop, so only the right ones go deeper
+		const auto *binary = static_cast<const BinaryExpr *>(expr);
+		while (!isDeeper(binary->rhs, limit - 1)) {
+			if (binary->lhs->kind != EXPR_BINARY) {
+				return isDeeper(binary->lhs, limit - 1);
+			}
+			binary = static_cast<const BinaryExpr *>(binary->lhs);
+		}
+		return true;
+	}
+	case EXPR_INDEX: {
+		const auto *index = static_cast<const IndexExpr *>(expr);
+		return isDeeper(index->array, limit - 1) || isDeeper(index->index, limit - 1);
+	}
+	case EXPR_CALL: {
+		const auto *call = static_cast<const CallExpr *>(expr);
+		for (uint32_t idx = 0; idx < call->count; idx++) {
+			if (isDeeper(call->args[idx], limit - 1)) {
+				return true;
+			}
+		}
+		return false;
+	}
+	case EXPR_CAST:
+		return isDeeper(static_cast<const CastExpr *>(expr)->operand, limit - 1);
+	default:
+		return false;
+	}
+}
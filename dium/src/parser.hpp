@@ -0,0 +1,118 @@
+/**
+ * @file       parser.hpp
+ * @brief      Definitions for the recursive-descent parser
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef PARSER_HPP
+#define PARSER_HPP
+
+#include <string>
+#include <vector>
+#include "arena.hpp"
+#include "ast.hpp"
+#include "diagnostics.hpp"
+#include "format.hpp"
+#include "token.hpp"
+
+/**
+ * Builds a syntax tree from a token stream. All nodes are allocated from the given
+ * arena, so the whole tree is freed along with it.
+ */
+class Parser {
+public:
+	/**
+	 * Creates a parser positioned at the first token.
+	 * @param tokens Tokens to parse, whose interner must outlive the syntax tree.
+	 * @param arena Arena to allocate nodes from.
+	 * @param name Name of the source file, used in error messages.
+	 * @param diagnostics Where syntax errors are reported.
+	 */
+	Parser(const TokenStream &tokens, Arena &arena, std::string name, Diagnostics &diagnostics);
+
+	/**
+	 * Parses the whole token stream. After a syntax error the parser skips to the next
+	 * line or closing '}' and carries on, so that every error is reported in one pass;
+	 * it stops early once the diagnostics are full.
+	 * @returns Syntax tree of the program, which is incomplete if any errors were
+	 *     reported.
+	 */
+	Program *parse();
+
+	/**
+	 * Parses a single function, which is how `parse()` goes through the file. Every
+	 * function depends on its own tokens only, so an editor can parse again just the
+	 * functions that changed.
+	 * @param first Index of the first token of the function.
+	 * @param[out] next Index of the token after the function, or of the next `func`
+	 *     after a syntax error.
+	 * @returns Syntax tree of the function, or `nullptr` after a syntax error.
+	 */
+	FuncDecl *parseFuncAt(size_t first, size_t *next);
+
+private:
+	/** Tokens being parsed */
+	const TokenStream &tokens;
+
+	/** Arena that nodes are allocated from */
+	Arena &arena;
+
+	/** Name of the source file */
+	std::string name;
+
+	/** Where syntax errors are reported */
+	Diagnostics &diagnostics;
+
+	/** Index of the current token */
+	size_t current = 0;
+
+	/** Nodes of lists that are still being parsed, copied into the arena when done */
+	std::vector<void *> scratch;
+
+	/** Number of blocks, `elsif` branches and expressions being parsed inside one another */
+	uint32_t depth = 0;
+
+	/** Number of expressions being parsed inside one another */
+	uint32_t expressions = 0;
+
+	TokenType peek(size_t ahead = 0) const;
+	const SourcePosition &here() const;
+	bool check(TokenType type) const;
+	bool accept(TokenType type);
+	void expect(TokenType type);
+	bool isTypeKeyword(size_t ahead = 0) const;
+	void synchronize();
+	void skipToFunc(size_t start);
+	void nest(const SourcePosition &pos, const char *what);
+
+	Name parseName();
+	Type parseType(bool allowVoid);
+	FuncDecl *parseFunc();
+	BlockStmt *parseBlock();
+	Stmt *parseStatement();
+	Stmt *parseIf();
+	Stmt *parseFor();
+	Expr *parseExpression();
+	Expr *parseAnd();
+	Expr *parseComparison();
+	Expr *parseAdditive();
+	Expr *parseMultiplicative();
+	Expr *parseUnary();
+	Expr *parsePostfix();
+	Expr *parsePrimary();
+	uint32_t parseArguments(TokenType close, Expr ***args);
+
+	template <typename T>
+	T **finishList(size_t mark, uint32_t *count);
+
+	template <typename T, typename Kind>
+	T *make(Kind kind, const SourcePosition &position);
+
+	[[noreturn]] void error(const SourcePosition &pos, FORMAT_STRING const char *fmt, ...) FORMAT_CHECK(3, 4);
+};
+
+#endif // PARSER_HPP
@@ -0,0 +1,142 @@
+/**
+ * @file       pool.cpp
+ * @brief      Implementation for the work-stealing thread pool
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include "pool.hpp"
+
+
+ThreadPool::ThreadPool(unsigned threads) {
+	if (threads == 0) {
+		threads = std::thread::hardware_concurrency();
+	}
+
+	if (threads == 0) {
+		threads = 1;
+	}
+
+	for (unsigned idx = 0; idx < threads; idx++) {
+		queues.push_back(std::make_unique<Queue>());
+	}
+
+	for (unsigned idx = 0; idx < threads; idx++) {
+		workers.emplace_back(&ThreadPool::work, this, idx);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+
+	wake.notify_all();
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::run(size_t count, const std::function<void(size_t)> &fn) {
+	if (count == 0) {
+		return;
+	}
+
+	// Hand every worker a contiguous block of jobs, so neighbouring jobs share a thread
+	size_t perWorker = (count + queues.size() - 1) / queues.size();
+	for (size_t idx = 0; idx < count; idx++) {
+		Queue &queue = *queues[idx / perWorker];
+		std::lock_guard<std::mutex> guard(queue.lock);
+		queue.jobs.push_back(idx);
+	}
+
+	std::unique_lock<std::mutex> guard(lock);
+	job = &fn;
+	remaining = count;
+	batch += 1;
+	wake.notify_all();
+
+	// Wait for the workers to park as well, so none of them can pick up the next batch
+	done.wait(guard, [this] { return remaining == 0 && active == 0; });
+	job = nullptr;
+}
+
+/**
+ * Main loop of a worker thread.
+ * @param id Index of the worker.
+ */
+void ThreadPool::work(unsigned id) {
+	uint64_t seen = 0;
+
+	while (true) {
+		const std::function<void(size_t)> *fn;
+
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			wake.wait(guard, [this, seen] { return stopping || batch != seen; });
+
+			if (stopping) {
+				return;
+			}
+
+			seen = batch;
+			fn = job;
+
+			// Woke up after the batch had already finished
+			if (fn == nullptr) {
+				continue;
+			}
+
+			active += 1;
+		}
+
+		size_t index;
+		while (take(id, &index)) {
+			(*fn)(index);
+
+			std::lock_guard<std::mutex> guard(lock);
+			remaining -= 1;
+		}
+
+		std::lock_guard<std::mutex> guard(lock);
+		active -= 1;
+		if (remaining == 0 && active == 0) {
+			done.notify_all();
+		}
+	}
+}
+
+/**
+ * Takes the next job for a worker, first from its own queue and then by stealing from
+ * the back of the other queues.
+ * @param id Index of the worker.
+ * @param[out] index Index of the job taken.
+ * @returns `true` if a job was taken, `false` if every queue is empty.
+ */
+bool ThreadPool::take(unsigned id, size_t *index) {
+	{
+		Queue &own = *queues[id];
+		std::lock_guard<std::mutex> guard(own.lock);
+
+		if (!own.jobs.empty()) {
+			*index = own.jobs.front();
+			own.jobs.pop_front();
+			return true;
+		}
+	}
+
+	for (size_t offset = 1; offset < queues.size(); offset++) {
+		Queue &victim = *queues[(id + offset) % queues.size()];
+		std::lock_guard<std::mutex> guard(victim.lock);
+
+		if (!victim.jobs.empty()) {
+			*index = victim.jobs.back();
+			victim.jobs.pop_back();
+			return true;
+		}
+	}
+
+	return false;
+}
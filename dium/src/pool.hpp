@@ -0,0 +1,100 @@
+/**
+ * @file       pool.hpp
+ * @brief      Definitions for the work-stealing thread pool
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef POOL_HPP
+#define POOL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of worker threads that run batches of independent jobs. Every worker
+ * owns a queue of jobs and steals from the other queues once its own runs dry, so
+ * uneven jobs (e.g. files of very different sizes) still keep all threads busy.
+ */
+class ThreadPool {
+public:
+	/**
+	 * Starts the worker threads.
+	 * @param threads Number of workers, or 0 for one per hardware thread.
+	 */
+	explicit ThreadPool(unsigned threads = 0);
+
+	/**
+	 * Stops and joins the worker threads.
+	 */
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	/**
+	 * Runs `job(0)` to `job(count - 1)` across the workers and waits for all of them.
+	 * @param count Number of jobs.
+	 * @param job Function to run for each job index.
+	 */
+	void run(size_t count, const std::function<void(size_t)> &job);
+
+	/**
+	 * Returns the number of worker threads.
+	 * @returns Number of workers.
+	 */
+	unsigned size() const {
+		return static_cast<unsigned>(workers.size());
+	}
+
+private:
+	/* Queue of jobs owned by a single worker */
+	struct Queue {
+		std::mutex lock;
+		std::deque<size_t> jobs;
+	};
+
+	/** Job queue of each worker */
+	std::vector<std::unique_ptr<Queue>> queues;
+
+	/** Worker threads */
+	std::vector<std::thread> workers;
+
+	/** Guards the fields below */
+	std::mutex lock;
+
+	/** Signalled when a new batch starts or the pool stops */
+	std::condition_variable wake;
+
+	/** Signalled when the last job of a batch finishes */
+	std::condition_variable done;
+
+	/** Function run for every job of the current batch */
+	const std::function<void(size_t)> *job = nullptr;
+
+	/** Number of jobs of the current batch that have not finished */
+	size_t remaining = 0;
+
+	/** Number of workers currently taking jobs from the queues */
+	unsigned active = 0;
+
+	/** Incremented for every batch, so workers can tell batches apart */
+	uint64_t batch = 0;
+
+	/** `true` once the pool is shutting down */
+	bool stopping = false;
+
+	void work(unsigned id);
+	bool take(unsigned id, size_t *index);
+};
+
+#endif // POOL_HPP
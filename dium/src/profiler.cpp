@@ -0,0 +1,209 @@
+/**
+ * @file       profiler.cpp
+ * @brief      Implementation for the sampling profiler of dium programs
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <algorithm>
+#include "format.hpp"
+#include "profiler.hpp"
+
+// --------------- function prototypes -------------------------
+
+static double share(uint64_t count, uint64_t samples);
+static void appendShare(std::string *out, uint64_t count, uint64_t samples);
+
+
+Profiler::Profiler(uint32_t interval) : interval{ std::max<uint32_t>(interval, 1) } {}
+
+void Profiler::start(const Module &module) {
+	firstFunc = module.funcs.data();
+	funcNames.clear();
+	for (const Function &func : module.funcs) {
+		funcNames.push_back(func.name);
+	}
+
+	funcSamples.assign(module.funcs.size(), FuncSamples{});
+	funcSeen.assign(module.funcs.size(), 0);
+}
+
+uint32_t Profiler::nextInterval() {
+	// xorshift32, anywhere from half to one and a half times the interval
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return interval / 2 + seed % interval + 1;
+}
+
+void Profiler::record(const std::vector<ProfileFrame> &stack) {
+	samples++;
+	scratch.clear();
+
+	for (size_t idx = 0; idx < stack.size(); idx++) {
+		const ProfileFrame &frame = stack[idx];
+		auto func = static_cast<uint32_t>(frame.func - firstFunc);
+		bool self = idx + 1 == stack.size();
+		scratch.push_back(func);
+
+		// A recursive function is on the stack many times, but is only counted once
+		if (funcSeen[func] != samples) {
+			funcSeen[func] = samples;
+			funcSamples[func].total++;
+		}
+		if (self) {
+			funcSamples[func].self++;
+		}
+
+		if (frame.instr < frame.func->positions.size()) {
+			const SourcePosition &pos = frame.func->positions[frame.instr];
+			countLine(pos.line, self);
+
+			if (self) {
+				auto &position = positions[{ pos.line, pos.column }];
+				position.first++;
+				position.second = func;
+			}
+		}
+	}
+
+	stacks[scratch]++;
+}
+
+std::string Profiler::formatFolded() const {
+	std::string out;
+
+	for (const auto &[stack, count] : stacks) {
+		for (size_t idx = 0; idx < stack.size(); idx++) {
+			if (idx > 0) {
+				out += ';';
+			}
+			out += funcNames[stack[idx]];
+		}
+		appendFormat(&out, " %llu\n", static_cast<unsigned long long>(count));
+	}
+	return out;
+}
+
+std::string Profiler::formatListing(const char *source) const {
+	std::string out;
+	appendFormat(&out, "\nProfile:       %llu samples, one every %u instructions on average\n", static_cast<unsigned long long>(samples),
+		interval);
+
+	if (samples == 0) {
+		return out;
+	}
+
+	// Functions, hottest first
+	std::vector<uint32_t> funcs;
+	for (uint32_t func = 0; func < funcSamples.size(); func++) {
+		if (funcSamples[func].total > 0) {
+			funcs.push_back(func);
+		}
+	}
+	std::sort(funcs.begin(), funcs.end(), [this](uint32_t lhs, uint32_t rhs) {
+		if (funcSamples[lhs].self != funcSamples[rhs].self) {
+			return funcSamples[lhs].self > funcSamples[rhs].self;
+		}
+		return funcSamples[lhs].total > funcSamples[rhs].total;
+	});
+
+	appendFormat(&out, "\n  %7s %7s  %s\n", "self", "total", "function");
+	for (uint32_t func : funcs) {
+		appendFormat(&out, "  %6.1f%% %6.1f%%  %s\n", share(funcSamples[func].self, samples), share(funcSamples[func].total, samples),
+			funcNames[func].c_str());
+	}
+
+	// Positions, hottest first
+	std::vector<std::pair<std::pair<int, int>, std::pair<uint64_t, uint32_t>>> hottest(positions.begin(), positions.end());
+	std::stable_sort(hottest.begin(), hottest.end(), [](const auto &lhs, const auto &rhs) {
+		return lhs.second.first > rhs.second.first;
+	});
+	hottest.resize(std::min<size_t>(hottest.size(), PROFILE_TOP_POSITIONS));
+
+	appendFormat(&out, "\n  %7s  %-10s %s\n", "self", "position", "function");
+	for (const auto &[pos, entry] : hottest) {
+		std::string where = customFormat("%d:%d", pos.first, pos.second);
+		appendFormat(&out, "  %6.1f%%  %-10s %s\n", share(entry.first, samples), where.c_str(), funcNames[entry.second].c_str());
+	}
+
+	// The source file, with the share of each line in front of it
+	appendFormat(&out, "\n  %7s %7s  %5s\n", "self", "total", "line");
+	const char *cursor = source;
+	for (int line = 1; *cursor != '\0'; line++) {
+		const char *end = cursor;
+		while (*end != '\0' && *end != '\n') {
+			end++;
+		}
+
+		auto idx = static_cast<size_t>(line);
+		out += "  ";
+		appendShare(&out, (idx < lineSelf.size()) ? lineSelf[idx] : 0, samples);
+		out += ' ';
+		appendShare(&out, (idx < lineTotal.size()) ? lineTotal[idx] : 0, samples);
+		appendFormat(&out, "  %5d | ", line);
+
+		// Keep carriage returns of Windows line endings out of the listing
+		size_t length = static_cast<size_t>(end - cursor);
+		if (length > 0 && cursor[length - 1] == '\r') {
+			length--;
+		}
+		out.append(cursor, length);
+		out += '\n';
+
+		cursor = (*end == '\n') ? end + 1 : end;
+	}
+	return out;
+}
+
+/**
+ * Counts a sample towards a line.
+ * @param line Line the sample was at.
+ * @param self `true` if the sample was at an instruction of the line, rather than in a call made from it.
+ */
+void Profiler::countLine(int line, bool self) {
+	if (line < 0) {
+		return;
+	}
+
+	auto idx = static_cast<size_t>(line);
+	if (idx >= lineTotal.size()) {
+		lineSelf.resize(idx + 1, 0);
+		lineTotal.resize(idx + 1, 0);
+		lineSeen.resize(idx + 1, 0);
+	}
+
+	if (self) {
+		lineSelf[idx]++;
+	}
+	if (lineSeen[idx] != samples) {
+		lineSeen[idx] = samples;
+		lineTotal[idx]++;
+	}
+}
+
+/**
+ * Returns a number of samples as a percentage of all samples.
+ * @param count Number of samples.
+ * @param samples Number of all samples.
+ * @returns Percentage.
+ */
+static double share(uint64_t count, uint64_t samples) {
+	return 100.0 * static_cast<double>(count) / static_cast<double>(samples);
+}
+
+/**
+ * Appends a percentage of samples, or blanks of the same width if there are none, so
+ * that cold lines stand out less.
+ * @param out String to append to.
+ * @param count Number of samples.
+ * @param samples Number of all samples.
+ */
+static void appendShare(std::string *out, uint64_t count, uint64_t samples) {
+	if (count == 0) {
+		out->append(7, ' ');
+	} else {
+		appendFormat(out, "%6.1f%%", share(count, samples));
+	}
+}
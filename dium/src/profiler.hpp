@@ -0,0 +1,149 @@
+/**
+ * @file       profiler.hpp
+ * @brief      Definitions for the sampling profiler of dium programs
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "bytecode.hpp"
+
+/** Default number of instructions between samples */
+#define PROFILE_INTERVAL 1000
+
+/** Number of hottest source positions listed above the annotated source */
+#define PROFILE_TOP_POSITIONS 10
+
+/** Function being run and the instruction it is at, as seen by a sample */
+struct ProfileFrame {
+	/** Function being run */
+	const Function *func;
+
+	/** Index of the instruction being run, or of the call for callers */
+	size_t instr;
+};
+
+/**
+ * Sampling profiler, which the virtual machine calls every few thousand interpreted
+ * instructions with the call stack at that point. Sampling on the instruction count
+ * rather than on a timer keeps the virtual machine free of signals and makes runs
+ * repeatable; the interval is jittered so that samples do not line up with loops.
+ * Samples therefore measure interpreted instructions, not time spent in machine code,
+ * so the profiled program is run without the just-in-time compiler.
+ */
+class Profiler {
+public:
+	/**
+	 * Creates a profiler.
+	 * @param interval Average number of instructions between samples.
+	 */
+	explicit Profiler(uint32_t interval = PROFILE_INTERVAL);
+
+	/**
+	 * Starts profiling a module. The names of its functions are copied, so the profile
+	 * can be written after the module is gone.
+	 * @param module Module about to be run.
+	 */
+	void start(const Module &module);
+
+	/**
+	 * Returns the number of instructions to run before the next sample.
+	 * @returns Number of instructions, at least 1.
+	 */
+	uint32_t nextInterval();
+
+	/**
+	 * Records a sample.
+	 * @param stack Active calls, innermost last.
+	 */
+	void record(const std::vector<ProfileFrame> &stack);
+
+	/**
+	 * Returns the number of samples recorded so far.
+	 * @returns Number of samples.
+	 */
+	uint64_t getSampleCount() const {
+		return samples;
+	}
+
+	/**
+	 * Writes the samples as folded stacks, one line per distinct call stack with its
+	 * functions from outermost to innermost separated by `;` and followed by its number
+	 * of samples, which flamegraph.pl, speedscope and inferno read.
+	 * @returns Folded stacks.
+	 */
+	std::string formatFolded() const;
+
+	/**
+	 * Writes the source file annotated with the share of samples of each line, below a
+	 * summary of the hottest functions and source positions. A line counts as "self"
+	 * when a sample was at one of its instructions, and as "total" when it was there or
+	 * in a call made from it.
+	 * @param source Text of the source file, followed by a zero byte.
+	 * @returns Annotated listing.
+	 */
+	std::string formatListing(const char *source) const;
+
+private:
+	/* Samples of a function */
+	struct FuncSamples {
+		/** Samples at the function's own instructions */
+		uint64_t self = 0;
+
+		/** Samples in the function or anything it called */
+		uint64_t total = 0;
+	};
+
+	/** Average number of instructions between samples */
+	uint32_t interval;
+
+	/** State of the random number generator that jitters the interval */
+	uint32_t seed = 0x9e3779b9;
+
+	/** Number of samples recorded */
+	uint64_t samples = 0;
+
+	/** First function of the module, to number functions by */
+	const Function *firstFunc = nullptr;
+
+	/** Name of each function of the module */
+	std::vector<std::string> funcNames;
+
+	/** Samples of each function of the module */
+	std::vector<FuncSamples> funcSamples;
+
+	/** Number of samples of each call stack, as indices of its functions */
+	std::map<std::vector<uint32_t>, uint64_t> stacks;
+
+	/** Samples at the instructions of each line */
+	std::vector<uint64_t> lineSelf;
+
+	/** Samples at each line or in calls made from it */
+	std::vector<uint64_t> lineTotal;
+
+	/** Samples at each line and column, with the function they belong to */
+	std::map<std::pair<int, int>, std::pair<uint64_t, uint32_t>> positions;
+
+	/** Sample that last counted each line towards its total, so recursion counts once */
+	std::vector<uint64_t> lineSeen;
+
+	/** Sample that last counted each function towards its total */
+	std::vector<uint64_t> funcSeen;
+
+	/** Indices of the functions of the sample being recorded */
+	std::vector<uint32_t> scratch;
+
+	void countLine(int line, bool self);
+};
+
+#endif // PROFILER_HPP
@@ -0,0 +1,432 @@
+/**
+ * @file       scan.cpp
+ * @brief      Implementation for the vectorised character scanners used by the lexer
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "scan.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define DIUM_SIMD_X86
+	#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+	#define DIUM_TARGET_AVX2
+#else
+	#define DIUM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+/* Set of scanners for a single instruction set */
+struct Scanners {
+	const char *name;                                          /* Instruction set name */
+	const char *(*skipSpace)(const char *p);                   /* Skips whitespace */
+	const char *(*findLineEnd)(const char *p);                 /* Finds the end of the line */
+	const char *(*findCommentMark)(const char *p);             /* Finds '-' or '/' */
+	const char *(*findStringMark)(const char *p);              /* Finds special string characters */
+	int (*countLines)(const char *b, const char *e, const char **s);  /* Counts line breaks */
+};
+
+// --------------- function prototypes -------------------------
+
+static const char *lazySkipSpace(const char *p);
+static const char *lazyFindLineEnd(const char *p);
+static const char *lazyFindCommentMark(const char *p);
+static const char *lazyFindStringMark(const char *p);
+static int lazyCountLines(const char *b, const char *e, const char **s);
+
+/* Scanners in use, which select the real ones on first use */
+static Scanners active = {
+	"none", lazySkipSpace, lazyFindLineEnd, lazyFindCommentMark, lazyFindStringMark, lazyCountLines
+};
+
+/**
+ * Finds the index of the lowest set bit.
+ * @param mask Non-zero mask.
+ * @returns Index of the lowest set bit.
+ */
+static inline int lowestBit(uint32_t mask) {
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanForward(&idx, mask);
+	return static_cast<int>(idx);
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+/**
+ * Finds the index of the highest set bit.
+ * @param mask Non-zero mask.
+ * @returns Index of the highest set bit.
+ */
+static inline int highestBit(uint32_t mask) {
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanReverse(&idx, mask);
+	return static_cast<int>(idx);
+#else
+	return 31 - __builtin_clz(mask);
+#endif
+}
+
+/**
+ * Counts the set bits in a mask.
+ * @param mask Mask to count.
+ * @returns Number of set bits.
+ */
+static inline int countBits(uint32_t mask) {
+#ifdef _MSC_VER
+	int count = 0;
+	for (; mask != 0; mask &= mask - 1) {
+		count += 1;
+	}
+	return count;
+#else
+	return __builtin_popcount(mask);
+#endif
+}
+
+// --------------- scalar scanners -----------------------------
+
+static const char *skipSpaceScalar(const char *p) {
+	while (*p == ' ' || (*p >= '\t' && *p <= '\r')) {
+		p++;
+	}
+	return p;
+}
+
+static const char *findLineEndScalar(const char *p) {
+	while (*p != '\n' && *p != '\r' && *p != '\0') {
+		p++;
+	}
+	return p;
+}
+
+static const char *findCommentMarkScalar(const char *p) {
+	while (*p != '-' && *p != '/' && *p != '\0') {
+		p++;
+	}
+	return p;
+}
+
+static const char *findStringMarkScalar(const char *p) {
+	while (*p != '"' && *p != '\\' && static_cast<signed char>(*p) >= 32) {
+		p++;
+	}
+	return p;
+}
+
+static int countLinesScalar(const char *b, const char *e, const char **s) {
+	int count = 0;
+
+	for (const char *p = b; p < e; p++) {
+		if (*p == '\n' || (*p == '\r' && p[1] != '\n')) {
+			count += 1;
+			*s = p + 1;
+		}
+	}
+
+	return count;
+}
+
+#ifdef DIUM_SIMD_X86
+
+// --------------- SSE2 scanners -------------------------------
+
+static const char *skipSpaceSse2(const char *p) {
+	const __m128i space = _mm_set1_epi8(' ');
+	const __m128i tab = _mm_set1_epi8('\t');
+	const __m128i four = _mm_set1_epi8(4);
+
+	while (true) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		__m128i t = _mm_sub_epi8(v, tab);
+
+		// Whitespace is ' ' or '\t' to '\r' (checked as an unsigned range)
+		__m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(_mm_min_epu8(t, four), t));
+		uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_epi8(ws)) & 0xFFFF;
+
+		if (mask != 0) {
+			return p + lowestBit(mask);
+		}
+		p += 16;
+	}
+}
+
+static const char *findLineEndSse2(const char *p) {
+	const __m128i lf = _mm_set1_epi8('\n');
+	const __m128i cr = _mm_set1_epi8('\r');
+	const __m128i zero = _mm_setzero_si128();
+
+	while (true) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		__m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)), _mm_cmpeq_epi8(v, zero));
+		uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+
+		if (mask != 0) {
+			return p + lowestBit(mask);
+		}
+		p += 16;
+	}
+}
+
+static const char *findCommentMarkSse2(const char *p) {
+	const __m128i dash = _mm_set1_epi8('-');
+	const __m128i slash = _mm_set1_epi8('/');
+	const __m128i zero = _mm_setzero_si128();
+
+	while (true) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		__m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, dash), _mm_cmpeq_epi8(v, slash)), _mm_cmpeq_epi8(v, zero));
+		uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+
+		if (mask != 0) {
+			return p + lowestBit(mask);
+		}
+		p += 16;
+	}
+}
+
+static const char *findStringMarkSse2(const char *p) {
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i printable = _mm_set1_epi8(32);
+
+	while (true) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+
+		// Signed comparison catches both control characters and bytes above 127
+		__m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)), _mm_cmplt_epi8(v, printable));
+		uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+
+		if (mask != 0) {
+			return p + lowestBit(mask);
+		}
+		p += 16;
+	}
+}
+
+static int countLinesSse2(const char *b, const char *e, const char **s) {
+	const __m128i lf = _mm_set1_epi8('\n');
+	const __m128i cr = _mm_set1_epi8('\r');
+	int count = 0;
+
+	for (const char *p = b; p < e; p += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		__m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 1));
+
+		// A '\r' only ends a line when it is not followed by '\n'
+		__m128i lone = _mm_andnot_si128(_mm_cmpeq_epi8(next, lf), _mm_cmpeq_epi8(v, cr));
+		uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, lf), lone)));
+
+		if (e - p < 16) {
+			mask &= (1u << (e - p)) - 1;
+		}
+
+		if (mask != 0) {
+			count += countBits(mask);
+			*s = p + highestBit(mask) + 1;
+		}
+	}
+
+	return count;
+}
+
+// --------------- AVX2 scanners -------------------------------
+
+DIUM_TARGET_AVX2 static const char *skipSpaceAvx2(const char *p) {
+	const __m256i space = _mm256_set1_epi8(' ');
+	const __m256i tab = _mm256_set1_epi8('\t');
+	const __m256i four = _mm256_set1_epi8(4);
+
+	while (true) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		__m256i t = _mm256_sub_epi8(v, tab);
+		__m256i ws = _mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(_mm256_min_epu8(t, four), t));
+		uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(ws));
+
+		if (mask != 0) {
+			return p + lowestBit(mask);
+		}
+		p += 32;
+	}
+}
+
+DIUM_TARGET_AVX2 static const char *findLineEndAvx2(const char *p) {
+	const __m256i lf = _mm256_set1_epi8('\n');
+	const __m256i cr = _mm256_set1_epi8('\r');
+	const __m256i zero = _mm256_setzero_si256();
+
+	while (true) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		__m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, cr)), _mm256_cmpeq_epi8(v, zero));
+		uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+
+		if (mask != 0) {
+			return p + lowestBit(mask);
+		}
+		p += 32;
+	}
+}
+
+DIUM_TARGET_AVX2 static const char *findCommentMarkAvx2(const char *p) {
+	const __m256i dash = _mm256_set1_epi8('-');
+	const __m256i slash = _mm256_set1_epi8('/');
+	const __m256i zero = _mm256_setzero_si256();
+
+	while (true) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		__m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, dash), _mm256_cmpeq_epi8(v, slash)), _mm256_cmpeq_epi8(v, zero));
+		uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+
+		if (mask != 0) {
+			return p + lowestBit(mask);
+		}
+		p += 32;
+	}
+}
+
+DIUM_TARGET_AVX2 static const char *findStringMarkAvx2(const char *p) {
+	const __m256i quote = _mm256_set1_epi8('"');
+	const __m256i backslash = _mm256_set1_epi8('\\');
+	const __m256i printable = _mm256_set1_epi8(32);
+
+	while (true) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		__m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)), _mm256_cmpgt_epi8(printable, v));
+		uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+
+		if (mask != 0) {
+			return p + lowestBit(mask);
+		}
+		p += 32;
+	}
+}
+
+DIUM_TARGET_AVX2 static int countLinesAvx2(const char *b, const char *e, const char **s) {
+	const __m256i lf = _mm256_set1_epi8('\n');
+	const __m256i cr = _mm256_set1_epi8('\r');
+	int count = 0;
+
+	for (const char *p = b; p < e; p += 32) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		__m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 1));
+		__m256i lone = _mm256_andnot_si256(_mm256_cmpeq_epi8(next, lf), _mm256_cmpeq_epi8(v, cr));
+		uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, lf), lone)));
+
+		if (e - p < 32) {
+			mask &= (1u << (e - p)) - 1;
+		}
+
+		if (mask != 0) {
+			count += countBits(mask);
+			*s = p + highestBit(mask) + 1;
+		}
+	}
+
+	return count;
+}
+
+/**
+ * Checks if the processor and operating system support AVX2.
+ * @returns `true` if AVX2 instructions can be used, `false` otherwise.
+ */
+static bool hasAvx2() {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+
+	// Processor supports AVX and the OS saves the YMM registers
+	bool osSaves = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6);
+	if (!osSaves) {
+		return false;
+	}
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // DIUM_SIMD_X86
+
+void initScanner() {
+	// Allows the scalar scanners to be forced for comparison
+	const char *forced = getenv("DIUM_SCANNER");
+	bool scalar = forced != nullptr && strcmp(forced, "scalar") == 0;
+
+#ifdef DIUM_SIMD_X86
+	if (scalar) {
+		active = { "scalar", skipSpaceScalar, findLineEndScalar, findCommentMarkScalar, findStringMarkScalar, countLinesScalar };
+	} else if (hasAvx2() && !(forced != nullptr && strcmp(forced, "sse2") == 0)) {
+		active = { "avx2", skipSpaceAvx2, findLineEndAvx2, findCommentMarkAvx2, findStringMarkAvx2, countLinesAvx2 };
+	} else {
+		active = { "sse2", skipSpaceSse2, findLineEndSse2, findCommentMarkSse2, findStringMarkSse2, countLinesSse2 };
+	}
+#else
+	(void) scalar;
+	active = { "scalar", skipSpaceScalar, findLineEndScalar, findCommentMarkScalar, findStringMarkScalar, countLinesScalar };
+#endif
+}
+
+const char *getScannerName() {
+	if (active.skipSpace == lazySkipSpace) {
+		initScanner();
+	}
+	return active.name;
+}
+
+const char *skipSpace(const char *p) {
+	return active.skipSpace(p);
+}
+
+const char *findLineEnd(const char *p) {
+	return active.findLineEnd(p);
+}
+
+const char *findCommentMark(const char *p) {
+	return active.findCommentMark(p);
+}
+
+const char *findStringMark(const char *p) {
+	return active.findStringMark(p);
+}
+
+int countLines(const char *begin, const char *end, const char **lineStart) {
+	return active.countLines(begin, end, lineStart);
+}
+
+// --------------- lazy selection ------------------------------
+
+static const char *lazySkipSpace(const char *p) {
+	initScanner();
+	return active.skipSpace(p);
+}
+
+static const char *lazyFindLineEnd(const char *p) {
+	initScanner();
+	return active.findLineEnd(p);
+}
+
+static const char *lazyFindCommentMark(const char *p) {
+	initScanner();
+	return active.findCommentMark(p);
+}
+
+static const char *lazyFindStringMark(const char *p) {
+	initScanner();
+	return active.findStringMark(p);
+}
+
+static int lazyCountLines(const char *b, const char *e, const char **s) {
+	initScanner();
+	return active.countLines(b, e, s);
+}
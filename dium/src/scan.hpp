@@ -0,0 +1,69 @@
+/**
+ * @file       scan.hpp
+ * @brief      Definitions for the vectorised character scanners used by the lexer
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef SCAN_HPP
+#define SCAN_HPP
+
+/*
+ * Every scanner stops at a zero byte, so they can be pointed anywhere inside a
+ * `SourceBuffer` without a length and rely on its padding as the sentinel. Blocks of
+ * up to 32 characters (plus one for look-ahead) are read past the stopping point.
+ */
+
+/**
+ * Selects the fastest scanners supported by the processor. Called automatically on
+ * first use, but may be called up front to avoid the check on the hot path.
+ */
+void initScanner();
+
+/**
+ * Returns the name of the scanners in use ("avx2", "sse2" or "scalar").
+ * @returns Name of the instruction set used by the scanners.
+ */
+const char *getScannerName();
+
+/**
+ * Skips over whitespace (as defined by `isspace` in the "C" locale).
+ * @param p First character to check.
+ * @returns Pointer to the first character that is not whitespace.
+ */
+const char *skipSpace(const char *p);
+
+/**
+ * Finds the end of the current line.
+ * @param p First character to check.
+ * @returns Pointer to the first '\n', '\r' or zero byte.
+ */
+const char *findLineEnd(const char *p);
+
+/**
+ * Finds the next character that could open or close a multi-line comment.
+ * @param p First character to check.
+ * @returns Pointer to the first '-', '/' or zero byte.
+ */
+const char *findCommentMark(const char *p);
+
+/**
+ * Finds the next character inside a string literal that needs special handling.
+ * @param p First character to check.
+ * @returns Pointer to the first '"', '\\', control or non-ASCII character.
+ */
+const char *findStringMark(const char *p);
+
+/**
+ * Counts the line breaks in a range, treating "\r\n" as a single line break.
+ * @param begin First character of the range.
+ * @param end One past the last character of the range.
+ * @param[out] lineStart Set to the character following the last line break, if any.
+ * @returns Number of line breaks in the range.
+ */
+int countLines(const char *begin, const char *end, const char **lineStart);
+
+#endif // SCAN_HPP
@@ -0,0 +1,220 @@
+/**
+ * @file       source.cpp
+ * @brief      Implementation for reading source files into memory
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "source.hpp"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+	#include <fcntl.h>
+	#include <io.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+// --------------- function prototypes -------------------------
+
+static bool mapSource(SourceBuffer *buffer, const char *path);
+static bool readSource(SourceBuffer *buffer, FILE *file);
+
+/** Size of the chunks read from streams that cannot be mapped */
+#define READ_CHUNK_SIZE (64 * 1024)
+
+
+bool openSource(SourceBuffer *buffer, const char *path) {
+	*buffer = SourceBuffer{};
+
+	// Standard input can only be read in one go
+	if (strcmp(path, "-") == 0) {
+#ifdef _WIN32
+		_setmode(_fileno(stdin), _O_BINARY);
+#endif
+		return readSource(buffer, stdin);
+	}
+
+	if (mapSource(buffer, path)) {
+		return true;
+	}
+
+	FILE *file = fopen(path, "rb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	bool success = readSource(buffer, file);
+	fclose(file);
+	return success;
+}
+
+bool copySource(SourceBuffer *buffer, const char *text, size_t length) {
+	char *data = static_cast<char *>(malloc(length + SOURCE_PADDING));
+	if (data == nullptr) {
+		return false;
+	}
+
+	memcpy(data, text, length);
+	memset(data + length, 0, SOURCE_PADDING);
+
+	buffer->data = data;
+	buffer->size = length;
+	buffer->capacity = length + SOURCE_PADDING;
+	buffer->mapped = false;
+	return true;
+}
+
+void closeSource(SourceBuffer *buffer) {
+	if (buffer->data == nullptr) {
+		return;
+	}
+
+	if (buffer->mapped) {
+#ifdef _WIN32
+		UnmapViewOfFile(buffer->data);
+#else
+		munmap(const_cast<char *>(buffer->data), buffer->capacity);
+#endif
+	} else {
+		free(const_cast<char *>(buffer->data));
+	}
+
+	*buffer = SourceBuffer{};
+}
+
+/**
+ * Memory-maps a regular file. Pages are zero-filled past the end of the file, so the
+ * mapping is only used when the last page has room for the padding.
+ * @param[out] buffer Buffer to fill.
+ * @param path Path to the file.
+ * @returns `true` if the file was mapped, `false` if it has to be read instead.
+ */
+bool mapSource(SourceBuffer *buffer, const char *path) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+
+	if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	auto size = static_cast<size_t>(fileSize.QuadPart);
+	size_t pageSize = info.dwPageSize;
+	size_t slack = (pageSize - (size % pageSize)) % pageSize;
+
+	if (slack < SOURCE_PADDING) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr) {
+		return false;
+	}
+
+	void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (data == nullptr) {
+		return false;
+	}
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	auto size = static_cast<size_t>(info.st_size);
+	auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	size_t slack = (pageSize - (size % pageSize)) % pageSize;
+
+	if (slack < SOURCE_PADDING) {
+		close(fd);
+		return false;
+	}
+
+	void *data = mmap(nullptr, size + slack, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+
+	// The lexer walks the file front to back exactly once
+	madvise(data, size + slack, MADV_SEQUENTIAL);
+#endif
+
+	buffer->data = static_cast<const char *>(data);
+	buffer->size = size;
+	buffer->capacity = size + slack;
+	buffer->mapped = true;
+	return true;
+}
+
+/**
+ * Reads the whole of a stream onto the heap.
+ * @param[out] buffer Buffer to fill.
+ * @param file Stream to read from.
+ * @returns `true` if the stream was read successfully, `false` otherwise.
+ */
+bool readSource(SourceBuffer *buffer, FILE *file) {
+	size_t capacity = READ_CHUNK_SIZE;
+	size_t size = 0;
+	char *data = static_cast<char *>(malloc(capacity));
+	if (data == nullptr) {
+		return false;
+	}
+
+	while (true) {
+		if (capacity - size < READ_CHUNK_SIZE + SOURCE_PADDING) {
+			// The old block is still ours when a bigger one cannot be had
+			char *grown = static_cast<char *>(realloc(data, capacity * 2));
+			if (grown == nullptr) {
+				free(data);
+				return false;
+			}
+			data = grown;
+			capacity *= 2;
+		}
+
+		size_t count = fread(data + size, 1, READ_CHUNK_SIZE, file);
+		size += count;
+
+		if (count < READ_CHUNK_SIZE) {
+			break;
+		}
+	}
+
+	if (ferror(file)) {
+		free(data);
+		return false;
+	}
+
+	memset(data + size, 0, SOURCE_PADDING);
+	buffer->data = data;
+	buffer->size = size;
+	buffer->capacity = capacity;
+	buffer->mapped = false;
+	return true;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file       source.hpp
+ * @brief      Definitions for reading source files into memory
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef SOURCE_HPP
+#define SOURCE_HPP
+
+#include <cstddef>
+
+/**
+ * Minimum number of zero bytes that follow the last character of a source buffer, which
+ * is enough for the scanners to read a whole 32-byte block (plus look-ahead) past the end.
+ */
+#define SOURCE_PADDING 64
+
+/** Contents of a source file held in memory */
+struct SourceBuffer {
+	/** First character of the source, always followed by `SOURCE_PADDING` zero bytes */
+	const char *data = nullptr;
+
+	/** Number of characters in the source (excluding the padding) */
+	size_t size = 0;
+
+	/** Number of bytes that were mapped or allocated */
+	size_t capacity = 0;
+
+	/** `true` if the data is memory-mapped, `false` if it lives on the heap */
+	bool mapped = false;
+};
+
+/**
+ * Reads a whole source file into memory. Regular files are memory-mapped when the
+ * zero-filled tail of the last page is large enough to act as the padding, while
+ * everything else (including standard input, given as "-") is read in one go.
+ * @param[out] buffer Buffer to fill.
+ * @param path Path to the source file, or "-" for the standard input.
+ * @returns `true` if the source was read successfully, `false` otherwise.
+ */
+bool openSource(SourceBuffer *buffer, const char *path);
+
+/**
+ * Copies the given text into a padded source buffer.
+ * @param[out] buffer Buffer to fill.
+ * @param text Text to copy.
+ * @param length Number of characters in the text.
+ * @returns `true` if the text was copied, `false` if there was no memory for it.
+ */
+bool copySource(SourceBuffer *buffer, const char *text, size_t length);
+
+/**
+ * Releases the memory held by a source buffer.
+ * @param buffer Buffer to release.
+ */
+void closeSource(SourceBuffer *buffer);
+
+#endif // SOURCE_HPP
@@ -0,0 +1,228 @@
+/**
+ * @file       stats.cpp
+ * @brief      Implementation for measuring the phases of a run
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include "error.hpp"
+#include "format.hpp"
+#include "json.hpp"
+#include "stats.hpp"
+#include "vm.hpp"
+
+/* Statistics of this run */
+static RunStats stats;
+
+/* Names of the phases, in the order of `Phase` */
+static const char *phaseNames[PHASE_COUNT] = { "read", "load", "lex", "parse", "check", "compile", "optimize", "execute" };
+
+// --------------- function prototypes -------------------------
+
+static double elapsed();
+static void endPhases();
+static std::vector<std::pair<uint64_t, size_t>> sortCounts(const uint64_t *counts, size_t size);
+
+
+RunStats &getStats() {
+	return stats;
+}
+
+void enableStats() {
+	stats.enabled = true;
+	stats.origin = std::chrono::steady_clock::now();
+	std::fill(std::begin(stats.phaseStart), std::end(stats.phaseStart), -1.0);
+	std::fill(std::begin(stats.phaseTime), std::end(stats.phaseTime), -1.0);
+	std::fill(std::begin(stats.tokenCounts), std::end(stats.tokenCounts), 0);
+	std::fill(std::begin(stats.opcodeCounts), std::end(stats.opcodeCounts), 0);
+}
+
+PhaseTimer::PhaseTimer(Phase phase) : phase{ phase } {
+	if (stats.enabled) {
+		stats.phaseStart[phase] = elapsed();
+		stats.phaseTime[phase] = -1.0;
+	}
+}
+
+PhaseTimer::~PhaseTimer() {
+	if (stats.enabled) {
+		stats.phaseTime[phase] = elapsed() - stats.phaseStart[phase];
+	}
+}
+
+void countSource(const SourceBuffer &buffer) {
+	if (stats.enabled) {
+		stats.sourceBytes = buffer.size;
+	}
+}
+
+void countTokens(const TokenStream &tokens) {
+	if (!stats.enabled) {
+		return;
+	}
+
+	for (TokenType type : tokens.types) {
+		stats.tokenCounts[type]++;
+	}
+}
+
+void countArena(const Arena &arena) {
+	if (!stats.enabled) {
+		return;
+	}
+
+	stats.arenaBytes = arena.getBytesUsed();
+	stats.arenaReserved = arena.getBytesReserved();
+	stats.arenaBlocks = arena.getBlockCount();
+}
+
+void countRun(const VM &vm) {
+	if (!stats.enabled) {
+		return;
+	}
+
+	for (int op = 0; op < OP_COUNT; op++) {
+		stats.opcodeCounts[op] = vm.getOpcodeCount(static_cast<Opcode>(op));
+	}
+	stats.heapObjects = vm.getHeap().getTotalObjects();
+	stats.heapBytes = vm.getHeap().getTotalBytes();
+	stats.jitCompiled = vm.getCompiledCount();
+}
+
+std::string formatStats() {
+	endPhases();
+	std::string out;
+
+	out += "\nPhases:\n";
+	double total = 0;
+	for (int phase = 0; phase < PHASE_COUNT; phase++) {
+		if (stats.phaseStart[phase] >= 0) {
+			appendFormat(&out, "  %-12s %10.3f ms\n", phaseNames[phase], stats.phaseTime[phase] / 1000.0);
+			total += stats.phaseTime[phase];
+		}
+	}
+	appendFormat(&out, "  %-12s %10.3f ms (%.3f ms since the start)\n", "total", total / 1000.0, elapsed() / 1000.0);
+
+	uint64_t tokens = 0;
+	for (uint64_t count : stats.tokenCounts) {
+		tokens += count;
+	}
+	appendFormat(&out, "\nSource:        %zu bytes, %llu tokens\n", stats.sourceBytes, static_cast<unsigned long long>(tokens));
+	for (const auto &[count, type] : sortCounts(stats.tokenCounts, TOK_NONE)) {
+		appendFormat(&out, "  %-18s %10llu\n", getTokenString(static_cast<TokenType>(type)), static_cast<unsigned long long>(count));
+	}
+
+	appendFormat(&out, "\nArena:         %zu bytes used, %zu reserved in %zu blocks\n", stats.arenaBytes, stats.arenaReserved,
+		stats.arenaBlocks);
+	appendFormat(&out, "Heap:          %llu objects, %llu bytes allocated\n", static_cast<unsigned long long>(stats.heapObjects),
+		static_cast<unsigned long long>(stats.heapBytes));
+	appendFormat(&out, "JIT:           %zu functions compiled\n", stats.jitCompiled);
+
+	uint64_t instructions = 0;
+	for (uint64_t count : stats.opcodeCounts) {
+		instructions += count;
+	}
+	appendFormat(&out, "\nInstructions:  %llu interpreted\n", static_cast<unsigned long long>(instructions));
+	for (const auto &[count, op] : sortCounts(stats.opcodeCounts, OP_COUNT)) {
+		appendFormat(&out, "  %-18s %10llu %6.2f%%\n", getOpcodeName(static_cast<Opcode>(op)), static_cast<unsigned long long>(count),
+			100.0 * static_cast<double>(count) / static_cast<double>(instructions));
+	}
+	return out;
+}
+
+std::string formatTrace() {
+	endPhases();
+	std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	// Name the process after the source file, everything happens on one thread
+	out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":";
+	appendJsonString(&out, "dium " + sname);
+	out += "}}";
+
+	for (int phase = 0; phase < PHASE_COUNT; phase++) {
+		if (stats.phaseStart[phase] < 0) {
+			continue;
+		}
+
+		appendFormat(&out, ",{\"name\":\"%s\",\"cat\":\"phase\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,\"args\":{",
+			phaseNames[phase], stats.phaseStart[phase], stats.phaseTime[phase]);
+
+		// Each phase carries the counts of what it produced
+		switch (phase) {
+		case PHASE_READ:
+			appendFormat(&out, "\"bytes\":%zu", stats.sourceBytes);
+			break;
+		case PHASE_LEX: {
+			const char *separator = "";
+			for (const auto &[count, type] : sortCounts(stats.tokenCounts, TOK_NONE)) {
+				out += separator;
+				appendJsonString(&out, getTokenString(static_cast<TokenType>(type)));
+				appendFormat(&out, ":%llu", static_cast<unsigned long long>(count));
+				separator = ",";
+			}
+			break;
+		}
+		case PHASE_EXECUTE: {
+			const char *separator = "";
+			for (const auto &[count, op] : sortCounts(stats.opcodeCounts, OP_COUNT)) {
+				appendFormat(&out, "%s\"%s\":%llu", separator, getOpcodeName(static_cast<Opcode>(op)), static_cast<unsigned long long>(count));
+				separator = ",";
+			}
+			break;
+		}
+		default:
+			break;
+		}
+		out += "}}";
+	}
+
+	// Totals that belong to no single phase
+	appendFormat(&out, "],\"otherData\":{\"source_bytes\":%zu,\"arena_bytes\":%zu,\"arena_reserved\":%zu,\"arena_blocks\":%zu,"
+		"\"heap_objects\":%llu,\"heap_bytes\":%llu,\"jit_compiled\":%zu}}\n", stats.sourceBytes, stats.arenaBytes, stats.arenaReserved,
+		stats.arenaBlocks, static_cast<unsigned long long>(stats.heapObjects), static_cast<unsigned long long>(stats.heapBytes), stats.jitCompiled);
+	return out;
+}
+
+/**
+ * Returns the time since statistics were enabled.
+ * @returns Microseconds since the origin.
+ */
+static double elapsed() {
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - stats.origin).count();
+}
+
+/**
+ * Ends the phases that are still running, which happens when the process exits on an error.
+ */
+static void endPhases() {
+	for (int phase = 0; phase < PHASE_COUNT; phase++) {
+		if (stats.phaseStart[phase] >= 0 && stats.phaseTime[phase] < 0) {
+			stats.phaseTime[phase] = elapsed() - stats.phaseStart[phase];
+		}
+	}
+}
+
+/**
+ * Lists the counts that are not zero, largest first.
+ * @param counts Count of each item.
+ * @param size Number of items.
+ * @returns Pairs of a count and the index of its item.
+ */
+static std::vector<std::pair<uint64_t, size_t>> sortCounts(const uint64_t *counts, size_t size) {
+	std::vector<std::pair<uint64_t, size_t>> sorted;
+
+	for (size_t idx = 0; idx < size; idx++) {
+		if (counts[idx] != 0) {
+			sorted.emplace_back(counts[idx], idx);
+		}
+	}
+
+	std::sort(sorted.begin(), sorted.end(), [](const auto &lhs, const auto &rhs) {
+		return (lhs.first != rhs.first) ? lhs.first > rhs.first : lhs.second < rhs.second;
+	});
+	return sorted;
+}
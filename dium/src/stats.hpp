@@ -0,0 +1,168 @@
+/**
+ * @file       stats.hpp
+ * @brief      Definitions for measuring the phases of a run
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "arena.hpp"
+#include "bytecode.hpp"
+#include "source.hpp"
+#include "token.hpp"
+
+class VM;
+
+/** Phases of a run, in the order they happen */
+enum Phase : uint8_t {
+	PHASE_READ,      /* reading the source file */
+	PHASE_LOAD,      /* loading the compiled program from the cache instead */
+	PHASE_LEX,       /* splitting it into tokens */
+	PHASE_PARSE,     /* building the syntax tree */
+	PHASE_CHECK,     /* checking types and names */
+	PHASE_COMPILE,   /* generating bytecode */
+	PHASE_OPTIMIZE,  /* optimizing the bytecode */
+	PHASE_EXECUTE,   /* running the program */
+	PHASE_COUNT
+};
+
+/**
+ * What a run of the compiler did and how long each phase took. Nothing is measured
+ * until `enableStats()` is called: phases check a single flag, and counts that would
+ * cost something on a hot path are gathered afterwards (tokens, by walking the token
+ * stream; allocations, from totals the arena and heap keep anyway) or by code that is
+ * only run when measuring (instructions, by the counting variant of the virtual
+ * machine).
+ */
+struct RunStats {
+	/** `true` once measuring was enabled */
+	bool enabled = false;
+
+	/** Time everything is measured from */
+	std::chrono::steady_clock::time_point origin;
+
+	/** Start of each phase in microseconds since the origin, negative if it did not start */
+	double phaseStart[PHASE_COUNT];
+
+	/** Time taken by each phase in microseconds, negative while it has not ended */
+	double phaseTime[PHASE_COUNT];
+
+	/** Size of the source file in bytes */
+	size_t sourceBytes = 0;
+
+	/** Number of tokens of each type */
+	uint64_t tokenCounts[TOK_NONE];
+
+	/** Bytes handed out by the arena of the syntax tree */
+	size_t arenaBytes = 0;
+
+	/** Bytes the arena reserved from the system... */
+	size_t arenaReserved = 0;
+
+	/** ...in this many blocks */
+	size_t arenaBlocks = 0;
+
+	/** Number of strings and arrays the program allocated */
+	uint64_t heapObjects = 0;
+
+	/** Bytes held by those objects when they were allocated */
+	uint64_t heapBytes = 0;
+
+	/** Number of instructions of each opcode that were interpreted */
+	uint64_t opcodeCounts[OP_COUNT];
+
+	/** Number of functions compiled to machine code, whose instructions are not counted */
+	size_t jitCompiled = 0;
+};
+
+/**
+ * Returns the statistics of this run.
+ * @returns Statistics, empty unless `enableStats()` was called.
+ */
+RunStats &getStats();
+
+/**
+ * Starts measuring, from now on.
+ */
+void enableStats();
+
+/**
+ * Checks if statistics are being gathered.
+ * @returns `true` once `enableStats()` was called.
+ */
+inline bool statsEnabled() {
+	return getStats().enabled;
+}
+
+/**
+ * Times a phase from its creation to its destruction. Phases that are still running
+ * when the process exits, after an error, are ended by the report.
+ */
+class PhaseTimer {
+public:
+	/**
+	 * Starts a phase, if statistics are being gathered.
+	 * @param phase Phase to time.
+	 */
+	explicit PhaseTimer(Phase phase);
+
+	/**
+	 * Ends the phase.
+	 */
+	~PhaseTimer();
+
+	PhaseTimer(const PhaseTimer &) = delete;
+	PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+private:
+	Phase phase;
+};
+
+/**
+ * Records the size of the source file, if statistics are being gathered.
+ * @param buffer Text of the source file.
+ */
+void countSource(const SourceBuffer &buffer);
+
+/**
+ * Counts the tokens of each type, if statistics are being gathered.
+ * @param tokens Tokens of the source file.
+ */
+void countTokens(const TokenStream &tokens);
+
+/**
+ * Records how much memory an arena used, if statistics are being gathered.
+ * @param arena Arena the syntax tree was allocated from.
+ */
+void countArena(const Arena &arena);
+
+/**
+ * Records what the virtual machine executed and allocated, if statistics are being
+ * gathered. Called after the program returns, and before a runtime error exits.
+ * @param vm Virtual machine that ran the program.
+ */
+void countRun(const VM &vm);
+
+/**
+ * Writes the statistics as text, ending phases that are still running.
+ * @returns Readable report.
+ */
+std::string formatStats();
+
+/**
+ * Writes the statistics in the Chrome trace event format, which chrome://tracing and
+ * Perfetto can open: a span for each phase, with its counts as arguments.
+ * @returns JSON text of the trace.
+ */
+std::string formatTrace();
+
+#endif // STATS_HPP
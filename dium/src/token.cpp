@@ -22,3 +22,40 @@ const char *getTokenString(TokenType type) {
 	assert(type >= 0 && type < (sizeof(tokenNames) / sizeof(char *)));
 	return tokenNames[type];
 }
+
+std::string getStringValue(const Token &token, const char *source) {
+	std::string_view raw = getStringText(token, source);
+	if (!(token.flags & TOKF_ESCAPED)) {
+		return std::string(raw);
+	}
+
+	return unescapeString(raw);
+}
+
+std::string unescapeString(std::string_view raw) {
+	std::string value;
+	value.reserve(raw.size());
+
+	for (size_t idx = 0; idx < raw.size(); idx++) {
+		if (raw[idx] != '\\') {
+			value += raw[idx];
+			continue;
+		}
+
+		// The lexer only accepts known escape codes
+		idx += 1;
+		switch (raw[idx]) {
+		case 'n':
+			value += '\n';
+			break;
+		case 't':
+			value += '\t';
+			break;
+		default:
+			value += raw[idx];
+			break;
+		}
+	}
+
+	return value;
+}
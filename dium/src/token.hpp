@@ -12,8 +12,12 @@
 #define TOKEN_HPP
 
 #include <cstdint>
+#include <cstring>
 #include <string>
-#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "interner.hpp"
 
 /** Maximum length of an identifier */
 #define MAX_ID_LENGTH 32
@@ -84,27 +88,188 @@ enum TokenType : int32_t {
 
 };
 
-/** Token data type */
+/* Position in the source file */
+struct SourcePosition {
+	int line = 1;
+	int column = 1;
+};
+
+/** Extra information about a token */
+enum TokenFlags : uint8_t {
+	TOKF_NONE    = 0,
+	TOKF_KEYWORD = 1 << 0,  /* reserved word, rather than a literal of the same type (e.g. `num` vs `42`) */
+	TOKF_ESCAPED = 1 << 1,  /* string literal containing escape codes */
+	TOKF_UNCLOSED = 1 << 2  /* string literal missing its closing quote, cut off at the end of its line */
+};
+
+/**
+ * Token data type. Tokens are trivially copyable and refer back to the source buffer
+ * for their text, so producing one never touches the heap.
+ */
 struct Token {
 	/** Type of the token */
 	TokenType type;
 
-	/** Identifier */
-	std::optional<std::string> identifier;
+	/** Combination of `TokenFlags` */
+	uint8_t flags;
+
+	/** Offset of the first character of the token in the source */
+	uint32_t offset;
+
+	/** Number of characters in the token (including quotes for literals) */
+	uint32_t length;
 
-	/** Value (for strings) */
-	std::optional<std::string> string;
+	/** Position of the first character of the token */
+	SourcePosition position;
 
-	/** Value (for characters) */
-	std::optional<char> character;
+	union {
+		/** Value (for characters) */
+		char character;
 
-	/** Value (for numbers) */
-	std::optional<int> ivalue;
+		/** Value (for numbers) */
+		int ivalue;
 
-	/** Value (for decimals) */
-	std::optional<double> dvalue;
+		/** Value (for decimals) */
+		double dvalue;
+
+		/** Interned name (for identifiers) */
+		Symbol symbol;
+	};
 };
 
+static_assert(std::is_trivially_copyable<Token>::value, "Tokens must stay trivially copyable");
+
+/**
+ * Tokens of a whole source file, stored as a struct of arrays so that later stages can
+ * scan one property (usually the type) of many tokens at once and look ahead freely.
+ * The last token is always `TOK_EOF`.
+ */
+struct TokenStream {
+	/** Source the tokens were read from */
+	const char *source = nullptr;
+
+	/** Table the identifiers were interned in */
+	const Interner *symbols = nullptr;
+
+	/** Type of each token */
+	std::vector<TokenType> types;
+
+	/** Flags of each token */
+	std::vector<uint8_t> flags;
+
+	/** Offset of each token in the source */
+	std::vector<uint32_t> offsets;
+
+	/** Length of each token */
+	std::vector<uint32_t> lengths;
+
+	/** Line and column of each token */
+	std::vector<SourcePosition> positions;
+
+	/** Raw bits of the value of each token (see `Token`) */
+	std::vector<uint64_t> values;
+
+	/**
+	 * Returns the number of tokens in the stream.
+	 * @returns Number of tokens, including the final `TOK_EOF`.
+	 */
+	size_t size() const {
+		return types.size();
+	}
+
+	/**
+	 * Reserves space for the given number of tokens.
+	 * @param count Number of tokens to reserve space for.
+	 */
+	void reserve(size_t count) {
+		types.reserve(count);
+		flags.reserve(count);
+		offsets.reserve(count);
+		lengths.reserve(count);
+		positions.reserve(count);
+		values.reserve(count);
+	}
+
+	/**
+	 * Appends a token to the end of the stream.
+	 * @param token Token to append.
+	 */
+	void push(const Token &token) {
+		uint64_t value;
+		memcpy(&value, &token.dvalue, sizeof(value));
+
+		types.push_back(token.type);
+		flags.push_back(token.flags);
+		offsets.push_back(token.offset);
+		lengths.push_back(token.length);
+		positions.push_back(token.position);
+		values.push_back(value);
+	}
+
+	/**
+	 * Gathers a single token from the stream.
+	 * @param idx Index of the token.
+	 * @param[out] token Token to fill.
+	 */
+	void get(size_t idx, Token *token) const {
+		token->type = types[idx];
+		token->flags = flags[idx];
+		token->offset = offsets[idx];
+		token->length = lengths[idx];
+		token->position = positions[idx];
+		memcpy(&token->dvalue, &values[idx], sizeof(values[idx]));
+	}
+
+	/**
+	 * Returns the symbol of an identifier in the stream.
+	 * @param idx Index of a `TOK_ID` token.
+	 * @returns Symbol the lexer interned the identifier as.
+	 */
+	Symbol getSymbol(size_t idx) const {
+		Symbol symbol;
+		memcpy(&symbol, &values[idx], sizeof(symbol));
+		return symbol;
+	}
+};
+
+/**
+ * Returns the text of a token.
+ * @param token Token to get the text of.
+ * @param source Source the token was read from.
+ * @returns View of the characters making up the token.
+ */
+inline std::string_view getTokenText(const Token &token, const char *source) {
+	return std::string_view(source + token.offset, token.length);
+}
+
+/**
+ * Returns the contents of a string literal, without the surrounding quotes. Escape
+ * codes are left as written.
+ * @param token String literal token.
+ * @param source Source the token was read from.
+ * @returns View of the characters between the quotes.
+ */
+inline std::string_view getStringText(const Token &token, const char *source) {
+	return std::string_view(source + token.offset + 1, token.length - 2);
+}
+
+/**
+ * Returns the value of a string literal, replacing escape codes by the characters
+ * they represent. Only allocates when the literal is used as a value.
+ * @param token String literal token.
+ * @param source Source the token was read from.
+ * @returns Value of the string literal.
+ */
+std::string getStringValue(const Token &token, const char *source);
+
+/**
+ * Replaces the escape codes in the text of a string literal by the characters they
+ * represent.
+ * @param raw Characters between the quotes, as written.
+ * @returns Value of the string literal.
+ */
+std::string unescapeString(std::string_view raw);
+
 /**
  * Returns a string representation of the token type.
  * @param type Type of token to get the string representation of.
@@ -0,0 +1,241 @@
+/**
+ * @file       value.cpp
+ * @brief      Implementation for runtime values and the garbage-collected heap
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include "value.hpp"
+
+
+void appendValue(std::string *out, Value value, Type type) {
+	char buffer[NUMBER_TEXT_MAX];
+
+	if (type.rank > 0) {
+		const ArrayObject *array = asArray(value);
+		*out += '[';
+
+		for (size_t idx = 0; idx < array->items.size(); idx++) {
+			if (idx > 0) {
+				*out += ", ";
+			}
+			appendValue(out, array->items[idx], array->itemType);
+		}
+
+		*out += ']';
+		return;
+	}
+
+	switch (type.base) {
+	case TYPE_VOID:
+		break;
+	case TYPE_BOOL:
+		*out += value.num ? "true" : "false";
+		break;
+	case TYPE_CHAR:
+		*out += static_cast<char>(value.num);
+		break;
+	case TYPE_NUM:
+		out->append(buffer, formatNum(buffer, value.num));
+		break;
+	case TYPE_DEC:
+		out->append(buffer, formatDec(buffer, value.dec));
+		break;
+	case TYPE_STR: {
+		StrView str = getStr(value);
+		out->append(str.chars, str.length);
+		break;
+	}
+	}
+}
+
+void printValue(Output &out, Value value, Type type) {
+	if (type.rank > 0) {
+		const ArrayObject *array = asArray(value);
+		out.put('[');
+
+		for (size_t idx = 0; idx < array->items.size(); idx++) {
+			if (idx > 0) {
+				out.write(", ", 2);
+			}
+			printValue(out, array->items[idx], array->itemType);
+		}
+
+		out.put(']');
+		return;
+	}
+
+	switch (type.base) {
+	case TYPE_VOID:
+		break;
+	case TYPE_BOOL:
+		out.write(value.num ? std::string_view("true") : std::string_view("false"));
+		break;
+	case TYPE_CHAR:
+		out.put(static_cast<char>(value.num));
+		break;
+	case TYPE_NUM:
+		out.writeNum(value.num);
+		break;
+	case TYPE_DEC:
+		out.writeDec(value.dec);
+		break;
+	case TYPE_STR: {
+		StrView str = getStr(value);
+		out.write(str.chars, str.length);
+		break;
+	}
+	}
+}
+
+bool equalStrings(const Value &a, const Value &b) {
+	// The same object or the same small string
+	if (a.num == b.num) {
+		return true;
+	}
+	if (isSmallStr(a) || isSmallStr(b)) {
+		return false;
+	}
+
+	// Literals with different objects have different texts
+	const StrObject *lhs = asStr(a);
+	const StrObject *rhs = asStr(b);
+	if (lhs->interned && rhs->interned) {
+		return false;
+	}
+	return lhs->length == rhs->length && memcmp(lhs->chars(), rhs->chars(), lhs->length) == 0;
+}
+
+int compareStrings(const Value &a, const Value &b) {
+	if (a.num == b.num) {
+		return 0;
+	}
+
+	StrView lhs = getStr(a);
+	StrView rhs = getStr(b);
+	return std::string_view(lhs.chars, lhs.length).compare(std::string_view(rhs.chars, rhs.length));
+}
+
+// --------------- heap ----------------------------------------
+
+Heap::~Heap() {
+	while (objects != nullptr) {
+		Object *next = objects->next;
+		release(objects);
+		objects = next;
+	}
+}
+
+StrObject *Heap::newString(const char *text, size_t length) {
+	size_t size = sizeof(StrObject) + length + 1;
+	void *memory = malloc(size);
+	if (memory == nullptr) {
+		throw std::bad_alloc();
+	}
+
+	auto *str = new (memory) StrObject;
+	str->length = static_cast<uint32_t>(length);
+	str->interned = false;
+	memcpy(str->chars(), text, length);
+	str->chars()[length] = '\0';
+
+	track(str, OBJ_STR, size);
+	return str;
+}
+
+ArrayObject *Heap::newArray(Type itemType, const Value *items, size_t count) {
+	auto *array = new ArrayObject;
+	array->itemType = itemType;
+	array->items.assign(items, items + count);
+
+	track(array, OBJ_ARRAY, getSize(array));
+	return array;
+}
+
+void Heap::trace() {
+	// Arrays of strings and arrays are the only objects that refer to others
+	while (!grey.empty()) {
+		Object *obj = grey.back();
+		grey.pop_back();
+
+		if (obj->kind == OBJ_ARRAY && isRefType(static_cast<ArrayObject *>(obj)->itemType)) {
+			for (Value item : static_cast<ArrayObject *>(obj)->items) {
+				mark(item.obj);
+			}
+		}
+	}
+}
+
+void Heap::sweep() {
+	Object **link = &objects;
+
+	while (*link != nullptr) {
+		Object *obj = *link;
+
+		if (obj->marked) {
+			obj->marked = false;
+			link = &obj->next;
+		} else {
+			*link = obj->next;
+			allocated -= getSize(obj);
+			release(obj);
+		}
+	}
+
+	// Grow with the live data so that collections stay proportional to allocation
+	threshold = allocated * 2;
+	if (threshold < HEAP_INITIAL_THRESHOLD) {
+		threshold = HEAP_INITIAL_THRESHOLD;
+	}
+}
+
+/**
+ * Adds a new object to the list of all objects.
+ * @param obj Object to add.
+ * @param kind Kind of the object.
+ * @param size Number of bytes held by the object.
+ */
+void Heap::track(Object *obj, ObjectKind kind, size_t size) {
+	obj->kind = kind;
+	obj->marked = false;
+	obj->next = objects;
+	objects = obj;
+	allocated += size;
+	totalObjects++;
+	totalBytes += size;
+}
+
+/**
+ * Frees an object.
+ * @param obj Object to free.
+ */
+void Heap::release(Object *obj) {
+	switch (obj->kind) {
+	case OBJ_STR:
+		static_cast<StrObject *>(obj)->~StrObject();
+		free(obj);
+		break;
+	case OBJ_ARRAY:
+		delete static_cast<ArrayObject *>(obj);
+		break;
+	}
+}
+
+/**
+ * Returns the number of bytes held by an object.
+ * @param obj Object to measure.
+ * @returns Size of the object and the memory it owns.
+ */
+size_t Heap::getSize(const Object *obj) const {
+	switch (obj->kind) {
+	case OBJ_STR:
+		return sizeof(StrObject) + static_cast<const StrObject *>(obj)->length + 1;
+	default:
+		return sizeof(ArrayObject) + static_cast<const ArrayObject *>(obj)->items.capacity() * sizeof(Value);
+	}
+}
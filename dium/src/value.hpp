@@ -0,0 +1,312 @@
+/**
+ * @file       value.hpp
+ * @brief      Data type definitions for runtime values and the garbage-collected heap
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef VALUE_HPP
+#define VALUE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "ast.hpp"
+#include "output.hpp"
+
+/** Heap size that triggers the first collection */
+#define HEAP_INITIAL_THRESHOLD (1024 * 1024)
+
+/** Kinds of heap objects */
+enum ObjectKind : uint8_t {
+	OBJ_STR,
+	OBJ_ARRAY
+};
+
+/** Fields shared by all heap objects */
+struct Object {
+	ObjectKind kind;
+
+	/** Set while collecting when the object is reachable */
+	bool marked;
+
+	/** Next object in the list of all objects */
+	Object *next;
+};
+
+/**
+ * Value held in a register, an array or a constant. Values carry no type: the type
+ * checker knows the type of every register, so the instructions reading a value know
+ * which field to use. `bool` and `char` values are stored in `num`.
+ */
+union Value {
+	int64_t num;
+	double dec;
+	Object *obj;
+};
+
+static_assert(sizeof(Value) == 8, "Values must stay 8 bytes");
+
+/** Immutable string, with its characters following the header */
+struct StrObject : Object {
+	/** Number of characters (not counting the terminating '\0') */
+	uint32_t length;
+
+	/** Set for the strings of literals, which exist once for each distinct text */
+	bool interned;
+
+	/**
+	 * Returns the characters of the string.
+	 * @returns First character, followed by a '\0'.
+	 */
+	char *chars() {
+		return reinterpret_cast<char *>(this + 1);
+	}
+
+	const char *chars() const {
+		return reinterpret_cast<const char *>(this + 1);
+	}
+};
+
+/*
+ * Strings of up to `SMALL_STR_MAX` characters live in the value itself instead of on
+ * the heap. Object pointers are never odd, so the lowest byte of a small string holds
+ * 1 + 2 * length, followed by the characters and '\0' padding. Every string that short
+ * is stored this way, so a small string is never equal to a string on the heap.
+ */
+constexpr size_t SMALL_STR_MAX = 6;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Small strings need the lowest byte of a pointer to come first"
+#endif
+
+/** Characters of a string, wherever they are stored */
+struct StrView {
+	/** First character, followed by a '\0' */
+	const char *chars;
+
+	uint32_t length;
+};
+
+/** Fixed-size array with reference semantics */
+struct ArrayObject : Object {
+	/** Type of the items, which the collector and printing need */
+	Type itemType;
+
+	std::vector<Value> items;
+};
+
+// --------------- value helpers -------------------------------
+
+/** Creates a `num` value (also used for `bool` and `char`) */
+inline Value makeNum(int64_t num) {
+	Value value;
+	value.num = num;
+	return value;
+}
+
+/** Creates a `dec` value */
+inline Value makeDec(double dec) {
+	Value value;
+	value.dec = dec;
+	return value;
+}
+
+/** Creates a value referring to a heap object */
+inline Value makeObject(Object *obj) {
+	Value value;
+	value.obj = obj;
+	return value;
+}
+
+/** Checks whether a `string` value holds a small string rather than an object */
+inline bool isSmallStr(Value value) {
+	return (value.num & 1) != 0;
+}
+
+/** Creates a `string` value holding at most `SMALL_STR_MAX` characters */
+inline Value makeSmallStr(const char *text, size_t length) {
+	Value value;
+	value.num = 0;
+
+	auto *bytes = reinterpret_cast<unsigned char *>(&value);
+	bytes[0] = static_cast<unsigned char>(1 + 2 * length);
+	memcpy(bytes + 1, text, length);
+	return value;
+}
+
+/** Returns the string object held by a `string` value that is not a small string */
+inline StrObject *asStr(Value value) {
+	return static_cast<StrObject *>(value.obj);
+}
+
+/**
+ * Returns the characters of a `string` value. Those of a small string are stored in
+ * the value, so the view is only valid as long as `value` is.
+ */
+inline StrView getStr(const Value &value) {
+	if (isSmallStr(value)) {
+		const auto *bytes = reinterpret_cast<const unsigned char *>(&value);
+		return StrView{ reinterpret_cast<const char *>(bytes + 1), static_cast<uint32_t>(bytes[0] >> 1) };
+	}
+	return StrView{ asStr(value)->chars(), asStr(value)->length };
+}
+
+/** Returns the array held by an array value */
+inline ArrayObject *asArray(Value value) {
+	return static_cast<ArrayObject *>(value.obj);
+}
+
+/**
+ * Appends the printed form of a value to a string.
+ * @param out String to append to.
+ * @param value Value to print.
+ * @param type Type of the value.
+ */
+void appendValue(std::string *out, Value value, Type type);
+
+/**
+ * Writes the printed form of a value straight to an output stream.
+ * @param out Stream to write to.
+ * @param value Value to print.
+ * @param type Type of the value.
+ */
+void printValue(Output &out, Value value, Type type);
+
+/**
+ * Checks whether two strings have the same characters.
+ * @param a First string.
+ * @param b Second string.
+ * @returns `true` if they are equal.
+ */
+bool equalStrings(const Value &a, const Value &b);
+
+/**
+ * Orders two strings by their characters.
+ * @param a First string.
+ * @param b Second string.
+ * @returns Negative if `a` comes first, positive if `b` does, 0 if they are equal.
+ */
+int compareStrings(const Value &a, const Value &b);
+
+// --------------- heap ----------------------------------------
+
+/**
+ * Owner of all heap objects. Objects are freed by a mark-and-sweep collection, for
+ * which the caller marks the roots before sweeping.
+ */
+class Heap {
+public:
+	Heap() = default;
+
+	/**
+	 * Frees all objects.
+	 */
+	~Heap();
+
+	Heap(const Heap &) = delete;
+	Heap &operator=(const Heap &) = delete;
+
+	/**
+	 * Allocates a string object. Strings of up to `SMALL_STR_MAX` characters are made
+	 * with `makeSmallStr` instead.
+	 * @param text Characters of the string.
+	 * @param length Number of characters.
+	 * @returns New string.
+	 */
+	StrObject *newString(const char *text, size_t length);
+
+	/**
+	 * Allocates an array.
+	 * @param itemType Type of the items.
+	 * @param items First item of the array.
+	 * @param count Number of items.
+	 * @returns New array.
+	 */
+	ArrayObject *newArray(Type itemType, const Value *items, size_t count);
+
+	/**
+	 * Checks if enough has been allocated since the last collection to collect again.
+	 * @returns `true` if a collection is due, `false` otherwise.
+	 */
+	bool shouldCollect() const {
+		return allocated >= threshold;
+	}
+
+	/**
+	 * Marks an object as reachable. Whatever it refers to is marked by `trace`.
+	 * @param obj Object to mark, or the bits of a small string, which are skipped.
+	 */
+	void mark(Object *obj) {
+		if (isSmallStr(makeObject(obj))) {
+			return;
+		}
+		if (!obj->marked) {
+			obj->marked = true;
+			grey.push_back(obj);
+		}
+	}
+
+	/**
+	 * Marks everything reachable from the objects marked so far.
+	 */
+	void trace();
+
+	/**
+	 * Frees every object that has not been marked since the last sweep.
+	 */
+	void sweep();
+
+	/**
+	 * Returns the number of bytes held by objects.
+	 * @returns Bytes currently allocated.
+	 */
+	size_t getBytesAllocated() const {
+		return allocated;
+	}
+
+	/**
+	 * Returns the number of objects allocated, including those already freed.
+	 * @returns Number of objects ever allocated.
+	 */
+	uint64_t getTotalObjects() const {
+		return totalObjects;
+	}
+
+	/**
+	 * Returns the number of bytes allocated, including those already freed.
+	 * @returns Bytes ever allocated.
+	 */
+	uint64_t getTotalBytes() const {
+		return totalBytes;
+	}
+
+private:
+	/** List of all objects */
+	Object *objects = nullptr;
+
+	/** Number of bytes held by objects */
+	size_t allocated = 0;
+
+	/** Number of objects ever allocated */
+	uint64_t totalObjects = 0;
+
+	/** Number of bytes ever allocated */
+	uint64_t totalBytes = 0;
+
+	/** Number of bytes that triggers the next collection */
+	size_t threshold = HEAP_INITIAL_THRESHOLD;
+
+	/** Objects that have been marked but whose references have not */
+	std::vector<Object *> grey;
+
+	void track(Object *obj, ObjectKind kind, size_t size);
+	void release(Object *obj);
+	size_t getSize(const Object *obj) const;
+};
+
+#endif // VALUE_HPP
@@ -0,0 +1,699 @@
+/**
+ * @file       vm.cpp
+ * @brief      Implementation of the register-based virtual machine
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#include <algorithm>
+#include <charconv>
+#include <cinttypes>
+#include <cmath>
+#include <iterator>
+#include "error.hpp"
+#include "stats.hpp"
+#include "vm.hpp"
+
+/*
+ * GCC and Clang can jump straight from one handler to the next through a table of
+ * label addresses, which gives every handler its own indirect branch to predict.
+ * Other compilers fall back to a `switch` in a loop. Define DIUM_NO_COMPUTED_GOTO to
+ * force the `switch` for comparison.
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(DIUM_NO_COMPUTED_GOTO)
+	#define DIUM_COMPUTED_GOTO 1
+#else
+	#define DIUM_COMPUTED_GOTO 0
+#endif
+
+#if DIUM_COMPUTED_GOTO
+	#define VM_FETCH()       do { instr = *pc++; if (Counted) { VM_COUNT(); } } while (0)
+	#define VM_NEXT()        do { VM_FETCH(); goto *labels[instr.op]; } while (0)
+	#define VM_CASE(name)    op_##name:
+#else
+	#define VM_FETCH()       do { instr = *pc++; if (Counted) { VM_COUNT(); } } while (0)
+	#define VM_NEXT()        continue
+	#define VM_CASE(name)    case OP_##name:
+#endif
+
+/* Saves the instruction pointer so that errors and collections can see it */
+#define VM_SYNC()            (frames.back().pc = pc)
+
+/* Counts the instruction just fetched, and samples the call stack when it is due */
+#define VM_COUNT() \
+	count++; \
+	opcodeCounts[instr.op]++; \
+	if (count == nextSample) { \
+		VM_SYNC(); \
+		nextSample = count + takeSample(); \
+	}
+
+/* Reports a runtime error at the current instruction */
+#define VM_ERROR(...)        do { VM_SYNC(); error(__VA_ARGS__); } while (0)
+
+/*
+ * Hands the current frame to its machine code at an instruction and continues
+ * interpreting wherever the machine code stops. Not wrapped in `do ... while (0)`,
+ * since `VM_NEXT` may be a `continue`.
+ */
+#define VM_ENTER_JIT(jitCode, idx) \
+	pc = code + (jitCode)->enter(R, idx); \
+	VM_NEXT()
+
+/* Applies an operator to two numbers, which wrap around instead of overflowing */
+#define VM_WRAP(op)          makeNum(static_cast<int64_t>(static_cast<uint64_t>(R[instr.b].num) op static_cast<uint64_t>(R[instr.c].num)))
+
+/* Compares two registers by one member of their values */
+#define VM_COMPARE(field, op) makeNum(R[instr.b].field op R[instr.c].field)
+
+
+VM::VM(const Module &module, JitMode jitMode)
+	: module{ module }, stack(VM_STACK_SIZE), out{ getStdout() }, jitMode{ Jit::isSupported() ? jitMode : JIT_OFF },
+	jitStates(module.funcs.size(), JitState{ 0, 0, nullptr }) {
+	frames.reserve(VM_MAX_CALL_DEPTH);
+	constants.reserve(module.constants.size());
+
+	for (const Constant &constant : module.constants) {
+		switch (constant.kind) {
+		case CONST_NUM:
+			constants.push_back(makeNum(constant.num));
+			break;
+		case CONST_DEC:
+			constants.push_back(makeDec(constant.dec));
+			break;
+		case CONST_STR:
+			// Each distinct literal is one constant, so its object can be compared by address
+			if (constant.text.size() <= SMALL_STR_MAX) {
+				constants.push_back(makeSmallStr(constant.text.data(), constant.text.size()));
+			} else {
+				StrObject *str = heap.newString(constant.text.data(), constant.text.size());
+				str->interned = true;
+				constants.push_back(makeObject(str));
+			}
+			break;
+		}
+	}
+}
+
+int VM::run(bool counted) {
+	const Function *entry = &module.funcs[module.entry];
+	frames.clear();
+	frames.push_back({ entry, entry->code.data(), stack.data() });
+
+	if (jitMode == JIT_EAGER) {
+		for (const Function &func : module.funcs) {
+			compileFunc(&func);
+		}
+	}
+
+	if (counted) {
+		std::fill(std::begin(opcodeCounts), std::end(opcodeCounts), 0);
+	}
+	return (counted || profiler != nullptr) ? execute<true>() : execute<false>();
+}
+
+const char *VM::getDispatchName() {
+	return DIUM_COMPUTED_GOTO ? "computed goto" : "switch";
+}
+
+/**
+ * Runs instructions until the program returns from `main` or exits.
+ * @tparam Counted `true` to count the executed instructions.
+ * @returns Exit code of the program.
+ */
+template <bool Counted>
+int VM::execute() {
+#if DIUM_COMPUTED_GOTO
+	static const void *const labels[] = {
+#define DIUM_OPCODE_LABEL(name, format) &&op_##name,
+		DIUM_OPCODES(DIUM_OPCODE_LABEL)
+#undef DIUM_OPCODE_LABEL
+	};
+#endif
+
+	const Value *stackEnd = stack.data() + stack.size();
+	const Instr *code = frames.back().func->code.data();
+	const Instr *pc = frames.back().pc;
+	Value *R = frames.back().base;
+	Instr instr;
+	uint64_t count = 0;
+	uint64_t nextSample = (Counted && profiler != nullptr) ? profiler->nextInterval() : UINT64_MAX;
+
+#if DIUM_COMPUTED_GOTO
+	VM_NEXT();
+#else
+	for (;;) {
+	VM_FETCH();
+	switch (instr.op) {
+#endif
+
+	VM_CASE(MOVE) {
+		R[instr.a] = R[instr.b];
+		VM_NEXT();
+	}
+	VM_CASE(LOADI) {
+		R[instr.a] = makeNum(static_cast<int32_t>(getWide(instr)));
+		VM_NEXT();
+	}
+	VM_CASE(LOADK) {
+		R[instr.a] = constants[getWide(instr)];
+		VM_NEXT();
+	}
+	VM_CASE(NEWARRAY) {
+		VM_SYNC();
+		if (heap.shouldCollect()) {
+			collect();
+		}
+		R[instr.a] = makeObject(heap.newArray(unpackType(instr.type), R + instr.b, instr.c));
+		VM_NEXT();
+	}
+	VM_CASE(GETINDEX) {
+		const std::vector<Value> &items = asArray(R[instr.b])->items;
+		int64_t idx = R[instr.c].num;
+
+		if (static_cast<uint64_t>(idx) >= items.size()) {
+			VM_ERROR("Index %" PRId64 " is out of bounds for an array of length %zu", idx, items.size());
+		}
+		R[instr.a] = items[static_cast<size_t>(idx)];
+		VM_NEXT();
+	}
+	VM_CASE(GETCHAR) {
+		StrView str = getStr(R[instr.b]);
+		int64_t idx = R[instr.c].num;
+
+		if (static_cast<uint64_t>(idx) >= str.length) {
+			VM_ERROR("Index %" PRId64 " is out of bounds for a string of length %u", idx, str.length);
+		}
+		R[instr.a] = makeNum(static_cast<unsigned char>(str.chars[idx]));
+		VM_NEXT();
+	}
+	VM_CASE(SETINDEX) {
+		std::vector<Value> &items = asArray(R[instr.a])->items;
+		int64_t idx = R[instr.b].num;
+
+		if (static_cast<uint64_t>(idx) >= items.size()) {
+			VM_ERROR("Index %" PRId64 " is out of bounds for an array of length %zu", idx, items.size());
+		}
+		items[static_cast<size_t>(idx)] = R[instr.c];
+		VM_NEXT();
+	}
+	VM_CASE(ADD_NUM) {
+		R[instr.a] = VM_WRAP(+);
+		VM_NEXT();
+	}
+	VM_CASE(SUB_NUM) {
+		R[instr.a] = VM_WRAP(-);
+		VM_NEXT();
+	}
+	VM_CASE(MUL_NUM) {
+		R[instr.a] = VM_WRAP(*);
+		VM_NEXT();
+	}
+	VM_CASE(DIV_NUM) {
+		// Division by zero and overflow are left to the slow path
+		if (R[instr.c].num > 0) {
+			R[instr.a] = makeNum(R[instr.b].num / R[instr.c].num);
+		} else {
+			VM_SYNC();
+			R[instr.a] = divide(OP_DIV_NUM, R[instr.b].num, R[instr.c].num);
+		}
+		VM_NEXT();
+	}
+	VM_CASE(MOD_NUM) {
+		if (R[instr.c].num > 0) {
+			R[instr.a] = makeNum(R[instr.b].num % R[instr.c].num);
+		} else {
+			VM_SYNC();
+			R[instr.a] = divide(OP_MOD_NUM, R[instr.b].num, R[instr.c].num);
+		}
+		VM_NEXT();
+	}
+	VM_CASE(NEG_NUM) {
+		R[instr.a] = makeNum(static_cast<int64_t>(0 - static_cast<uint64_t>(R[instr.b].num)));
+		VM_NEXT();
+	}
+	VM_CASE(DIVP2_NUM) {
+		// Negative dividends are biased by 2^C - 1 so that the shift rounds towards zero
+		int64_t num = R[instr.b].num;
+		int64_t bias = static_cast<int64_t>(static_cast<uint64_t>(num >> 63) >> (64 - instr.c));
+		R[instr.a] = makeNum((num + bias) >> instr.c);
+		VM_NEXT();
+	}
+	VM_CASE(MODP2_NUM) {
+		int64_t num = R[instr.b].num;
+		int64_t bias = static_cast<int64_t>(static_cast<uint64_t>(num >> 63) >> (64 - instr.c));
+		R[instr.a] = makeNum(((num + bias) & ((int64_t{ 1 } << instr.c) - 1)) - bias);
+		VM_NEXT();
+	}
+	VM_CASE(ADD_DEC) {
+		R[instr.a] = makeDec(R[instr.b].dec + R[instr.c].dec);
+		VM_NEXT();
+	}
+	VM_CASE(SUB_DEC) {
+		R[instr.a] = makeDec(R[instr.b].dec - R[instr.c].dec);
+		VM_NEXT();
+	}
+	VM_CASE(MUL_DEC) {
+		R[instr.a] = makeDec(R[instr.b].dec * R[instr.c].dec);
+		VM_NEXT();
+	}
+	VM_CASE(DIV_DEC) {
+		R[instr.a] = makeDec(R[instr.b].dec / R[instr.c].dec);
+		VM_NEXT();
+	}
+	VM_CASE(MOD_DEC) {
+		R[instr.a] = makeDec(std::fmod(R[instr.b].dec, R[instr.c].dec));
+		VM_NEXT();
+	}
+	VM_CASE(NEG_DEC) {
+		R[instr.a] = makeDec(-R[instr.b].dec);
+		VM_NEXT();
+	}
+	VM_CASE(CONCAT) {
+		// The whole chain is built in one buffer and allocated once
+		output.clear();
+		for (uint16_t idx = 0; idx < instr.c; idx++) {
+			StrView str = getStr(R[instr.b + idx]);
+			output.append(str.chars, str.length);
+		}
+		VM_SYNC();
+		R[instr.a] = newString(output);
+		VM_NEXT();
+	}
+	VM_CASE(NOT) {
+		R[instr.a] = makeNum(!R[instr.b].num);
+		VM_NEXT();
+	}
+	VM_CASE(EQ_NUM) {
+		R[instr.a] = VM_COMPARE(num, ==);
+		VM_NEXT();
+	}
+	VM_CASE(NE_NUM) {
+		R[instr.a] = VM_COMPARE(num, !=);
+		VM_NEXT();
+	}
+	VM_CASE(LT_NUM) {
+		R[instr.a] = VM_COMPARE(num, <);
+		VM_NEXT();
+	}
+	VM_CASE(LE_NUM) {
+		R[instr.a] = VM_COMPARE(num, <=);
+		VM_NEXT();
+	}
+	VM_CASE(EQ_DEC) {
+		R[instr.a] = VM_COMPARE(dec, ==);
+		VM_NEXT();
+	}
+	VM_CASE(NE_DEC) {
+		R[instr.a] = VM_COMPARE(dec, !=);
+		VM_NEXT();
+	}
+	VM_CASE(LT_DEC) {
+		R[instr.a] = VM_COMPARE(dec, <);
+		VM_NEXT();
+	}
+	VM_CASE(LE_DEC) {
+		R[instr.a] = VM_COMPARE(dec, <=);
+		VM_NEXT();
+	}
+	VM_CASE(EQ_STR) {
+		R[instr.a] = makeNum(equalStrings(R[instr.b], R[instr.c]));
+		VM_NEXT();
+	}
+	VM_CASE(NE_STR) {
+		R[instr.a] = makeNum(!equalStrings(R[instr.b], R[instr.c]));
+		VM_NEXT();
+	}
+	VM_CASE(LT_STR) {
+		R[instr.a] = makeNum(compareStrings(R[instr.b], R[instr.c]) < 0);
+		VM_NEXT();
+	}
+	VM_CASE(LE_STR) {
+		R[instr.a] = makeNum(compareStrings(R[instr.b], R[instr.c]) <= 0);
+		VM_NEXT();
+	}
+	VM_CASE(EQ_REF) {
+		R[instr.a] = VM_COMPARE(obj, ==);
+		VM_NEXT();
+	}
+	VM_CASE(NE_REF) {
+		R[instr.a] = VM_COMPARE(obj, !=);
+		VM_NEXT();
+	}
+	VM_CASE(NUM2DEC) {
+		R[instr.a] = makeDec(static_cast<double>(R[instr.b].num));
+		VM_NEXT();
+	}
+	VM_CASE(DEC2NUM) {
+		double dec = R[instr.b].dec;
+
+		if (!(dec > -9223372036854775808.0 && dec < 9223372036854775808.0)) {
+			VM_ERROR("Cannot convert %g to num", dec);
+		}
+		R[instr.a] = makeNum(static_cast<int64_t>(dec));
+		VM_NEXT();
+	}
+	VM_CASE(NUM2CHAR) {
+		int64_t num = R[instr.b].num;
+
+		if (num < 0 || num > 255) {
+			VM_ERROR("Cannot convert %" PRId64 " to char", num);
+		}
+		R[instr.a] = makeNum(num);
+		VM_NEXT();
+	}
+	VM_CASE(NUM2BOOL) {
+		R[instr.a] = makeNum(R[instr.b].num != 0);
+		VM_NEXT();
+	}
+	VM_CASE(STR2NUM) {
+		VM_SYNC();
+		R[instr.a] = parseNum(getStr(R[instr.b]));
+		VM_NEXT();
+	}
+	VM_CASE(STR2DEC) {
+		VM_SYNC();
+		R[instr.a] = parseDec(getStr(R[instr.b]));
+		VM_NEXT();
+	}
+	VM_CASE(STR2CHAR) {
+		StrView str = getStr(R[instr.b]);
+
+		if (str.length != 1) {
+			VM_ERROR("Cannot convert a string of length %u to char", str.length);
+		}
+		R[instr.a] = makeNum(static_cast<unsigned char>(str.chars[0]));
+		VM_NEXT();
+	}
+	VM_CASE(TOSTR) {
+		output.clear();
+		appendValue(&output, R[instr.b], unpackType(instr.type));
+		VM_SYNC();
+		R[instr.a] = newString(output);
+		VM_NEXT();
+	}
+	VM_CASE(JMP) {
+		const Instr *target = code + getWide(instr);
+
+		// Backward jumps close loops, which are where hot functions spend their time
+		if (jitMode != JIT_OFF && target < pc) {
+			const Function *func = frames.back().func;
+			JitState &state = jitStates[func - module.funcs.data()];
+
+			if (state.code != nullptr || (++state.loops >= JIT_LOOP_THRESHOLD && compileFunc(func) != nullptr)) {
+				VM_ENTER_JIT(state.code, getWide(instr));
+			}
+		}
+
+		pc = target;
+		VM_NEXT();
+	}
+	VM_CASE(JMPF) {
+		if (!R[instr.a].num) {
+			pc = code + getWide(instr);
+		}
+		VM_NEXT();
+	}
+	VM_CASE(JMPT) {
+		if (R[instr.a].num) {
+			pc = code + getWide(instr);
+		}
+		VM_NEXT();
+	}
+	VM_CASE(RANGE) {
+		int64_t start = R[instr.b].num;
+		int64_t stop = R[instr.b + 1].num;
+		int64_t step = R[instr.b + 2].num;
+
+		if (step == 0) {
+			VM_ERROR("The step of 'range' cannot be 0");
+		}
+
+		// Distances are unsigned so that ranges spanning all of num cannot overflow
+		uint64_t count = 0;
+		if (step > 0 && start < stop) {
+			count = (static_cast<uint64_t>(stop) - static_cast<uint64_t>(start) - 1) / static_cast<uint64_t>(step) + 1;
+		} else if (step < 0 && start > stop) {
+			count = (static_cast<uint64_t>(start) - static_cast<uint64_t>(stop) - 1) / (0 - static_cast<uint64_t>(step)) + 1;
+		}
+
+		R[instr.a] = makeNum(static_cast<int64_t>(count));
+		R[instr.a + 1] = makeNum(start);
+		R[instr.a + 2] = makeNum(step);
+		VM_NEXT();
+	}
+	VM_CASE(FORITER) {
+		Value *loop = R + instr.a;
+
+		if (loop[0].num == 0) {
+			pc = code + getWide(instr);
+			VM_NEXT();
+		}
+
+		// The value after the last one may wrap around, but is never used
+		loop[0].num = static_cast<int64_t>(static_cast<uint64_t>(loop[0].num) - 1);
+		loop[3] = loop[1];
+		loop[1].num = static_cast<int64_t>(static_cast<uint64_t>(loop[1].num) + static_cast<uint64_t>(loop[2].num));
+		VM_NEXT();
+	}
+	VM_CASE(CALL) {
+		const Function *callee = &module.funcs[instr.b];
+		Value *base = R + instr.a;
+
+		if (base + callee->frameSize > stackEnd || frames.size() == VM_MAX_CALL_DEPTH) {
+			VM_ERROR("Stack overflow when calling '%s'", callee->name.c_str());
+		}
+
+		VM_SYNC();
+		frames.push_back({ callee, nullptr, base });
+		code = callee->code.data();
+		pc = code;
+		R = base;
+
+		if (jitMode != JIT_OFF) {
+			JitState &state = jitStates[instr.b];
+
+			if (state.code != nullptr || (++state.calls >= JIT_CALL_THRESHOLD && compileFunc(callee) != nullptr)) {
+				VM_ENTER_JIT(state.code, 0);
+			}
+		}
+		VM_NEXT();
+	}
+	VM_CASE(RET) {
+		Value result = R[instr.a];
+		frames.pop_back();
+
+		if (frames.empty()) {
+			instructions = count;
+			return 0;
+		}
+
+		const Frame &caller = frames.back();
+		code = caller.func->code.data();
+		pc = caller.pc;
+		R = caller.base;
+		R[pc[-1].a] = result;
+
+		const JitCode *callerCode = jitStates[caller.func - module.funcs.data()].code;
+		if (callerCode != nullptr) {
+			VM_ENTER_JIT(callerCode, static_cast<uint32_t>(pc - code));
+		}
+		VM_NEXT();
+	}
+	VM_CASE(RET0) {
+		frames.pop_back();
+
+		if (frames.empty()) {
+			instructions = count;
+			return 0;
+		}
+
+		const Frame &caller = frames.back();
+		code = caller.func->code.data();
+		pc = caller.pc;
+		R = caller.base;
+
+		const JitCode *callerCode = jitStates[caller.func - module.funcs.data()].code;
+		if (callerCode != nullptr) {
+			VM_ENTER_JIT(callerCode, static_cast<uint32_t>(pc - code));
+		}
+		VM_NEXT();
+	}
+	VM_CASE(PRINT) {
+		printValue(out, R[instr.a], unpackType(instr.type));
+		VM_NEXT();
+	}
+	VM_CASE(PRINTLN) {
+		printValue(out, R[instr.a], unpackType(instr.type));
+		out.put('\n');
+		VM_NEXT();
+	}
+	VM_CASE(NEWLINE) {
+		out.put('\n');
+		VM_NEXT();
+	}
+	VM_CASE(EXIT) {
+		instructions = count;
+		return static_cast<int>(R[instr.a].num);
+	}
+
+#if !DIUM_COMPUTED_GOTO
+	default:
+		VM_ERROR("Unknown opcode %d", instr.op);
+	}
+	}
+#endif
+}
+
+// --------------- slow paths ----------------------------------
+
+/**
+ * Compiles a function to machine code, unless it already is.
+ * @param func Function to compile.
+ * @returns Machine code, or `nullptr` if it could not be made.
+ */
+const JitCode *VM::compileFunc(const Function *func) {
+	JitState &state = jitStates[func - module.funcs.data()];
+
+	if (state.code == nullptr) {
+		state.code = jit.compile(*func, constants);
+
+		// Do not try again on every call
+		if (state.code == nullptr) {
+			state.calls = 0;
+			state.loops = 0;
+		}
+	}
+
+	return state.code;
+}
+
+/**
+ * Divides two numbers when the divisor is not positive.
+ * @param op `OP_DIV_NUM` or `OP_MOD_NUM`.
+ * @param lhs Dividend.
+ * @param rhs Divisor.
+ * @returns Quotient or remainder.
+ */
+Value VM::divide(Opcode op, int64_t lhs, int64_t rhs) {
+	if (rhs == 0) {
+		error("Division by zero");
+	}
+
+	// INT64_MIN / -1 does not fit, so it wraps around like the other operators
+	if (rhs == -1) {
+		int64_t negated = static_cast<int64_t>(0 - static_cast<uint64_t>(lhs));
+		return makeNum((op == OP_DIV_NUM) ? negated : 0);
+	}
+
+	return makeNum((op == OP_DIV_NUM) ? lhs / rhs : lhs % rhs);
+}
+
+/**
+ * Parses a whole string as a number, e.g. `num("42")`.
+ * @param str String to parse.
+ * @returns Parsed number.
+ */
+Value VM::parseNum(StrView str) {
+	int64_t num = 0;
+	auto result = std::from_chars(str.chars, str.chars + str.length, num);
+
+	if (result.ec != std::errc() || result.ptr != str.chars + str.length) {
+		error("Cannot convert \"%s\" to num", str.chars);
+	}
+	return makeNum(num);
+}
+
+/**
+ * Parses a whole string as a decimal, e.g. `dec("1.5")`.
+ * @param str String to parse.
+ * @returns Parsed decimal.
+ */
+Value VM::parseDec(StrView str) {
+	double dec = 0;
+	auto result = std::from_chars(str.chars, str.chars + str.length, dec);
+
+	if (result.ec != std::errc() || result.ptr != str.chars + str.length) {
+		error("Cannot convert \"%s\" to dec", str.chars);
+	}
+	return makeDec(dec);
+}
+
+/**
+ * Creates a string, collecting garbage first when one is due and the string does not
+ * fit in a value.
+ * @param text Characters of the string.
+ * @returns New string.
+ */
+Value VM::newString(const std::string &text) {
+	if (text.size() <= SMALL_STR_MAX) {
+		return makeSmallStr(text.data(), text.size());
+	}
+
+	if (heap.shouldCollect()) {
+		collect();
+	}
+	return makeObject(heap.newString(text.data(), text.size()));
+}
+
+/**
+ * Frees every object that cannot be reached from the active frames or the constants.
+ * Every frame is stopped at a safepoint (the innermost one at an allocation, the others
+ * at calls), whose stack map lists the registers holding references.
+ */
+void VM::collect() {
+	for (const Frame &frame : frames) {
+		const Function *func = frame.func;
+		uint32_t idx = static_cast<uint32_t>(frame.pc - func->code.data() - 1);
+
+		auto safepoint = std::lower_bound(func->safepoints.begin(), func->safepoints.end(), idx);
+		size_t point = static_cast<size_t>(safepoint - func->safepoints.begin());
+
+		for (uint32_t ref = func->refStarts[point]; ref < func->refStarts[point + 1]; ref++) {
+			heap.mark(frame.base[func->refRegs[ref]].obj);
+		}
+	}
+
+	for (size_t idx = 0; idx < constants.size(); idx++) {
+		if (module.constants[idx].kind == CONST_STR) {
+			heap.mark(constants[idx].obj);
+		}
+	}
+
+	heap.trace();
+	heap.sweep();
+}
+
+/**
+ * Reports a runtime error at the current instruction of the innermost frame.
+ * @param fmt Formatted string.
+ * @param ... Variable arguments.
+ */
+/**
+ * Hands the call stack to the profiler.
+ * @returns Number of instructions until the next sample.
+ */
+uint32_t VM::takeSample() {
+	sample.clear();
+	for (const Frame &frame : frames) {
+		// Every saved instruction pointer is one past the instruction being run
+		const Instr *code = frame.func->code.data();
+		sample.push_back({ frame.func, static_cast<size_t>(frame.pc - code) - 1 });
+	}
+
+	profiler->record(sample);
+	return profiler->nextInterval();
+}
+
+void VM::error(const char *fmt, ...) {
+	const Frame &frame = frames.back();
+	size_t idx = static_cast<size_t>(frame.pc - frame.func->code.data()) - 1;
+
+	out.flush();
+	countRun(*this);
+
+	va_list args;
+	va_start(args, fmt);
+	printErrAtV(module.name.c_str(), &frame.func->positions[idx], fmt, args);
+}
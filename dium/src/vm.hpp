@@ -0,0 +1,184 @@
+/**
+ * @file       vm.hpp
+ * @brief      Definitions for the register-based virtual machine
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ */
+
+#pragma once
+
+#ifndef VM_HPP
+#define VM_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ast.hpp"
+#include "bytecode.hpp"
+#include "format.hpp"
+#include "jit.hpp"
+#include "profiler.hpp"
+#include "value.hpp"
+
+/** Number of registers shared by all call frames */
+#define VM_STACK_SIZE (1024 * 1024)
+
+/** Maximum number of nested calls */
+#define VM_MAX_CALL_DEPTH (64 * 1024)
+
+/**
+ * Runs a compiled module. Each call frame is a window of registers on a shared stack,
+ * starting at the arguments the caller placed at the top of its own frame.
+ *
+ * Functions start out interpreted. With the JIT on, a function that is called or
+ * loops often enough is compiled to machine code, which is entered whenever the
+ * function is called, jumps backwards or is returned to, and which hands control back
+ * to the interpreter for the instructions it does not handle.
+ */
+class VM {
+public:
+	/**
+	 * Creates a virtual machine for a module.
+	 * @param module Module to run, which must outlive the virtual machine.
+	 * @param jitMode When to compile functions to machine code.
+	 */
+	explicit VM(const Module &module, JitMode jitMode = JIT_OFF);
+
+	/**
+	 * Runs `main` until it returns or the program exits.
+	 * @param counted `true` to count the executed instructions (see `getInstructionCount`),
+	 * which is implied by a profiler.
+	 * @returns Exit code of the program.
+	 */
+	int run(bool counted = false);
+
+	/**
+	 * Returns the number of instructions executed by the last counted run.
+	 * @returns Number of instructions.
+	 */
+	uint64_t getInstructionCount() const {
+		return instructions;
+	}
+
+	/**
+	 * Returns the number of instructions of an opcode executed by the last counted run.
+	 * @param op Opcode to count.
+	 * @returns Number of instructions.
+	 */
+	uint64_t getOpcodeCount(Opcode op) const {
+		return opcodeCounts[op];
+	}
+
+	/**
+	 * Samples the call stack of the interpreted instructions of later runs.
+	 * @param profiler Profiler to record the samples, already started on the module.
+	 */
+	void setProfiler(Profiler *profiler) {
+		this->profiler = profiler;
+	}
+
+	/**
+	 * Returns the heap of the program, to see how much it allocated.
+	 * @returns Owner of all strings and arrays.
+	 */
+	const Heap &getHeap() const {
+		return heap;
+	}
+
+	/**
+	 * Returns the number of functions compiled to machine code so far.
+	 * @returns Number of compiled functions.
+	 */
+	size_t getCompiledCount() const {
+		return jit.getCompiledCount();
+	}
+
+	/**
+	 * Returns the way instructions are dispatched in this build.
+	 * @returns "computed goto" or "switch".
+	 */
+	static const char *getDispatchName();
+
+private:
+	/* Call frame */
+	struct Frame {
+		/** Function being run */
+		const Function *func;
+
+		/** Next instruction, only up to date while the frame is not running */
+		const Instr *pc;
+
+		/** First register of the frame */
+		Value *base;
+	};
+
+	/* Progress of a function towards being compiled */
+	struct JitState {
+		/** Number of calls so far */
+		uint32_t calls;
+
+		/** Number of backward jumps so far */
+		uint32_t loops;
+
+		/** Machine code, once compiled */
+		const JitCode *code;
+	};
+
+	/** Module being run */
+	const Module &module;
+
+	/** Owner of all strings and arrays */
+	Heap heap;
+
+	/** Values of the constants of the module */
+	std::vector<Value> constants;
+
+	/** Registers of all call frames */
+	std::vector<Value> stack;
+
+	/** Active calls, innermost last */
+	std::vector<Frame> frames;
+
+	/** Scratch space for building strings */
+	std::string output;
+
+	/** Standard output, written to by `print` and `println` */
+	Output &out;
+
+	/** Number of instructions executed by the last counted run */
+	uint64_t instructions = 0;
+
+	/** Number of instructions of each opcode executed by the last counted run */
+	uint64_t opcodeCounts[OP_COUNT] = {};
+
+	/** Profiler sampling the call stack, if any */
+	Profiler *profiler = nullptr;
+
+	/** Call stack handed to the profiler */
+	std::vector<ProfileFrame> sample;
+
+	/** When functions are compiled to machine code */
+	JitMode jitMode;
+
+	/** Compiler and owner of the machine code */
+	Jit jit;
+
+	/** State of each function of the module */
+	std::vector<JitState> jitStates;
+
+	template <bool Counted>
+	int execute();
+
+	const JitCode *compileFunc(const Function *func);
+	Value divide(Opcode op, int64_t lhs, int64_t rhs);
+	Value parseNum(StrView str);
+	Value parseDec(StrView str);
+	Value newString(const std::string &text);
+	void collect();
+	uint32_t takeSample();
+
+	[[noreturn]] void error(FORMAT_STRING const char *fmt, ...) FORMAT_CHECK(2, 3);
+};
+
+#endif // VM_HPP
@@ -0,0 +1,53 @@
+# Builds a program with `dium build` under a name full of shell syntax, and checks that
+# the executable prints the same as the interpreter and that no part of the name ran.
+#
+#   cmake -DDIUM=<dium> -DPROGRAM=<program.dm> -DOUTPUT_DIR=<dir> -P build.cmake
+#
+# The C compiler is taken from the CC environment variable, as `dium build` does.
+
+cmake_minimum_required(VERSION 3.14)
+
+foreach(variable DIUM PROGRAM OUTPUT_DIR)
+	if(NOT DEFINED ${variable})
+		message(FATAL_ERROR "${variable} is not set")
+	endif()
+endforeach()
+
+# A shell would run `touch injected` from either name
+set(source "it's $(touch injected) `touch injected` a.dm")
+set(executable "x $(touch injected)")
+
+file(REMOVE_RECURSE ${OUTPUT_DIR})
+file(MAKE_DIRECTORY ${OUTPUT_DIR})
+configure_file(${PROGRAM} "${OUTPUT_DIR}/${source}" COPYONLY)
+
+execute_process(COMMAND ${DIUM} "${source}"
+	WORKING_DIRECTORY ${OUTPUT_DIR}
+	OUTPUT_VARIABLE expected
+	RESULT_VARIABLE expectedStatus
+	TIMEOUT 120)
+
+execute_process(COMMAND ${DIUM} build "${source}" -o "${executable}"
+	WORKING_DIRECTORY ${OUTPUT_DIR}
+	RESULT_VARIABLE status
+	TIMEOUT 120)
+
+if(EXISTS ${OUTPUT_DIR}/injected)
+	message(FATAL_ERROR "dium build ran part of a file name as a command")
+endif()
+if(NOT status EQUAL 0)
+	message(FATAL_ERROR "dium build failed: ${status}")
+endif()
+
+execute_process(COMMAND "${OUTPUT_DIR}/${executable}"
+	WORKING_DIRECTORY ${OUTPUT_DIR}
+	OUTPUT_VARIABLE output
+	RESULT_VARIABLE outputStatus
+	TIMEOUT 120)
+
+if(NOT "${output}exit code ${outputStatus}" STREQUAL "${expected}exit code ${expectedStatus}")
+	file(WRITE ${OUTPUT_DIR}/expected.txt "${expected}exit code ${expectedStatus}\n")
+	file(WRITE ${OUTPUT_DIR}/output.txt "${output}exit code ${outputStatus}\n")
+	message(FATAL_ERROR "The executable differs from the interpreter, see ${OUTPUT_DIR}/output.txt")
+endif()
+message(STATUS "'${source}' built to '${executable}'")
@@ -0,0 +1,230 @@
+/**
+ * @file       cache_test.cpp
+ * @brief      Test of the on-disk cache of compiled programs
+ * @copyright  Copyright (c) 2022-present
+ * @author     Kyle Chapman
+ * @date       2026-10-16
+ *
+ * Runs `dium --cache=<dir> --stats` on a copy of a program and checks, from whether
+ * the statistics report a compile phase, that:
+ *   - a warm run prints the same as the cold run that filled the cache, without compiling
+ *   - an edited source misses the cache, and the original hits it again
+ *   - another optimization level misses the cache
+ *   - a build of another compiler version (DMC_COMPILER_VERSION) misses the cache,
+ *     and leaves the files of this one alone
+ *   - truncated, damaged and overlong cache files are rejected and replaced
+ *
+ *   cache_test <dium> <dium of another version> <program.dm> <scratch directory>
+ */
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "cache.hpp"
+
+#ifndef _WIN32
+	#include <sys/wait.h>
+#endif
+
+namespace fs = std::filesystem;
+
+/* What a run of the interpreter printed */
+struct Run {
+	std::string output;
+	int status;
+
+	/** `false` if the program came from the cache */
+	bool compiled;
+};
+
+/* Paths the test works with */
+static std::string scratch;
+static std::string program;
+static std::string cacheDirectory;
+
+static int failures = 0;
+
+/**
+ * Reports a failed check.
+ * @param ok Result of the check.
+ * @param what What was checked.
+ */
+static void check(bool ok, const std::string &what) {
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what.c_str());
+		failures++;
+	}
+}
+
+/**
+ * Reads a whole file.
+ * @param path Path of the file.
+ * @returns Contents of the file, empty if it cannot be read.
+ */
+static std::string readFile(const std::string &path) {
+	std::ifstream file(path, std::ios::binary);
+	std::ostringstream text;
+	text << file.rdbuf();
+	return text.str();
+}
+
+/**
+ * Replaces a whole file.
+ * @param path Path of the file.
+ * @param text New contents.
+ */
+static void writeFile(const std::string &path, const std::string &text) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+/**
+ * Lists the cache files.
+ * @returns Paths of the ".dmc" files in the cache directory.
+ */
+static std::vector<std::string> listCacheFiles() {
+	std::vector<std::string> files;
+	std::error_code error;
+
+	for (const auto &entry : fs::directory_iterator(cacheDirectory, error)) {
+		if (entry.path().extension() == ".dmc") {
+			files.push_back(entry.path().string());
+		}
+	}
+	return files;
+}
+
+/**
+ * Runs the interpreter on the program with the cache.
+ * @param dium Interpreter to run.
+ * @param options Extra options.
+ * @returns What it printed and whether it compiled the program.
+ */
+static Run run(const std::string &dium, const std::string &options) {
+	std::string out = (fs::path(scratch) / "out.txt").string();
+	std::string err = (fs::path(scratch) / "err.txt").string();
+	std::string command = "\"" + dium + "\" --cache=\"" + cacheDirectory + "\" --stats " + options + " \"" + program + "\" > \"" + out
+		+ "\" 2> \"" + err + "\"";
+
+#ifdef _WIN32
+	// cmd.exe drops the first and last quotes of the whole line
+	int status = std::system(("\"" + command + "\"").c_str());
+#else
+	int status = std::system(command.c_str());
+	status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+
+	// The statistics only have a compile phase when the program was compiled
+	return Run{ readFile(out), status, readFile(err).find("\n  compile ") != std::string::npos };
+}
+
+/**
+ * Checks that a run printed the same as the first run and exited the same way.
+ * @param actual Run to check.
+ * @param expected First run.
+ * @param what Name of the run.
+ */
+static void checkSame(const Run &actual, const Run &expected, const std::string &what) {
+	check(actual.output == expected.output, what + ": output differs from the cold run");
+	check(actual.status == expected.status, what + ": exit code differs from the cold run");
+}
+
+int main(int argc, char *argv[]) {
+	if (argc != 5) {
+		fprintf(stderr, "Usage: cache_test <dium> <dium of another version> <program.dm> <scratch directory>\n");
+		return 2;
+	}
+
+	std::string dium = argv[1];
+	std::string other = argv[2];
+	scratch = argv[4];
+	program = (fs::path(scratch) / "program.dm").string();
+	cacheDirectory = (fs::path(scratch) / "cache").string();
+
+	// Edits go to a copy of the program, in a cache of its own
+	std::error_code error;
+	fs::remove_all(scratch, error);
+	fs::create_directories(scratch);
+	std::string source = readFile(argv[3]);
+	if (source.empty()) {
+		fprintf(stderr, "Program '%s' could not be read\n", argv[3]);
+		return 2;
+	}
+	writeFile(program, source);
+
+	Run cold = run(dium, "");
+	check(cold.compiled, "cold run: not compiled");
+	check(!cold.output.empty(), "cold run: printed nothing");
+
+	std::vector<std::string> files = listCacheFiles();
+	check(files.size() == 1, "cold run: no cache file written");
+	if (files.size() != 1) {
+		return 1;
+	}
+	std::string cached = files[0];
+	std::string contents = readFile(cached);
+
+	Run warm = run(dium, "");
+	check(!warm.compiled, "warm run: compiled again");
+	checkSame(warm, cold, "warm run");
+
+	// Any edit misses, even one that does not change what the program does
+	writeFile(program, source + "\n// edited\n");
+	Run edited = run(dium, "");
+	check(edited.compiled, "edited source: hit the cache");
+	checkSame(edited, cold, "edited source");
+	check(listCacheFiles().size() == 2, "edited source: no cache file of its own");
+
+	writeFile(program, source);
+	check(!run(dium, "").compiled, "source edited back: missed the cache");
+
+	// Each optimization level has files of its own
+	Run level = run(dium, "-O0");
+	check(level.compiled, "-O0: hit the cache of -O2");
+	checkSame(level, cold, "-O0");
+	check(!run(dium, "-O0").compiled, "-O0 again: missed the cache");
+	check(!run(dium, "-O2").compiled, "-O2 after -O0: missed the cache");
+
+	// So does each compiler version, and neither replaces the files of the other
+	Run version = run(other, "");
+	check(version.compiled, "other compiler version: hit the cache");
+	checkSame(version, cold, "other compiler version");
+	check(!run(other, "").compiled, "other compiler version again: missed the cache");
+	check(readFile(cached) == contents, "other compiler version: replaced the cache file");
+	check(!run(dium, "").compiled, "after another compiler version: missed the cache");
+
+	// Damaged files are compiled over and replaced, so that the next run hits again
+	std::vector<std::pair<std::string, std::string>> damaged;
+	for (size_t size : { size_t{ 0 }, size_t{ 7 }, sizeof(DmcHeader) - 1, sizeof(DmcHeader), contents.size() / 2, contents.size() - 1 }) {
+		damaged.push_back({ "truncated to " + std::to_string(size) + " bytes", contents.substr(0, size) });
+	}
+	for (size_t offset : { offsetof(DmcHeader, magic), offsetof(DmcHeader, version), offsetof(DmcHeader, byteOrder), offsetof(DmcHeader, sourceHash),
+			 offsetof(DmcHeader, sourceSize), offsetof(DmcHeader, compilerHash), offsetof(DmcHeader, payloadSize),
+			 offsetof(DmcHeader, payloadChecksum), sizeof(DmcHeader), contents.size() / 2, contents.size() - 1 }) {
+		std::string bytes = contents;
+		bytes[offset] = static_cast<char>(bytes[offset] ^ 0x40);
+		damaged.push_back({ "byte " + std::to_string(offset) + " changed", bytes });
+	}
+	damaged.push_back({ "bytes appended", contents + std::string(8, '\0') });
+
+	for (const auto &damage : damaged) {
+		writeFile(cached, damage.second);
+		Run rejected = run(dium, "");
+		check(rejected.compiled, "cache file " + damage.first + ": not rejected");
+		checkSame(rejected, cold, "cache file " + damage.first);
+		check(readFile(cached) == contents, "cache file " + damage.first + ": not replaced");
+		check(!run(dium, "").compiled, "cache file " + damage.first + ": missed the cache after it was replaced");
+	}
+
+	if (failures > 0) {
+		fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+	printf("Cache checks passed, with %zu damaged files\n", damaged.size());
+	return 0;
+}
@@ -0,0 +1,68 @@
+# Runs programs under several sets of options and checks that each set prints the
+# same output and exits with the same code as the first one, which is the reference.
+#
+#   cmake -DDIUM=<dium> "-DPROGRAMS=<glob>|<glob>" "-DMODES=<options>|<options>"
+#         -DOUTPUT_DIR=<dir> -P differential.cmake
+#
+# Options within a mode are separated by spaces, e.g. "-O2 --jit=eager". When outputs
+# differ, both are kept in OUTPUT_DIR to compare.
+
+cmake_minimum_required(VERSION 3.14)
+
+foreach(variable DIUM PROGRAMS MODES OUTPUT_DIR)
+	if(NOT DEFINED ${variable})
+		message(FATAL_ERROR "${variable} is not set")
+	endif()
+endforeach()
+
+string(REPLACE "|" ";" globs "${PROGRAMS}")
+string(REPLACE "|" ";" modes "${MODES}")
+
+set(programs)
+foreach(glob IN LISTS globs)
+	file(GLOB found ${glob})
+	if(NOT found)
+		message(FATAL_ERROR "No programs match ${glob}")
+	endif()
+	list(APPEND programs ${found})
+endforeach()
+
+file(MAKE_DIRECTORY ${OUTPUT_DIR})
+set(failures 0)
+
+foreach(program IN LISTS programs)
+	get_filename_component(name ${program} NAME_WE)
+	unset(reference)
+
+	foreach(mode IN LISTS modes)
+		separate_arguments(options UNIX_COMMAND "${mode}")
+		execute_process(COMMAND ${DIUM} ${options} ${program}
+			OUTPUT_VARIABLE output
+			ERROR_VARIABLE output
+			RESULT_VARIABLE status
+			TIMEOUT 120)
+
+		if(NOT status MATCHES "^[0-9]+$")
+			message(SEND_ERROR "${name} with '${mode}': ${status}")
+			math(EXPR failures "${failures} + 1")
+		elseif(NOT DEFINED reference)
+			set(reference "${output}exit code ${status}\n")
+			set(referenceMode "${mode}")
+		elseif(NOT "${output}exit code ${status}\n" STREQUAL "${reference}")
+			string(REGEX REPLACE "[^A-Za-z0-9]+" "_" suffix "${mode}")
+			string(REGEX REPLACE "[^A-Za-z0-9]+" "_" referenceSuffix "${referenceMode}")
+			file(WRITE ${OUTPUT_DIR}/${name}${referenceSuffix}.txt "${reference}")
+			file(WRITE ${OUTPUT_DIR}/${name}${suffix}.txt "${output}exit code ${status}\n")
+			message(SEND_ERROR "${name} with '${mode}' differs from '${referenceMode}', see "
+				"${OUTPUT_DIR}/${name}${suffix}.txt")
+			math(EXPR failures "${failures} + 1")
+		endif()
+	endforeach()
+endforeach()
+
+list(LENGTH programs count)
+list(LENGTH modes modeCount)
+if(failures GREATER 0)
+	message(FATAL_ERROR "${failures} runs differ from their reference")
+endif()
+message(STATUS "${count} programs agree under ${modeCount} modes")